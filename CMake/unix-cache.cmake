@@ -56,6 +56,11 @@ endif()
 set(HAVE_CLOSESOCKET 0)
 set(HAVE_DECL_FSEEKO 1)
 set(HAVE_DIRENT_H 1)
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+  set(HAVE_EPOLL_CREATE1 1)
+else()
+  set(HAVE_EPOLL_CREATE1 0)
+endif()
 if(APPLE OR
    CYGWIN OR
    CMAKE_SYSTEM_NAME STREQUAL "OpenBSD")
@@ -215,6 +220,11 @@ set(HAVE_SA_FAMILY_T 1)
 set(HAVE_SCHED_YIELD 1)
 set(HAVE_SELECT 1)
 set(HAVE_SEND 1)
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+  set(HAVE_SENDFILE 1)
+else()
+  set(HAVE_SENDFILE 0)
+endif()
 if(APPLE OR
    CYGWIN)
   set(HAVE_SENDMMSG 0)
@@ -260,6 +270,11 @@ set(HAVE_STRUCT_TIMEVAL 1)
 if(ANDROID OR CMAKE_SYSTEM_NAME STREQUAL "iOS")
   set(HAVE_SUSECONDS_T 1)
 endif()
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+  set(HAVE_SYS_EPOLL_H 1)
+else()
+  set(HAVE_SYS_EPOLL_H 0)
+endif()
 if(APPLE OR
    CYGWIN OR
    CMAKE_SYSTEM_NAME STREQUAL "OpenBSD")
@@ -280,6 +295,11 @@ set(HAVE_SYS_PARAM_H 1)
 set(HAVE_SYS_POLL_H 1)
 set(HAVE_SYS_RESOURCE_H 1)
 set(HAVE_SYS_SELECT_H 1)
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+  set(HAVE_SYS_SENDFILE_H 1)
+else()
+  set(HAVE_SYS_SENDFILE_H 0)
+endif()
 if(CYGWIN OR
    CMAKE_SYSTEM_NAME STREQUAL "Linux")
   set(HAVE_SYS_SOCKIO_H 0)
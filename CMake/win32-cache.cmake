@@ -88,6 +88,7 @@ set(HAVE_ALARM 0)
 set(HAVE_ARC4RANDOM 0)
 set(HAVE_ARPA_INET_H 0)
 set(HAVE_CLOSESOCKET 1)
+set(HAVE_EPOLL_CREATE1 0)
 set(HAVE_EVENTFD 0)
 set(HAVE_FCNTL 0)
 set(HAVE_FCNTL_H 1)
@@ -144,6 +145,7 @@ set(HAVE_PWD_H 0)
 set(HAVE_RECV 1)
 set(HAVE_SELECT 1)
 set(HAVE_SEND 1)
+set(HAVE_SENDFILE 0)
 set(HAVE_SENDMMSG 0)
 set(HAVE_SENDMSG 0)
 set(HAVE_SETLOCALE 1)
@@ -162,12 +164,14 @@ set(HAVE_STRERROR_R 0)
 set(HAVE_STROPTS_H 0)
 set(HAVE_STRUCT_SOCKADDR_STORAGE 1)
 set(HAVE_STRUCT_TIMEVAL 1)
+set(HAVE_SYS_EPOLL_H 0)
 set(HAVE_SYS_EVENTFD_H 0)
 set(HAVE_SYS_FILIO_H 0)
 set(HAVE_SYS_IOCTL_H 0)
 set(HAVE_SYS_POLL_H 0)
 set(HAVE_SYS_RESOURCE_H 0)
 set(HAVE_SYS_SELECT_H 0)
+set(HAVE_SYS_SENDFILE_H 0)
 set(HAVE_SYS_SOCKIO_H 0)
 set(HAVE_SYS_TYPES_H 1)
 set(HAVE_SYS_UN_H 0)
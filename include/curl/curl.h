@@ -286,6 +286,11 @@ typedef size_t (*curl_write_callback)(char *buffer,
                                       size_t nitems,
                                       void *outstream);
 
+/* This is the CURLOPT_RECVBUFFERFUNCTION callback prototype. It returns a
+   buffer to receive response body data into and sets '*buflen' to its
+   size, or returns NULL to have libcurl use its own buffer. */
+typedef char *(*curl_recvbuffer_callback)(size_t *buflen, void *clientp);
+
 /* This callback will be called when a new resolver request is made */
 typedef int (*curl_resolver_start_callback)(void *resolver_state,
                                             void *reserved, void *userdata);
@@ -2258,6 +2263,19 @@ typedef enum {
   /* set TLS supported signature algorithms */
   CURLOPT(CURLOPT_SSL_SIGNATURE_ALGORITHMS, CURLOPTTYPE_STRINGPOINT, 328),
 
+  /* callback that provides the buffer to receive response body data into */
+  CURLOPT(CURLOPT_RECVBUFFERFUNCTION, CURLOPTTYPE_FUNCTIONPOINT, 329),
+  CURLOPT(CURLOPT_RECVBUFFERDATA, CURLOPTTYPE_CBPOINT, 330),
+
+  /* append changed cookies to the cookie jar instead of rewriting it */
+  CURLOPT(CURLOPT_COOKIEJOURNAL, CURLOPTTYPE_LONG, 331),
+
+  /* seconds to remember failed name resolves */
+  CURLOPT(CURLOPT_DNS_CACHE_NEGATIVE_TIMEOUT, CURLOPTTYPE_LONG, 332),
+
+  /* seconds to keep using expired DNS cache entries while refreshing them */
+  CURLOPT(CURLOPT_DNS_CACHE_STALE_TIMEOUT, CURLOPTTYPE_LONG, 333),
+
   CURLOPT_LASTENTRY /* the last unused */
 } CURLoption;
 
@@ -2996,7 +3014,13 @@ typedef enum {
   CURLINFO_EARLYDATA_SENT_T = CURLINFO_OFF_T + 68,
   CURLINFO_HTTPAUTH_USED    = CURLINFO_LONG + 69,
   CURLINFO_PROXYAUTH_USED   = CURLINFO_LONG + 70,
-  CURLINFO_LASTONE          = 70
+  CURLINFO_QUIC_RECV_PACKETS = CURLINFO_OFF_T + 71,
+  CURLINFO_QUIC_RECV_CALLS  = CURLINFO_OFF_T + 72,
+  CURLINFO_QUIC_SEND_PACKETS = CURLINFO_OFF_T + 73,
+  CURLINFO_QUIC_SEND_CALLS  = CURLINFO_OFF_T + 74,
+  CURLINFO_RECV_WINDOW_T    = CURLINFO_OFF_T + 75,
+  CURLINFO_RTT_T            = CURLINFO_OFF_T + 76,
+  CURLINFO_LASTONE          = 76
 } CURLINFO;
 
 /* CURLINFO_RESPONSE_CODE is the new name for the option previously known as
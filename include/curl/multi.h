@@ -398,6 +398,18 @@ typedef enum {
   /* network has changed, adjust caches/connection reuse */
   CURLOPT(CURLMOPT_NETWORK_CHANGED, CURLOPTTYPE_LONG, 17),
 
+  /* the event backend used by curl_multi_wait() and curl_multi_poll() */
+  CURLOPT(CURLMOPT_POLL_BACKEND, CURLOPTTYPE_LONG, 18),
+
+  /* maximum number of threads resolving names for the transfers */
+  CURLOPT(CURLMOPT_MAX_RESOLVE_THREADS, CURLOPTTYPE_LONG, 19),
+
+  /* maximum number of name lookups waiting for a resolver thread */
+  CURLOPT(CURLMOPT_MAX_RESOLVE_QUEUE, CURLOPTTYPE_LONG, 20),
+
+  /* maximum number of bytes buffered for the transfers */
+  CURLOPT(CURLMOPT_MAX_MEMORY, CURLOPTTYPE_OFF_T, 21),
+
   CURLMOPT_LASTENTRY /* the last unused */
 } CURLMoption;
 
@@ -413,6 +425,16 @@ typedef enum {
      Ongoing transfers will continue with the connection they have. */
 #define CURLM_NWCOPT_CLEAR_DNS (1L<<0)
 
+/* Values for the CURLMOPT_POLL_BACKEND argument: */
+
+/* - CURLMPOLL_DEFAULT collects all transfer sockets and poll()s them on
+     every call */
+#define CURLMPOLL_DEFAULT 0L
+
+/* - CURLMPOLL_EPOLL keeps a persistent epoll set that is only updated
+     when a transfer's socket interest changes (Linux only) */
+#define CURLMPOLL_EPOLL   1L
+
 /*
  * Name:    curl_multi_setopt()
  *
@@ -488,6 +510,60 @@ CURL_EXTERN CURLMcode curl_multi_waitfds(CURLM *multi,
                                          unsigned int size,
                                          unsigned int *fd_count);
 
+/* One socket event for curl_multi_socket_actions() */
+struct curl_sockaction {
+  curl_socket_t fd; /* the socket or CURL_SOCKET_TIMEOUT */
+  int ev_bitmask;   /* CURL_CSELECT_* bits, as for curl_multi_socket_action */
+};
+
+/*
+ * Name:    curl_multi_socket_actions()
+ *
+ * Desc:    Like curl_multi_socket_action(), but for many sockets at once.
+ *          All transfers on the given sockets are marked for processing
+ *          first and each of them is then run only once, with timers
+ *          checked a single time for the whole batch.
+ *
+ * Returns: CURLMcode type, general multi error code.
+ */
+CURL_EXTERN CURLMcode curl_multi_socket_actions(CURLM *multi_handle,
+                                        const struct curl_sockaction *actions,
+                                        unsigned int count,
+                                        int *running_handles);
+
+/*
+ * Name:    curl_multi_prewarm()
+ *
+ * Desc:    Keeps at least 'min_idle' connections to the origin of the URL
+ *          set in 'easy' connected and idle in the multi handle's
+ *          connection pool, ready for transfers to reuse. The options of
+ *          'easy' are copied. Passing a 'min_idle' of zero stops keeping
+ *          connections warm for the origin.
+ *
+ * Returns: CURLMcode type, general multi error code.
+ */
+CURL_EXTERN CURLMcode curl_multi_prewarm(CURLM *multi_handle,
+                                         CURL *easy,
+                                         unsigned int min_idle);
+
+typedef enum {
+  CURLMINFO_NONE, /* first, never use this */
+  /* bytes in buffers accounted against CURLMOPT_MAX_MEMORY */
+  CURLMINFO_MEMORY_USED,
+  CURLMINFO_LASTENTRY /* the last unused */
+} CURLMinfo_offt;
+
+/*
+ * Name:    curl_multi_get_offt()
+ *
+ * Desc:    Retrieves a numeric value for the 'info' of the multi handle.
+ *
+ * Returns: CURLMcode type, general multi error code.
+ */
+CURL_EXTERN CURLMcode curl_multi_get_offt(CURLM *multi_handle,
+                                          CURLMinfo_offt info,
+                                          curl_off_t *pvalue);
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
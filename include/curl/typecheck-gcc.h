@@ -124,6 +124,9 @@
           if((option) == CURLOPT_PREREQFUNCTION)                        \
             if(!curlcheck_prereq_cb(value))                             \
               _curl_easy_setopt_err_prereq_cb();                        \
+          if((option) == CURLOPT_RECVBUFFERFUNCTION)                    \
+            if(!curlcheck_recvbuffer_cb(value))                         \
+              _curl_easy_setopt_err_recvbuffer_cb();                    \
           if((option) == CURLOPT_TRAILERFUNCTION)                       \
             if(!curlcheck_trailer_cb(value))                            \
               _curl_easy_setopt_err_trailer_cb();                       \
@@ -264,6 +267,8 @@ CURLWARNING(_curl_easy_setopt_err_interleave_cb,
             "curl_easy_setopt expects a curl_interleave_callback argument")
 CURLWARNING(_curl_easy_setopt_err_prereq_cb,
             "curl_easy_setopt expects a curl_prereq_callback argument")
+CURLWARNING(_curl_easy_setopt_err_recvbuffer_cb,
+            "curl_easy_setopt expects a curl_recvbuffer_callback argument")
 CURLWARNING(_curl_easy_setopt_err_trailer_cb,
             "curl_easy_setopt expects a curl_trailerfunc_ok argument")
 CURLWARNING(_curl_easy_setopt_err_error_buffer,
@@ -441,6 +446,7 @@ CURLWARNING(_curl_easy_getinfo_err_curl_off_t,
    (option) == CURLOPT_IOCTLDATA ||                                           \
    (option) == CURLOPT_OPENSOCKETDATA ||                                      \
    (option) == CURLOPT_PREREQDATA ||                                          \
+   (option) == CURLOPT_RECVBUFFERDATA ||                                      \
    (option) == CURLOPT_XFERINFODATA ||                                        \
    (option) == CURLOPT_READDATA ||                                            \
    (option) == CURLOPT_SEEKDATA ||                                            \
@@ -859,6 +865,11 @@ typedef size_t (*_curl_interleave_callback2)(char *p, size_t s,
   (curlcheck_NULL(expr) ||                                              \
    curlcheck_cb_compatible((expr), curl_prereq_callback))
 
+/* evaluates to true if expr is of type curl_recvbuffer_callback */
+#define curlcheck_recvbuffer_cb(expr)                                   \
+  (curlcheck_NULL(expr) ||                                              \
+   curlcheck_cb_compatible((expr), curl_recvbuffer_callback))
+
 /* evaluates to true if expr is of type curl_trailer_callback */
 #define curlcheck_trailer_cb(expr)                                      \
   (curlcheck_NULL(expr) ||                                              \
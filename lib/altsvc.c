@@ -31,6 +31,7 @@
 #include <curl/curl.h>
 #include "urldata.h"
 #include "altsvc.h"
+#include "binstore.h"
 #include "curl_get_line.h"
 #include "parsedate.h"
 #include "sendf.h"
@@ -38,6 +39,7 @@
 #include "fopen.h"
 #include "rename.h"
 #include "strdup.h"
+#include "strcase.h"
 #include "curlx/inet_pton.h"
 #include "curlx/strparse.h"
 #include "connect.h"
@@ -53,6 +55,11 @@
 #define MAX_ALTSVC_ALPNLEN 10
 
 #define H3VERSION "h3"
+#define ALTSVC_HASH_SIZE 64 /* initial number of hash slots, a power of two */
+
+/* binary store record fields: source ALPN, source port, destination ALPN,
+   destination host, destination port, expires, persist, priority */
+#define ALTSVC_BIN_FMT "sissiiii"
 
 /* Given the ALPN ID, return the name */
 const char *Curl_alpnid2str(enum alpnid id)
@@ -72,11 +79,104 @@ const char *Curl_alpnid2str(enum alpnid id)
 
 static void altsvc_free(struct altsvc *as)
 {
-  free(as->src.host);
-  free(as->dst.host);
+  /* the hostnames are stored in the same allocation */
   free(as);
 }
 
+/*
+ * The entries are indexed in a hash table on their source origin: the case
+ * insensitive hostname, port number and ALPN id. The table doubles its number
+ * of slots when it holds more entries than slots. Within a slot the entries
+ * are kept in the same order as in the list, so that lookups return the
+ * first matching alternative.
+ */
+static size_t altsvc_hash(const char *host, size_t hlen,
+                          unsigned short port, enum alpnid alpnid)
+{
+  const char *end = host + hlen;
+  size_t h = 5381;
+
+  while(host < end) {
+    size_t j = (size_t)Curl_raw_toupper(*host++);
+    h += h << 5;
+    h ^= j;
+  }
+  h += h << 5;
+  h ^= port;
+  h += h << 5;
+  h ^= (size_t)alpnid;
+
+  return h;
+}
+
+/* Double the number of hash slots. When this fails the table keeps working
+   with longer chains. */
+static void altsvc_grow(struct altsvcinfo *asi)
+{
+  size_t nslots = asi->nslots ? asi->nslots * 2 : ALTSVC_HASH_SIZE;
+  struct altsvc **slots = calloc(nslots, sizeof(*slots));
+  struct Curl_llist_node *e;
+  size_t i;
+
+  if(!slots)
+    return;
+  for(e = Curl_llist_head(&asi->list); e; e = Curl_node_next(e)) {
+    struct altsvc *as = Curl_node_elem(e);
+    size_t slot = as->hash & (nslots - 1);
+    as->next = slots[slot];
+    slots[slot] = as;
+  }
+  /* the chains are now in reverse list order, turn them around */
+  for(i = 0; i < nslots; i++) {
+    struct altsvc *as = slots[i];
+    struct altsvc *prev = NULL;
+    while(as) {
+      struct altsvc *next = as->next;
+      as->next = prev;
+      prev = as;
+      as = next;
+    }
+    slots[i] = prev;
+  }
+  free(asi->slots);
+  asi->slots = slots;
+  asi->nslots = nslots;
+}
+
+/* Add the entry last in the list and its hash chain. Frees the entry and
+   returns error on out of memory. */
+static CURLcode altsvc_link(struct altsvcinfo *asi, struct altsvc *as)
+{
+  struct altsvc **pp;
+
+  if(Curl_llist_count(&asi->list) >= asi->nslots)
+    altsvc_grow(asi);
+  if(!asi->nslots) {
+    altsvc_free(as);
+    return CURLE_OUT_OF_MEMORY;
+  }
+  as->hash = altsvc_hash(as->src.host, strlen(as->src.host), as->src.port,
+                         as->src.alpnid);
+  as->next = NULL;
+  pp = &asi->slots[as->hash & (asi->nslots - 1)];
+  while(*pp)
+    pp = &(*pp)->next;
+  *pp = as;
+  Curl_llist_append(&asi->list, as, &as->node);
+  return CURLE_OK;
+}
+
+/* Unlink the entry from the list and its hash chain, then free it */
+static void altsvc_remove(struct altsvcinfo *asi, struct altsvc *as)
+{
+  struct altsvc **pp = &asi->slots[as->hash & (asi->nslots - 1)];
+  while(*pp != as)
+    pp = &(*pp)->next;
+  *pp = as->next;
+  Curl_node_remove(&as->node);
+  altsvc_free(as);
+}
+
 static struct altsvc *altsvc_createid(const char *srchost,
                                       size_t hlen,
                                       const char *dsthost,
@@ -86,14 +186,13 @@ static struct altsvc *altsvc_createid(const char *srchost,
                                       size_t srcport,
                                       size_t dstport)
 {
-  struct altsvc *as = calloc(1, sizeof(struct altsvc));
-  if(!as)
-    return NULL;
+  struct altsvc *as;
+  char *host;
   DEBUGASSERT(hlen);
   DEBUGASSERT(dlen);
   if(!hlen || !dlen)
     /* bad input */
-    goto error;
+    return NULL;
   if((hlen > 2) && srchost[0] == '[') {
     /* IPv6 address, strip off brackets */
     srchost++;
@@ -103,7 +202,7 @@ static struct altsvc *altsvc_createid(const char *srchost,
     /* strip off trailing dot */
     hlen--;
     if(!hlen)
-      goto error;
+      return NULL;
   }
   if((dlen > 2) && dsthost[0] == '[') {
     /* IPv6 address, strip off brackets */
@@ -111,13 +210,17 @@ static struct altsvc *altsvc_createid(const char *srchost,
     dlen -= 2;
   }
 
-  as->src.host = Curl_memdup0(srchost, hlen);
-  if(!as->src.host)
-    goto error;
+  /* the entry and both hostnames in one allocation */
+  as = calloc(1, sizeof(struct altsvc) + hlen + dlen + 2);
+  if(!as)
+    return NULL;
 
-  as->dst.host = Curl_memdup0(dsthost, dlen);
-  if(!as->dst.host)
-    goto error;
+  host = (char *)&as[1];
+  memcpy(host, srchost, hlen);
+  as->src.host = host;
+  host += hlen + 1;
+  memcpy(host, dsthost, dlen);
+  as->dst.host = host;
 
   as->src.alpnid = srcalpnid;
   as->dst.alpnid = dstalpnid;
@@ -125,9 +228,6 @@ static struct altsvc *altsvc_createid(const char *srchost,
   as->dst.port = (unsigned short)dstport;
 
   return as;
-error:
-  altsvc_free(as);
-  return NULL;
 }
 
 static struct altsvc *altsvc_create(struct Curl_str *srchost,
@@ -200,17 +300,82 @@ static CURLcode altsvc_add(struct altsvcinfo *asi, const char *line)
       as->expires = expires;
       as->prio = 0; /* not supported to just set zero */
       as->persist = persist ? 1 : 0;
-      Curl_llist_append(&asi->list, as, &as->node);
+      return altsvc_link(asi, as);
     }
   }
 
   return CURLE_OK;
 }
 
+/* Copy an entry from a binary store file into the cache */
+static CURLcode altsvc_restore(struct altsvcinfo *asi,
+                               const struct Curl_binrec *rec)
+{
+  enum alpnid srcalpnid = Curl_alpn2alpnid(rec->f[0].str, rec->f[0].len);
+  enum alpnid dstalpnid = Curl_alpn2alpnid(rec->f[2].str, rec->f[2].len);
+  struct altsvc *as;
+
+  if(!srcalpnid || !dstalpnid || !rec->keylen || !rec->f[3].len ||
+     (rec->keylen > MAX_ALTSVC_HOSTLEN) ||
+     (rec->f[3].len > MAX_ALTSVC_HOSTLEN) ||
+     (rec->f[1].num < 0) || (rec->f[1].num > 65535) ||
+     (rec->f[4].num < 0) || (rec->f[4].num > 65535))
+    return CURLE_OK;
+  as = altsvc_createid(rec->key, rec->keylen, rec->f[3].str, rec->f[3].len,
+                       srcalpnid, dstalpnid,
+                       (size_t)rec->f[1].num, (size_t)rec->f[4].num);
+  if(!as)
+    return CURLE_OUT_OF_MEMORY;
+#if SIZEOF_TIME_T < SIZEOF_CURL_OFF_T
+  if(rec->f[5].num > TIME_T_MAX)
+    as->expires = TIME_T_MAX;
+  else
+#endif
+    as->expires = (time_t)rec->f[5].num;
+  as->prio = 0; /* not supported to just set zero */
+  as->persist = rec->f[6].num ? 1 : 0;
+  return altsvc_link(asi, as);
+}
+
+/* Copy the stored entries for this source host into the cache */
+static void altsvc_unstore(struct altsvcinfo *asi, const char *srchost,
+                           size_t hlen)
+{
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(&asi->stores); n; n = Curl_node_next(n)) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    struct Curl_binrec rec;
+    while(Curl_binstore_take(bs, srchost, hlen, &rec))
+      (void)altsvc_restore(asi, &rec);
+  }
+  Curl_binstore_prune(&asi->stores);
+}
+
+/* Copy all stored entries into the cache */
+static CURLcode altsvc_unstore_all(struct altsvcinfo *asi)
+{
+  CURLcode result = CURLE_OK;
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(&asi->stores); n && !result;
+      n = Curl_node_next(n)) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    struct Curl_binrec rec;
+    while(!result && Curl_binstore_next(bs, &rec))
+      result = altsvc_restore(asi, &rec);
+  }
+  Curl_binstore_prune(&asi->stores);
+  return result;
+}
+
 /*
  * Load alt-svc entries from the given file. The text based line-oriented file
  * format is documented here: https://curl.se/docs/alt-svc.html
  *
+ * A binary store file is not read, its entries are copied into the cache
+ * when their source hosts are looked up.
+ *
  * This function only returns error on major problems that prevent alt-svc
  * handling to work completely. It will ignore individual syntactical errors
  * etc.
@@ -218,6 +383,7 @@ static CURLcode altsvc_add(struct altsvcinfo *asi, const char *line)
 static CURLcode altsvc_load(struct altsvcinfo *asi, const char *file)
 {
   CURLcode result = CURLE_OK;
+  struct Curl_binstore *bs;
   FILE *fp;
 
   /* we need a private copy of the filename so that the altsvc cache file
@@ -227,6 +393,14 @@ static CURLcode altsvc_load(struct altsvcinfo *asi, const char *file)
   if(!asi->filename)
     return CURLE_OUT_OF_MEMORY;
 
+  result = Curl_binstore_open(file, CURL_BINSTORE_ALTSVC, ALTSVC_BIN_FMT,
+                              &bs);
+  if(bs)
+    Curl_llist_append(&asi->stores, bs, &bs->node);
+  if(result || bs)
+    /* a broken store file is ignored */
+    return (result == CURLE_OUT_OF_MEMORY) ? result : CURLE_OK;
+
   fp = fopen(file, FOPEN_READTEXT);
   if(fp) {
     struct dynbuf buf;
@@ -290,6 +464,40 @@ static CURLcode altsvc_out(struct altsvc *as, FILE *fp)
   return CURLE_OK;
 }
 
+/*
+ * Write the altsvc cache as a binary store file
+ */
+static CURLcode altsvc_out_bin(struct altsvcinfo *asi, FILE *fp)
+{
+  struct Curl_binwriter w;
+  struct Curl_llist_node *e;
+  CURLcode result = CURLE_OK;
+
+  Curl_binwriter_init(&w, CURL_BINSTORE_ALTSVC, ALTSVC_BIN_FMT);
+  for(e = Curl_llist_head(&asi->list); e && !result; e = Curl_node_next(e)) {
+    struct altsvc *as = Curl_node_elem(e);
+    struct Curl_binrec rec;
+    rec.key = as->src.host;
+    rec.keylen = strlen(as->src.host);
+    rec.f[0].str = Curl_alpnid2str(as->src.alpnid);
+    rec.f[0].len = strlen(rec.f[0].str);
+    rec.f[1].num = as->src.port;
+    rec.f[2].str = Curl_alpnid2str(as->dst.alpnid);
+    rec.f[2].len = strlen(rec.f[2].str);
+    rec.f[3].str = as->dst.host;
+    rec.f[3].len = strlen(as->dst.host);
+    rec.f[4].num = as->dst.port;
+    rec.f[5].num = (curl_off_t)as->expires;
+    rec.f[6].num = as->persist;
+    rec.f[7].num = as->prio;
+    result = Curl_binwriter_add(&w, &rec);
+  }
+  if(!result)
+    result = Curl_binwriter_write(&w, fp);
+  Curl_binwriter_free(&w);
+  return result;
+}
+
 /* ---- library-wide functions below ---- */
 
 /*
@@ -302,6 +510,7 @@ struct altsvcinfo *Curl_altsvc_init(void)
   if(!asi)
     return NULL;
   Curl_llist_init(&asi->list, NULL);
+  Curl_llist_init(&asi->stores, NULL);
 
   /* set default behavior */
   asi->flags = CURLALTSVC_H1
@@ -349,6 +558,8 @@ void Curl_altsvc_cleanup(struct altsvcinfo **altsvcp)
       n = Curl_node_next(e);
       altsvc_free(as);
     }
+    Curl_binstore_destroy(&altsvc->stores);
+    free(altsvc->slots);
     free(altsvc->filename);
     free(altsvc);
     *altsvcp = NULL; /* clear the pointer */
@@ -356,7 +567,8 @@ void Curl_altsvc_cleanup(struct altsvcinfo **altsvcp)
 }
 
 /*
- * Curl_altsvc_save() writes the altsvc cache to a file.
+ * Curl_altsvc_save() writes the altsvc cache to a file. A file that is a
+ * binary store is written as one.
  */
 CURLcode Curl_altsvc_save(struct Curl_easy *data,
                           struct altsvcinfo *altsvc, const char *file)
@@ -364,6 +576,7 @@ CURLcode Curl_altsvc_save(struct Curl_easy *data,
   CURLcode result = CURLE_OK;
   FILE *out;
   char *tempstore = NULL;
+  bool binary;
 
   if(!altsvc)
     /* no cache activated */
@@ -377,19 +590,29 @@ CURLcode Curl_altsvc_save(struct Curl_easy *data,
     /* marked as read-only, no file or zero length filename */
     return CURLE_OK;
 
+  /* all entries are saved, read what is left in the store files */
+  result = altsvc_unstore_all(altsvc);
+  if(result)
+    return result;
+
+  binary = Curl_binstore_is(file);
   result = Curl_fopen(data, file, &out, &tempstore);
   if(!result) {
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
-    fputs("# Your alt-svc cache. https://curl.se/docs/alt-svc.html\n"
-          "# This file was generated by libcurl! Edit at your own risk.\n",
-          out);
-    for(e = Curl_llist_head(&altsvc->list); e; e = n) {
-      struct altsvc *as = Curl_node_elem(e);
-      n = Curl_node_next(e);
-      result = altsvc_out(as, out);
-      if(result)
-        break;
+    if(binary)
+      result = altsvc_out_bin(altsvc, out);
+    else {
+      struct Curl_llist_node *e;
+      struct Curl_llist_node *n;
+      fputs("# Your alt-svc cache. https://curl.se/docs/alt-svc.html\n"
+            "# This file was generated by libcurl! Edit at your own risk.\n",
+            out);
+      for(e = Curl_llist_head(&altsvc->list); e; e = n) {
+        struct altsvc *as = Curl_node_elem(e);
+        n = Curl_node_next(e);
+        result = altsvc_out(as, out);
+        if(result)
+          break;
+      }
     }
     fclose(out);
     if(!result && tempstore && Curl_rename(tempstore, file))
@@ -405,35 +628,46 @@ CURLcode Curl_altsvc_save(struct Curl_easy *data,
 /* hostcompare() returns true if 'host' matches 'check'. The first host
  * argument may have a trailing dot present that will be ignored.
  */
-static bool hostcompare(const char *host, const char *check)
+static bool hostcompare(const char *host, size_t hlen, const char *check)
 {
-  size_t hlen = strlen(host);
   size_t clen = strlen(check);
 
-  if(hlen && (host[hlen - 1] == '.'))
-    hlen--;
   if(hlen != clen)
     /* they cannot match if they have different lengths */
     return FALSE;
   return curl_strnequal(host, check, hlen);
 }
 
+/* hostlen() returns the length of the hostname, without any trailing dot */
+static size_t hostlen(const char *host)
+{
+  size_t hlen = strlen(host);
+  if(hlen && (host[hlen - 1] == '.'))
+    hlen--;
+  return hlen;
+}
+
 /* altsvc_flush() removes all alternatives for this source origin from the
    list */
 static void altsvc_flush(struct altsvcinfo *asi, enum alpnid srcalpnid,
                          const char *srchost, unsigned short srcport)
 {
-  struct Curl_llist_node *e;
-  struct Curl_llist_node *n;
-  for(e = Curl_llist_head(&asi->list); e; e = n) {
-    struct altsvc *as = Curl_node_elem(e);
-    n = Curl_node_next(e);
-    if((srcalpnid == as->src.alpnid) &&
+  size_t hlen = hostlen(srchost);
+  size_t hash = altsvc_hash(srchost, hlen, srcport, srcalpnid);
+  struct altsvc *as;
+  struct altsvc *n;
+
+  if(Curl_llist_count(&asi->stores))
+    altsvc_unstore(asi, srchost, hlen);
+  if(!asi->nslots)
+    return;
+  for(as = asi->slots[hash & (asi->nslots - 1)]; as; as = n) {
+    n = as->next;
+    if((as->hash == hash) &&
+       (srcalpnid == as->src.alpnid) &&
        (srcport == as->src.port) &&
-       hostcompare(srchost, as->src.host)) {
-      Curl_node_remove(e);
-      altsvc_free(as);
-    }
+       hostcompare(srchost, hlen, as->src.host))
+      altsvc_remove(asi, as);
   }
 }
 
@@ -600,7 +834,8 @@ CURLcode Curl_altsvc_parse(struct Curl_easy *data,
             else
               as->expires = maxage + secs;
             as->persist = persist;
-            Curl_llist_append(&asi->list, as, &as->node);
+            if(altsvc_link(asi, as))
+              return CURLE_OUT_OF_MEMORY;
             infof(data, "Added alt-svc: %.*s:%d over %s",
                   (int)curlx_strlen(&dsthost), curlx_str(&dsthost),
                   dstport, Curl_alpnid2str(dstalpnid));
@@ -636,24 +871,31 @@ bool Curl_altsvc_lookup(struct altsvcinfo *asi,
                         struct altsvc **dstentry,
                         const int versions) /* one or more bits */
 {
-  struct Curl_llist_node *e;
-  struct Curl_llist_node *n;
   time_t now = time(NULL);
+  size_t hlen;
+  size_t hash;
+  struct altsvc *as;
+  struct altsvc *n;
   DEBUGASSERT(asi);
   DEBUGASSERT(srchost);
   DEBUGASSERT(dstentry);
 
-  for(e = Curl_llist_head(&asi->list); e; e = n) {
-    struct altsvc *as = Curl_node_elem(e);
-    n = Curl_node_next(e);
+  hlen = hostlen(srchost);
+  if(Curl_llist_count(&asi->stores))
+    altsvc_unstore(asi, srchost, hlen);
+  if(!asi->nslots)
+    return FALSE;
+  hash = altsvc_hash(srchost, hlen, (unsigned short)srcport, srcalpnid);
+  for(as = asi->slots[hash & (asi->nslots - 1)]; as; as = n) {
+    n = as->next;
     if(as->expires < now) {
       /* an expired entry, remove */
-      Curl_node_remove(e);
-      altsvc_free(as);
+      altsvc_remove(asi, as);
       continue;
     }
-    if((as->src.alpnid == srcalpnid) &&
-       hostcompare(srchost, as->src.host) &&
+    if((as->hash == hash) &&
+       (as->src.alpnid == srcalpnid) &&
+       hostcompare(srchost, hlen, as->src.host) &&
        (as->src.port == srcport) &&
        (versions & (int)as->dst.alpnid)) {
       /* match */
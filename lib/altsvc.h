@@ -40,6 +40,8 @@ struct altsvc {
   struct althost dst;
   time_t expires;
   struct Curl_llist_node node;
+  struct altsvc *next; /* next entry in the same hash slot */
+  size_t hash; /* hash of the source origin */
   unsigned int prio;
   BIT(persist);
 };
@@ -47,6 +49,9 @@ struct altsvc {
 struct altsvcinfo {
   char *filename;
   struct Curl_llist list; /* list of entries */
+  struct altsvc **slots; /* entries hashed on their source origin */
+  size_t nslots; /* always zero or a power of two */
+  struct Curl_llist stores; /* binary store files not read in full */
   long flags; /* the publicly set bitmask */
 };
 
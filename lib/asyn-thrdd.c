@@ -105,8 +105,6 @@ void Curl_async_global_cleanup(void)
 #endif
 }
 
-static void async_thrdd_destroy(struct Curl_easy *);
-
 CURLcode Curl_async_get_impl(struct Curl_easy *data, void **impl)
 {
   (void)data;
@@ -114,19 +112,66 @@ CURLcode Curl_async_get_impl(struct Curl_easy *data, void **impl)
   return CURLE_OK;
 }
 
+/* A name lookup handled by the resolver pool of a multi handle. Transfers
+ * asking for the same name, port and hints while it is queued or running
+ * wait on the same query and each get a copy of its result. */
+struct async_thrdd_query {
+  struct Curl_llist_node node; /* in the pool's `queue` or `running` */
+  struct Curl_llist waiters;   /* struct async_thrdd_addr_ctx */
+  char *hostname;
+  struct Curl_addrinfo *res;
+#ifdef HAVE_GETADDRINFO
+  struct addrinfo hints;
+#endif
+  int port;
+  int sock_error;
+};
+
+struct async_thrdd_pool;
+
+/* A resolver thread. Its flags are protected by the pool mutex. A detached
+ * worker frees this itself when it ends, otherwise the owner does after
+ * joining the thread. */
+struct async_thrdd_worker {
+  struct Curl_llist_node node;
+  curl_thread_t thread_hnd;
+  struct async_thrdd_pool *pool;
+  BIT(busy);      /* resolving a query, without holding the mutex */
+  BIT(ended);     /* leaving, ready to be joined */
+  BIT(detached);  /* the owner let go of it */
+};
+
+/* The resolver threads of a multi handle. Workers are started on demand,
+ * up to the multi's limit. They stay around until the multi handle is
+ * cleaned up, unless the multi belongs to curl_easy_perform(): then a
+ * worker ends when the queue is empty. The multi handle and each running
+ * worker hold a reference, the last one to let go frees the pool. */
+struct async_thrdd_pool {
+  curl_mutex_t mutx;         /* protects everything, including the
+                                async_thrdd_addr_ctx of waiting transfers */
+  curl_cond_t cond;          /* signals queued queries to idle workers */
+  struct Curl_llist queue;   /* queries waiting for a worker */
+  struct Curl_llist running; /* queries being resolved */
+  struct Curl_llist workers; /* struct async_thrdd_worker, owner only */
+  unsigned int nidle;        /* workers waiting for a query */
+  int ref_count;
+  BIT(shutdown);
+  BIT(keep_idle);            /* idle workers wait for more queries */
+  BIT(quick_exit);           /* do not wait for workers on shutdown */
+};
+
 /* Destroy context of threaded resolver */
 static void addr_ctx_destroy(struct async_thrdd_addr_ctx *addr_ctx)
 {
   if(addr_ctx) {
-    DEBUGASSERT(!addr_ctx->ref_count);
-    Curl_mutex_destroy(&addr_ctx->mutx);
-    free(addr_ctx->hostname);
+    DEBUGASSERT(!addr_ctx->query);
+    Curl_cond_destroy(&addr_ctx->cond);
     if(addr_ctx->res)
       Curl_freeaddrinfo(addr_ctx->res);
 #ifndef CURL_DISABLE_SOCKETPAIR
   /*
-   * close one end of the socket pair (may be done in resolver thread);
-   * the other end (for reading) is always closed in the parent thread.
+   * close one end of the socket pair, the other end (for reading) is
+   * closed by the caller.
    */
 #ifndef USE_EVENTFD
   if(addr_ctx->sock_pair[1] != CURL_SOCKET_BAD) {
@@ -139,152 +184,461 @@ static void addr_ctx_destroy(struct async_thrdd_addr_ctx *addr_ctx)
 }
 
 /* Initialize context for threaded resolver */
-static struct async_thrdd_addr_ctx *
-addr_ctx_create(const char *hostname, int port,
-                const struct addrinfo *hints)
+static struct async_thrdd_addr_ctx *addr_ctx_create(void)
 {
   struct async_thrdd_addr_ctx *addr_ctx = calloc(1, sizeof(*addr_ctx));
   if(!addr_ctx)
     return NULL;
 
-  addr_ctx->thread_hnd = curl_thread_t_null;
-  addr_ctx->port = port;
-#ifndef CURL_DISABLE_SOCKETPAIR
-  addr_ctx->sock_pair[0] = CURL_SOCKET_BAD;
-  addr_ctx->sock_pair[1] = CURL_SOCKET_BAD;
-#endif
-  addr_ctx->ref_count = 0;
-
-#ifdef HAVE_GETADDRINFO
-  DEBUGASSERT(hints);
-  addr_ctx->hints = *hints;
-#else
-  (void)hints;
-#endif
-
-  Curl_mutex_init(&addr_ctx->mutx);
-
 #ifndef CURL_DISABLE_SOCKETPAIR
   /* create socket pair or pipe */
   if(wakeup_create(addr_ctx->sock_pair, FALSE) < 0) {
-    addr_ctx->sock_pair[0] = CURL_SOCKET_BAD;
-    addr_ctx->sock_pair[1] = CURL_SOCKET_BAD;
-    goto err_exit;
+    free(addr_ctx);
+    return NULL;
   }
 #endif
+  Curl_cond_init(&addr_ctx->cond);
   addr_ctx->sock_error = CURL_ASYNC_SUCCESS;
-
-  /* Copying hostname string because original can be destroyed by parent
-   * thread during gethostbyname execution.
-   */
-  addr_ctx->hostname = strdup(hostname);
-  if(!addr_ctx->hostname)
-    goto err_exit;
-
-  addr_ctx->ref_count = 1;
+  addr_ctx->start = curlx_now();
   return addr_ctx;
+}
 
-err_exit:
+/*
+ * addr_ctx_done() marks the resolve of a transfer as done and wakes it up.
+ * Call with the pool mutex held.
+ */
+static void addr_ctx_done(struct async_thrdd_addr_ctx *addr_ctx)
+{
+  addr_ctx->query = NULL;
+  addr_ctx->done = TRUE;
 #ifndef CURL_DISABLE_SOCKETPAIR
-  if(addr_ctx->sock_pair[0] != CURL_SOCKET_BAD) {
-    wakeup_close(addr_ctx->sock_pair[0]);
-    addr_ctx->sock_pair[0] = CURL_SOCKET_BAD;
+  if(addr_ctx->sock_pair[1] != CURL_SOCKET_BAD) {
+#ifdef USE_EVENTFD
+    const uint64_t buf[1] = { 1 };
+#else
+    const char buf[1] = { 1 };
+#endif
+    /* DNS has been resolved, signal client task */
+    if(wakeup_write(addr_ctx->sock_pair[1], buf, sizeof(buf)) < 0) {
+      /* update sock_error to errno */
+      addr_ctx->sock_error = SOCKERRNO;
+    }
   }
 #endif
-  addr_ctx_destroy(addr_ctx);
-  return NULL;
+  Curl_cond_signal(&addr_ctx->cond);
 }
 
-#ifdef HAVE_GETADDRINFO
+static void query_free(struct async_thrdd_query *q)
+{
+  DEBUGASSERT(!Curl_llist_count(&q->waiters));
+  free(q->hostname);
+  if(q->res)
+    Curl_freeaddrinfo(q->res);
+  free(q);
+}
 
 /*
- * getaddrinfo_thread() resolves a name and then exits.
- *
- * For builds without ARES, but with USE_IPV6, create a resolver thread
- * and wait on it.
+ * query_done() hands the outcome of a finished query to all transfers
+ * waiting on it and frees it. Call with the pool mutex held.
  */
-static CURL_THREAD_RETURN_T CURL_STDCALL getaddrinfo_thread(void *arg)
+static void query_done(struct async_thrdd_query *q)
 {
-  struct async_thrdd_addr_ctx *addr_ctx = arg;
+  struct Curl_llist_node *e;
+
+  for(e = Curl_llist_head(&q->waiters); e; e = Curl_llist_head(&q->waiters)) {
+    struct async_thrdd_addr_ctx *addr_ctx = Curl_node_take_elem(e);
+
+    addr_ctx->sock_error = q->sock_error;
+    if(q->res) {
+      if(Curl_llist_count(&q->waiters)) {
+        /* more waiters to go, they all need their own copy */
+        addr_ctx->res = Curl_addrinfo_dup(q->res);
+        if(!addr_ctx->res)
+          addr_ctx->sock_error = RESOLVER_ENOMEM;
+      }
+      else {
+        addr_ctx->res = q->res;
+        q->res = NULL;
+      }
+    }
+    addr_ctx_done(addr_ctx);
+  }
+  query_free(q);
+}
+
+/*
+ * query_fail() makes all transfers waiting on a query give up on it.
+ * Call with the pool mutex held.
+ */
+static void query_fail(struct async_thrdd_query *q)
+{
+  struct Curl_llist_node *e;
+
+  for(e = Curl_llist_head(&q->waiters); e; e = Curl_llist_head(&q->waiters)) {
+    struct async_thrdd_addr_ctx *addr_ctx = Curl_node_take_elem(e);
+    addr_ctx_done(addr_ctx);
+    addr_ctx->pool = NULL;
+  }
+}
+
+/* Run the actual name resolve of a query, without holding the mutex. */
+static void query_resolve(struct async_thrdd_query *q)
+{
+#ifdef HAVE_GETADDRINFO
   char service[12];
   int rc;
-  bool all_gone;
 
-  msnprintf(service, sizeof(service), "%d", addr_ctx->port);
+  msnprintf(service, sizeof(service), "%d", q->port);
 
-  rc = Curl_getaddrinfo_ex(addr_ctx->hostname, service,
-                           &addr_ctx->hints, &addr_ctx->res);
+  rc = Curl_getaddrinfo_ex(q->hostname, service, &q->hints, &q->res);
 
   if(rc) {
-    addr_ctx->sock_error = SOCKERRNO ? SOCKERRNO : rc;
-    if(addr_ctx->sock_error == 0)
-      addr_ctx->sock_error = RESOLVER_ENOMEM;
+    q->sock_error = SOCKERRNO ? SOCKERRNO : rc;
+    if(q->sock_error == 0)
+      q->sock_error = RESOLVER_ENOMEM;
   }
   else {
-    Curl_addrinfo_set_port(addr_ctx->res, addr_ctx->port);
+    Curl_addrinfo_set_port(q->res, q->port);
   }
-
-  Curl_mutex_acquire(&addr_ctx->mutx);
-  if(addr_ctx->ref_count > 1) {
-    /* Someone still waiting on our results. */
-#ifndef CURL_DISABLE_SOCKETPAIR
-    if(addr_ctx->sock_pair[1] != CURL_SOCKET_BAD) {
-#ifdef USE_EVENTFD
-      const uint64_t buf[1] = { 1 };
 #else
-      const char buf[1] = { 1 };
+  q->res = Curl_ipv4_resolve_r(q->hostname, q->port);
+
+  if(!q->res) {
+    q->sock_error = SOCKERRNO;
+    if(q->sock_error == 0)
+      q->sock_error = RESOLVER_ENOMEM;
+  }
 #endif
-      /* DNS has been resolved, signal client task */
-      if(wakeup_write(addr_ctx->sock_pair[1], buf, sizeof(buf)) < 0) {
-        /* update sock_error to errno */
-        addr_ctx->sock_error = SOCKERRNO;
-      }
+}
+
+static void pool_free(struct async_thrdd_pool *pool)
+{
+  DEBUGASSERT(!Curl_llist_count(&pool->queue));
+  DEBUGASSERT(!Curl_llist_count(&pool->running));
+  Curl_cond_destroy(&pool->cond);
+  Curl_mutex_destroy(&pool->mutx);
+  free(pool);
+}
+
+/*
+ * pool_worker() takes queries off the queue and resolves them until the
+ * pool is shut down.
+ */
+static CURL_THREAD_RETURN_T CURL_STDCALL pool_worker(void *arg)
+{
+  struct async_thrdd_worker *w = arg;
+  struct async_thrdd_pool *pool = w->pool;
+  bool all_gone;
+
+  Curl_mutex_acquire(&pool->mutx);
+  for(;;) {
+    struct async_thrdd_query *q;
+
+    while(!pool->shutdown && !Curl_llist_count(&pool->queue) &&
+          pool->keep_idle) {
+      pool->nidle++;
+      Curl_cond_wait(&pool->cond, &pool->mutx);
+      pool->nidle--;
     }
-#endif
+    if(pool->shutdown || !Curl_llist_count(&pool->queue))
+      break;
+
+    q = Curl_node_take_elem(Curl_llist_head(&pool->queue));
+    Curl_llist_append(&pool->running, q, &q->node);
+    /* a signal may wake only one of us, pass it on while work is left */
+    if(Curl_llist_count(&pool->queue))
+      Curl_cond_signal(&pool->cond);
+    w->busy = TRUE;
+    Curl_mutex_release(&pool->mutx);
+
+    query_resolve(q);
+
+    Curl_mutex_acquire(&pool->mutx);
+    w->busy = FALSE;
+    Curl_node_remove(&q->node);
+    query_done(q);
   }
-  /* thread gives up its reference to the shared data now. */
-  --addr_ctx->ref_count;
-  all_gone = !addr_ctx->ref_count;
-  Curl_mutex_release(&addr_ctx->mutx);
+  /* wake up the next worker to see the shutdown */
+  Curl_cond_signal(&pool->cond);
+  if(w->detached)
+    free(w);
+  else
+    w->ended = TRUE;
+  --pool->ref_count;
+  all_gone = !pool->ref_count;
+  Curl_mutex_release(&pool->mutx);
   if(all_gone)
-    addr_ctx_destroy(addr_ctx);
+    pool_free(pool);
 
   return 0;
 }
 
-#else /* HAVE_GETADDRINFO */
+static struct async_thrdd_pool *pool_get(struct Curl_multi *multi,
+                                         bool keep_idle)
+{
+  if(!multi->resolve_pool) {
+    struct async_thrdd_pool *pool = calloc(1, sizeof(*pool));
+    if(!pool)
+      return NULL;
+    Curl_mutex_init(&pool->mutx);
+    Curl_cond_init(&pool->cond);
+    Curl_llist_init(&pool->queue, NULL);
+    Curl_llist_init(&pool->running, NULL);
+    Curl_llist_init(&pool->workers, NULL);
+    pool->ref_count = 1;
+    pool->keep_idle = keep_idle;
+    multi->resolve_pool = pool;
+  }
+  return multi->resolve_pool;
+}
+
+/* Join the workers that ended. Call with the pool mutex held. */
+static void pool_reap(struct async_thrdd_pool *pool)
+{
+  struct Curl_llist_node *e = Curl_llist_head(&pool->workers);
+
+  while(e) {
+    struct async_thrdd_worker *w = Curl_node_elem(e);
+    e = Curl_node_next(e);
+    if(w->ended) {
+      /* it does not need the mutex anymore */
+      Curl_node_remove(&w->node);
+      Curl_thread_join(&w->thread_hnd);
+      free(w);
+    }
+  }
+}
+
+static bool query_matches(struct async_thrdd_query *q,
+                          const char *hostname, int port,
+                          const struct addrinfo *hints)
+{
+#ifdef HAVE_GETADDRINFO
+  if((q->hints.ai_family != hints->ai_family) ||
+     (q->hints.ai_socktype != hints->ai_socktype))
+    return FALSE;
+#else
+  (void)hints;
+#endif
+  return (q->port == port) && curl_strequal(q->hostname, hostname);
+}
+
+static struct async_thrdd_query *
+pool_find(struct Curl_llist *list, const char *hostname, int port,
+          const struct addrinfo *hints)
+{
+  struct Curl_llist_node *e;
+
+  for(e = Curl_llist_head(list); e; e = Curl_node_next(e)) {
+    struct async_thrdd_query *q = Curl_node_elem(e);
+    if(query_matches(q, hostname, port, hints))
+      return q;
+  }
+  return NULL;
+}
 
 /*
- * gethostbyname_thread() resolves a name and then exits.
+ * pool_submit() makes `addr_ctx` wait on a query for the given name. A
+ * query already queued or running for it is joined, otherwise a new one is
+ * queued and a worker started when none is idle and the limit allows.
+ *
+ * Returns 0 or an errno value on failure.
  */
-static CURL_THREAD_RETURN_T CURL_STDCALL gethostbyname_thread(void *arg)
+static int pool_submit(struct Curl_easy *data,
+                       struct async_thrdd_pool *pool,
+                       struct async_thrdd_addr_ctx *addr_ctx,
+                       const char *hostname, int port,
+                       const struct addrinfo *hints)
 {
-  struct async_thrdd_addr_ctx *addr_ctx = arg;
-  bool all_gone;
+  struct Curl_multi *multi = data->multi;
+  struct async_thrdd_query *q;
+  size_t nqueued;
+  int err = 0;
+
+  Curl_mutex_acquire(&pool->mutx);
+  q = pool_find(&pool->running, hostname, port, hints);
+  if(!q)
+    q = pool_find(&pool->queue, hostname, port, hints);
+  if(q) {
+    CURL_TRC_DNS(data, "resolve of %s:%d joins ongoing lookup with %zu "
+                 "other transfers", hostname, port,
+                 Curl_llist_count(&q->waiters));
+    goto out;
+  }
 
-  addr_ctx->res = Curl_ipv4_resolve_r(addr_ctx->hostname, addr_ctx->port);
+  nqueued = Curl_llist_count(&pool->queue);
+  if(multi->max_resolve_queue && (nqueued >= multi->max_resolve_queue)) {
+    CURL_TRC_DNS(data, "resolve queue is full (%zu)", nqueued);
+    err = SOCKEWOULDBLOCK;
+    goto out;
+  }
 
-  if(!addr_ctx->res) {
-    addr_ctx->sock_error = SOCKERRNO;
-    if(addr_ctx->sock_error == 0)
-      addr_ctx->sock_error = RESOLVER_ENOMEM;
+  q = calloc(1, sizeof(*q));
+  if(!q) {
+    err = SOCKENOMEM;
+    goto out;
+  }
+  q->hostname = strdup(hostname);
+  if(!q->hostname) {
+    free(q);
+    q = NULL;
+    err = SOCKENOMEM;
+    goto out;
   }
+  Curl_llist_init(&q->waiters, NULL);
+  q->port = port;
+#ifdef HAVE_GETADDRINFO
+  DEBUGASSERT(hints);
+  q->hints = *hints;
+#endif
+  Curl_llist_append(&pool->queue, q, &q->node);
+  ++nqueued;
+
+  pool_reap(pool);
+  if((nqueued > pool->nidle) &&
+     (Curl_llist_count(&pool->workers) < multi->max_resolve_threads)) {
+    struct async_thrdd_worker *w = calloc(1, sizeof(*w));
+    if(w) {
+      /* the running thread holds a reference to the pool */
+      w->pool = pool;
+      ++pool->ref_count;
+      w->thread_hnd = Curl_thread_create(pool_worker, w);
+      if(w->thread_hnd == curl_thread_t_null) {
+        --pool->ref_count;
+        err = errno;
+        free(w);
+      }
+      else {
+        Curl_llist_append(&pool->workers, w, &w->node);
+        CURL_TRC_DNS(data, "resolve pool started worker #%zu",
+                     Curl_llist_count(&pool->workers));
+      }
+    }
+    else
+      err = SOCKENOMEM;
+
+    if(err) {
+      if(!Curl_llist_count(&pool->workers)) {
+        /* nobody to run the query */
+        Curl_node_remove(&q->node);
+        query_free(q);
+        q = NULL;
+        goto out;
+      }
+      /* the ones we have do the work */
+      err = 0;
+    }
+  }
+  Curl_cond_signal(&pool->cond);
+
+out:
+  if(q) {
+    addr_ctx->pool = pool;
+    addr_ctx->query = q;
+    Curl_llist_append(&q->waiters, addr_ctx, &addr_ctx->wnode);
+    if(data->set.quick_exit)
+      pool->quick_exit = TRUE;
+  }
+  Curl_mutex_release(&pool->mutx);
+  return err;
+}
 
-  Curl_mutex_acquire(&addr_ctx->mutx);
-  /* thread gives up its reference to the shared data now. */
-  --addr_ctx->ref_count;
-  all_gone = !addr_ctx->ref_count;;
-  Curl_mutex_release(&addr_ctx->mutx);
-  if(all_gone)
-    addr_ctx_destroy(addr_ctx);
+/*
+ * addr_ctx_detach() stops `addr_ctx` from waiting on its query. A query
+ * nobody waits on anymore is dropped if no worker has picked it up yet,
+ * otherwise the worker discards its result.
+ */
+static void addr_ctx_detach(struct async_thrdd_addr_ctx *addr_ctx)
+{
+  struct async_thrdd_pool *pool = addr_ctx->pool;
 
-  return 0;
+  if(!pool)
+    return;
+  Curl_mutex_acquire(&pool->mutx);
+  if(addr_ctx->query) {
+    struct async_thrdd_query *q = addr_ctx->query;
+    Curl_node_remove(&addr_ctx->wnode);
+    addr_ctx->query = NULL;
+    if(!Curl_llist_count(&q->waiters) &&
+       (Curl_node_llist(&q->node) == &pool->queue)) {
+      Curl_node_remove(&q->node);
+      query_free(q);
+    }
+  }
+  Curl_mutex_release(&pool->mutx);
+  addr_ctx->pool = NULL;
+}
+
+static bool addr_ctx_is_done(struct async_thrdd_addr_ctx *addr_ctx)
+{
+  bool done;
+
+  if(!addr_ctx->pool)
+    return addr_ctx->done;
+  Curl_mutex_acquire(&addr_ctx->pool->mutx);
+  done = addr_ctx->done;
+  Curl_mutex_release(&addr_ctx->pool->mutx);
+  return done;
 }
 
-#endif /* HAVE_GETADDRINFO */
+void Curl_async_thrdd_pool_destroy(struct Curl_multi *multi)
+{
+  struct async_thrdd_pool *pool = multi->resolve_pool;
+  struct Curl_llist_node *e;
+  bool all_gone;
+
+  if(!pool)
+    return;
+  multi->resolve_pool = NULL;
+
+  Curl_mutex_acquire(&pool->mutx);
+  pool->shutdown = TRUE;
+  /* queued queries are dropped, running ones are left to their workers
+     which discard the results. Transfers still waiting fail. */
+  while(Curl_llist_count(&pool->queue)) {
+    struct async_thrdd_query *q =
+      Curl_node_take_elem(Curl_llist_head(&pool->queue));
+    query_fail(q);
+    query_free(q);
+  }
+  for(e = Curl_llist_head(&pool->running); e; e = Curl_node_next(e))
+    query_fail(Curl_node_elem(e));
+  Curl_cond_signal(&pool->cond);
+
+  /* Workers busy resolving may be stuck in the resolver for a long time,
+     they are detached and end on their own. So are all workers on a quick
+     exit. The list of workers is only ever changed by the owner. */
+  pool_reap(pool);
+  e = Curl_llist_head(&pool->workers);
+  while(e) {
+    struct async_thrdd_worker *w = Curl_node_elem(e);
+    e = Curl_node_next(e);
+    if(w->busy || pool->quick_exit) {
+      Curl_node_remove(&w->node);
+      Curl_thread_destroy(&w->thread_hnd);
+      w->detached = TRUE;
+    }
+  }
+  Curl_mutex_release(&pool->mutx);
+
+  /* the others are idle and see the shutdown right away */
+  while(Curl_llist_count(&pool->workers)) {
+    struct async_thrdd_worker *w =
+      Curl_node_take_elem(Curl_llist_head(&pool->workers));
+    Curl_thread_join(&w->thread_hnd);
+    free(w);
+  }
+
+  Curl_mutex_acquire(&pool->mutx);
+  --pool->ref_count;
+  all_gone = !pool->ref_count;
+  Curl_mutex_release(&pool->mutx);
+  if(all_gone)
+    pool_free(pool);
+}
 
 /*
- * async_thrdd_destroy() cleans up async resolver data and thread handle.
+ * async_thrdd_destroy() cleans up async resolver data of a transfer.
  */
 static void async_thrdd_destroy(struct Curl_easy *data)
 {
@@ -302,33 +656,11 @@ static void async_thrdd_destroy(struct Curl_easy *data)
 #ifndef CURL_DISABLE_SOCKETPAIR
     curl_socket_t sock_rd = addr->sock_pair[0];
 #endif
-    bool done;
-
-    /* Release our reference to the data shared with the thread. */
-    Curl_mutex_acquire(&addr->mutx);
-    --addr->ref_count;
-    CURL_TRC_DNS(data, "resolve, destroy async data, shared ref=%d",
-                 addr->ref_count);
-    done = !addr->ref_count;
-    /* we give up our reference to `addr`, so NULL our pointer.
-     * coverity analyses this as being a potential unsynched write,
-     * assuming two calls to this function could be invoked concurrently.
-     * Which they never are, as the transfer's side runs single-threaded. */
+
+    CURL_TRC_DNS(data, "resolve, destroy async data");
+    addr_ctx_detach(addr);
     thrdd->addr = NULL;
-    if(!done) {
-      /* thread is still running. Detach the thread while mutexed, it will
-       * trigger the cleanup when it releases its reference. */
-      Curl_thread_destroy(&addr->thread_hnd);
-    }
-    Curl_mutex_release(&addr->mutx);
-
-    if(done) {
-      /* thread has released its reference, join it and
-       * release the memory we shared with it. */
-      if(addr->thread_hnd != curl_thread_t_null)
-        Curl_thread_join(&addr->thread_hnd);
-      addr_ctx_destroy(addr);
-    }
+    addr_ctx_destroy(addr);
 #ifndef CURL_DISABLE_SOCKETPAIR
     /*
      * ensure CURLMOPT_SOCKETFUNCTION fires CURL_POLL_REMOVE
@@ -379,8 +711,9 @@ static CURLcode async_rr_start(struct Curl_easy *data)
 #endif
 
 /*
- * async_thrdd_init() starts a new thread that performs the actual
- * resolve. This function returns before the resolve is done.
+ * async_thrdd_init() hands the resolve to the resolver pool of the
+ * transfer's multi handle. This function returns before the resolve is
+ * done.
  *
  * Returns FALSE in case of failure, otherwise TRUE.
  */
@@ -390,6 +723,7 @@ static bool async_thrdd_init(struct Curl_easy *data,
 {
   struct async_thrdd_ctx *thrdd = &data->state.async.thrdd;
   struct async_thrdd_addr_ctx *addr_ctx;
+  struct async_thrdd_pool *pool;
 
   /* !checksrc! disable ERRNOVAR 1 */
   int err = ENOMEM;
@@ -416,39 +750,36 @@ static bool async_thrdd_init(struct Curl_easy *data,
   if(!data->state.async.hostname)
     goto err_exit;
 
-  addr_ctx = addr_ctx_create(hostname, port, hints);
+  DEBUGASSERT(data->multi);
+  if(!data->multi) {
+    err = SOCKEINVAL;
+    goto err_exit;
+  }
+  /* the multi of curl_easy_perform() lives as long as the easy handle, it
+     does not keep idle threads around */
+  pool = pool_get(data->multi, data->multi != data->multi_easy);
+  if(!pool)
+    goto err_exit;
+
+  addr_ctx = addr_ctx_create();
   if(!addr_ctx)
     goto err_exit;
   thrdd->addr = addr_ctx;
 
-  Curl_mutex_acquire(&addr_ctx->mutx);
-  DEBUGASSERT(addr_ctx->ref_count == 1);
-  /* passing addr_ctx to the thread adds a reference */
-  addr_ctx->start = curlx_now();
-  ++addr_ctx->ref_count;
-#ifdef HAVE_GETADDRINFO
-  addr_ctx->thread_hnd = Curl_thread_create(getaddrinfo_thread, addr_ctx);
-#else
-  addr_ctx->thread_hnd = Curl_thread_create(gethostbyname_thread, addr_ctx);
-#endif
-  if(addr_ctx->thread_hnd == curl_thread_t_null) {
-    /* The thread never started, remove its reference that never happened. */
-    --addr_ctx->ref_count;
-    err = errno;
-    Curl_mutex_release(&addr_ctx->mutx);
+  err = pool_submit(data, pool, addr_ctx, hostname, port, hints);
+  if(err)
     goto err_exit;
-  }
-  Curl_mutex_release(&addr_ctx->mutx);
 
 #ifdef USE_HTTPSRR_ARES
   if(async_rr_start(data))
     infof(data, "Failed HTTPS RR operation");
 #endif
-  CURL_TRC_DNS(data, "resolve thread started for of %s:%d", hostname, port);
+  CURL_TRC_DNS(data, "resolve of %s:%d handed to resolver pool",
+               hostname, port);
   return TRUE;
 
 err_exit:
-  CURL_TRC_DNS(data, "resolve thread failed init: %d", err);
+  CURL_TRC_DNS(data, "resolve failed init: %d", err);
   async_thrdd_destroy(data);
   CURL_SETERRNO(err);
   return FALSE;
@@ -461,18 +792,18 @@ static CURLcode asyn_thrdd_await(struct Curl_easy *data,
                                  struct async_thrdd_addr_ctx *addr_ctx,
                                  struct Curl_dns_entry **entry)
 {
+  struct async_thrdd_pool *pool = addr_ctx->pool;
   CURLcode result = CURLE_OK;
 
-  DEBUGASSERT(addr_ctx->thread_hnd != curl_thread_t_null);
-
-  CURL_TRC_DNS(data, "resolve, wait for thread to finish");
-  /* wait for the thread to resolve the name */
-  if(Curl_thread_join(&addr_ctx->thread_hnd)) {
-    if(entry)
-      result = Curl_async_is_resolved(data, entry);
+  CURL_TRC_DNS(data, "resolve, wait for lookup to finish");
+  if(pool) {
+    Curl_mutex_acquire(&pool->mutx);
+    while(!addr_ctx->done)
+      Curl_cond_wait(&addr_ctx->cond, &pool->mutx);
+    Curl_mutex_release(&pool->mutx);
   }
-  else
-    DEBUGASSERT(0);
+  if(entry)
+    result = Curl_async_is_resolved(data, entry);
 
   data->state.async.done = TRUE;
   if(entry)
@@ -482,23 +813,14 @@ static CURLcode asyn_thrdd_await(struct Curl_easy *data,
   return result;
 }
 
-
 /*
- * Until we gain a way to signal the resolver threads to stop early, we must
- * simply wait for them and ignore their results.
+ * The lookup of a transfer runs in the resolver pool, which discards
+ * its result when nobody waits for it anymore. There is no need to wait
+ * for it.
  */
 void Curl_async_thrdd_shutdown(struct Curl_easy *data)
 {
-  struct async_thrdd_ctx *thrdd = &data->state.async.thrdd;
-
-  /* If we are still resolving, we must wait for the threads to fully clean up,
-     unfortunately. Otherwise, we can simply cancel to clean up any resolver
-     data. */
-  if(thrdd->addr && (thrdd->addr->thread_hnd != curl_thread_t_null) &&
-     !data->set.quick_exit)
-    (void)asyn_thrdd_await(data, thrdd->addr, NULL);
-  else
-    async_thrdd_destroy(data);
+  async_thrdd_destroy(data);
 }
 
 void Curl_async_thrdd_destroy(struct Curl_easy *data)
@@ -559,9 +881,7 @@ CURLcode Curl_async_is_resolved(struct Curl_easy *data,
   if(!thrdd->addr)
     return CURLE_FAILED_INIT;
 
-  Curl_mutex_acquire(&thrdd->addr->mutx);
-  done = (thrdd->addr->ref_count == 1);
-  Curl_mutex_release(&thrdd->addr->mutx);
+  done = addr_ctx_is_done(thrdd->addr);
 
   if(done) {
     CURLcode result = CURLE_OK;
@@ -695,7 +1015,7 @@ struct Curl_addrinfo *Curl_async_getaddrinfo(struct Curl_easy *data,
     return NULL;
   }
 
-  failf(data, "getaddrinfo() thread failed");
+  failf(data, "gethostbyname() failed to start in resolver pool");
 
   return NULL;
 }
@@ -740,7 +1060,7 @@ struct Curl_addrinfo *Curl_async_getaddrinfo(struct Curl_easy *data,
     return NULL;
   }
 
-  failf(data, "getaddrinfo() thread failed to start");
+  failf(data, "getaddrinfo() failed to start in resolver pool");
   return NULL;
 
 }
@@ -27,6 +27,7 @@
 #include "curl_setup.h"
 
 struct Curl_easy;
+struct Curl_multi;
 struct Curl_dns_entry;
 
 #ifdef CURLRES_ASYNCH
@@ -171,34 +172,35 @@ CURLcode Curl_async_ares_set_dns_local_ip6(struct Curl_easy *data);
 #ifdef CURLRES_THREADED
 /* async resolving implementation using POSIX threads */
 #include "curl_threads.h"
+#include "llist.h"
 
-/* Context for threaded address resolver */
+struct async_thrdd_pool;
+struct async_thrdd_query;
+
+/* Context for threaded address resolver. This is owned by the transfer.
+ * While it waits on a query, the pool's workers write its result members
+ * and the transfer only reads them with the pool mutex held. */
 struct async_thrdd_addr_ctx {
-  curl_thread_t thread_hnd;
-  char *hostname;        /* hostname to resolve, Curl_async.hostname
-                            duplicate */
-  curl_mutex_t mutx;
+  struct async_thrdd_pool *pool;   /* pool resolving for us or NULL */
+  struct async_thrdd_query *query; /* query we wait on, NULL when done */
+  struct Curl_llist_node wnode;    /* in the query's list of waiters */
+  curl_cond_t cond;                /* signaled when the query is done */
 #ifndef CURL_DISABLE_SOCKETPAIR
   curl_socket_t sock_pair[2]; /* eventfd/pipes/socket pair */
 #endif
   struct Curl_addrinfo *res;
-#ifdef HAVE_GETADDRINFO
-  struct addrinfo hints;
-#endif
   struct curltime start;
   timediff_t interval_end;
   unsigned int poll_interval;
-  int port;
   int sock_error;
-  int ref_count;
+  BIT(done);
 };
 
 /* Context for threaded resolver */
 struct async_thrdd_ctx {
-  /* `addr` is a pointer since this memory is shared with a started
-   * thread. Since threads cannot be killed, we use reference counting
-   * so that we can "release" our pointer to this memory while the
-   * thread is still running. */
+  /* `addr` is NULL when no resolve is ongoing. The lookup itself is
+   * a query held by the resolver pool of the multi handle, which keeps
+   * running, and may serve other transfers, when we give up on it. */
   struct async_thrdd_addr_ctx *addr;
 #if defined(USE_HTTPSRR) && defined(USE_ARES)
   struct {
@@ -213,6 +215,14 @@ struct async_thrdd_ctx {
 void Curl_async_thrdd_shutdown(struct Curl_easy *data);
 void Curl_async_thrdd_destroy(struct Curl_easy *data);
 
+/*
+ * Curl_async_thrdd_pool_destroy()
+ *
+ * Shuts down the resolver threads of a multi handle and fails all queries
+ * still queued. Called when the multi handle is cleaned up.
+ */
+void Curl_async_thrdd_pool_destroy(struct Curl_multi *multi);
+
 #endif /* CURLRES_THREADED */
 
 #ifndef CURL_DISABLE_DOH
@@ -0,0 +1,476 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+
+#ifndef CURL_DISABLE_HTTP
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "binstore.h"
+#include "strcase.h"
+
+/* The last 2 #include files should be in this order */
+#include "curl_memory.h"
+#include "memdebug.h"
+
+#define BINSTORE_MAGIC "\x89" "CURLBS\n"
+#define BINSTORE_MAGICLEN 8
+#define BINSTORE_VERSION 1
+#define BINSTORE_HEADER 20 /* magic, version, kind and count */
+#define BINSTORE_MAX_SIZE (256 * 1024 * 1024)
+
+static unsigned int bs_get32(const unsigned char *p)
+{
+  return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) |
+    ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+/* Compare two keys case insensitively, the order the index is sorted in */
+static int bs_keycmp(const char *k1, size_t l1, const char *k2, size_t l2)
+{
+  size_t n = CURLMIN(l1, l2);
+  size_t i;
+
+  for(i = 0; i < n; i++) {
+    unsigned char c1 = (unsigned char)Curl_raw_tolower(k1[i]);
+    unsigned char c2 = (unsigned char)Curl_raw_tolower(k2[i]);
+    if(c1 != c2)
+      return (c1 < c2) ? -1 : 1;
+  }
+  if(l1 == l2)
+    return 0;
+  return (l1 < l2) ? -1 : 1;
+}
+
+/* Get the key of the record at this position and the offset following it.
+   Returns FALSE when the record is outside of the file. */
+static bool bs_key(const struct Curl_binstore *bs, unsigned int idx,
+                   const char **pkey, size_t *plen, size_t *pend)
+{
+  size_t off = bs_get32(&bs->map[BINSTORE_HEADER + (size_t)idx * 4]);
+  size_t len;
+
+  if((off < BINSTORE_HEADER) || (off > bs->size - 2))
+    return FALSE;
+  len = ((size_t)bs->map[off] << 8) | bs->map[off + 1];
+  off += 2;
+  if(len > bs->size - off)
+    return FALSE;
+  *pkey = (const char *)&bs->map[off];
+  *plen = len;
+  *pend = off + len;
+  return TRUE;
+}
+
+/* Decode the record at this position. Returns FALSE when it does not fit in
+   the file or does not have the fields of the store. */
+static bool bs_decode(const struct Curl_binstore *bs, unsigned int idx,
+                      struct Curl_binrec *rec)
+{
+  const unsigned char *map = bs->map;
+  size_t nfields = strlen(bs->fmt);
+  size_t off;
+  size_t i;
+
+  if(!bs_key(bs, idx, &rec->key, &rec->keylen, &off) ||
+     (off >= bs->size) || (map[off++] != nfields))
+    return FALSE;
+  rec->idx = idx;
+  for(i = 0; i < nfields; i++) {
+    if((off >= bs->size) || (map[off++] != (unsigned char)bs->fmt[i]))
+      return FALSE;
+    if(bs->fmt[i] == 'i') {
+      curl_uint64_t num = 0;
+      int j;
+      if(bs->size - off < 8)
+        return FALSE;
+      for(j = 0; j < 8; j++)
+        num = (num << 8) | map[off++];
+      rec->f[i].num = (curl_off_t)num;
+    }
+    else {
+      size_t len;
+      if(bs->size - off < 4)
+        return FALSE;
+      len = bs_get32(&map[off]);
+      off += 4;
+      if(len > bs->size - off)
+        return FALSE;
+      rec->f[i].str = (const char *)&map[off];
+      rec->f[i].len = len;
+      off += len;
+    }
+  }
+  return TRUE;
+}
+
+/* Return the position of the first record with a key not less than the
+   given one */
+static unsigned int bs_lower(const struct Curl_binstore *bs,
+                             const char *key, size_t keylen)
+{
+  unsigned int lo = 0;
+  unsigned int hi = bs->count;
+
+  while(lo < hi) {
+    unsigned int mid = lo + (hi - lo) / 2;
+    const char *k;
+    size_t klen;
+    size_t end;
+    if(!bs_key(bs, mid, &k, &klen, &end)) {
+      /* a broken record sorts first */
+      k = "";
+      klen = 0;
+    }
+    if(bs_keycmp(k, klen, key, keylen) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+CURLcode Curl_binstore_open(const char *file, unsigned int kind,
+                            const char *fmt, struct Curl_binstore **pbs)
+{
+  unsigned char magic[BINSTORE_MAGICLEN];
+  struct Curl_binstore *bs = NULL;
+  CURLcode result = CURLE_READ_ERROR;
+  struct_stat st;
+  size_t size;
+  FILE *fp;
+
+  DEBUGASSERT(strlen(fmt) <= CURL_BINREC_MAXFIELDS);
+  *pbs = NULL;
+  fp = fopen(file, "rb");
+  if(!fp)
+    return CURLE_OK;
+  if((fread(magic, 1, sizeof(magic), fp) != sizeof(magic)) ||
+     memcmp(magic, BINSTORE_MAGIC, sizeof(magic))) {
+    /* not a store file */
+    fclose(fp);
+    return CURLE_OK;
+  }
+  if(fstat(fileno(fp), &st) || (st.st_size < BINSTORE_HEADER) ||
+     (st.st_size > BINSTORE_MAX_SIZE))
+    goto fail;
+  size = (size_t)st.st_size;
+
+  bs = calloc(1, sizeof(*bs));
+  if(!bs) {
+    result = CURLE_OUT_OF_MEMORY;
+    goto fail;
+  }
+  Curl_uint_bset_init(&bs->taken);
+  bs->fmt = fmt;
+#ifdef HAVE_SYS_MMAN_H
+  {
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if(map != MAP_FAILED) {
+      bs->map = map;
+      bs->size = size;
+      bs->mapped = TRUE;
+    }
+  }
+#endif
+  if(!bs->map) {
+    /* no mmap() available or it failed, read the file instead */
+    unsigned char *buf = malloc(size);
+    if(!buf) {
+      result = CURLE_OUT_OF_MEMORY;
+      goto fail;
+    }
+    bs->map = buf;
+    bs->size = size;
+    if(fseek(fp, 0, SEEK_SET) || (fread(buf, 1, size, fp) != size))
+      goto fail;
+  }
+
+  if((bs_get32(&bs->map[8]) != BINSTORE_VERSION) ||
+     (bs_get32(&bs->map[12]) != kind))
+    goto fail;
+  bs->count = bs_get32(&bs->map[16]);
+  if(bs->count > (size - BINSTORE_HEADER) / 4)
+    goto fail;
+  if(Curl_uint_bset_resize(&bs->taken, bs->count)) {
+    result = CURLE_OUT_OF_MEMORY;
+    goto fail;
+  }
+  bs->left = bs->count;
+  fclose(fp);
+  *pbs = bs;
+  return CURLE_OK;
+
+fail:
+  Curl_binstore_free(bs);
+  fclose(fp);
+  return result;
+}
+
+void Curl_binstore_free(struct Curl_binstore *bs)
+{
+  if(bs) {
+#ifdef HAVE_SYS_MMAN_H
+    if(bs->mapped)
+      munmap(CURL_UNCONST(bs->map), bs->size);
+    else
+#endif
+      free(CURL_UNCONST(bs->map));
+    Curl_uint_bset_destroy(&bs->taken);
+    free(bs);
+  }
+}
+
+void Curl_binstore_destroy(struct Curl_llist *stores)
+{
+  struct Curl_llist_node *n;
+
+  while((n = Curl_llist_head(stores))) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    Curl_node_remove(n);
+    Curl_binstore_free(bs);
+  }
+}
+
+void Curl_binstore_prune(struct Curl_llist *stores)
+{
+  struct Curl_llist_node *n;
+  struct Curl_llist_node *e;
+
+  for(n = Curl_llist_head(stores); n; n = e) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    e = Curl_node_next(n);
+    if(!bs->left) {
+      Curl_node_remove(n);
+      Curl_binstore_free(bs);
+    }
+  }
+}
+
+bool Curl_binstore_is(const char *file)
+{
+  unsigned char magic[BINSTORE_MAGICLEN];
+  bool is = FALSE;
+  FILE *fp = fopen(file, "rb");
+
+  if(fp) {
+    is = (fread(magic, 1, sizeof(magic), fp) == sizeof(magic)) &&
+      !memcmp(magic, BINSTORE_MAGIC, sizeof(magic));
+    fclose(fp);
+  }
+  return is;
+}
+
+void Curl_binstore_drop(struct Curl_binstore *bs, unsigned int idx)
+{
+  if((idx < bs->count) && !Curl_uint_bset_contains(&bs->taken, idx)) {
+    Curl_uint_bset_add(&bs->taken, idx);
+    bs->left--;
+  }
+}
+
+bool Curl_binstore_get(struct Curl_binstore *bs, unsigned int idx,
+                       struct Curl_binrec *rec)
+{
+  return (idx < bs->count) && !Curl_uint_bset_contains(&bs->taken, idx) &&
+    bs_decode(bs, idx, rec);
+}
+
+/* Take out the record at this position if it is still there. A broken
+   record is dropped. */
+static bool bs_takeout(struct Curl_binstore *bs, unsigned int idx,
+                       struct Curl_binrec *rec)
+{
+  bool ok = Curl_binstore_get(bs, idx, rec);
+  Curl_binstore_drop(bs, idx);
+  return ok;
+}
+
+bool Curl_binstore_take(struct Curl_binstore *bs,
+                        const char *key, size_t keylen,
+                        struct Curl_binrec *rec)
+{
+  unsigned int i;
+
+  if(!bs->left)
+    return FALSE;
+  for(i = bs_lower(bs, key, keylen); i < bs->count; i++) {
+    const char *k;
+    size_t klen;
+    size_t end;
+    if(!bs_key(bs, i, &k, &klen, &end) || bs_keycmp(k, klen, key, keylen))
+      break;
+    if(bs_takeout(bs, i, rec))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+bool Curl_binstore_next(struct Curl_binstore *bs, struct Curl_binrec *rec)
+{
+  while(bs->left && (bs->scan < bs->count)) {
+    if(bs_takeout(bs, bs->scan++, rec))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+void Curl_binwriter_init(struct Curl_binwriter *w, unsigned int kind,
+                         const char *fmt)
+{
+  DEBUGASSERT(strlen(fmt) <= CURL_BINREC_MAXFIELDS);
+  memset(w, 0, sizeof(*w));
+  curlx_dyn_init(&w->recs, BINSTORE_MAX_SIZE);
+  w->kind = kind;
+  w->fmt = fmt;
+}
+
+void Curl_binwriter_free(struct Curl_binwriter *w)
+{
+  curlx_dyn_free(&w->recs);
+  Curl_safefree(w->offs);
+  w->count = w->alloc = 0;
+}
+
+/* Append the number in network byte order using this many bytes */
+static CURLcode bw_put(struct dynbuf *b, curl_uint64_t num, size_t bytes)
+{
+  unsigned char buf[8];
+  size_t i = bytes;
+
+  DEBUGASSERT(bytes <= sizeof(buf));
+  while(i--) {
+    buf[i] = (unsigned char)(num & 0xff);
+    num >>= 8;
+  }
+  return curlx_dyn_addn(b, buf, bytes);
+}
+
+CURLcode Curl_binwriter_add(struct Curl_binwriter *w,
+                            const struct Curl_binrec *rec)
+{
+  size_t nfields = strlen(w->fmt);
+  size_t off = curlx_dyn_len(&w->recs);
+  CURLcode result;
+  size_t i;
+
+  if((rec->keylen > 0xffff) || (off > BINSTORE_MAX_SIZE))
+    return CURLE_TOO_LARGE;
+  if(w->count == w->alloc) {
+    unsigned int alloc = w->alloc ? w->alloc * 2 : 64;
+    unsigned int *offs = realloc(w->offs, alloc * sizeof(*offs));
+    if(!offs)
+      return CURLE_OUT_OF_MEMORY;
+    w->offs = offs;
+    w->alloc = alloc;
+  }
+
+  result = bw_put(&w->recs, rec->keylen, 2);
+  if(!result && rec->keylen)
+    result = curlx_dyn_addn(&w->recs, rec->key, rec->keylen);
+  if(!result)
+    result = bw_put(&w->recs, nfields, 1);
+  for(i = 0; !result && (i < nfields); i++) {
+    result = bw_put(&w->recs, (unsigned char)w->fmt[i], 1);
+    if(result)
+      break;
+    if(w->fmt[i] == 'i')
+      result = bw_put(&w->recs, (curl_uint64_t)rec->f[i].num, 8);
+    else {
+      result = bw_put(&w->recs, rec->f[i].len, 4);
+      if(!result && rec->f[i].len)
+        result = curlx_dyn_addn(&w->recs, rec->f[i].str, rec->f[i].len);
+    }
+  }
+  if(!result)
+    w->offs[w->count++] = (unsigned int)off;
+  return result;
+}
+
+struct bw_entry {
+  const char *key;
+  size_t keylen;
+  unsigned int off;
+};
+
+/* sort on the key, keeping the order the records were added in */
+static int bw_sort(const void *p1, const void *p2)
+{
+  const struct bw_entry *e1 = p1;
+  const struct bw_entry *e2 = p2;
+  int rc = bs_keycmp(e1->key, e1->keylen, e2->key, e2->keylen);
+
+  if(!rc)
+    rc = (e1->off < e2->off) ? -1 : 1;
+  return rc;
+}
+
+CURLcode Curl_binwriter_write(struct Curl_binwriter *w, FILE *out)
+{
+  const unsigned char *recs = curlx_dyn_uptr(&w->recs);
+  size_t len = curlx_dyn_len(&w->recs);
+  size_t hsize = BINSTORE_HEADER + (size_t)w->count * 4;
+  struct bw_entry *e = NULL;
+  struct dynbuf head;
+  CURLcode result;
+  unsigned int i;
+
+  if(hsize + len > BINSTORE_MAX_SIZE)
+    return CURLE_TOO_LARGE;
+  if(w->count) {
+    e = malloc(w->count * sizeof(*e));
+    if(!e)
+      return CURLE_OUT_OF_MEMORY;
+    for(i = 0; i < w->count; i++) {
+      const unsigned char *rec = &recs[w->offs[i]];
+      e[i].keylen = ((size_t)rec[0] << 8) | rec[1];
+      e[i].key = (const char *)&rec[2];
+      e[i].off = w->offs[i];
+    }
+    qsort(e, w->count, sizeof(*e), bw_sort);
+  }
+
+  curlx_dyn_init(&head, BINSTORE_MAX_SIZE);
+  result = curlx_dyn_addn(&head, BINSTORE_MAGIC, BINSTORE_MAGICLEN);
+  if(!result)
+    result = bw_put(&head, BINSTORE_VERSION, 4);
+  if(!result)
+    result = bw_put(&head, w->kind, 4);
+  if(!result)
+    result = bw_put(&head, w->count, 4);
+  for(i = 0; !result && (i < w->count); i++)
+    result = bw_put(&head, hsize + e[i].off, 4);
+  if(!result &&
+     ((fwrite(curlx_dyn_ptr(&head), 1, hsize, out) != hsize) ||
+      (len && (fwrite(recs, 1, len, out) != len))))
+    result = CURLE_WRITE_ERROR;
+
+  curlx_dyn_free(&head);
+  free(e);
+  return result;
+}
+
+#endif /* CURL_DISABLE_HTTP */
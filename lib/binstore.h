@@ -0,0 +1,145 @@
+#ifndef HEADER_CURL_BINSTORE_H
+#define HEADER_CURL_BINSTORE_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+
+#include <curl/curl.h>
+#include "llist.h"
+#include "uint-bset.h"
+#include "curlx/dynbuf.h"
+
+/*
+ * Binary store files for the cookie, HSTS and alt-svc caches.
+ *
+ * A store file is memory-mapped and queried in place. Its records are
+ * indexed on a case insensitive key, the hostname or cookie domain they are
+ * for. The first time a key is used, its records are taken out of the store
+ * and copied into the in-memory cache, where they are updated. The file is
+ * never modified, saving a cache writes a new file.
+ *
+ * The file layout, all numbers in network byte order:
+ *
+ *   8 bytes   magic "\x89CURLBS\n"
+ *   32 bits   version, 1
+ *   32 bits   kind, CURL_BINSTORE_*
+ *   32 bits   number of records
+ *   32 bits   file offset of each record, in key order
+ *   records:
+ *     16 bits   key length
+ *     N bytes   key
+ *     8 bits    number of fields
+ *     fields, each one starting with a type byte:
+ *       'i' followed by a signed 64 bit number
+ *       's' followed by a 32 bit length and that many bytes
+ */
+
+#define CURL_BINSTORE_COOKIE 1
+#define CURL_BINSTORE_HSTS   2
+#define CURL_BINSTORE_ALTSVC 3
+
+#define CURL_BINREC_MAXFIELDS 8
+
+struct Curl_binfield {
+  const char *str; /* 's' field, not null-terminated */
+  size_t len;      /* length of 'str' */
+  curl_off_t num;  /* 'i' field */
+};
+
+struct Curl_binrec {
+  const char *key; /* not null-terminated */
+  size_t keylen;
+  unsigned int idx; /* position in the store */
+  struct Curl_binfield f[CURL_BINREC_MAXFIELDS];
+};
+
+struct Curl_binstore {
+  struct Curl_llist_node node; /* for the owner's list of stores */
+  const unsigned char *map;    /* the file contents */
+  size_t size;                 /* size of 'map' */
+  const char *fmt;             /* the field types every record has */
+  struct uint_bset taken;      /* records taken out of the store */
+  unsigned int count;          /* number of records */
+  unsigned int left;           /* number of records not taken */
+  unsigned int scan;           /* all records before this are taken */
+  unsigned int base;           /* free for the owner to use */
+  BIT(mapped);                 /* 'map' is mmap()ed, not allocated */
+};
+
+/*
+ * Open the store file of the given kind, its records having the fields
+ * listed in 'fmt'. '*pbs' is set to NULL when the file is not a store file,
+ * to be read as text. A store file that is broken or of another kind is
+ * returned as error.
+ */
+CURLcode Curl_binstore_open(const char *file, unsigned int kind,
+                            const char *fmt, struct Curl_binstore **pbs);
+void Curl_binstore_free(struct Curl_binstore *bs);
+
+/* Free all stores in the list */
+void Curl_binstore_destroy(struct Curl_llist *stores);
+
+/* Free the stores in the list that have no records left */
+void Curl_binstore_prune(struct Curl_llist *stores);
+
+/* TRUE if the file exists and is a store file */
+bool Curl_binstore_is(const char *file);
+
+/* Take out the next record for the key. Returns FALSE when there is none. */
+bool Curl_binstore_take(struct Curl_binstore *bs,
+                        const char *key, size_t keylen,
+                        struct Curl_binrec *rec);
+
+/* Take out the next record in key order. Returns FALSE when there is
+   none. */
+bool Curl_binstore_next(struct Curl_binstore *bs, struct Curl_binrec *rec);
+
+/* Get the record at this position without taking it out. Returns FALSE
+   when it is taken already or broken. */
+bool Curl_binstore_get(struct Curl_binstore *bs, unsigned int idx,
+                       struct Curl_binrec *rec);
+
+/* Drop the record at this position without using it */
+void Curl_binstore_drop(struct Curl_binstore *bs, unsigned int idx);
+
+/*
+ * Collects records and writes them as a store file.
+ */
+struct Curl_binwriter {
+  struct dynbuf recs;   /* the records, in the order added */
+  unsigned int *offs;   /* offset of each record in 'recs' */
+  unsigned int count;   /* number of records */
+  unsigned int alloc;   /* allocated size of 'offs' */
+  unsigned int kind;
+  const char *fmt;
+};
+
+void Curl_binwriter_init(struct Curl_binwriter *w, unsigned int kind,
+                         const char *fmt);
+CURLcode Curl_binwriter_add(struct Curl_binwriter *w,
+                            const struct Curl_binrec *rec);
+CURLcode Curl_binwriter_write(struct Curl_binwriter *w, FILE *out);
+void Curl_binwriter_free(struct Curl_binwriter *w);
+
+#endif /* HEADER_CURL_BINSTORE_H */
@@ -138,24 +138,126 @@ static size_t chunk_skip(struct buf_chunk *chunk, size_t amount)
   return n;
 }
 
-static void chunk_list_free(struct buf_chunk **anchor)
+/* Free a chunk, accounting for it in `cache` when it came from a pool
+ * attached to one. */
+static void chunk_free(struct buf_chunk *chunk, struct bufc_cache *cache)
+{
+  if(cache) {
+    DEBUGASSERT(cache->mem_used >= chunk->dlen);
+    cache->mem_used -= chunk->dlen;
+  }
+  free(chunk);
+}
+
+static void chunk_list_free(struct buf_chunk **anchor,
+                            struct bufc_cache *cache)
 {
   struct buf_chunk *chunk;
   while(*anchor) {
     chunk = *anchor;
     *anchor = chunk->next;
-    free(chunk);
+    chunk_free(chunk, cache);
+  }
+}
+
+
+
+void Curl_bufcache_init(struct bufc_cache *cache,
+                        size_t spare_low, size_t spare_high)
+{
+  DEBUGASSERT(spare_low <= spare_high);
+  memset(cache, 0, sizeof(*cache));
+  cache->spare_low = spare_low;
+  cache->spare_high = spare_high;
+}
+
+static struct bufc_class *bufcache_class(struct bufc_cache *cache,
+                                         size_t chunk_size, bool create)
+{
+  struct bufc_class *unused = NULL;
+  size_t i;
+
+  for(i = 0; i < BUFC_CACHE_CLASSES; ++i) {
+    struct bufc_class *cls = &cache->classes[i];
+    if(cls->chunk_size == chunk_size)
+      return cls;
+    if(!cls->chunk_size && !unused)
+      unused = cls;
+  }
+  if(create && unused) {
+    unused->chunk_size = chunk_size;
+    return unused;
+  }
+  return NULL;
+}
+
+static struct buf_chunk *bufcache_take(struct bufc_cache *cache,
+                                       size_t chunk_size)
+{
+  struct bufc_class *cls = bufcache_class(cache, chunk_size, FALSE);
+  struct buf_chunk *chunk;
+
+  if(!cls || !cls->spare)
+    return NULL;
+  chunk = cls->spare;
+  cls->spare = chunk->next;
+  --cls->spare_count;
+  return chunk;
+}
+
+static void bufcache_put(struct bufc_cache *cache,
+                         struct buf_chunk *chunk)
+{
+  struct bufc_class *cls = bufcache_class(cache, chunk->dlen, TRUE);
+
+  if(!cls || cls->spare_count >= cache->spare_high) {
+    chunk_free(chunk, cache);
+  }
+  else {
+    chunk->next = cls->spare;
+    cls->spare = chunk;
+    ++cls->spare_count;
+  }
+}
+
+void Curl_bufcache_trim(struct bufc_cache *cache)
+{
+  size_t i;
+
+  for(i = 0; i < BUFC_CACHE_CLASSES; ++i) {
+    struct bufc_class *cls = &cache->classes[i];
+    while(cls->spare_count > cache->spare_low) {
+      struct buf_chunk *chunk = cls->spare;
+      cls->spare = chunk->next;
+      --cls->spare_count;
+      chunk_free(chunk, cache);
+    }
   }
 }
 
+void Curl_bufcache_free(struct bufc_cache *cache)
+{
+  size_t i;
 
+  for(i = 0; i < BUFC_CACHE_CLASSES; ++i) {
+    chunk_list_free(&cache->classes[i].spare, cache);
+    cache->classes[i].spare_count = 0;
+  }
+}
 
 void Curl_bufcp_init(struct bufc_pool *pool,
                      size_t chunk_size, size_t spare_max)
+{
+  Curl_bufcp_init2(pool, NULL, chunk_size, spare_max);
+}
+
+void Curl_bufcp_init2(struct bufc_pool *pool, struct bufc_cache *cache,
+                      size_t chunk_size, size_t spare_max)
 {
   DEBUGASSERT(chunk_size > 0);
   DEBUGASSERT(spare_max > 0);
   memset(pool, 0, sizeof(*pool));
+  pool->cache = cache;
   pool->chunk_size = chunk_size;
   pool->spare_max = spare_max;
 }
@@ -170,10 +272,22 @@ static CURLcode bufcp_take(struct bufc_pool *pool,
     pool->spare = chunk->next;
     --pool->spare_count;
     chunk_reset(chunk);
+    if(pool->cache)
+      ++pool->cache->n_reuse;
     *pchunk = chunk;
     return CURLE_OK;
   }
 
+  if(pool->cache) {
+    chunk = bufcache_take(pool->cache, pool->chunk_size);
+    if(chunk) {
+      chunk_reset(chunk);
+      ++pool->cache->n_reuse;
+      *pchunk = chunk;
+      return CURLE_OK;
+    }
+  }
+
   /* Check for integer overflow before allocation */
   if(pool->chunk_size > SIZE_MAX - sizeof(*chunk)) {
     *pchunk = NULL;
@@ -186,6 +300,10 @@ static CURLcode bufcp_take(struct bufc_pool *pool,
     return CURLE_OUT_OF_MEMORY;
   }
   chunk->dlen = pool->chunk_size;
+  if(pool->cache) {
+    ++pool->cache->n_alloc;
+    pool->cache->mem_used += chunk->dlen;
+  }
   *pchunk = chunk;
   return CURLE_OK;
 }
@@ -194,7 +312,10 @@ static void bufcp_put(struct bufc_pool *pool,
                       struct buf_chunk *chunk)
 {
   if(pool->spare_count >= pool->spare_max) {
-    free(chunk);
+    if(pool->cache)
+      bufcache_put(pool->cache, chunk);
+    else
+      free(chunk);
   }
   else {
     chunk_reset(chunk);
@@ -206,7 +327,15 @@ static void bufcp_put(struct bufc_pool *pool,
 
 void Curl_bufcp_free(struct bufc_pool *pool)
 {
-  chunk_list_free(&pool->spare);
+  if(pool->cache) {
+    while(pool->spare) {
+      struct buf_chunk *chunk = pool->spare;
+      pool->spare = chunk->next;
+      bufcache_put(pool->cache, chunk);
+    }
+  }
+  else
+    chunk_list_free(&pool->spare, NULL);
   pool->spare_count = 0;
 }
 
@@ -241,8 +370,10 @@ void Curl_bufq_initp(struct bufq *q, struct bufc_pool *pool,
 
 void Curl_bufq_free(struct bufq *q)
 {
-  chunk_list_free(&q->head);
-  chunk_list_free(&q->spare);
+  /* the pool may already be released, free its chunks here */
+  struct bufc_cache *cache = q->pool ? q->pool->cache : NULL;
+  chunk_list_free(&q->head, cache);
+  chunk_list_free(&q->spare, cache);
   q->tail = NULL;
   q->chunk_count = 0;
 }
@@ -43,15 +43,63 @@ struct buf_chunk {
   } x;
 };
 
+/**
+ * A cache of spare chunks in a few size classes, shared by all pools
+ * that are attached to it, e.g. all connection filters of a multi handle.
+ *
+ * Pools hand the spares they do not want to keep to the cache and take
+ * from it before allocating new chunks. A size class is assigned on
+ * first use of a chunk size. Chunks of sizes for which no class is
+ * available bypass the cache.
+ *
+ * The cache keeps at most `spare_high` chunks per class. On
+ * `Curl_bufcache_trim()` it releases spares until `spare_low` remain.
+ * `mem_used` counts the bytes of all chunks allocated by attached pools
+ * that are not freed yet, in use or spare.
+ * Like pools, a cache is not thread safe.
+ */
+#define BUFC_CACHE_CLASSES  4
+
+struct bufc_class {
+  struct buf_chunk *spare;  /* list of available spare chunks */
+  size_t chunk_size;        /* the size of chunks in this class, 0 unused */
+  size_t spare_count;       /* current number of spare chunks in list */
+};
+
+struct bufc_cache {
+  struct bufc_class classes[BUFC_CACHE_CLASSES];
+  size_t spare_low;         /* spares per class to keep on trim */
+  size_t spare_high;        /* max spares per class to keep */
+  size_t n_alloc;           /* chunks allocated by attached pools */
+  size_t n_reuse;           /* chunks handed out again from spares */
+  size_t mem_used;          /* bytes in chunks of attached pools */
+};
+
+void Curl_bufcache_init(struct bufc_cache *cache,
+                        size_t spare_low, size_t spare_high);
+
+/**
+ * Release spare chunks in all classes down to the `spare_low` mark.
+ */
+void Curl_bufcache_trim(struct bufc_cache *cache);
+
+void Curl_bufcache_free(struct bufc_cache *cache);
+
 /**
  * A pool for providing/keeping a number of chunks of the same size
  *
  * The same pool can be shared by many `bufq` instances. However, a pool
  * is not thread safe. All bufqs using it are supposed to operate in the
  * same thread.
+ *
+ * A pool may be attached to a `bufc_cache`. It then takes chunks from
+ * the cache when it has no spares of its own and passes spares beyond
+ * `spare_max` - and all remaining ones when freed - to the cache. The
+ * cache must outlive the pool.
  */
 struct bufc_pool {
   struct buf_chunk *spare;  /* list of available spare chunks */
+  struct bufc_cache *cache; /* optional cache shared with other pools */
   size_t chunk_size;        /* the size of chunks in this pool */
   size_t spare_count;       /* current number of spare chunks in list */
   size_t spare_max;         /* max number of spares to keep */
@@ -60,6 +108,12 @@ struct bufc_pool {
 void Curl_bufcp_init(struct bufc_pool *pool,
                      size_t chunk_size, size_t spare_max);
 
+/**
+ * Initialize a pool attached to `cache`, which may be NULL.
+ */
+void Curl_bufcp_init2(struct bufc_pool *pool, struct bufc_cache *cache,
+                      size_t chunk_size, size_t spare_max);
+
 void Curl_bufcp_free(struct bufc_pool *pool);
 
 /**
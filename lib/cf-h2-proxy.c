@@ -42,6 +42,7 @@
 #include "multiif.h"
 #include "sendf.h"
 #include "cf-h2-proxy.h"
+#include "flowctl.h"
 
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
@@ -51,7 +52,10 @@
 #define PROXY_H2_CHUNK_SIZE  (16*1024)
 
 #define PROXY_HTTP2_HUGE_WINDOW_SIZE (100 * 1024 * 1024)
+/* the tunnel window starts small and grows up to H2_TUNNEL_WINDOW_SIZE
+ * with the bandwidth-delay product measured */
 #define H2_TUNNEL_WINDOW_SIZE        (10 * 1024 * 1024)
+#define H2_TUNNEL_WINDOW_SIZE_INITIAL (64 * 1024)
 
 #define PROXY_H2_NW_RECV_CHUNKS  (H2_TUNNEL_WINDOW_SIZE / PROXY_H2_CHUNK_SIZE)
 #define PROXY_H2_NW_SEND_CHUNKS   1
@@ -180,6 +184,7 @@ struct cf_h2_proxy_ctx {
   struct bufq outbufq; /* network send buffer */
 
   struct tunnel_stream tunnel; /* our tunnel CONNECT stream */
+  struct flowctl fc;           /* tunnel window from the measured BDP */
   int32_t goaway_error;
   int32_t last_stream_id;
   BIT(conn_closed);
@@ -311,6 +316,8 @@ static CURLcode cf_h2_proxy_ctx_init(struct Curl_cfilter *cf,
 
   if(tunnel_stream_init(cf, &ctx->tunnel))
     goto out;
+  Curl_flowctl_init(&ctx->fc, H2_TUNNEL_WINDOW_SIZE_INITIAL,
+                    H2_TUNNEL_WINDOW_SIZE);
 
   rc = nghttp2_session_callbacks_new(&cbs);
   if(rc) {
@@ -344,7 +351,7 @@ static CURLcode cf_h2_proxy_ctx_init(struct Curl_cfilter *cf,
     iv[0].settings_id = NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS;
     iv[0].value = Curl_multi_max_concurrent_streams(data->multi);
     iv[1].settings_id = NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE;
-    iv[1].value = H2_TUNNEL_WINDOW_SIZE;
+    iv[1].value = ctx->fc.window;
     iv[2].settings_id = NGHTTP2_SETTINGS_ENABLE_PUSH;
     iv[2].value = 0;
     rc = nghttp2_submit_settings(ctx->h2, NGHTTP2_FLAG_NONE, iv, 3);
@@ -635,6 +642,48 @@ static int proxy_h2_on_frame_send(nghttp2_session *session,
 }
 #endif /* !CURL_DISABLE_VERBOSE_STRINGS */
 
+/* opaque data of the PINGs measuring the BDP, to tell their ACKs apart */
+static const uint8_t proxy_h2_bdp_ping[8] = {
+  'c', 'u', 'r', 'l', '-', 'b', 'd', 'p'
+};
+
+static void proxy_h2_bdp_probe(struct Curl_cfilter *cf,
+                               struct Curl_easy *data)
+{
+  struct cf_h2_proxy_ctx *ctx = cf->ctx;
+  int rc;
+
+  rc = nghttp2_submit_ping(ctx->h2, NGHTTP2_FLAG_NONE, proxy_h2_bdp_ping);
+  if(rc) {
+    CURL_TRC_CF(data, cf, "[0] BDP ping failed: %s(%d)",
+                nghttp2_strerror(rc), rc);
+    return;
+  }
+  Curl_flowctl_probe_start(&ctx->fc, curlx_now());
+}
+
+static int proxy_h2_bdp_ack(struct Curl_cfilter *cf, struct Curl_easy *data)
+{
+  struct cf_h2_proxy_ctx *ctx = cf->ctx;
+  int rc;
+
+  if(!Curl_flowctl_probe_done(&ctx->fc, curlx_now()) ||
+     (ctx->tunnel.stream_id <= 0))
+    return 0;
+  CURL_TRC_CF(data, cf, "[%d] BDP tunnel window now %u, rtt=%"
+              FMT_TIMEDIFF_T "us", ctx->tunnel.stream_id, ctx->fc.window,
+              ctx->fc.rtt_us);
+  rc = nghttp2_session_set_local_window_size(ctx->h2, NGHTTP2_FLAG_NONE,
+                                             ctx->tunnel.stream_id,
+                                             (int32_t)ctx->fc.window);
+  if(rc) {
+    failf(data, "nghttp2_session_set_local_window_size() failed: %s(%d)",
+          nghttp2_strerror(rc), rc);
+    return NGHTTP2_ERR_CALLBACK_FAILURE;
+  }
+  return 0;
+}
+
 static int proxy_h2_on_frame_recv(nghttp2_session *session,
                                   const nghttp2_frame *frame,
                                   void *userp)
@@ -673,6 +722,12 @@ static int proxy_h2_on_frame_recv(nghttp2_session *session,
     case NGHTTP2_GOAWAY:
       ctx->rcvd_goaway = TRUE;
       break;
+    case NGHTTP2_PING:
+      if((frame->hd.flags & NGHTTP2_FLAG_ACK) &&
+         !memcmp(frame->ping.opaque_data, proxy_h2_bdp_ping,
+                 sizeof(proxy_h2_bdp_ping)))
+        return proxy_h2_bdp_ack(cf, data);
+      break;
     default:
       break;
     }
@@ -846,6 +901,8 @@ static int tunnel_recv_callback(nghttp2_session *session, uint8_t flags,
   }
   /* tunnel.recbuf has soft limit, any success MUST add all data */
   DEBUGASSERT((size_t)nwritten == len);
+  if(Curl_flowctl_recvd(&ctx->fc, len))
+    proxy_h2_bdp_probe(cf, CF_DATA_CURRENT(cf));
   return 0;
 }
 
@@ -1540,6 +1597,9 @@ static CURLcode cf_h2_proxy_query(struct Curl_cfilter *cf,
     *palpn = NULL;
     return CURLE_OK;
   }
+  case CF_QUERY_FLOWCTL_STATS:
+    Curl_flowctl_get_stats(&ctx->fc, pres2);
+    return CURLE_OK;
   default:
     break;
   }
@@ -50,6 +50,9 @@
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
+#ifdef USE_SENDFILE
+#include <sys/sendfile.h>
+#endif
 
 #ifdef __VMS
 #include <in.h>
@@ -2261,3 +2264,62 @@ CURLcode Curl_cf_socket_peek(struct Curl_cfilter *cf,
   }
   return CURLE_FAILED_INIT;
 }
+
+#ifdef USE_SENDFILE
+CURLcode Curl_cf_socket_sendfile(struct Curl_cfilter *cf,
+                                 struct Curl_easy *data,
+                                 int fd, curl_off_t offset, size_t len,
+                                 size_t *pnwritten)
+{
+  struct cf_socket_ctx *ctx = cf->ctx;
+  off_t off = (off_t)offset;
+  ssize_t nwritten;
+
+  *pnwritten = 0;
+  if(!ctx || (cf->cft != &Curl_cft_tcp && cf->cft != &Curl_cft_unix &&
+              cf->cft != &Curl_cft_tcp_accept))
+    return CURLE_NOT_BUILT_IN;
+  /* the first send on a fast open connection goes via sendto() */
+  if(cf->conn->bits.tcp_fastopen)
+    return CURLE_NOT_BUILT_IN;
+#ifdef DEBUGBUILD
+  /* leave simulated blocking and partial writes to cf_socket_send() */
+  if(ctx->wblock_percent > 0 || ctx->wpartial_percent > 0)
+    return CURLE_NOT_BUILT_IN;
+#endif
+#if SIZEOF_CURL_OFF_T > SIZEOF_OFF_T
+  if((curl_off_t)off != offset)
+    return CURLE_NOT_BUILT_IN;
+#endif
+
+  nwritten = sendfile(ctx->sock, fd, &off, len);
+  if(nwritten < 0) {
+    int sockerr = SOCKERRNO;
+    char buffer[STRERROR_LEN];
+
+    if((SOCKEWOULDBLOCK == sockerr) || (EAGAIN == sockerr) ||
+       (SOCKEINTR == sockerr)) {
+      CURL_TRC_CF(data, cf, "sendfile(len=%zu) -> EAGAIN", len);
+      return CURLE_AGAIN;
+    }
+    if((SOCKEINVAL == sockerr) || (ENOSYS == sockerr)) {
+      /* file or socket type not supported, send the usual way */
+      CURL_TRC_CF(data, cf, "sendfile(len=%zu) not supported", len);
+      return CURLE_NOT_BUILT_IN;
+    }
+    failf(data, "Send failure: %s",
+          Curl_strerror(sockerr, buffer, sizeof(buffer)));
+    data->state.os_errno = sockerr;
+    return CURLE_SEND_ERROR;
+  }
+  if(!nwritten && len) {
+    /* the file is shorter than expected, let a read report it */
+    CURL_TRC_CF(data, cf, "sendfile(len=%zu) at end of file", len);
+    return CURLE_NOT_BUILT_IN;
+  }
+  *pnwritten = (size_t)nwritten;
+  CURL_TRC_CF(data, cf, "sendfile(len=%zu, offset=%" FMT_OFF_T ") -> %zu",
+              len, offset, *pnwritten);
+  return CURLE_OK;
+}
+#endif /* USE_SENDFILE */
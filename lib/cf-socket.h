@@ -159,6 +159,19 @@ CURLcode Curl_cf_socket_peek(struct Curl_cfilter *cf,
                              const struct Curl_sockaddr_ex **paddr,
                              struct ip_quadruple *pip);
 
+#ifdef USE_SENDFILE
+/**
+ * Send `len` bytes of file `fd`, starting at `offset`, with sendfile()
+ * on the TCP or UNIX socket of the filter. Returns CURLE_AGAIN when the
+ * socket would block and CURLE_NOT_BUILT_IN when the filter or the file
+ * do not support it.
+ */
+CURLcode Curl_cf_socket_sendfile(struct Curl_cfilter *cf,
+                                 struct Curl_easy *data,
+                                 int fd, curl_off_t offset, size_t len,
+                                 size_t *pnwritten);
+#endif
+
 extern struct Curl_cftype Curl_cft_tcp;
 extern struct Curl_cftype Curl_cft_udp;
 extern struct Curl_cftype Curl_cft_unix;
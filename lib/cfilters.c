@@ -28,6 +28,7 @@
 #include "strerror.h"
 #include "cfilters.h"
 #include "connect.h"
+#include "cf-socket.h"
 #include "url.h"
 #include "sendf.h"
 #include "sockaddr.h" /* required for Curl_sockaddr_storage */
@@ -626,6 +627,28 @@ CURLcode Curl_conn_get_ip_info(struct Curl_easy *data,
   return Curl_conn_cf_get_ip_info(cf, data, is_ipv6, ipquad);
 }
 
+bool Curl_conn_get_udp_io_stats(struct Curl_easy *data,
+                                struct connectdata *conn, int sockindex,
+                                struct udp_io_stats *stats)
+{
+  struct Curl_cfilter *cf = conn ? conn->cfilter[sockindex] : NULL;
+  CURLcode result = cf ? cf->cft->query(cf, data, CF_QUERY_UDP_IO_STATS,
+                                        NULL, (void *)stats) :
+                         CURLE_UNKNOWN_OPTION;
+  return !result;
+}
+
+bool Curl_conn_get_flowctl_stats(struct Curl_easy *data,
+                                 struct connectdata *conn, int sockindex,
+                                 struct flowctl_stats *stats)
+{
+  struct Curl_cfilter *cf = conn ? conn->cfilter[sockindex] : NULL;
+  CURLcode result = cf ? cf->cft->query(cf, data, CF_QUERY_FLOWCTL_STATS,
+                                        NULL, (void *)stats) :
+                         CURLE_UNKNOWN_OPTION;
+  return !result;
+}
+
 bool Curl_conn_is_multiplex(struct connectdata *conn, int sockindex)
 {
   struct Curl_cfilter *cf = conn ? conn->cfilter[sockindex] : NULL;
@@ -1070,6 +1093,21 @@ CURLcode Curl_conn_recv(struct Curl_easy *data, int sockindex,
   return CURLE_FAILED_INIT;
 }
 
+#ifdef DEBUGBUILD
+/* Allow debug builds to override the amount to send, to force short
+ * sends */
+static size_t conn_send_len(size_t len)
+{
+  const char *p = getenv("CURL_SMALLSENDS");
+  if(len && p) {
+    curl_off_t altsize;
+    if(!curlx_str_number(&p, &altsize, len))
+      return (size_t)altsize;
+  }
+  return len;
+}
+#endif
+
 CURLcode Curl_conn_send(struct Curl_easy *data, int sockindex,
                         const void *buf, size_t blen, bool eos,
                         size_t *pnwritten)
@@ -1080,16 +1118,7 @@ CURLcode Curl_conn_send(struct Curl_easy *data, int sockindex,
   DEBUGASSERT(data->conn);
   DEBUGASSERT(sockindex >= 0 && sockindex < 2);
 #ifdef DEBUGBUILD
-  if(write_len) {
-    /* Allow debug builds to override this logic to force short sends
-    */
-    const char *p = getenv("CURL_SMALLSENDS");
-    if(p) {
-      curl_off_t altsize;
-      if(!curlx_str_number(&p, &altsize, write_len))
-        write_len = (size_t)altsize;
-    }
-  }
+  write_len = conn_send_len(write_len);
 #endif
   if(write_len != blen)
     eos = FALSE;
@@ -1100,6 +1129,33 @@ CURLcode Curl_conn_send(struct Curl_easy *data, int sockindex,
   return CURLE_FAILED_INIT;
 }
 
+#ifdef USE_SENDFILE
+CURLcode Curl_conn_sendfile(struct Curl_easy *data, int sockindex,
+                            int fd, curl_off_t offset, size_t len,
+                            size_t *pnwritten)
+{
+  struct Curl_cfilter *cf;
+
+  DEBUGASSERT(data);
+  DEBUGASSERT(data->conn);
+  DEBUGASSERT(sockindex >= 0 && sockindex < 2);
+  *pnwritten = 0;
+  if(data->conn->send[sockindex] != Curl_cf_send)
+    return CURLE_NOT_BUILT_IN;
+  /* All filters above the socket need to pass data on unchanged. */
+  for(cf = data->conn->cfilter[sockindex]; cf && cf->next; cf = cf->next) {
+    if(!cf->connected || cf->cft->do_send != Curl_cf_def_send)
+      return CURLE_NOT_BUILT_IN;
+  }
+  if(!cf || !cf->connected)
+    return CURLE_NOT_BUILT_IN;
+#ifdef DEBUGBUILD
+  len = conn_send_len(len);
+#endif
+  return Curl_cf_socket_sendfile(cf, data, fd, offset, len, pnwritten);
+}
+#endif
+
 void Curl_pollset_reset(struct Curl_easy *data,
                         struct easy_pollset *ps)
 {
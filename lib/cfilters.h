@@ -32,6 +32,8 @@ struct Curl_easy;
 struct Curl_dns_entry;
 struct connectdata;
 struct ip_quadruple;
+struct udp_io_stats;
+struct flowctl_stats;
 struct curl_tlssessioninfo;
 
 /* Callback to destroy resources held by this filter instance.
@@ -162,6 +164,12 @@ typedef CURLcode Curl_cft_cntrl(struct Curl_cfilter *cf,
                         null-terminated string or NULL if none
                         selected/handshake not done. Implemented by filter
                         types CF_TYPE_SSL or CF_TYPE_IP_CONNECT.
+ * - CF_QUERY_UDP_IO_STATS: fill out the passed udp_io_stats with the
+ *                      datagram and system call counters of a QUIC
+ *                      connection doing its own UDP I/O.
+ * - CF_QUERY_FLOWCTL_STATS: fill out the passed flowctl_stats with the
+ *                      receive window a multiplexing filter uses for
+ *                      the transfer and the round-trip time measured.
  */
 /*      query                             res1       res2     */
 #define CF_QUERY_MAX_CONCURRENT     1  /* number     -        */
@@ -181,6 +189,8 @@ typedef CURLcode Curl_cft_cntrl(struct Curl_cfilter *cf,
 #define CF_QUERY_SSL_CTX_INFO      13  /* -    struct curl_tlssessioninfo * */
 #define CF_QUERY_TRANSPORT         14  /* TRNSPRT_*  - * */
 #define CF_QUERY_ALPN_NEGOTIATED   15  /* -          const char * */
+#define CF_QUERY_UDP_IO_STATS      16  /* -      struct udp_io_stats * */
+#define CF_QUERY_FLOWCTL_STATS     17  /* -      struct flowctl_stats * */
 
 /**
  * Query the cfilter for properties. Filters ignorant of a query will
@@ -408,6 +418,22 @@ CURLcode Curl_conn_get_ip_info(struct Curl_easy *data,
                                struct connectdata *conn, int sockindex,
                                bool *is_ipv6, struct ip_quadruple *ipquad);
 
+/*
+ * Fill `stats` with the UDP datagram and system call counters of the
+ * connection when available, otherwise return FALSE.
+ */
+bool Curl_conn_get_udp_io_stats(struct Curl_easy *data,
+                                struct connectdata *conn, int sockindex,
+                                struct udp_io_stats *stats);
+
+/*
+ * Fill `stats` with the receive flow-control window and round-trip time
+ * of the connection when available, otherwise return FALSE.
+ */
+bool Curl_conn_get_flowctl_stats(struct Curl_easy *data,
+                                 struct connectdata *conn, int sockindex,
+                                 struct flowctl_stats *stats);
+
 /**
  * Connection provides multiplexing of easy handles at `socketindex`.
  */
@@ -631,6 +657,19 @@ CURLcode Curl_conn_send(struct Curl_easy *data, int sockindex,
                         const void *buf, size_t blen, bool eos,
                         size_t *pnwritten);
 
+#ifdef USE_SENDFILE
+/*
+ * Send `len` bytes of file `fd` at `offset` directly on the socket of the
+ * connection, using FIRSTSOCKET/SECONDARYSOCKET. Only possible when all
+ * filters above the socket pass data on unchanged, e.g. without TLS.
+ * Will return CURLE_AGAIN iff blocked on sending and CURLE_NOT_BUILT_IN
+ * when the connection does not allow it.
+ */
+CURLcode Curl_conn_sendfile(struct Curl_easy *data, int sockindex,
+                            int fd, curl_off_t offset, size_t len,
+                            size_t *pnwritten);
+#endif
+
 
 void Curl_pollset_reset(struct Curl_easy *data,
                         struct easy_pollset *ps);
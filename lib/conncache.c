@@ -36,6 +36,7 @@
 #include "sendf.h"
 #include "cshutdn.h"
 #include "conncache.h"
+#include "cprewarm.h"
 #include "http_negotiate.h"
 #include "http_ntlm.h"
 #include "share.h"
@@ -51,6 +52,7 @@
 #include "memdebug.h"
 
 
+
 #define CPOOL_IS_LOCKED(c)    ((c) && (c)->locked)
 
 #define CPOOL_LOCK(c,d)                                                 \
@@ -74,6 +76,24 @@
     }                                                                   \
   } while(0)
 
+#ifdef CPOOL_SHARDS
+#define CPOOL_SHARDED(c)      ((c)->num_shards > 1)
+#else
+#define CPOOL_SHARDED(c)      FALSE
+#endif
+
+/* A part of the pool, holding the bundles of the destinations whose hash
+ * falls into it. A pool that is not sharded has a single one, protected
+ * by the pool's lock. A sharded pool does its own locking: each shard has
+ * a mutex and operations on the whole pool lock all shards, in order.
+ * The pool's `lock` protects its counters and is taken last. */
+struct cpool_shard {
+  struct Curl_hash dest2bundle;
+  struct curltime last_cleanup;
+#ifdef CPOOL_SHARDS
+  curl_mutex_t mutex;
+#endif
+};
 
 /* A list of connections to the same destination. */
 struct cpool_bundle {
@@ -88,6 +108,145 @@ static void cpool_discard_conn(struct cpool *cpool,
                                struct connectdata *conn,
                                bool aborted);
 
+static struct cpool_shard *cpool_get_shard(struct cpool *cpool,
+                                           const char *dest)
+{
+  if(!CPOOL_SHARDED(cpool) || !dest)
+    return cpool->shards;
+  return &cpool->shards[Curl_hash_str(CURL_UNCONST(dest), strlen(dest) + 1,
+                                      cpool->num_shards)];
+}
+
+static void cpool_shard_acquire(struct cpool *cpool,
+                                struct cpool_shard *shard,
+                                struct Curl_easy *data)
+{
+#ifdef CPOOL_SHARDS
+  if(CPOOL_SHARDED(cpool)) {
+    (void)data;
+    Curl_mutex_acquire(&shard->mutex);
+  }
+  else
+#endif
+  {
+    (void)shard;
+    CPOOL_LOCK(cpool, data);
+  }
+}
+
+static void cpool_shard_release(struct cpool *cpool,
+                                struct cpool_shard *shard,
+                                struct Curl_easy *data)
+{
+#ifdef CPOOL_SHARDS
+  if(CPOOL_SHARDED(cpool)) {
+    (void)data;
+    Curl_mutex_release(&shard->mutex);
+  }
+  else
+#endif
+  {
+    (void)shard;
+    CPOOL_UNLOCK(cpool, data);
+  }
+}
+
+/* Lock the shard for working on its connections. The transfer remembers
+ * the lock it holds, so that callbacks it makes meanwhile find it without
+ * looking at the shard other threads may be locking. */
+static void cpool_shard_lock(struct cpool *cpool,
+                             struct cpool_shard *shard,
+                             struct Curl_easy *data)
+{
+  cpool_shard_acquire(cpool, shard, data);
+#ifdef CPOOL_SHARDS
+  DEBUGASSERT(!data->state.cpool_locked);
+  data->state.cpool_locked = shard;
+#endif
+}
+
+static void cpool_shard_unlock(struct cpool *cpool,
+                               struct cpool_shard *shard,
+                               struct Curl_easy *data)
+{
+#ifdef CPOOL_SHARDS
+  DEBUGASSERT(data->state.cpool_locked == shard);
+  data->state.cpool_locked = NULL;
+#endif
+  cpool_shard_release(cpool, shard, data);
+}
+
+/* TRUE when `data` already holds the lock of the shard, e.g. when called
+ * from a callback. */
+static bool cpool_shard_is_locked(struct cpool *cpool,
+                                  struct cpool_shard *shard,
+                                  struct Curl_easy *data)
+{
+#ifdef CPOOL_SHARDS
+  if(CPOOL_SHARDED(cpool))
+    return (data->state.cpool_locked == shard) ||
+           (data->state.cpool_locked == cpool);
+#else
+  (void)shard;
+  (void)data;
+#endif
+  return CPOOL_IS_LOCKED(cpool);
+}
+
+/* Lock all of the pool */
+static void cpool_lock_all(struct cpool *cpool, struct Curl_easy *data)
+{
+  size_t i;
+  for(i = 0; i < cpool->num_shards; ++i)
+    cpool_shard_acquire(cpool, &cpool->shards[i], data);
+#ifdef CPOOL_SHARDS
+  DEBUGASSERT(!data->state.cpool_locked);
+  data->state.cpool_locked = cpool;
+#endif
+}
+
+static void cpool_unlock_all(struct cpool *cpool, struct Curl_easy *data)
+{
+  size_t i = cpool->num_shards;
+#ifdef CPOOL_SHARDS
+  DEBUGASSERT(data->state.cpool_locked == cpool);
+  data->state.cpool_locked = NULL;
+#endif
+  while(i)
+    cpool_shard_release(cpool, &cpool->shards[--i], data);
+}
+
+/* Lock the pool's counters. In a pool that is not sharded, these are
+ * protected by the pool's lock already. */
+static void cpool_count_lock(struct cpool *cpool)
+{
+#ifdef CPOOL_SHARDS
+  if(CPOOL_SHARDED(cpool))
+    Curl_mutex_acquire(&cpool->lock);
+#else
+  (void)cpool;
+#endif
+}
+
+static void cpool_count_unlock(struct cpool *cpool)
+{
+#ifdef CPOOL_SHARDS
+  if(CPOOL_SHARDED(cpool))
+    Curl_mutex_release(&cpool->lock);
+#else
+  (void)cpool;
+#endif
+}
+
+static size_t cpool_num_conn(struct cpool *cpool)
+{
+  size_t n;
+  cpool_count_lock(cpool);
+  n = cpool->num_conn;
+  cpool_count_unlock(cpool);
+  return n;
+}
+
 static struct cpool_bundle *cpool_bundle_create(const char *dest)
 {
   struct cpool_bundle *bundle;
@@ -132,30 +291,53 @@ static void cpool_bundle_free_entry(void *freethis)
   cpool_bundle_destroy((struct cpool_bundle *)freethis);
 }
 
-void Curl_cpool_init(struct cpool *cpool,
-                     struct Curl_easy *idata,
-                     struct Curl_share *share,
-                     size_t size)
+CURLcode Curl_cpool_init(struct cpool *cpool,
+                         struct Curl_easy *idata,
+                         struct Curl_share *share,
+                         size_t size)
 {
-  Curl_hash_init(&cpool->dest2bundle, size, Curl_hash_str,
-                 curlx_str_key_compare, cpool_bundle_free_entry);
+  size_t i, num_shards = 1;
 
   DEBUGASSERT(idata);
+#ifdef CPOOL_SHARDS
+  if(share) {
+    /* transfers in several threads may use a shared pool */
+    num_shards = CPOOL_SHARDS;
+    size = (size + num_shards - 1) / num_shards;
+  }
+#endif
+  cpool->shards = calloc(num_shards, sizeof(*cpool->shards));
+  if(!cpool->shards)
+    return CURLE_OUT_OF_MEMORY;
+  cpool->num_shards = num_shards;
+  for(i = 0; i < num_shards; ++i) {
+    Curl_hash_init(&cpool->shards[i].dest2bundle, size, Curl_hash_str,
+                   curlx_str_key_compare, cpool_bundle_free_entry);
+#ifdef CPOOL_SHARDS
+    if(CPOOL_SHARDED(cpool))
+      Curl_mutex_init(&cpool->shards[i].mutex);
+#endif
+  }
+#ifdef CPOOL_SHARDS
+  if(CPOOL_SHARDED(cpool))
+    Curl_mutex_init(&cpool->lock);
+#endif
 
   cpool->idata = idata;
   cpool->share = share;
   cpool->initialised = TRUE;
+  return CURLE_OK;
 }
 
-/* Return the "first" connection in the pool or NULL. */
-static struct connectdata *cpool_get_first(struct cpool *cpool)
+/* Return the "first" connection in the shard or NULL. */
+static struct connectdata *cpool_get_first(struct cpool_shard *shard)
 {
   struct Curl_hash_iterator iter;
   struct Curl_hash_element *he;
   struct cpool_bundle *bundle;
   struct Curl_llist_node *conn_node;
 
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
+  Curl_hash_start_iterate(&shard->dest2bundle, &iter);
   for(he = Curl_hash_next_element(&iter); he;
       he = Curl_hash_next_element(&iter)) {
     bundle = he->ptr;
@@ -167,37 +349,38 @@ static struct connectdata *cpool_get_first(struct cpool *cpool)
 }
 
 
-static struct cpool_bundle *cpool_find_bundle(struct cpool *cpool,
+static struct cpool_bundle *cpool_find_bundle(struct cpool_shard *shard,
                                               struct connectdata *conn)
 {
-  return Curl_hash_pick(&cpool->dest2bundle,
+  return Curl_hash_pick(&shard->dest2bundle,
                         conn->destination, strlen(conn->destination) + 1);
 }
 
 
-static void cpool_remove_bundle(struct cpool *cpool,
+static void cpool_remove_bundle(struct cpool_shard *shard,
                                 struct cpool_bundle *bundle)
 {
-  if(!cpool)
-    return;
-  Curl_hash_delete(&cpool->dest2bundle, bundle->dest, bundle->dest_len);
+  Curl_hash_delete(&shard->dest2bundle, bundle->dest, bundle->dest_len);
 }
 
 
 static void cpool_remove_conn(struct cpool *cpool,
+                              struct cpool_shard *shard,
                               struct connectdata *conn)
 {
   struct Curl_llist *list = Curl_node_llist(&conn->cpool_node);
   DEBUGASSERT(cpool);
   if(list) {
     /* The connection is certainly in the pool, but where? */
-    struct cpool_bundle *bundle = cpool_find_bundle(cpool, conn);
+    struct cpool_bundle *bundle = cpool_find_bundle(shard, conn);
     if(bundle && (list == &bundle->conns)) {
       cpool_bundle_remove(bundle, conn);
       if(!Curl_llist_count(&bundle->conns))
-        cpool_remove_bundle(cpool, bundle);
+        cpool_remove_bundle(shard, bundle);
       conn->bits.in_cpool = FALSE;
+      cpool_count_lock(cpool);
       cpool->num_conn--;
+      cpool_count_unlock(cpool);
     }
     else {
       /* Should have been in the bundle list */
@@ -210,24 +393,40 @@ void Curl_cpool_destroy(struct cpool *cpool)
 {
   if(cpool && cpool->initialised && cpool->idata) {
     struct connectdata *conn;
+    size_t i;
     SIGPIPE_VARIABLE(pipe_st);
 
     CURL_TRC_M(cpool->idata, "%s[CPOOL] destroy, %zu connections",
                cpool->share ? "[SHARE] " : "", cpool->num_conn);
     /* Move all connections to the shutdown list */
     sigpipe_init(&pipe_st);
-    CPOOL_LOCK(cpool, cpool->idata);
-    conn = cpool_get_first(cpool);
-    while(conn) {
-      cpool_remove_conn(cpool, conn);
-      sigpipe_apply(cpool->idata, &pipe_st);
-      connclose(conn, "kill all");
-      cpool_discard_conn(cpool, cpool->idata, conn, FALSE);
-      conn = cpool_get_first(cpool);
+    cpool_lock_all(cpool, cpool->idata);
+    for(i = 0; i < cpool->num_shards; ++i) {
+      struct cpool_shard *shard = &cpool->shards[i];
+      conn = cpool_get_first(shard);
+      while(conn) {
+        cpool_remove_conn(cpool, shard, conn);
+        sigpipe_apply(cpool->idata, &pipe_st);
+        connclose(conn, "kill all");
+        cpool_discard_conn(cpool, cpool->idata, conn, FALSE);
+        conn = cpool_get_first(shard);
+      }
     }
-    CPOOL_UNLOCK(cpool, cpool->idata);
+    cpool_unlock_all(cpool, cpool->idata);
     sigpipe_restore(&pipe_st);
-    Curl_hash_destroy(&cpool->dest2bundle);
+    for(i = 0; i < cpool->num_shards; ++i) {
+      Curl_hash_destroy(&cpool->shards[i].dest2bundle);
+#ifdef CPOOL_SHARDS
+      if(CPOOL_SHARDED(cpool))
+        Curl_mutex_destroy(&cpool->shards[i].mutex);
+#endif
+    }
+#ifdef CPOOL_SHARDS
+    if(CPOOL_SHARDED(cpool))
+      Curl_mutex_destroy(&cpool->lock);
+#endif
+    Curl_safefree(cpool->shards);
+    cpool->num_shards = 0;
   }
 }
 
@@ -250,14 +449,20 @@ void Curl_cpool_xfer_init(struct Curl_easy *data)
 
   DEBUGASSERT(cpool);
   if(cpool) {
-    CPOOL_LOCK(cpool, data);
+    if(CPOOL_SHARDED(cpool))
+      cpool_count_lock(cpool);
+    else
+      CPOOL_LOCK(cpool, data);
     /* the identifier inside the connection cache */
     data->id = cpool->next_easy_id++;
     if(cpool->next_easy_id <= 0)
       cpool->next_easy_id = 0;
     data->state.lastconnect_id = -1;
 
-    CPOOL_UNLOCK(cpool, data);
+    if(CPOOL_SHARDED(cpool))
+      cpool_count_unlock(cpool);
+    else
+      CPOOL_UNLOCK(cpool, data);
   }
   else {
     /* We should not get here, but in a non-debug build, do something */
@@ -267,7 +472,7 @@ void Curl_cpool_xfer_init(struct Curl_easy *data)
 }
 
 static struct cpool_bundle *
-cpool_add_bundle(struct cpool *cpool, struct connectdata *conn)
+cpool_add_bundle(struct cpool_shard *shard, struct connectdata *conn)
 {
   struct cpool_bundle *bundle;
 
@@ -275,7 +480,7 @@ cpool_add_bundle(struct cpool *cpool, struct connectdata *conn)
   if(!bundle)
     return NULL;
 
-  if(!Curl_hash_add(&cpool->dest2bundle,
+  if(!Curl_hash_add(&shard->dest2bundle,
                     bundle->dest, bundle->dest_len, bundle)) {
     cpool_bundle_destroy(bundle);
     return NULL;
@@ -312,7 +517,10 @@ cpool_bundle_get_oldest_idle(struct cpool_bundle *bundle)
   return oldest_idle;
 }
 
-static struct connectdata *cpool_get_oldest_idle(struct cpool *cpool)
+/* Return the oldest idle connection in the shard or, when `shard` is NULL,
+ * in all of the pool. */
+static struct connectdata *cpool_get_oldest_idle(struct cpool *cpool,
+                                                 struct cpool_shard *shard)
 {
   struct Curl_hash_iterator iter;
   struct Curl_llist_node *curr;
@@ -322,25 +530,31 @@ static struct connectdata *cpool_get_oldest_idle(struct cpool *cpool)
   struct curltime now;
   timediff_t highscore =- 1;
   timediff_t score;
+  size_t i;
 
   now = curlx_now();
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
-
-  for(he = Curl_hash_next_element(&iter); he;
-      he = Curl_hash_next_element(&iter)) {
-    struct connectdata *conn;
-    bundle = he->ptr;
-
-    for(curr = Curl_llist_head(&bundle->conns); curr;
-        curr = Curl_node_next(curr)) {
-      conn = Curl_node_elem(curr);
-      if(CONN_INUSE(conn) || conn->bits.close || conn->connect_only)
-        continue;
-      /* Set higher score for the age passed since the connection was used */
-      score = curlx_timediff(now, conn->lastused);
-      if(score > highscore) {
-        highscore = score;
-        oldest_idle = conn;
+  for(i = 0; i < cpool->num_shards; ++i) {
+    if(shard && (shard != &cpool->shards[i]))
+      continue;
+    Curl_hash_start_iterate(&cpool->shards[i].dest2bundle, &iter);
+
+    for(he = Curl_hash_next_element(&iter); he;
+        he = Curl_hash_next_element(&iter)) {
+      struct connectdata *conn;
+      bundle = he->ptr;
+
+      for(curr = Curl_llist_head(&bundle->conns); curr;
+          curr = Curl_node_next(curr)) {
+        conn = Curl_node_elem(curr);
+        if(CONN_INUSE(conn) || conn->bits.close || conn->connect_only)
+          continue;
+        /* Set higher score for the age passed since the connection was
+           used */
+        score = curlx_timediff(now, conn->lastused);
+        if(score > highscore) {
+          highscore = score;
+          oldest_idle = conn;
+        }
       }
     }
   }
@@ -352,6 +566,7 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
                             struct connectdata *conn)
 {
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
   struct cpool_bundle *bundle;
   size_t dest_limit = 0;
   size_t total_limit = 0;
@@ -369,11 +584,12 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
   if(!dest_limit && !total_limit)
     return CPOOL_LIMIT_OK;
 
-  CPOOL_LOCK(cpool, cpool->idata);
+  shard = cpool_get_shard(cpool, conn->destination);
+  cpool_lock_all(cpool, cpool->idata);
   if(dest_limit) {
     size_t live;
 
-    bundle = cpool_find_bundle(cpool, conn);
+    bundle = cpool_find_bundle(shard, conn);
     live = bundle ? Curl_llist_count(&bundle->conns) : 0;
     shutdowns = Curl_cshutdn_dest_count(data, conn->destination);
     while((live  + shutdowns) >= dest_limit) {
@@ -399,7 +615,7 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
         Curl_conn_terminate(cpool->idata, oldest_idle, FALSE);
 
         /* in case the bundle was destroyed in disconnect, look it up again */
-        bundle = cpool_find_bundle(cpool, conn);
+        bundle = cpool_find_bundle(shard, conn);
         live = bundle ? Curl_llist_count(&bundle->conns) : 0;
       }
       shutdowns = Curl_cshutdn_dest_count(cpool->idata, conn->destination);
@@ -412,33 +628,34 @@ int Curl_cpool_check_limits(struct Curl_easy *data,
 
   if(total_limit) {
     shutdowns = Curl_cshutdn_count(cpool->idata);
-    while((cpool->num_conn + shutdowns) >= total_limit) {
+    while((cpool_num_conn(cpool) + shutdowns) >= total_limit) {
       if(shutdowns) {
         /* close one connection in shutdown right away, if we can */
         if(!Curl_cshutdn_close_oldest(data, NULL))
           break;
       }
       else {
-        struct connectdata *oldest_idle = cpool_get_oldest_idle(cpool);
+        struct connectdata *oldest_idle = cpool_get_oldest_idle(cpool, NULL);
         if(!oldest_idle)
           break;
         /* disconnect the old conn and continue */
         CURL_TRC_M(data, "Discarding connection #%"
                    FMT_OFF_T " from %zu to reach total "
                    "limit of %zu",
-                   oldest_idle->connection_id, cpool->num_conn, total_limit);
+                   oldest_idle->connection_id, cpool_num_conn(cpool),
+                   total_limit);
         Curl_conn_terminate(cpool->idata, oldest_idle, FALSE);
       }
       shutdowns = Curl_cshutdn_count(cpool->idata);
     }
-    if((cpool->num_conn + shutdowns) >= total_limit) {
+    if((cpool_num_conn(cpool) + shutdowns) >= total_limit) {
       result = CPOOL_LIMIT_TOTAL;
       goto out;
     }
   }
 
 out:
-  CPOOL_UNLOCK(cpool, cpool->idata);
+  cpool_unlock_all(cpool, cpool->idata);
   return result;
 }
 
@@ -448,16 +665,19 @@ CURLcode Curl_cpool_add(struct Curl_easy *data,
   CURLcode result = CURLE_OK;
   struct cpool_bundle *bundle = NULL;
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
+  size_t num_conn;
   DEBUGASSERT(conn);
 
   DEBUGASSERT(cpool);
   if(!cpool)
     return CURLE_FAILED_INIT;
 
-  CPOOL_LOCK(cpool, data);
-  bundle = cpool_find_bundle(cpool, conn);
+  shard = cpool_get_shard(cpool, conn->destination);
+  cpool_shard_lock(cpool, shard, data);
+  bundle = cpool_find_bundle(shard, conn);
   if(!bundle) {
-    bundle = cpool_add_bundle(cpool, conn);
+    bundle = cpool_add_bundle(shard, conn);
     if(!bundle) {
       result = CURLE_OUT_OF_MEMORY;
       goto out;
@@ -465,22 +685,24 @@ CURLcode Curl_cpool_add(struct Curl_easy *data,
   }
 
   cpool_bundle_add(bundle, conn);
+  cpool_count_lock(cpool);
   conn->connection_id = cpool->next_connection_id++;
-  cpool->num_conn++;
+  num_conn = ++cpool->num_conn;
+  cpool_count_unlock(cpool);
   CURL_TRC_M(data, "[CPOOL] added connection %" FMT_OFF_T ". "
              "The cache now contains %zu members",
-             conn->connection_id, cpool->num_conn);
+             conn->connection_id, num_conn);
 out:
-  CPOOL_UNLOCK(cpool, data);
+  cpool_shard_unlock(cpool, shard, data);
 
   return result;
 }
 
-/* This function iterates the entire connection pool and calls the function
-   func() with the connection pointer as the first argument and the supplied
-   'param' argument as the other.
+/* This function iterates the connections in the pool's shard and calls the
+   function func() with the connection pointer as the first argument and
+   the supplied 'param' argument as the other.
 
-   The cpool lock is still held when the callback is called. It needs it,
+   The shard's lock is still held when the callback is called. It needs it,
    so that it can safely continue traversing the lists once the callback
    returns.
 
@@ -488,19 +710,17 @@ out:
 
    Return 0 from func() to continue the loop, return 1 to abort it.
  */
-static bool cpool_foreach(struct Curl_easy *data,
-                          struct cpool *cpool,
-                          void *param,
-                          int (*func)(struct Curl_easy *data,
-                                      struct connectdata *conn, void *param))
+static bool cpool_shard_foreach(struct Curl_easy *data,
+                                struct cpool_shard *shard,
+                                void *param,
+                                int (*func)(struct Curl_easy *data,
+                                            struct connectdata *conn,
+                                            void *param))
 {
   struct Curl_hash_iterator iter;
   struct Curl_hash_element *he;
 
-  if(!cpool)
-    return FALSE;
-
-  Curl_hash_start_iterate(&cpool->dest2bundle, &iter);
+  Curl_hash_start_iterate(&shard->dest2bundle, &iter);
 
   he = Curl_hash_next_element(&iter);
   while(he) {
@@ -523,6 +743,26 @@ static bool cpool_foreach(struct Curl_easy *data,
   return FALSE;
 }
 
+/* Iterate all connections in the pool like cpool_shard_foreach(). All of
+   the pool is locked when this is called. */
+static bool cpool_foreach(struct Curl_easy *data,
+                          struct cpool *cpool,
+                          void *param,
+                          int (*func)(struct Curl_easy *data,
+                                      struct connectdata *conn, void *param))
+{
+  size_t i;
+
+  if(!cpool)
+    return FALSE;
+
+  for(i = 0; i < cpool->num_shards; ++i) {
+    if(cpool_shard_foreach(data, &cpool->shards[i], param, func))
+      return TRUE;
+  }
+  return FALSE;
+}
+
 /*
  * A connection (already in the pool) has become idle. Do any
  * cleanups in regard to the pool's limits.
@@ -532,30 +772,42 @@ static bool cpool_foreach(struct Curl_easy *data,
 bool Curl_cpool_conn_now_idle(struct Curl_easy *data,
                               struct connectdata *conn)
 {
-  unsigned int maxconnects = !data->multi->maxconnects ?
-    (Curl_multi_xfers_running(data->multi) * 4) : data->multi->maxconnects;
+  unsigned int maxconnects = data->multi->maxconnects;
   struct connectdata *oldest_idle = NULL;
   struct cpool *cpool = cpool_get_instance(data);
   bool kept = TRUE;
 
+  if(!maxconnects) {
+    maxconnects = Curl_multi_xfers_running(data->multi) * 4;
+    /* leave room for the connections kept warm */
+    if(maxconnects)
+      maxconnects += Curl_cprewarm_wanted(data->multi);
+  }
+
   conn->lastused = curlx_now(); /* it was used up until now */
   if(cpool && maxconnects) {
+    struct cpool_shard *shard = cpool_get_shard(cpool, conn->destination);
     /* may be called form a callback already under lock */
-    bool do_lock = !CPOOL_IS_LOCKED(cpool);
+    bool do_lock = !cpool_shard_is_locked(cpool, shard, data);
+    size_t num_conn;
     if(do_lock)
-      CPOOL_LOCK(cpool, data);
-    if(cpool->num_conn > maxconnects) {
+      cpool_shard_lock(cpool, shard, data);
+    num_conn = cpool_num_conn(cpool);
+    if(num_conn > maxconnects) {
       infof(data, "Connection pool is full, closing the oldest of %zu/%u",
-            cpool->num_conn, maxconnects);
+            num_conn, maxconnects);
 
-      oldest_idle = cpool_get_oldest_idle(cpool);
+      /* Only the shard of this connection is locked in a sharded pool,
+       * discard the oldest there. */
+      oldest_idle = cpool_get_oldest_idle(cpool, CPOOL_SHARDED(cpool) ?
+                                          shard : NULL);
       kept = (oldest_idle != conn);
       if(oldest_idle) {
         Curl_conn_terminate(data, oldest_idle, FALSE);
       }
     }
     if(do_lock)
-      CPOOL_UNLOCK(cpool, data);
+      cpool_shard_unlock(cpool, shard, data);
   }
 
   return kept;
@@ -568,6 +820,7 @@ bool Curl_cpool_find(struct Curl_easy *data,
                      void *userdata)
 {
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
   struct cpool_bundle *bundle;
   bool result = FALSE;
 
@@ -576,8 +829,9 @@ bool Curl_cpool_find(struct Curl_easy *data,
   if(!cpool)
     return FALSE;
 
-  CPOOL_LOCK(cpool, data);
-  bundle = Curl_hash_pick(&cpool->dest2bundle,
+  shard = cpool_get_shard(cpool, destination);
+  cpool_shard_lock(cpool, shard, data);
+  bundle = Curl_hash_pick(&shard->dest2bundle,
                           CURL_UNCONST(destination),
                           strlen(destination) + 1);
   if(bundle) {
@@ -597,7 +851,7 @@ bool Curl_cpool_find(struct Curl_easy *data,
   if(done_cb) {
     result = done_cb(result, userdata);
   }
-  CPOOL_UNLOCK(cpool, data);
+  cpool_shard_unlock(cpool, shard, data);
   return result;
 }
 
@@ -653,6 +907,7 @@ void Curl_conn_terminate(struct Curl_easy *data,
                          bool aborted)
 {
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
   bool do_lock;
 
   DEBUGASSERT(cpool);
@@ -670,12 +925,13 @@ void Curl_conn_terminate(struct Curl_easy *data,
 
   /* This method may be called while we are under lock, e.g. from a
    * user callback in find. */
-  do_lock = !CPOOL_IS_LOCKED(cpool);
+  shard = cpool_get_shard(cpool, conn->destination);
+  do_lock = !cpool_shard_is_locked(cpool, shard, data);
   if(do_lock)
-    CPOOL_LOCK(cpool, data);
+    cpool_shard_lock(cpool, shard, data);
 
   if(conn->bits.in_cpool) {
-    cpool_remove_conn(cpool, conn);
+    cpool_remove_conn(cpool, shard, conn);
     DEBUGASSERT(!conn->bits.in_cpool);
   }
 
@@ -697,7 +953,7 @@ void Curl_conn_terminate(struct Curl_easy *data,
   }
 
   if(do_lock)
-    CPOOL_UNLOCK(cpool, data);
+    cpool_shard_unlock(cpool, shard, data);
 }
 
 
@@ -723,27 +979,32 @@ static int cpool_reap_dead_cb(struct Curl_easy *data,
  * connections, closes and removes them.
  * The cleanup is done at most once per second.
  *
+ * In a sharded pool, each call checks one shard only, so transfers do not
+ * lock all of the pool for this. Which shard depends on the transfer.
+ *
  * When called, this transfer has no connection attached.
  */
 void Curl_cpool_prune_dead(struct Curl_easy *data)
 {
   struct cpool *cpool = cpool_get_instance(data);
+  struct cpool_shard *shard;
   struct cpool_reaper_ctx rctx;
   timediff_t elapsed;
 
   if(!cpool)
     return;
 
+  shard = &cpool->shards[(size_t)data->id % cpool->num_shards];
   rctx.now = curlx_now();
-  CPOOL_LOCK(cpool, data);
-  elapsed = curlx_timediff(rctx.now, cpool->last_cleanup);
+  cpool_shard_lock(cpool, shard, data);
+  elapsed = curlx_timediff(rctx.now, shard->last_cleanup);
 
   if(elapsed >= 1000L) {
-    while(cpool_foreach(data, cpool, &rctx, cpool_reap_dead_cb))
+    while(cpool_shard_foreach(data, shard, &rctx, cpool_reap_dead_cb))
       ;
-    cpool->last_cleanup = rctx.now;
+    shard->last_cleanup = rctx.now;
   }
-  CPOOL_UNLOCK(cpool, data);
+  cpool_shard_unlock(cpool, shard, data);
 }
 
 static int conn_upkeep(struct Curl_easy *data,
@@ -763,9 +1024,9 @@ CURLcode Curl_cpool_upkeep(void *data)
   if(!cpool)
     return CURLE_OK;
 
-  CPOOL_LOCK(cpool, data);
+  cpool_lock_all(cpool, data);
   cpool_foreach(data, cpool, &now, conn_upkeep);
-  CPOOL_UNLOCK(cpool, data);
+  cpool_unlock_all(cpool, data);
   return CURLE_OK;
 }
 
@@ -796,9 +1057,9 @@ struct connectdata *Curl_cpool_get_conn(struct Curl_easy *data,
     return NULL;
   fctx.id = conn_id;
   fctx.conn = NULL;
-  CPOOL_LOCK(cpool, data);
+  cpool_lock_all(cpool, data);
   cpool_foreach(data, cpool, &fctx, cpool_find_conn);
-  CPOOL_UNLOCK(cpool, data);
+  cpool_unlock_all(cpool, data);
   return fctx.conn;
 }
 
@@ -831,9 +1092,9 @@ void Curl_cpool_do_by_id(struct Curl_easy *data, curl_off_t conn_id,
   dctx.id = conn_id;
   dctx.cb = cb;
   dctx.cbdata = cbdata;
-  CPOOL_LOCK(cpool, data);
+  cpool_lock_all(cpool, data);
   cpool_foreach(data, cpool, &dctx, cpool_do_conn);
-  CPOOL_UNLOCK(cpool, data);
+  cpool_unlock_all(cpool, data);
 }
 
 void Curl_cpool_do_locked(struct Curl_easy *data,
@@ -842,9 +1103,10 @@ void Curl_cpool_do_locked(struct Curl_easy *data,
 {
   struct cpool *cpool = cpool_get_instance(data);
   if(cpool) {
-    CPOOL_LOCK(cpool, data);
+    struct cpool_shard *shard = cpool_get_shard(cpool, conn->destination);
+    cpool_shard_lock(cpool, shard, data);
     cb(conn, data, cbdata);
-    CPOOL_UNLOCK(cpool, data);
+    cpool_shard_unlock(cpool, shard, data);
   }
   else
     cb(conn, data, cbdata);
@@ -876,11 +1138,11 @@ void Curl_cpool_nw_changed(struct Curl_easy *data)
   struct cpool *cpool = cpool_get_instance(data);
 
   if(cpool) {
-    CPOOL_LOCK(cpool, data);
+    cpool_lock_all(cpool, data);
     cpool_foreach(data, cpool, NULL, cpool_mark_stale);
     while(cpool_foreach(data, cpool, NULL, cpool_reap_no_reuse))
       ;
-    CPOOL_UNLOCK(cpool, data);
+    cpool_unlock_all(cpool, data);
   }
 }
 
@@ -27,6 +27,7 @@
 
 #include <curl/curl.h>
 #include "curlx/timeval.h"
+#include "curl_threads.h"
 
 struct connectdata;
 struct Curl_easy;
@@ -48,26 +49,39 @@ void Curl_conn_terminate(struct Curl_easy *data,
                          struct connectdata *conn,
                          bool aborted);
 
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+/* A pool in a share is split into this many shards by destination, each
+ * with its own lock. Transfers in different threads then only wait on each
+ * other when their connections are in the same shard. */
+#define CPOOL_SHARDS 16
+#endif
+
+struct cpool_shard;
+
 struct cpool {
-   /* the pooled connections, bundled per destination */
-  struct Curl_hash dest2bundle;
+   /* the pooled connections, bundled per destination, in shards */
+  struct cpool_shard *shards;
+  size_t num_shards;
   size_t num_conn;
   curl_off_t next_connection_id;
   curl_off_t next_easy_id;
-  struct curltime last_cleanup;
   struct Curl_easy *idata; /* internal handle for maintenance */
   struct Curl_share *share; /* != NULL if pool belongs to share */
+#ifdef CPOOL_SHARDS
+  curl_mutex_t lock; /* for the counters of a sharded pool */
+#endif
   BIT(locked);
   BIT(initialised);
 };
 
-/* Init the pool, pass multi only if pool is owned by it.
- * Cannot fail.
+/* Init the pool, pass share only if pool is owned by it. A shared pool
+ * is sharded when curl is built with thread support and then locks its
+ * shards itself instead of using the share's CURL_LOCK_DATA_CONNECT lock.
  */
-void Curl_cpool_init(struct cpool *cpool,
-                     struct Curl_easy *idata,
-                     struct Curl_share *share,
-                     size_t size);
+CURLcode Curl_cpool_init(struct cpool *cpool,
+                         struct Curl_easy *idata,
+                         struct Curl_share *share,
+                         size_t size);
 
 /* Destroy all connections and free all members */
 void Curl_cpool_destroy(struct cpool *connc);
@@ -51,6 +51,7 @@
 #include "sendf.h"
 #include "http.h"
 #include "content_encoding.h"
+#include "multihandle.h"
 #include "strdup.h"
 
 /* The last 3 #include files should be in this order */
@@ -69,6 +70,22 @@
 #define DECOMPRESS_BUFFER_SIZE 16384 /* buffer size for decompressed data */
 #endif
 
+#if defined(HAVE_LIBZ) || defined(HAVE_ZSTD)
+/* The multi's cache of decoder states or NULL. With `create` set, it is
+   allocated when there is none yet. */
+static struct Curl_decoder_cache *decoder_cache(struct Curl_easy *data,
+                                                bool create)
+{
+  struct Curl_multi *multi = data->multi;
+
+  if(!multi)
+    return NULL;
+  if(!multi->decoders && create)
+    multi->decoders = calloc(1, sizeof(*multi->decoders));
+  return multi->decoders;
+}
+#endif
+
 #ifdef HAVE_LIBZ
 
 #if !defined(ZLIB_VERNUM) || (ZLIB_VERNUM < 0x1252)
@@ -89,7 +106,7 @@ struct zlib_writer {
   zlibInitState zlib_init;   /* zlib init state */
   char buffer[DECOMPRESS_BUFFER_SIZE]; /* Put the decompressed data here. */
   uInt trailerlen;           /* Remaining trailer byte count. */
-  z_stream z;                /* State structure for zlib. */
+  z_stream *z;               /* State structure for zlib. */
 };
 
 
@@ -121,23 +138,65 @@ process_zlib_error(struct Curl_easy *data, z_stream *z)
   return CURLE_BAD_CONTENT_ENCODING;
 }
 
-static CURLcode
-exit_zlib(struct Curl_easy *data,
-          z_stream *z, zlibInitState *zlib_init, CURLcode result)
+/* Get an inflate state from the multi's cache or make a new one. */
+static CURLcode zlib_take(struct Curl_easy *data, struct zlib_writer *zp,
+                          int window_bits)
 {
-  if(*zlib_init != ZLIB_UNINIT) {
-    if(inflateEnd(z) != Z_OK && result == CURLE_OK)
-      result = process_zlib_error(data, z);
-    *zlib_init = ZLIB_UNINIT;
+  struct Curl_decoder_cache *dc = decoder_cache(data, FALSE);
+  z_stream *z;
+
+  while(dc && dc->zlib_count) {
+    z = dc->zlib[--dc->zlib_count];
+    if(inflateReset2(z, window_bits) == Z_OK) {
+      zp->z = z;
+      return CURLE_OK;
+    }
+    inflateEnd(z);
+    free(z);
   }
 
+  z = calloc(1, sizeof(*z));
+  if(!z)
+    return CURLE_OUT_OF_MEMORY;
+  z->zalloc = (alloc_func) zalloc_cb;
+  z->zfree = (free_func) zfree_cb;
+  if(inflateInit2(z, window_bits) != Z_OK) {
+    CURLcode result = process_zlib_error(data, z);
+    free(z);
+    return result;
+  }
+  zp->z = z;
+  return CURLE_OK;
+}
+
+/* Keep the writer's inflate state in the multi's cache or free it. */
+static void zlib_release(struct Curl_easy *data, struct zlib_writer *zp)
+{
+  struct Curl_decoder_cache *dc;
+
+  if(!zp->z)
+    return;
+  dc = decoder_cache(data, TRUE);
+  if(dc && (dc->zlib_count < CURL_DECODER_CACHE_MAX))
+    dc->zlib[dc->zlib_count++] = zp->z;
+  else {
+    inflateEnd(zp->z);
+    free(zp->z);
+  }
+  zp->z = NULL;
+  zp->zlib_init = ZLIB_UNINIT;
+}
+
+/* Stop inflating. The inflate state is released when the writer closes. */
+static CURLcode exit_zlib(zlibInitState *zlib_init, CURLcode result)
+{
+  *zlib_init = ZLIB_UNINIT;
   return result;
 }
 
-static CURLcode process_trailer(struct Curl_easy *data,
-                                struct zlib_writer *zp)
+static CURLcode process_trailer(struct zlib_writer *zp)
 {
-  z_stream *z = &zp->z;
+  z_stream *z = zp->z;
   CURLcode result = CURLE_OK;
   uInt len = z->avail_in < zp->trailerlen ? z->avail_in : zp->trailerlen;
 
@@ -150,7 +209,7 @@ static CURLcode process_trailer(struct Curl_easy *data,
   if(z->avail_in)
     result = CURLE_WRITE_ERROR;
   if(result || !zp->trailerlen)
-    result = exit_zlib(data, z, &zp->zlib_init, result);
+    result = exit_zlib(&zp->zlib_init, result);
   else {
     /* Only occurs for gzip with zlib < 1.2.0.4 or raw deflate. */
     zp->zlib_init = ZLIB_EXTERNAL_TRAILER;
@@ -163,7 +222,7 @@ static CURLcode inflate_stream(struct Curl_easy *data,
                                zlibInitState started)
 {
   struct zlib_writer *zp = (struct zlib_writer *) writer;
-  z_stream *z = &zp->z;         /* zlib state structure */
+  z_stream *z = zp->z;          /* zlib state structure */
   uInt nread = z->avail_in;
   z_const Bytef *orig_in = z->next_in;
   bool done = FALSE;
@@ -173,7 +232,7 @@ static CURLcode inflate_stream(struct Curl_easy *data,
   if(zp->zlib_init != ZLIB_INIT &&
      zp->zlib_init != ZLIB_INFLATING &&
      zp->zlib_init != ZLIB_INIT_GZIP)
-    return exit_zlib(data, z, &zp->zlib_init, CURLE_WRITE_ERROR);
+    return exit_zlib(&zp->zlib_init, CURLE_WRITE_ERROR);
 
   /* because the buffer size is fixed, iteratively decompress and transfer to
      the client via next_write function. */
@@ -194,7 +253,7 @@ static CURLcode inflate_stream(struct Curl_easy *data,
         result = Curl_cwriter_write(data, writer->next, type, zp->buffer,
                                     DECOMPRESS_BUFFER_SIZE - z->avail_out);
         if(result) {
-          exit_zlib(data, z, &zp->zlib_init, result);
+          exit_zlib(&zp->zlib_init, result);
           break;
         }
       }
@@ -210,7 +269,7 @@ static CURLcode inflate_stream(struct Curl_easy *data,
       /* No more data to flush: just exit loop. */
       break;
     case Z_STREAM_END:
-      result = process_trailer(data, zp);
+      result = process_trailer(zp);
       break;
     case Z_DATA_ERROR:
       /* some servers seem to not generate zlib headers, so this is an attempt
@@ -224,12 +283,12 @@ static CURLcode inflate_stream(struct Curl_easy *data,
           done = FALSE;
           break;
         }
-        zp->zlib_init = ZLIB_UNINIT;    /* inflateEnd() already called. */
+        zp->zlib_init = ZLIB_UNINIT;
       }
-      result = exit_zlib(data, z, &zp->zlib_init, process_zlib_error(data, z));
+      result = exit_zlib(&zp->zlib_init, process_zlib_error(data, z));
       break;
     default:
-      result = exit_zlib(data, z, &zp->zlib_init, process_zlib_error(data, z));
+      result = exit_zlib(&zp->zlib_init, process_zlib_error(data, z));
       break;
     }
   }
@@ -249,14 +308,12 @@ static CURLcode deflate_do_init(struct Curl_easy *data,
                                 struct Curl_cwriter *writer)
 {
   struct zlib_writer *zp = (struct zlib_writer *) writer;
-  z_stream *z = &zp->z;     /* zlib state structure */
+  CURLcode result;
 
   /* Initialize zlib */
-  z->zalloc = (alloc_func) zalloc_cb;
-  z->zfree = (free_func) zfree_cb;
-
-  if(inflateInit(z) != Z_OK)
-    return process_zlib_error(data, z);
+  result = zlib_take(data, zp, MAX_WBITS);
+  if(result)
+    return result;
   zp->zlib_init = ZLIB_INIT;
   return CURLE_OK;
 }
@@ -266,7 +323,7 @@ static CURLcode deflate_do_write(struct Curl_easy *data,
                                  const char *buf, size_t nbytes)
 {
   struct zlib_writer *zp = (struct zlib_writer *) writer;
-  z_stream *z = &zp->z;     /* zlib state structure */
+  z_stream *z = zp->z;      /* zlib state structure */
 
   if(!(type & CLIENTWRITE_BODY) || !nbytes)
     return Curl_cwriter_write(data, writer->next, type, buf, nbytes);
@@ -276,7 +333,7 @@ static CURLcode deflate_do_write(struct Curl_easy *data,
   z->avail_in = (uInt)nbytes;
 
   if(zp->zlib_init == ZLIB_EXTERNAL_TRAILER)
-    return process_trailer(data, zp);
+    return process_trailer(zp);
 
   /* Now uncompress the data */
   return inflate_stream(data, writer, type, ZLIB_INFLATING);
@@ -286,9 +343,8 @@ static void deflate_do_close(struct Curl_easy *data,
                              struct Curl_cwriter *writer)
 {
   struct zlib_writer *zp = (struct zlib_writer *) writer;
-  z_stream *z = &zp->z;     /* zlib state structure */
 
-  exit_zlib(data, z, &zp->zlib_init, CURLE_OK);
+  zlib_release(data, zp);
 }
 
 static const struct Curl_cwtype deflate_encoding = {
@@ -306,14 +362,12 @@ static CURLcode gzip_do_init(struct Curl_easy *data,
                              struct Curl_cwriter *writer)
 {
   struct zlib_writer *zp = (struct zlib_writer *) writer;
-  z_stream *z = &zp->z;     /* zlib state structure */
+  CURLcode result;
 
   /* Initialize zlib */
-  z->zalloc = (alloc_func) zalloc_cb;
-  z->zfree = (free_func) zfree_cb;
-
-  if(inflateInit2(z, MAX_WBITS + 32) != Z_OK)
-    return process_zlib_error(data, z);
+  result = zlib_take(data, zp, MAX_WBITS + 32);
+  if(result)
+    return result;
 
   zp->zlib_init = ZLIB_INIT_GZIP; /* Transparent gzip decompress state */
   return CURLE_OK;
@@ -324,7 +378,7 @@ static CURLcode gzip_do_write(struct Curl_easy *data,
                               const char *buf, size_t nbytes)
 {
   struct zlib_writer *zp = (struct zlib_writer *) writer;
-  z_stream *z = &zp->z;     /* zlib state structure */
+  z_stream *z = zp->z;      /* zlib state structure */
 
   if(!(type & CLIENTWRITE_BODY) || !nbytes)
     return Curl_cwriter_write(data, writer->next, type, buf, nbytes);
@@ -338,16 +392,15 @@ static CURLcode gzip_do_write(struct Curl_easy *data,
   }
 
   /* We are running with an old version: return error. */
-  return exit_zlib(data, z, &zp->zlib_init, CURLE_WRITE_ERROR);
+  return exit_zlib(&zp->zlib_init, CURLE_WRITE_ERROR);
 }
 
 static void gzip_do_close(struct Curl_easy *data,
                           struct Curl_cwriter *writer)
 {
   struct zlib_writer *zp = (struct zlib_writer *) writer;
-  z_stream *z = &zp->z;     /* zlib state structure */
 
-  exit_zlib(data, z, &zp->zlib_init, CURLE_OK);
+  zlib_release(data, zp);
 }
 
 static const struct Curl_cwtype gzip_encoding = {
@@ -510,8 +563,15 @@ static CURLcode zstd_do_init(struct Curl_easy *data,
                              struct Curl_cwriter *writer)
 {
   struct zstd_writer *zp = (struct zstd_writer *) writer;
+  struct Curl_decoder_cache *dc = decoder_cache(data, FALSE);
 
-  (void)data;
+  while(dc && dc->zstd_count) {
+    zp->zds = dc->zstd[--dc->zstd_count];
+    if(!ZSTD_isError(ZSTD_initDStream(zp->zds)))
+      return CURLE_OK;
+    ZSTD_freeDStream(zp->zds);
+    zp->zds = NULL;
+  }
 
 #ifdef ZSTD_STATIC_LINKING_ONLY
   zp->zds = ZSTD_createDStream_advanced((ZSTD_customMem) {
@@ -569,10 +629,13 @@ static void zstd_do_close(struct Curl_easy *data,
                           struct Curl_cwriter *writer)
 {
   struct zstd_writer *zp = (struct zstd_writer *) writer;
-  (void)data;
 
   if(zp->zds) {
-    ZSTD_freeDStream(zp->zds);
+    struct Curl_decoder_cache *dc = decoder_cache(data, TRUE);
+    if(dc && (dc->zstd_count < CURL_DECODER_CACHE_MAX))
+      dc->zstd[dc->zstd_count++] = zp->zds;
+    else
+      ZSTD_freeDStream(zp->zds);
     zp->zds = NULL;
   }
 }
@@ -838,6 +901,24 @@ CURLcode Curl_build_unencoding_stack(struct Curl_easy *data,
   return CURLE_OK;
 }
 
+void Curl_decoder_cache_destroy(struct Curl_decoder_cache *dc)
+{
+  if(!dc)
+    return;
+#ifdef HAVE_LIBZ
+  while(dc->zlib_count) {
+    z_stream *z = dc->zlib[--dc->zlib_count];
+    inflateEnd(z);
+    free(z);
+  }
+#endif
+#ifdef HAVE_ZSTD
+  while(dc->zstd_count)
+    ZSTD_freeDStream(dc->zstd[--dc->zstd_count]);
+#endif
+  free(dc);
+}
+
 #else
 /* Stubs for builds without HTTP. */
 CURLcode Curl_build_unencoding_stack(struct Curl_easy *data,
@@ -859,4 +940,9 @@ void Curl_all_content_encodings(char *buf, size_t blen)
     strcpy(buf, CONTENT_ENCODING_DEFAULT);
 }
 
+void Curl_decoder_cache_destroy(struct Curl_decoder_cache *dc)
+{
+  free(dc);
+}
+
 #endif /* CURL_DISABLE_HTTP */
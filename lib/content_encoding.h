@@ -26,6 +26,24 @@
 #include "curl_setup.h"
 
 struct Curl_cwriter;
+struct Curl_easy;
+
+/* Maximum number of decoder states of each kind kept for reuse */
+#define CURL_DECODER_CACHE_MAX 8
+
+/* Decoder states of finished transfers, kept by a multi handle and reset
+   for reuse by later transfers. This saves setting up the decoder and
+   allocating its window again for every compressed response. The multi
+   allocates the cache when the first state is put into it. */
+struct Curl_decoder_cache {
+  void *zlib[CURL_DECODER_CACHE_MAX]; /* z_stream, inflate initialized */
+  void *zstd[CURL_DECODER_CACHE_MAX]; /* ZSTD_DStream */
+  unsigned char zlib_count;
+  unsigned char zstd_count;
+};
+
+/* Free the cached states and the cache itself, which may be NULL. */
+void Curl_decoder_cache_destroy(struct Curl_decoder_cache *dc);
 
 void Curl_all_content_encodings(char *buf, size_t blen);
 
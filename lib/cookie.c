@@ -75,6 +75,7 @@ Example set of cookies:
 
 #include "urldata.h"
 #include "cookie.h"
+#include "binstore.h"
 #include "psl.h"
 #include "sendf.h"
 #include "slist.h"
@@ -96,6 +97,13 @@ Example set of cookies:
 
 static void strstore(char **str, const char *newstr, size_t len);
 
+/* binary store record fields: flags, path, expires, name, value and the
+   order of creation. The key is the domain. */
+#define COOKIE_BIN_FMT "isissi"
+#define COOKIE_BIN_TAILMATCH (1<<0)
+#define COOKIE_BIN_SECURE    (1<<1)
+#define COOKIE_BIN_HTTPONLY  (1<<2)
+
 /* number of seconds in 400 days */
 #define COOKIES_MAXAGE (400*24*3600)
 
@@ -118,11 +126,16 @@ static void cap_expires(time_t now, struct Cookie *co)
 
 static void freecookie(struct Cookie *co)
 {
-  free(co->domain);
-  free(co->path);
-  free(co->spath);
-  free(co->name);
-  free(co->value);
+  if(co->strings)
+    /* the strings were allocated together */
+    free(co->strings);
+  else {
+    free(co->domain);
+    free(co->path);
+    free(co->spath);
+    free(co->name);
+    free(co->value);
+  }
   free(co);
 }
 
@@ -155,62 +168,6 @@ static bool cookie_tailmatch(const char *cookie_domain,
   return FALSE;
 }
 
-/*
- * matching cookie path and URL path
- * RFC6265 5.1.4 Paths and Path-Match
- */
-static bool pathmatch(const char *cookie_path, const char *uri_path)
-{
-  size_t cookie_path_len;
-  size_t uri_path_len;
-  bool ret = FALSE;
-
-  /* cookie_path must not have last '/' separator. ex: /sample */
-  cookie_path_len = strlen(cookie_path);
-  if(cookie_path_len == 1) {
-    /* cookie_path must be '/' */
-    return TRUE;
-  }
-
-  /* #-fragments are already cut off! */
-  if(strlen(uri_path) == 0 || uri_path[0] != '/')
-    uri_path = "/";
-
-  /*
-   * here, RFC6265 5.1.4 says
-   *  4. Output the characters of the uri-path from the first character up
-   *     to, but not including, the right-most %x2F ("/").
-   *  but URL path /hoge?fuga=xxx means /hoge/index.cgi?fuga=xxx in some site
-   *  without redirect.
-   *  Ignore this algorithm because /hoge is uri path for this case
-   *  (uri path is not /).
-   */
-
-  uri_path_len = strlen(uri_path);
-
-  if(uri_path_len < cookie_path_len)
-    goto pathmatched;
-
-  /* not using checkprefix() because matching should be case-sensitive */
-  if(strncmp(cookie_path, uri_path, cookie_path_len))
-    goto pathmatched;
-
-  /* The cookie-path and the uri-path are identical. */
-  if(cookie_path_len == uri_path_len) {
-    ret = TRUE;
-    goto pathmatched;
-  }
-
-  /* here, cookie_path_len < uri_path_len */
-  if(uri_path[cookie_path_len] == '/') {
-    ret = TRUE;
-    goto pathmatched;
-  }
-
-pathmatched:
-  return ret;
-}
-
 /*
  * Return the top-level domain, for optimal hashing.
  */
@@ -254,7 +211,7 @@ static size_t cookie_hash_domain(const char *domain, const size_t len)
     h ^= j;
   }
 
-  return (h % COOKIE_HASH_SIZE);
+  return h;
 }
 
 #if defined(_MSC_VER) && (_MSC_VER == 1900)
@@ -262,29 +219,317 @@ static size_t cookie_hash_domain(const char *domain, const size_t len)
 #endif
 
 /*
- * Hash this domain.
+ * The cookie jar index.
+ *
+ * Cookies are kept per domain, in a hash table of domains that doubles its
+ * number of slots when it holds more domains than slots. Each domain has a
+ * tree of its cookie paths, one node per path segment. A node holds the
+ * cookies whose sanitized path ends at it, the root holds the cookies for
+ * "/". Finding the cookies for a request only visits the domains the host
+ * can match and the path nodes along the request path.
+ *
+ * Path and domain nodes are freed when their last cookie is removed.
  */
-static size_t cookiehash(const char * const domain)
-{
-  const char *top;
+struct cookie_path {
+  struct Curl_llist_node node; /* in the parent's list of children */
+  struct cookie_path *parent;  /* NULL for the root */
+  struct cookie_domain *dom;   /* the domain this path belongs to */
+  struct Curl_llist children;  /* the paths one segment longer */
+  struct Curl_llist cookies;   /* cookies with exactly this path */
+  size_t seglen;
+  char seg[1];                 /* path segment, allocated with the struct */
+};
+
+struct cookie_domain {
+  struct cookie_domain *next;  /* next domain in the same hash slot */
+  struct Curl_llist cookies;   /* all cookies for this domain */
+  struct cookie_path *root;
+  size_t hash;
   size_t len;
+  char name[1];                /* domain, allocated with the struct */
+};
+
+static struct cookie_path *cookie_path_create(struct cookie_domain *dom,
+                                              struct cookie_path *parent,
+                                              const char *seg, size_t len)
+{
+  struct cookie_path *p = malloc(sizeof(*p) + len);
+  if(!p)
+    return NULL;
+  p->parent = parent;
+  p->dom = dom;
+  Curl_llist_init(&p->children, NULL);
+  Curl_llist_init(&p->cookies, NULL);
+  p->seglen = len;
+  memcpy(p->seg, seg, len);
+  p->seg[len] = 0;
+  if(parent)
+    Curl_llist_append(&parent->children, p, &p->node);
+  return p;
+}
+
+static struct cookie_path *cookie_path_child(struct cookie_path *p,
+                                             const char *seg, size_t len)
+{
+  struct Curl_llist_node *n;
+  for(n = Curl_llist_head(&p->children); n; n = Curl_node_next(n)) {
+    struct cookie_path *c = Curl_node_elem(n);
+    /* paths match case-sensitively */
+    if((c->seglen == len) && !memcmp(c->seg, seg, len))
+      return c;
+  }
+  return NULL;
+}
+
+/* Free the path node and its parents as long as they are left empty. */
+static void cookie_path_prune(struct cookie_path *p)
+{
+  while(p->parent && !Curl_llist_count(&p->cookies) &&
+        !Curl_llist_count(&p->children)) {
+    struct cookie_path *parent = p->parent;
+    Curl_node_remove(&p->node);
+    free(p);
+    p = parent;
+  }
+}
+
+/* Return the index node for a sanitized cookie path, create it and its
+   parents if needed. Returns NULL on out of memory. */
+static struct cookie_path *cookie_path_get(struct cookie_domain *dom,
+                                           const char *spath)
+{
+  struct cookie_path *p = dom->root;
+
+  if(!spath || !spath[0] || !spath[1])
+    return p; /* no path or "/" */
+
+  spath++;
+  for(;;) {
+    const char *end = strchr(spath, '/');
+    size_t len = end ? (size_t)(end - spath) : strlen(spath);
+    struct cookie_path *c = cookie_path_child(p, spath, len);
+    if(!c) {
+      c = cookie_path_create(dom, p, spath, len);
+      if(!c) {
+        cookie_path_prune(p);
+        return NULL;
+      }
+    }
+    p = c;
+    if(!end)
+      break;
+    spath = end + 1;
+  }
+  return p;
+}
+
+static struct cookie_domain *cookie_domain_find(struct CookieInfo *ci,
+                                                const char *domain,
+                                                size_t len)
+{
+  struct cookie_domain *dom;
+  size_t hash;
+
+  if(!ci->nslots)
+    return NULL;
+  hash = cookie_hash_domain(domain, len);
+  for(dom = ci->domains[hash & (ci->nslots - 1)]; dom; dom = dom->next) {
+    if((dom->hash == hash) && (dom->len == len) &&
+       curl_strnequal(dom->name, domain, len))
+      return dom;
+  }
+  return NULL;
+}
+
+/* Double the number of slots in the domain hash. When this fails the hash
+   keeps working with longer chains. */
+static void cookie_domains_grow(struct CookieInfo *ci)
+{
+  size_t nslots = ci->nslots ? ci->nslots * 2 : COOKIE_HASH_SIZE;
+  struct cookie_domain **slots = calloc(nslots, sizeof(*slots));
+  size_t i;
+
+  if(!slots)
+    return;
+  for(i = 0; i < ci->nslots; i++) {
+    struct cookie_domain *dom = ci->domains[i];
+    while(dom) {
+      struct cookie_domain *next = dom->next;
+      size_t slot = dom->hash & (nslots - 1);
+      dom->next = slots[slot];
+      slots[slot] = dom;
+      dom = next;
+    }
+  }
+  free(ci->domains);
+  ci->domains = slots;
+  ci->nslots = nslots;
+}
+
+/* Return the index entry for a cookie domain, create it if needed. A NULL
+   domain has its own entry outside of the hash. Returns NULL on out of
+   memory. */
+static struct cookie_domain *cookie_domain_get(struct CookieInfo *ci,
+                                               const char *domain)
+{
+  struct cookie_domain *dom;
+  size_t len = domain ? strlen(domain) : 0;
+
+  if(!domain) {
+    if(ci->nodomain)
+      return ci->nodomain;
+  }
+  else {
+    dom = cookie_domain_find(ci, domain, len);
+    if(dom)
+      return dom;
+    if(ci->ndomains >= ci->nslots)
+      cookie_domains_grow(ci);
+    if(!ci->nslots)
+      return NULL;
+  }
+
+  dom = malloc(sizeof(*dom) + len);
+  if(!dom)
+    return NULL;
+  dom->next = NULL;
+  Curl_llist_init(&dom->cookies, NULL);
+  dom->hash = cookie_hash_domain(domain ? domain : "", len);
+  dom->len = len;
+  if(len)
+    memcpy(dom->name, domain, len);
+  dom->name[len] = 0;
+  dom->root = cookie_path_create(dom, NULL, "", 0);
+  if(!dom->root) {
+    free(dom);
+    return NULL;
+  }
+
+  if(!domain)
+    ci->nodomain = dom;
+  else {
+    size_t slot = dom->hash & (ci->nslots - 1);
+    dom->next = ci->domains[slot];
+    ci->domains[slot] = dom;
+    ci->ndomains++;
+  }
+  return dom;
+}
+
+static void cookie_domain_remove(struct CookieInfo *ci,
+                                 struct cookie_domain *dom)
+{
+  if(dom == ci->nodomain)
+    ci->nodomain = NULL;
+  else {
+    struct cookie_domain **pp = &ci->domains[dom->hash & (ci->nslots - 1)];
+    while(*pp != dom)
+      pp = &(*pp)->next;
+    *pp = dom->next;
+    ci->ndomains--;
+  }
+  free(dom->root);
+  free(dom);
+}
 
-  if(!domain || Curl_host_is_ipnum(domain))
-    return 0;
+/*
+ * Iterate over all domains in the jar, the one for cookies without a domain
+ * last. The current domain may be removed as long as the next one is
+ * fetched before that.
+ */
+static struct cookie_domain *cookie_domain_next(struct CookieInfo *ci,
+                                                struct cookie_domain *dom,
+                                                size_t *slotp)
+{
+  size_t slot;
+
+  if(dom) {
+    if(dom == ci->nodomain)
+      return NULL;
+    if(dom->next)
+      return dom->next;
+    slot = *slotp + 1;
+  }
+  else
+    slot = 0;
+
+  for(; slot < ci->nslots; slot++) {
+    if(ci->domains[slot]) {
+      *slotp = slot;
+      return ci->domains[slot];
+    }
+  }
+  *slotp = ci->nslots;
+  return ci->nodomain;
+}
+
+/* Add a cookie to the index. Returns FALSE on out of memory. */
+static bool cookie_link(struct CookieInfo *ci, struct Cookie *co)
+{
+  struct cookie_domain *dom = cookie_domain_get(ci, co->domain);
+  struct cookie_path *p;
 
-  top = get_top_domain(domain, &len);
-  return cookie_hash_domain(top, len);
+  if(!dom)
+    return FALSE;
+  p = cookie_path_get(dom, co->spath);
+  if(!p) {
+    if(!Curl_llist_count(&dom->cookies))
+      cookie_domain_remove(ci, dom);
+    return FALSE;
+  }
+  Curl_llist_append(&dom->cookies, co, &co->node);
+  Curl_llist_append(&p->cookies, co, &co->pathnode);
+  co->pidx = p;
+  return TRUE;
+}
+
+/* Remove a cookie from the index and free index nodes left empty. */
+static void cookie_unlink(struct CookieInfo *ci, struct Cookie *co)
+{
+  struct cookie_path *p = co->pidx;
+  struct cookie_domain *dom = p->dom;
+
+  Curl_node_remove(&co->node);
+  Curl_node_remove(&co->pathnode);
+  co->pidx = NULL;
+
+  cookie_path_prune(p);
+  if(!Curl_llist_count(&dom->cookies))
+    cookie_domain_remove(ci, dom);
+}
+
+/*
+ * Remove a cookie from the jar and free it. If the cookie jar file is
+ * journaled and may still have the cookie, set by 'written', the cookie is
+ * kept with an expiry in the past and appended as a removal on the next
+ * write.
+ */
+static void cookie_remove(struct CookieInfo *ci, struct Cookie *co,
+                          bool written)
+{
+  cookie_unlink(ci, co);
+  if(Curl_node_llist(&co->dirtynode))
+    Curl_node_remove(&co->dirtynode);
+  if(written && ci->journal && co->domain) {
+    co->expires = 1;
+    Curl_llist_append(&ci->removed, co, &co->node);
+  }
+  else
+    freecookie(co);
 }
 
 /*
  * cookie path sanitize
+ *
+ * Returns the start of the sanitized path within the given one and stores
+ * its length in 'lenp'.
  */
-static char *sanitize_cookie_path(const char *cookie_path)
+static const char *sanitize_path_span(const char *cookie_path, size_t *lenp)
 {
-  size_t len = strlen(cookie_path);
+  size_t len = *lenp;
 
   /* some sites send path attribute within '"'. */
-  if(cookie_path[0] == '\"') {
+  if(len && (cookie_path[0] == '\"')) {
     cookie_path++;
     len--;
   }
@@ -292,15 +537,25 @@ static char *sanitize_cookie_path(const char *cookie_path)
     len--;
 
   /* RFC6265 5.2.4 The Path Attribute */
-  if(cookie_path[0] != '/')
+  if(!len || (cookie_path[0] != '/')) {
     /* Let cookie-path be the default-path. */
-    return strdup("/");
+    *lenp = 1;
+    return "/";
+  }
 
   /* remove trailing slash */
   /* convert /hoge/ to /hoge */
-  if(len && cookie_path[len - 1] == '/')
+  if(cookie_path[len - 1] == '/')
     len--;
 
+  *lenp = len;
+  return cookie_path;
+}
+
+static char *sanitize_cookie_path(const char *cookie_path)
+{
+  size_t len = strlen(cookie_path);
+  cookie_path = sanitize_path_span(cookie_path, &len);
   return Curl_memdup0(cookie_path, len);
 }
 
@@ -363,9 +618,10 @@ static void strstore(char **str, const char *newstr, size_t len)
  */
 static void remove_expired(struct CookieInfo *ci)
 {
-  struct Cookie *co;
+  struct cookie_domain *dom;
+  struct cookie_domain *next;
   curl_off_t now = (curl_off_t)time(NULL);
-  unsigned int i;
+  size_t slot = 0;
 
   /*
    * If the earliest expiration timestamp in the jar is in the future we can
@@ -381,16 +637,19 @@ static void remove_expired(struct CookieInfo *ci)
   else
     ci->next_expiration = CURL_OFF_T_MAX;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
+  for(dom = cookie_domain_next(ci, NULL, &slot); dom; dom = next) {
     struct Curl_llist_node *n;
     struct Curl_llist_node *e = NULL;
 
-    for(n = Curl_llist_head(&ci->cookielist[i]); n; n = e) {
-      co = Curl_node_elem(n);
+    /* get the next domain before this one is possibly removed */
+    next = cookie_domain_next(ci, dom, &slot);
+    for(n = Curl_llist_head(&dom->cookies); n; n = e) {
+      struct Cookie *co = Curl_node_elem(n);
       e = Curl_node_next(n);
       if(co->expires && co->expires < now) {
-        Curl_node_remove(n);
-        freecookie(co);
+        /* a saved cookie expires in the jar file too, an unsaved one may
+           have replaced a saved one */
+        cookie_remove(ci, co, !!Curl_node_llist(&co->dirtynode));
         ci->numcookies--;
       }
       else {
@@ -760,6 +1019,16 @@ parse_cookie_header(struct Curl_easy *data,
   return CERR_OK;
 }
 
+/* copy the string and a terminating null byte, return the end */
+static char *cookie_strcopy(char *dest, const struct Curl_str *src)
+{
+  size_t len = curlx_strlen(src);
+  if(len)
+    memcpy(dest, curlx_str(src), len);
+  dest[len] = 0;
+  return &dest[len + 1];
+}
+
 static int
 parse_netscape(struct Cookie *co,
                struct CookieInfo *ci,
@@ -774,6 +1043,13 @@ parse_netscape(struct Cookie *co,
   const char *ptr, *next;
   int fields;
   size_t len;
+  struct Curl_str domain;
+  struct Curl_str path;
+  struct Curl_str name;
+  struct Curl_str value;
+  struct Curl_str spath;
+  bool nopath = FALSE;
+  char *str;
 
   /*
    * In 2008, Internet Explorer introduced HTTP-only cookies to prevent XSS
@@ -790,9 +1066,14 @@ parse_netscape(struct Cookie *co,
     /* do not even try the comments */
     return CERR_COMMENT;
 
+  curlx_str_init(&domain);
+  curlx_str_init(&path);
+  curlx_str_init(&name);
+  curlx_str_init(&value); /* the value may be left out */
+
   /*
-   * Now loop through the fields and init the struct we already have
-   * allocated
+   * Now loop through the fields and note where the strings are, they are
+   * stored in a single allocation once the whole line is parsed
    */
   fields = 0;
   for(next = lineptr; next; fields++) {
@@ -805,9 +1086,7 @@ parse_netscape(struct Cookie *co,
         ptr++;
         len--;
       }
-      co->domain = Curl_memdup0(ptr, len);
-      if(!co->domain)
-        return CERR_OUT_OF_MEMORY;
+      curlx_str_assign(&domain, ptr, len);
       break;
     case 1:
       /*
@@ -821,23 +1100,12 @@ parse_netscape(struct Cookie *co,
       /* The file format allows the path field to remain not filled in */
       if(strncmp("TRUE", ptr, len) && strncmp("FALSE", ptr, len)) {
         /* only if the path does not look like a boolean option! */
-        co->path = Curl_memdup0(ptr, len);
-        if(!co->path)
-          return CERR_OUT_OF_MEMORY;
-        else {
-          co->spath = sanitize_cookie_path(co->path);
-          if(!co->spath)
-            return CERR_OUT_OF_MEMORY;
-        }
+        curlx_str_assign(&path, ptr, len);
         break;
       }
       /* this does not look like a path, make one up! */
-      co->path = strdup("/");
-      if(!co->path)
-        return CERR_OUT_OF_MEMORY;
-      co->spath = strdup("/");
-      if(!co->spath)
-        return CERR_OUT_OF_MEMORY;
+      curlx_str_assign(&path, "/", 1);
+      nopath = TRUE;
       fields++; /* add a field and fall down to secure */
       FALLTHROUGH();
     case 3:
@@ -854,37 +1122,52 @@ parse_netscape(struct Cookie *co,
         return CERR_RANGE;
       break;
     case 5:
-      co->name = Curl_memdup0(ptr, len);
-      if(!co->name)
-        return CERR_OUT_OF_MEMORY;
-      else {
-        /* For Netscape file format cookies we check prefix on the name */
-        if(curl_strnequal("__Secure-", co->name, 9))
-          co->prefix_secure = TRUE;
-        else if(curl_strnequal("__Host-", co->name, 7))
-          co->prefix_host = TRUE;
-      }
+      curlx_str_assign(&name, ptr, len);
+      /* For Netscape file format cookies we check prefix on the name */
+      if(curl_strnequal("__Secure-", ptr, 9))
+        co->prefix_secure = TRUE;
+      else if(curl_strnequal("__Host-", ptr, 7))
+        co->prefix_host = TRUE;
       break;
     case 6:
-      co->value = Curl_memdup0(ptr, len);
-      if(!co->value)
-        return CERR_OUT_OF_MEMORY;
+      curlx_str_assign(&value, ptr, len);
       break;
     }
   }
-  if(fields == 6) {
-    /* we got a cookie with blank contents, fix it */
-    co->value = strdup("");
-    if(!co->value)
-      return CERR_OUT_OF_MEMORY;
-    else
-      fields++;
-  }
+  if(fields == 6)
+    /* we got a cookie with blank contents */
+    fields++;
 
   if(fields != 7)
     /* we did not find the sufficient number of fields */
     return CERR_FIELDS;
 
+  if(nopath)
+    curlx_str_assign(&spath, "/", 1);
+  else {
+    len = curlx_strlen(&path);
+    ptr = sanitize_path_span(curlx_str(&path), &len);
+    curlx_str_assign(&spath, ptr, len);
+  }
+
+  /* all the strings of the cookie in one allocation */
+  str = malloc(curlx_strlen(&domain) + curlx_strlen(&path) +
+               curlx_strlen(&spath) + curlx_strlen(&name) +
+               curlx_strlen(&value) + 5);
+  if(!str)
+    return CERR_OUT_OF_MEMORY;
+  co->strings = str;
+  co->domain = str;
+  str = cookie_strcopy(str, &domain);
+  co->path = str;
+  str = cookie_strcopy(str, &path);
+  co->spath = str;
+  str = cookie_strcopy(str, &spath);
+  co->name = str;
+  str = cookie_strcopy(str, &name);
+  co->value = str;
+  cookie_strcopy(str, &value);
+
   return CERR_OK;
 }
 
@@ -945,9 +1228,14 @@ replace_existing(struct Curl_easy *data,
 {
   bool replace_old = FALSE;
   struct Curl_llist_node *replace_n = NULL;
-  struct Curl_llist_node *n;
-  size_t myhash = cookiehash(co->domain);
-  for(n = Curl_llist_head(&ci->cookielist[myhash]); n; n = Curl_node_next(n)) {
+  struct Curl_llist_node *n = NULL;
+  struct cookie_domain *dom = co->domain ?
+    cookie_domain_find(ci, co->domain, strlen(co->domain)) : ci->nodomain;
+
+  /* only cookies for the same domain can be replaced or overlaid */
+  if(dom)
+    n = Curl_llist_head(&dom->cookies);
+  for(; n; n = Curl_node_next(n)) {
     struct Cookie *clist = Curl_node_elem(n);
     if(!strcmp(clist->name, co->name)) {
       /* the names are identical */
@@ -1030,61 +1318,29 @@ replace_existing(struct Curl_easy *data,
     /* when replacing, creationtime is kept from old */
     co->creationtime = repl->creationtime;
 
-    /* unlink the old */
-    Curl_node_remove(replace_n);
-
-    /* free the old cookie */
-    freecookie(repl);
+    /* unlink and free the old, the new one replaces it in the jar file */
+    cookie_remove(ci, repl, FALSE);
   }
   *replacep = replace_old;
   return CERR_OK;
 }
 
 /*
- * Curl_cookie_add
+ * cookie_insert
  *
- * Add a single cookie line to the cookie keeping object. Be aware that
- * sometimes we get an IP-only hostname, and that might also be a numerical
- * IPv6 address.
- *
- * Returns NULL on out of memory or invalid cookie. This is suboptimal,
- * as they should be treated separately.
+ * Add a parsed cookie to the jar, replacing an existing cookie it supersedes.
+ * Returns NULL and frees the cookie when it is not accepted.
  */
-struct Cookie *
-Curl_cookie_add(struct Curl_easy *data,
-                struct CookieInfo *ci,
-                bool httpheader, /* TRUE if HTTP header-style line */
-                bool noexpire, /* if TRUE, skip remove_expired() */
-                const char *lineptr,   /* first character of the line */
-                const char *domain, /* default domain */
-                const char *path,   /* full path used when this cookie is set,
-                                       used to get default path for the cookie
-                                       unless set */
-                bool secure)  /* TRUE if connection is over secure origin */
+static struct Cookie *
+cookie_insert(struct Curl_easy *data,
+              struct CookieInfo *ci,
+              struct Cookie *co,
+              const char *domain, /* default domain */
+              bool secure,  /* TRUE if connection is over secure origin */
+              bool noexpire) /* if TRUE, skip remove_expired() */
 {
-  struct Cookie *co;
-  size_t myhash;
-  int rc;
   bool replaces = FALSE;
 
-  DEBUGASSERT(data);
-  DEBUGASSERT(MAX_SET_COOKIE_AMOUNT <= 255); /* counter is an unsigned char */
-  if(data->req.setcookies >= MAX_SET_COOKIE_AMOUNT)
-    return NULL;
-
-  /* First, alloc and init a new struct for it */
-  co = calloc(1, sizeof(struct Cookie));
-  if(!co)
-    return NULL; /* bail out if we are this low on memory */
-
-  if(httpheader)
-    rc = parse_cookie_header(data, co, ci, lineptr, domain, path, secure);
-  else
-    rc = parse_netscape(co, ci, lineptr, secure);
-
-  if(rc)
-    goto fail;
-
   if(co->prefix_secure && !co->secure)
     /* The __Secure- prefix only requires that the cookie be set secure */
     goto fail;
@@ -1100,14 +1356,6 @@ Curl_cookie_add(struct Curl_easy *data,
       goto fail;
   }
 
-  if(!ci->running &&    /* read from a file */
-     ci->newsession &&  /* clean session cookies */
-     !co->expires)      /* this is a session cookie since it does not expire */
-    goto fail;
-
-  co->livecookie = ci->running;
-  co->creationtime = ++ci->lastct;
-
   /*
    * Now we have parsed the incoming line, we must now check if this supersedes
    * an already existing cookie, which it may if the previous have the same
@@ -1124,11 +1372,15 @@ Curl_cookie_add(struct Curl_easy *data,
   if(replace_existing(data, co, ci, secure, &replaces))
     goto fail;
 
-  /* add this cookie to the list */
-  myhash = cookiehash(co->domain);
-  Curl_llist_append(&ci->cookielist[myhash], co, &co->node);
+  /* add this cookie to the jar */
+  if(!cookie_link(ci, co)) {
+    if(replaces)
+      ci->numcookies--; /* the replaced cookie is gone */
+    goto fail;
+  }
+  Curl_llist_append(&ci->dirty, co, &co->dirtynode);
 
-  if(ci->running)
+  if(co->livecookie)
     /* Only show this when NOT reading the cookies from a file */
     infof(data, "%s cookie %s=\"%s\" for domain %s, path %s, "
           "expire %" FMT_OFF_T,
@@ -1151,6 +1403,269 @@ fail:
   return NULL;
 }
 
+/* TRUE if the stored string has bytes that do not belong in a cookie jar */
+static bool cookie_badbytes(const char *ptr, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)ptr;
+  size_t i;
+  for(i = 0; i < len; i++) {
+    if((p[i] < 0x20) || (p[i] == 0x7f))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+ * cookie_restore
+ *
+ * Copy a cookie from a binary store file into the jar, like a cookie read
+ * from a cookie file.
+ */
+static void cookie_restore(struct Curl_easy *data,
+                           struct CookieInfo *ci,
+                           struct Curl_binstore *bs,
+                           const struct Curl_binrec *rec)
+{
+  curl_off_t flags = rec->f[0].num;
+  curl_off_t order = rec->f[5].num;
+  struct Curl_str domain;
+  struct Curl_str path;
+  struct Curl_str spath;
+  struct Curl_str name;
+  struct Curl_str value;
+  struct Cookie *co;
+  const char *ptr;
+  size_t len;
+  char *str;
+
+  curlx_str_assign(&domain, rec->key, rec->keylen);
+  curlx_str_assign(&path, rec->f[1].str, rec->f[1].len);
+  curlx_str_assign(&name, rec->f[3].str, rec->f[3].len);
+  curlx_str_assign(&value, rec->f[4].str, rec->f[4].len);
+  if(!rec->keylen || !rec->f[3].len ||
+     ((rec->keylen + rec->f[1].len + rec->f[3].len + rec->f[4].len) >
+      MAX_COOKIE_LINE) ||
+     cookie_badbytes(rec->key, rec->keylen) ||
+     cookie_badbytes(rec->f[1].str, rec->f[1].len) ||
+     cookie_badbytes(rec->f[3].str, rec->f[3].len) ||
+     cookie_badbytes(rec->f[4].str, rec->f[4].len))
+    return;
+  if(rec->f[2].num && (rec->f[2].num < (curl_off_t)time(NULL)))
+    /* expired */
+    return;
+
+  len = rec->f[1].len;
+  ptr = sanitize_path_span(rec->f[1].str, &len);
+  curlx_str_assign(&spath, ptr, len);
+
+  co = calloc(1, sizeof(struct Cookie));
+  if(!co)
+    return;
+  str = malloc(curlx_strlen(&domain) + curlx_strlen(&path) +
+               curlx_strlen(&spath) + curlx_strlen(&name) +
+               curlx_strlen(&value) + 5);
+  if(!str) {
+    free(co);
+    return;
+  }
+  co->strings = str;
+  co->domain = str;
+  str = cookie_strcopy(str, &domain);
+  co->path = str;
+  str = cookie_strcopy(str, &path);
+  co->spath = str;
+  str = cookie_strcopy(str, &spath);
+  co->name = str;
+  str = cookie_strcopy(str, &name);
+  co->value = str;
+  cookie_strcopy(str, &value);
+
+  co->tailmatch = !!(flags & COOKIE_BIN_TAILMATCH);
+  co->secure = !!(flags & COOKIE_BIN_SECURE);
+  co->httponly = !!(flags & COOKIE_BIN_HTTPONLY);
+  co->expires = rec->f[2].num;
+  if(curl_strnequal("__Secure-", co->name, 9))
+    co->prefix_secure = TRUE;
+  else if(curl_strnequal("__Host-", co->name, 7))
+    co->prefix_host = TRUE;
+
+  /* the stored cookies keep the order they were created in */
+  if((order < 0) || (order >= (curl_off_t)bs->count))
+    order = rec->idx;
+  co->livecookie = FALSE;
+  co->creationtime = bs->base + (unsigned int)order + 1;
+  co->added = co->creationtime;
+
+  cookie_insert(data, ci, co, NULL, TRUE, TRUE);
+}
+
+/*
+ * cookie_unstore
+ *
+ * Copy the stored cookies for this domain from the binary store files into
+ * the jar.
+ */
+static void cookie_unstore(struct Curl_easy *data,
+                           struct CookieInfo *ci,
+                           const char *domain, size_t len)
+{
+  struct Curl_llist_node *n;
+
+  if(!Curl_llist_count(&ci->stores))
+    return;
+  for(n = Curl_llist_head(&ci->stores); n; n = Curl_node_next(n)) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    struct Curl_binrec rec;
+    while(Curl_binstore_take(bs, domain, len, &rec))
+      cookie_restore(data, ci, bs, &rec);
+  }
+  Curl_binstore_prune(&ci->stores);
+}
+
+/* Copy all stored cookies into the jar */
+static void cookie_unstore_all(struct Curl_easy *data,
+                               struct CookieInfo *ci)
+{
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(&ci->stores); n; n = Curl_node_next(n)) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    struct Curl_binrec rec;
+    while(Curl_binstore_next(bs, &rec))
+      cookie_restore(data, ci, bs, &rec);
+  }
+  Curl_binstore_destroy(&ci->stores);
+}
+
+/* Drop the session cookies from the binary store files */
+static void cookie_unstore_sessions(struct CookieInfo *ci)
+{
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(&ci->stores); n; n = Curl_node_next(n)) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    struct Curl_binrec rec;
+    unsigned int i;
+    for(i = 0; i < bs->count; i++) {
+      if(Curl_binstore_get(bs, i, &rec) && !rec.f[2].num)
+        Curl_binstore_drop(bs, i);
+    }
+  }
+  Curl_binstore_prune(&ci->stores);
+}
+
+/*
+ * Curl_cookie_add
+ *
+ * Add a single cookie line to the cookie keeping object. Be aware that
+ * sometimes we get an IP-only hostname, and that might also be a numerical
+ * IPv6 address.
+ *
+ * Returns NULL on out of memory or invalid cookie. This is suboptimal,
+ * as they should be treated separately.
+ */
+struct Cookie *
+Curl_cookie_add(struct Curl_easy *data,
+                struct CookieInfo *ci,
+                bool httpheader, /* TRUE if HTTP header-style line */
+                bool noexpire, /* if TRUE, skip remove_expired() */
+                const char *lineptr,   /* first character of the line */
+                const char *domain, /* default domain */
+                const char *path,   /* full path used when this cookie is set,
+                                       used to get default path for the cookie
+                                       unless set */
+                bool secure)  /* TRUE if connection is over secure origin */
+{
+  struct Cookie *co;
+  int rc;
+
+  DEBUGASSERT(data);
+  DEBUGASSERT(MAX_SET_COOKIE_AMOUNT <= 255); /* counter is an unsigned char */
+  if(data->req.setcookies >= MAX_SET_COOKIE_AMOUNT)
+    return NULL;
+
+  /* First, alloc and init a new struct for it */
+  co = calloc(1, sizeof(struct Cookie));
+  if(!co)
+    return NULL; /* bail out if we are this low on memory */
+
+  if(httpheader)
+    rc = parse_cookie_header(data, co, ci, lineptr, domain, path, secure);
+  else
+    rc = parse_netscape(co, ci, lineptr, secure);
+
+  if(rc)
+    goto fail;
+
+  if(!ci->running &&    /* read from a file */
+     ci->newsession &&  /* clean session cookies */
+     !co->expires)      /* this is a session cookie since it does not expire */
+    goto fail;
+
+  co->livecookie = ci->running;
+  co->creationtime = ++ci->lastct;
+  co->added = co->creationtime;
+
+  /* the stored cookies for the domain are in the jar before this one may
+     replace one of them */
+  if(co->domain)
+    cookie_unstore(data, ci, co->domain, strlen(co->domain));
+
+  return cookie_insert(data, ci, co, domain, secure, noexpire);
+fail:
+  freecookie(co);
+  return NULL;
+}
+
+
+/*
+ * cookie_journal_reset()
+ *
+ * The cookie jar file has just been written or read in full, or is no longer
+ * of interest when 'filename' is NULL. Forget the changes recorded for it and
+ * when journaling, remember the file and the number of cookie lines in it.
+ */
+static void cookie_journal_reset(struct Curl_easy *data,
+                                 struct CookieInfo *ci,
+                                 const char *filename,
+                                 size_t lines)
+{
+  struct Curl_llist_node *n;
+  struct_stat st;
+
+  Curl_llist_destroy(&ci->dirty, NULL);
+  while((n = Curl_llist_head(&ci->removed))) {
+    struct Cookie *co = Curl_node_elem(n);
+    Curl_node_remove(n);
+    freecookie(co);
+  }
+  Curl_safefree(ci->journal);
+
+  if(filename && data->set.cookiejournal &&
+     !stat(filename, &st) && S_ISREG(st.st_mode)) {
+    ci->journal = strdup(filename);
+    ci->journal_size = (curl_off_t)st.st_size;
+    ci->journal_lines = lines;
+  }
+}
+
+/*
+ * cookie_addstore()
+ *
+ * Add a binary store file to the jar. Its cookies are not read, they are
+ * copied into the jar when their domains are used.
+ */
+static void cookie_addstore(struct CookieInfo *ci, struct Curl_binstore *bs,
+                            bool newsession)
+{
+  /* the stored cookies are created after the ones in the jar, in the order
+     they were created in before */
+  bs->base = ci->lastct;
+  ci->lastct += bs->count;
+  Curl_llist_append(&ci->stores, bs, &bs->node);
+  if(newsession)
+    cookie_unstore_sessions(ci);
+}
 
 /*
  * Curl_cookie_init()
@@ -1174,30 +1689,36 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
   FILE *handle = NULL;
 
   if(!ci) {
-    int i;
-
-    /* we did not get a struct, create one */
+    /* we did not get a struct, create one. The domain hash is allocated
+       when the first cookie is added. */
     ci = calloc(1, sizeof(struct CookieInfo));
     if(!ci)
       return NULL; /* failed to get memory */
 
-    /* This does not use the destructor callback since we want to add
-       and remove to lists while keeping the cookie struct intact */
-    for(i = 0; i < COOKIE_HASH_SIZE; i++)
-      Curl_llist_init(&ci->cookielist[i], NULL);
     /*
      * Initialize the next_expiration time to signal that we do not have enough
      * information yet.
      */
     ci->next_expiration = CURL_OFF_T_MAX;
+
+    /* cookies are added and removed while the cookie struct is kept */
+    Curl_llist_init(&ci->dirty, NULL);
+    Curl_llist_init(&ci->removed, NULL);
+    Curl_llist_init(&ci->stores, NULL);
   }
   ci->newsession = newsession; /* new session? */
 
   if(data) {
     FILE *fp = NULL;
     if(file && *file) {
+      struct Curl_binstore *bs = NULL;
       if(!strcmp(file, "-"))
         fp = stdin;
+      else if(Curl_binstore_open(file, CURL_BINSTORE_COOKIE, COOKIE_BIN_FMT,
+                                 &bs))
+        infof(data, "WARNING: failed to read cookie store \"%s\"", file);
+      else if(bs)
+        cookie_addstore(ci, bs, newsession);
       else {
         fp = fopen(file, "rb");
         if(!fp)
@@ -1210,6 +1731,11 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
     ci->running = FALSE; /* this is not running, this is init */
     if(fp) {
       struct dynbuf buf;
+      size_t lines = 0;
+      /* a file read into an empty jar holds exactly the jar's cookies, it
+         can be appended to if it is also the cookie jar */
+      bool journal = handle && !ci->numcookies && !ci->journal &&
+        !newsession && !Curl_llist_count(&ci->stores);
       curlx_dyn_init(&buf, MAX_COOKIE_LINE);
       while(Curl_get_line(&buf, fp)) {
         const char *lineptr = curlx_dyn_ptr(&buf);
@@ -1222,6 +1748,7 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
         }
 
         Curl_cookie_add(data, ci, headerline, TRUE, lineptr, NULL, NULL, TRUE);
+        lines++;
       }
       curlx_dyn_free(&buf); /* free the line buffer */
 
@@ -1231,8 +1758,14 @@ struct CookieInfo *Curl_cookie_init(struct Curl_easy *data,
        */
       remove_expired(ci);
 
+      /* appending needs the whole file read and ending with a newline */
+      if(journal)
+        journal = feof(fp) && !fseek(fp, -1, SEEK_END) && (getc(fp) == '\n');
+
       if(handle)
         fclose(handle);
+      if(journal)
+        cookie_journal_reset(data, ci, file, lines);
     }
     data->state.cookie_engine = TRUE;
   }
@@ -1293,6 +1826,68 @@ static int cookie_sort_ct(const void *p1, const void *p2)
   return (c2->creationtime > c1->creationtime) ? 1 : -1;
 }
 
+/*
+ * cookie_sort_added
+ *
+ * Helper function to sort cookies in the order they were added to the jar.
+ */
+static int cookie_sort_added(const void *p1, const void *p2)
+{
+  const struct Cookie *c1 = *(const struct Cookie * const *)p1;
+  const struct Cookie *c2 = *(const struct Cookie * const *)p2;
+
+  return (c2->added > c1->added) ? -1 : 1;
+}
+
+/*
+ * Add the cookies of a domain that match the request path to the list.
+ *
+ * RFC6265 5.1.4 Paths and Path-Match: a cookie path matches when it is "/",
+ * equals the request path or is a prefix of it followed by a slash. Those
+ * are exactly the path nodes along the segments of the request path. Paths
+ * match case-sensitively.
+ *
+ * The RFC says to only use the request path up to its right-most slash. That
+ * is ignored since a URL path /hoge?fuga=xxx may mean /hoge/index.cgi?fuga=xxx
+ * on some sites.
+ */
+static size_t cookie_collect(struct cookie_domain *dom,
+                             const char *path,
+                             bool secure,
+                             bool tailonly,
+                             struct Curl_llist *list)
+{
+  struct cookie_path *p = dom->root;
+  size_t matches = 0;
+
+  path++; /* skip the leading slash */
+  for(;;) {
+    struct Curl_llist_node *n;
+    const char *end;
+
+    for(n = Curl_llist_head(&p->cookies); n; n = Curl_node_next(n)) {
+      struct Cookie *co = Curl_node_elem(n);
+
+      /* if the cookie requires we are secure we must only continue if we
+         are! */
+      if((co->secure && !secure) || (tailonly && !co->tailmatch))
+        continue;
+
+      Curl_llist_append(list, co, &co->getnode);
+      matches++;
+    }
+
+    if(!path)
+      break;
+    end = strchr(path, '/');
+    p = cookie_path_child(p, path, end ? (size_t)(end - path) : strlen(path));
+    if(!p)
+      break;
+    path = end ? end + 1 : NULL;
+  }
+  return matches;
+}
+
 /*
  * Curl_cookie_getlist
  *
@@ -1311,56 +1906,53 @@ int Curl_cookie_getlist(struct Curl_easy *data,
                         struct Curl_llist *list)
 {
   size_t matches = 0;
-  bool is_ip;
-  const size_t myhash = cookiehash(host);
-  struct Curl_llist_node *n;
+  size_t hostlen = strlen(host);
+  struct cookie_domain *dom;
 
   Curl_llist_init(list, NULL);
 
-  if(!ci || !Curl_llist_count(&ci->cookielist[myhash]))
+  if(!ci || (!ci->numcookies && !Curl_llist_count(&ci->stores)))
     return 1; /* no cookie struct or no cookies in the struct */
 
   /* at first, remove expired cookies */
   remove_expired(ci);
 
-  /* check if host is an IP(v4|v6) address */
-  is_ip = Curl_host_is_ipnum(host);
-
-  for(n = Curl_llist_head(&ci->cookielist[myhash]);
-      n; n = Curl_node_next(n)) {
-    struct Cookie *co = Curl_node_elem(n);
-
-    /* if the cookie requires we are secure we must only continue if we are! */
-    if(co->secure ? secure : TRUE) {
-
-      /* now check if the domain is correct */
-      if(!co->domain ||
-         (co->tailmatch && !is_ip &&
-          cookie_tailmatch(co->domain, strlen(co->domain), host)) ||
-         ((!co->tailmatch || is_ip) && curl_strequal(host, co->domain)) ) {
-        /*
-         * the right part of the host matches the domain stuff in the
-         * cookie data
-         */
-
-        /*
-         * now check the left part of the path with the cookies path
-         * requirement
-         */
-        if(!co->spath || pathmatch(co->spath, path) ) {
-
-          /*
-           * This is a match and we add it to the return-linked-list
-           */
-          Curl_llist_append(list, co, &co->getnode);
-          matches++;
-          if(matches >= MAX_COOKIE_SEND_AMOUNT) {
-            infof(data, "Included max number of cookies (%zu) in request!",
-                  matches);
-            break;
-          }
-        }
-      }
+  /* #-fragments are already cut off! */
+  if(path[0] != '/')
+    path = "/";
+
+  cookie_unstore(data, ci, host, hostlen);
+
+  /* cookies without a domain match all hosts */
+  if(ci->nodomain)
+    matches += cookie_collect(ci->nodomain, path, secure, FALSE, list);
+
+  /* all cookies for exactly this host match */
+  dom = cookie_domain_find(ci, host, hostlen);
+  if(dom)
+    matches += cookie_collect(dom, path, secure, FALSE, list);
+
+  /* tailmatching cookies for the parent domains match unless the host is an
+     IP(v4|v6) address. The parent domains are those ending at a dot of the
+     host name, not shorter than its top-level domain. */
+  if(!Curl_host_is_ipnum(host)) {
+    const char *dot = host;
+    size_t toplen;
+
+    get_top_domain(host, &toplen);
+    while(dot) {
+      size_t len;
+      dot = memchr(dot, '.', hostlen - (dot - host));
+      if(!dot)
+        break;
+      dot++;
+      len = hostlen - (dot - host);
+      if(len < toplen)
+        break;
+      cookie_unstore(data, ci, dot, len);
+      dom = cookie_domain_find(ci, dot, len);
+      if(dom)
+        matches += cookie_collect(dom, path, secure, TRUE, list);
     }
   }
 
@@ -1371,6 +1963,7 @@ int Curl_cookie_getlist(struct Curl_easy *data,
      * the swiftest way, we just sort them all based on path length.
      */
     struct Cookie **array;
+    struct Curl_llist_node *n;
     size_t i;
 
     /* alloc an array and store all cookie pointers */
@@ -1383,6 +1976,14 @@ int Curl_cookie_getlist(struct Curl_easy *data,
     for(i = 0; n; n = Curl_node_next(n))
       array[i++] = Curl_node_elem(n);
 
+    if(matches > MAX_COOKIE_SEND_AMOUNT) {
+      /* include the ones added first */
+      qsort(array, matches, sizeof(struct Cookie *), cookie_sort_added);
+      matches = MAX_COOKIE_SEND_AMOUNT;
+      infof(data, "Included max number of cookies (%zu) in request!",
+            matches);
+    }
+
     /* now sort the cookie pointers in path length order */
     qsort(array, matches, sizeof(struct Cookie *), cookie_sort);
 
@@ -1411,18 +2012,21 @@ fail:
 void Curl_cookie_clearall(struct CookieInfo *ci)
 {
   if(ci) {
-    unsigned int i;
-    for(i = 0; i < COOKIE_HASH_SIZE; i++) {
+    struct cookie_domain *dom;
+    struct cookie_domain *next;
+    size_t slot = 0;
+    for(dom = cookie_domain_next(ci, NULL, &slot); dom; dom = next) {
       struct Curl_llist_node *n;
-      for(n = Curl_llist_head(&ci->cookielist[i]); n;) {
+      next = cookie_domain_next(ci, dom, &slot);
+      for(n = Curl_llist_head(&dom->cookies); n;) {
         struct Cookie *c = Curl_node_elem(n);
         struct Curl_llist_node *e = Curl_node_next(n);
-        Curl_node_remove(n);
-        freecookie(c);
+        cookie_remove(ci, c, TRUE);
         n = e;
       }
     }
     ci->numcookies = 0;
+    Curl_binstore_destroy(&ci->stores);
   }
 }
 
@@ -1433,21 +2037,24 @@ void Curl_cookie_clearall(struct CookieInfo *ci)
  */
 void Curl_cookie_clearsess(struct CookieInfo *ci)
 {
-  unsigned int i;
+  struct cookie_domain *dom;
+  struct cookie_domain *next;
+  size_t slot = 0;
 
   if(!ci)
     return;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-    struct Curl_llist_node *n = Curl_llist_head(&ci->cookielist[i]);
+  cookie_unstore_sessions(ci);
+  for(dom = cookie_domain_next(ci, NULL, &slot); dom; dom = next) {
+    struct Curl_llist_node *n;
     struct Curl_llist_node *e = NULL;
 
-    for(; n; n = e) {
+    next = cookie_domain_next(ci, dom, &slot);
+    for(n = Curl_llist_head(&dom->cookies); n; n = e) {
       struct Cookie *curr = Curl_node_elem(n);
       e = Curl_node_next(n); /* in case the node is removed, get it early */
       if(!curr->expires) {
-        Curl_node_remove(n);
-        freecookie(curr);
+        cookie_remove(ci, curr, TRUE);
         ci->numcookies--;
       }
     }
@@ -1462,7 +2069,9 @@ void Curl_cookie_clearsess(struct CookieInfo *ci)
 void Curl_cookie_cleanup(struct CookieInfo *ci)
 {
   if(ci) {
+    cookie_journal_reset(NULL, ci, NULL, 0);
     Curl_cookie_clearall(ci);
+    free(ci->domains);
     free(ci); /* free the base struct as well */
   }
 }
@@ -1500,11 +2109,125 @@ static char *get_netscape_format(const struct Cookie *co)
     co->value ? co->value : "");
 }
 
+/*
+ * A journaled cookie jar file is written in full instead of appended to when
+ * it would otherwise hold more than twice the number of cookies in the jar
+ * plus this many lines.
+ */
+#define COOKIE_JOURNAL_SLACK 100
+
+static CURLcode cookie_journal_line(FILE *out, const struct Cookie *co)
+{
+  char *line = get_netscape_format(co);
+  int rc;
+
+  if(!line)
+    return CURLE_OUT_OF_MEMORY;
+  rc = fprintf(out, "%s\n", line);
+  free(line);
+  return (rc < 0) ? CURLE_WRITE_ERROR : CURLE_OK;
+}
+
+/*
+ * cookie_journal()
+ *
+ * Append the cookies added and removed since the journaled cookie jar file
+ * was last written to it. Reading the file, the appended lines replace the
+ * earlier ones for the same cookies and removed cookies are expired.
+ *
+ * '*done' is left FALSE when the file needs to be written in full instead:
+ * it is not the file written last, someone else changed it or it has grown
+ * too large.
+ */
+static CURLcode cookie_journal(struct Curl_easy *data,
+                               struct CookieInfo *ci,
+                               const char *filename,
+                               bool *done)
+{
+  size_t changes = Curl_llist_count(&ci->dirty) +
+    Curl_llist_count(&ci->removed);
+  struct Curl_llist_node *n;
+  struct_stat st;
+  FILE *out;
+  CURLcode error = CURLE_OK;
+
+  *done = FALSE;
+  if(!ci->journal || strcmp(ci->journal, filename) ||
+     (ci->journal_lines + changes >
+      2 * (size_t)ci->numcookies + COOKIE_JOURNAL_SLACK) ||
+     stat(filename, &st) || ((curl_off_t)st.st_size != ci->journal_size))
+    return CURLE_OK;
+
+  if(changes) {
+    out = fopen(filename, FOPEN_APPENDTEXT);
+    if(!out)
+      return CURLE_OK;
+
+    /* removals first, a cookie may have been removed and added again */
+    for(n = Curl_llist_head(&ci->removed); n && !error; n = Curl_node_next(n))
+      error = cookie_journal_line(out, Curl_node_elem(n));
+    for(n = Curl_llist_head(&ci->dirty); n && !error; n = Curl_node_next(n)) {
+      struct Cookie *co = Curl_node_elem(n);
+      /* only cookies with a domain property are saved */
+      if(co->domain)
+        error = cookie_journal_line(out, co);
+    }
+    if(fclose(out) && !error)
+      error = CURLE_WRITE_ERROR;
+    if(error) {
+      /* the file may end with a partial line, write it in full next time */
+      Curl_safefree(ci->journal);
+      return error;
+    }
+    cookie_journal_reset(data, ci, filename, ci->journal_lines + changes);
+  }
+  *done = TRUE;
+  return CURLE_OK;
+}
+
+/*
+ * cookie_output_bin()
+ *
+ * Writes the cookies, sorted newest first, as a binary store file.
+ */
+static CURLcode cookie_output_bin(struct Cookie **array, size_t nvalid,
+                                  FILE *out)
+{
+  struct Curl_binwriter w;
+  CURLcode error = CURLE_OK;
+  size_t i;
+
+  Curl_binwriter_init(&w, CURL_BINSTORE_COOKIE, COOKIE_BIN_FMT);
+  for(i = 0; !error && (i < nvalid); i++) {
+    const struct Cookie *co = array[i];
+    struct Curl_binrec rec;
+    rec.key = co->domain;
+    rec.keylen = strlen(co->domain);
+    rec.f[0].num = (co->tailmatch ? COOKIE_BIN_TAILMATCH : 0) |
+      (co->secure ? COOKIE_BIN_SECURE : 0) |
+      (co->httponly ? COOKIE_BIN_HTTPONLY : 0);
+    rec.f[1].str = co->path ? co->path : "/";
+    rec.f[1].len = strlen(rec.f[1].str);
+    rec.f[2].num = co->expires;
+    rec.f[3].str = co->name;
+    rec.f[3].len = strlen(co->name);
+    rec.f[4].str = co->value ? co->value : "";
+    rec.f[4].len = strlen(rec.f[4].str);
+    rec.f[5].num = (curl_off_t)(nvalid - 1 - i);
+    error = Curl_binwriter_add(&w, &rec);
+  }
+  if(!error)
+    error = Curl_binwriter_write(&w, out);
+  Curl_binwriter_free(&w);
+  return error;
+}
+
 /*
  * cookie_output()
  *
  * Writes all internally known cookies to the specified file. Specify
- * "-" as filename to write to stdout.
+ * "-" as filename to write to stdout. A file that is a binary store is
+ * written as one.
  *
  * The function returns non-zero on write failure.
  */
@@ -1514,13 +2237,19 @@ static CURLcode cookie_output(struct Curl_easy *data,
 {
   FILE *out = NULL;
   bool use_stdout = FALSE;
+  bool binary = FALSE;
   char *tempstore = NULL;
+  struct Cookie **array = NULL;
+  size_t nvalid = 0;
   CURLcode error = CURLE_OK;
 
   if(!ci)
     /* no cookie engine alive */
     return CURLE_OK;
 
+  /* all cookies are saved, read what is left in the store files */
+  cookie_unstore_all(data, ci);
+
   /* at first, remove expired cookies */
   remove_expired(ci);
 
@@ -1530,21 +2259,29 @@ static CURLcode cookie_output(struct Curl_easy *data,
     use_stdout = TRUE;
   }
   else {
+    binary = Curl_binstore_is(filename);
+    if(data->set.cookiejournal && !binary) {
+      bool done;
+      error = cookie_journal(data, ci, filename, &done);
+      if(error || done)
+        return error;
+    }
     error = Curl_fopen(data, filename, &out, &tempstore);
     if(error)
       goto error;
   }
 
-  fputs("# Netscape HTTP Cookie File\n"
-        "# https://curl.se/docs/http-cookies.html\n"
-        "# This file was generated by libcurl! Edit at your own risk.\n\n",
-        out);
+  if(!binary)
+    fputs("# Netscape HTTP Cookie File\n"
+          "# https://curl.se/docs/http-cookies.html\n"
+          "# This file was generated by libcurl! Edit at your own risk.\n\n",
+          out);
 
   if(ci->numcookies) {
-    unsigned int i;
-    size_t nvalid = 0;
-    struct Cookie **array;
+    size_t i;
     struct Curl_llist_node *n;
+    struct cookie_domain *dom;
+    size_t slot = 0;
 
     array = calloc(1, sizeof(struct Cookie *) * ci->numcookies);
     if(!array) {
@@ -1553,31 +2290,33 @@ static CURLcode cookie_output(struct Curl_easy *data,
     }
 
     /* only sort the cookies with a domain property */
-    for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-      for(n = Curl_llist_head(&ci->cookielist[i]); n;
-          n = Curl_node_next(n)) {
-        struct Cookie *co = Curl_node_elem(n);
-        if(!co->domain)
-          continue;
-        array[nvalid++] = co;
-      }
+    for(dom = cookie_domain_next(ci, NULL, &slot); dom;
+        dom = cookie_domain_next(ci, dom, &slot)) {
+      if(dom == ci->nodomain)
+        continue;
+      for(n = Curl_llist_head(&dom->cookies); n; n = Curl_node_next(n))
+        array[nvalid++] = Curl_node_elem(n);
     }
 
     qsort(array, nvalid, sizeof(struct Cookie *), cookie_sort_ct);
 
-    for(i = 0; i < nvalid; i++) {
+    for(i = 0; !binary && (i < nvalid); i++) {
       char *format_ptr = get_netscape_format(array[i]);
       if(!format_ptr) {
-        free(array);
         error = CURLE_OUT_OF_MEMORY;
         goto error;
       }
       fprintf(out, "%s\n", format_ptr);
       free(format_ptr);
     }
+  }
 
-    free(array);
+  if(binary) {
+    error = cookie_output_bin(array, nvalid, out);
+    if(error)
+      goto error;
   }
+  Curl_safefree(array);
 
   if(!use_stdout) {
     fclose(out);
@@ -1587,6 +2326,8 @@ static CURLcode cookie_output(struct Curl_easy *data,
       error = CURLE_WRITE_ERROR;
       goto error;
     }
+    /* the file now holds all cookies, a binary one is not appended to */
+    cookie_journal_reset(data, ci, binary ? NULL : filename, nvalid);
   }
 
   /*
@@ -1600,6 +2341,7 @@ static CURLcode cookie_output(struct Curl_easy *data,
 error:
   if(out && !use_stdout)
     fclose(out);
+  free(array);
   free(tempstore);
   return error;
 }
@@ -1608,34 +2350,54 @@ static struct curl_slist *cookie_list(struct Curl_easy *data)
 {
   struct curl_slist *list = NULL;
   struct curl_slist *beg;
-  unsigned int i;
+  struct CookieInfo *ci = data->cookies;
+  struct cookie_domain *dom;
+  struct Cookie **array;
+  size_t nvalid = 0;
+  size_t slot = 0;
+  size_t i;
   struct Curl_llist_node *n;
 
-  if(!data->cookies || (data->cookies->numcookies == 0))
+  if(!ci)
+    return NULL;
+  cookie_unstore_all(data, ci);
+  if(!ci->numcookies)
+    return NULL;
+
+  array = malloc(sizeof(struct Cookie *) * ci->numcookies);
+  if(!array)
     return NULL;
 
-  for(i = 0; i < COOKIE_HASH_SIZE; i++) {
-    for(n = Curl_llist_head(&data->cookies->cookielist[i]); n;
-        n = Curl_node_next(n)) {
-      struct Cookie *c = Curl_node_elem(n);
-      char *line;
-      if(!c->domain)
-        continue;
-      line = get_netscape_format(c);
-      if(!line) {
-        curl_slist_free_all(list);
-        return NULL;
-      }
-      beg = Curl_slist_append_nodup(list, line);
-      if(!beg) {
-        free(line);
-        curl_slist_free_all(list);
-        return NULL;
-      }
-      list = beg;
+  /* only list the cookies with a domain property */
+  for(dom = cookie_domain_next(ci, NULL, &slot); dom;
+      dom = cookie_domain_next(ci, dom, &slot)) {
+    if(dom == ci->nodomain)
+      continue;
+    for(n = Curl_llist_head(&dom->cookies); n; n = Curl_node_next(n))
+      array[nvalid++] = Curl_node_elem(n);
+  }
+
+  /* list them in the order they were added, not in the hash order */
+  qsort(array, nvalid, sizeof(struct Cookie *), cookie_sort_added);
+
+  for(i = 0; i < nvalid; i++) {
+    char *line = get_netscape_format(array[i]);
+    if(!line) {
+      curl_slist_free_all(list);
+      list = NULL;
+      break;
+    }
+    beg = Curl_slist_append_nodup(list, line);
+    if(!beg) {
+      free(line);
+      curl_slist_free_all(list);
+      list = NULL;
+      break;
     }
+    list = beg;
   }
 
+  free(array);
   return list;
 }
 
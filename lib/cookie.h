@@ -29,16 +29,26 @@
 
 #include "llist.h"
 
+struct cookie_domain;
+struct cookie_path;
+
 struct Cookie {
-  struct Curl_llist_node node; /* for the main cookie list */
+  struct Curl_llist_node node; /* for the list of its domain */
+  struct Curl_llist_node pathnode; /* for the list of its path */
   struct Curl_llist_node getnode; /* for getlist */
+  struct Curl_llist_node dirtynode; /* for the list of unsaved cookies */
+  struct cookie_path *pidx; /* the path index node holding this cookie */
   char *name;         /* <this> = value */
   char *value;        /* name = <this> */
   char *path;         /* path = <this> which is in Set-Cookie: */
   char *spath;        /* sanitized cookie path */
   char *domain;       /* domain = <this> */
+  char *strings;      /* when set, the one allocation holding all the above
+                         strings */
   curl_off_t expires; /* expires = <this> */
   unsigned int creationtime; /* time when the cookie was written */
+  unsigned int added; /* when it was added to the jar, unlike creationtime
+                         this is not kept from a cookie it replaces */
   BIT(tailmatch);     /* tail-match the domain name */
   BIT(secure);        /* the 'secure' keyword was used */
   BIT(livecookie);    /* updated from a server, not a stored file */
@@ -54,11 +64,23 @@ struct Cookie {
 #define COOKIE_PREFIX__SECURE (1<<0)
 #define COOKIE_PREFIX__HOST (1<<1)
 
-#define COOKIE_HASH_SIZE 63
+/* initial number of slots in the domain hash, must be a power of two */
+#define COOKIE_HASH_SIZE 64
 
 struct CookieInfo {
-  /* linked lists of cookies we know of */
-  struct Curl_llist cookielist[COOKIE_HASH_SIZE];
+  /* hash of the domains we know cookies for, grows with the number of
+     domains. Each domain has a path index of its cookies. */
+  struct cookie_domain **domains;
+  struct cookie_domain *nodomain; /* cookies without a domain */
+  size_t nslots;   /* number of slots in 'domains' */
+  size_t ndomains; /* number of domains in 'domains' */
+  struct Curl_llist stores; /* binary store files not read in full */
+  /* journal state, for appending changes to the cookie jar file */
+  struct Curl_llist dirty;   /* cookies added since the jar was written */
+  struct Curl_llist removed; /* removed cookies the jar file may hold */
+  char *journal;             /* the cookie jar file when journaled */
+  curl_off_t journal_size;   /* its size after it was last written */
+  size_t journal_lines;      /* number of cookie lines in it */
   curl_off_t next_expiration; /* the next time at which expiration happens */
   unsigned int numcookies;  /* number of cookies in the "jar" */
   unsigned int lastct;      /* last creation-time used in the jar */
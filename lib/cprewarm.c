@@ -0,0 +1,472 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "curl_setup.h"
+
+#include <curl/curl.h>
+
+#include "urldata.h"
+#include "url.h"
+#include "cfilters.h"
+#include "conncache.h"
+#include "cprewarm.h"
+#include "multihandle.h"
+#include "multiif.h"
+#include "sendf.h"
+#include "curl_trc.h"
+
+/* The last 3 #include files should be in this order */
+#include "curl_printf.h"
+#include "curl_memory.h"
+#include "memdebug.h"
+
+/* The most idle connections kept warm for a single origin */
+#define CPREWARM_MAX_IDLE       256
+/* Check the warm connections at least this often */
+#define CPREWARM_CHECK_MS       1000
+/* First wait after a failed warm-up, doubled on each further failure */
+#define CPREWARM_BACKOFF_MS     500
+#define CPREWARM_BACKOFF_MAX_MS (30 * 1000)
+
+struct cprewarm_slot {
+  curl_off_t conn_id;    /* the connection kept warm or -1 */
+  unsigned int mid;      /* transfer warming one up or UINT_MAX */
+  BIT(done);             /* that transfer has finished */
+};
+
+struct cprewarm_origin {
+  struct Curl_llist_node node;
+  struct Curl_easy *tmpl;       /* options for the warm-up transfers */
+  char *origin;                 /* "scheme://host:port" */
+  struct cprewarm_slot *slots;  /* `min_idle` of them */
+  unsigned int min_idle;
+  timediff_t backoff_ms;        /* wait after failures, 0 when working */
+  struct curltime failed;       /* time of the last failure */
+};
+
+struct cprewarm {
+  struct Curl_llist origins;    /* struct cprewarm_origin */
+  struct curltime last_check;
+  timediff_t check_ms;          /* next check this long after the last */
+  unsigned int wanted;          /* sum of all `min_idle` */
+  BIT(check);                   /* check at the next opportunity */
+};
+
+static struct cprewarm_origin *cprewarm_find(struct cprewarm *pw,
+                                             const char *origin)
+{
+  struct Curl_llist_node *e;
+  for(e = Curl_llist_head(&pw->origins); e; e = Curl_node_next(e)) {
+    struct cprewarm_origin *o = Curl_node_elem(e);
+    if(curl_strequal(o->origin, origin))
+      return o;
+  }
+  return NULL;
+}
+
+/* Stop the slot's warm-up transfer if still running, close its handle. */
+static void cprewarm_slot_reap(struct Curl_multi *multi,
+                               struct cprewarm_slot *slot)
+{
+  struct Curl_easy *data = Curl_multi_get_easy(multi, slot->mid);
+  if(data) {
+    (void)curl_multi_remove_handle(multi, data);
+    Curl_close(&data);
+  }
+  slot->mid = UINT_MAX;
+  slot->done = FALSE;
+}
+
+static void cprewarm_origin_free(struct Curl_multi *multi,
+                                 struct cprewarm_origin *o)
+{
+  unsigned int i;
+  for(i = 0; i < o->min_idle; i++) {
+    if(o->slots[i].mid != UINT_MAX)
+      cprewarm_slot_reap(multi, &o->slots[i]);
+  }
+  Curl_node_remove(&o->node);
+  Curl_close(&o->tmpl);
+  free(o->origin);
+  free(o->slots);
+  free(o);
+}
+
+static char *cprewarm_origin_of(const char *url)
+{
+  CURLU *uh = curl_url();
+  char *scheme = NULL;
+  char *host = NULL;
+  char *port = NULL;
+  char *origin = NULL;
+
+  if(uh &&
+     !curl_url_set(uh, CURLUPART_URL, url,
+                   CURLU_GUESS_SCHEME | CURLU_NON_SUPPORT_SCHEME) &&
+     !curl_url_get(uh, CURLUPART_SCHEME, &scheme, 0) &&
+     !curl_url_get(uh, CURLUPART_HOST, &host, 0) &&
+     !curl_url_get(uh, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT))
+    origin = aprintf("%s://%s:%s", scheme, host, port);
+
+  curl_free(scheme);
+  curl_free(host);
+  curl_free(port);
+  curl_url_cleanup(uh);
+  return origin;
+}
+
+/* The options for warm-up transfers: those `data` connects to `url` with.
+ * Each warm-up transfer gets its own copy that connects anew and leaves
+ * the connection in the pool. */
+static struct Curl_easy *cprewarm_tmpl(struct Curl_easy *data,
+                                       const char *url)
+{
+  struct Curl_easy *tmpl;
+  if(Curl_open_internal(data, url, &tmpl))
+    return NULL;
+  return tmpl;
+}
+
+static CURLMcode cprewarm_origin_update(struct Curl_multi *multi,
+                                        struct cprewarm_origin *o,
+                                        struct Curl_easy *data,
+                                        const char *url,
+                                        unsigned int min_idle)
+{
+  struct Curl_easy *tmpl = cprewarm_tmpl(data, url);
+  unsigned int i;
+
+  if(!tmpl)
+    return CURLM_OUT_OF_MEMORY;
+
+  if(min_idle > o->min_idle) {
+    struct cprewarm_slot *slots =
+      realloc(o->slots, min_idle * sizeof(struct cprewarm_slot));
+    if(!slots) {
+      Curl_close(&tmpl);
+      return CURLM_OUT_OF_MEMORY;
+    }
+    for(i = o->min_idle; i < min_idle; i++) {
+      slots[i].conn_id = -1;
+      slots[i].mid = UINT_MAX;
+      slots[i].done = FALSE;
+    }
+    o->slots = slots;
+  }
+  else {
+    /* Slots beyond the new number are forgotten. Their connections
+     * stay in the pool until used or pruned. */
+    for(i = min_idle; i < o->min_idle; i++) {
+      if(o->slots[i].mid != UINT_MAX)
+        cprewarm_slot_reap(multi, &o->slots[i]);
+    }
+  }
+  o->min_idle = min_idle;
+  Curl_close(&o->tmpl);
+  o->tmpl = tmpl;
+  o->backoff_ms = 0;
+  return CURLM_OK;
+}
+
+static void cprewarm_xfer_done(struct Curl_easy *admin,
+                               struct Curl_easy *data,
+                               CURLcode result)
+{
+  struct cprewarm *pw = admin->multi->prewarm;
+  struct Curl_llist_node *e;
+
+  if(!pw)
+    return;
+  for(e = Curl_llist_head(&pw->origins); e; e = Curl_node_next(e)) {
+    struct cprewarm_origin *o = Curl_node_elem(e);
+    unsigned int i;
+    for(i = 0; i < o->min_idle; i++) {
+      struct cprewarm_slot *slot = &o->slots[i];
+      if(slot->mid != data->mid)
+        continue;
+      slot->done = TRUE;
+      /* A connection closed again right away counts as failure, or
+       * we would keep on connecting. */
+      if(!result && (data->state.recent_conn_id >= 0) &&
+         Curl_cpool_get_conn(admin, data->state.recent_conn_id)) {
+        slot->conn_id = data->state.recent_conn_id;
+        o->backoff_ms = 0;
+        CURL_TRC_M(data, "warmed up connection #%" FMT_OFF_T " to %s",
+                   slot->conn_id, o->origin);
+      }
+      else {
+        o->backoff_ms = o->backoff_ms ?
+          CURLMIN(o->backoff_ms * 2, CPREWARM_BACKOFF_MAX_MS) :
+          CPREWARM_BACKOFF_MS;
+        o->failed = curlx_now();
+        infof(data, "Warming up a connection to %s failed, retry in %"
+              FMT_TIMEDIFF_T " ms", o->origin, o->backoff_ms);
+      }
+      /* have the handle reaped */
+      pw->check = TRUE;
+      Curl_expire(admin, 0, EXPIRE_PREWARM);
+      return;
+    }
+  }
+}
+
+CURLMcode Curl_cprewarm_set(struct Curl_multi *multi,
+                            struct Curl_easy *data,
+                            unsigned int min_idle)
+{
+  struct cprewarm *pw = multi->prewarm;
+  struct cprewarm_origin *o;
+  struct Curl_llist_node *e;
+  char *url = NULL;
+  char *origin = NULL;
+  CURLMcode mresult = CURLM_OK;
+
+  if(min_idle > CPREWARM_MAX_IDLE)
+    return CURLM_BAD_FUNCTION_ARGUMENT;
+
+  if(data->set.uh) {
+    if(curl_url_get(data->set.uh, CURLUPART_URL, &url, 0))
+      return CURLM_BAD_FUNCTION_ARGUMENT;
+  }
+  else if(data->set.str[STRING_SET_URL]) {
+    url = strdup(data->set.str[STRING_SET_URL]);
+    if(!url)
+      return CURLM_OUT_OF_MEMORY;
+  }
+  else
+    return CURLM_BAD_FUNCTION_ARGUMENT;
+
+  origin = cprewarm_origin_of(url);
+  if(!origin) {
+    mresult = CURLM_BAD_FUNCTION_ARGUMENT;
+    goto out;
+  }
+
+  if(!pw) {
+    if(!min_idle)
+      goto out;
+    pw = calloc(1, sizeof(*pw));
+    if(!pw) {
+      mresult = CURLM_OUT_OF_MEMORY;
+      goto out;
+    }
+    Curl_llist_init(&pw->origins, NULL);
+    multi->prewarm = pw;
+    /* the warm-up transfers report to the admin handle */
+    multi->admin->sub_xfer_done = cprewarm_xfer_done;
+  }
+
+  o = cprewarm_find(pw, origin);
+  if(!min_idle) {
+    if(o)
+      cprewarm_origin_free(multi, o);
+  }
+  else {
+    bool added = FALSE;
+    if(!o) {
+      o = calloc(1, sizeof(*o));
+      if(!o) {
+        mresult = CURLM_OUT_OF_MEMORY;
+        goto out;
+      }
+      o->origin = origin;
+      origin = NULL;
+      Curl_llist_append(&pw->origins, o, &o->node);
+      added = TRUE;
+    }
+    mresult = cprewarm_origin_update(multi, o, data, url, min_idle);
+    if(mresult) {
+      if(added)
+        cprewarm_origin_free(multi, o);
+      goto out;
+    }
+    /* The admin handle does the upkeep of pooled connections. Like its
+     * timeouts, use the interval of the most recent handle. */
+    multi->admin->set.upkeep_interval_ms = data->set.upkeep_interval_ms;
+  }
+
+  pw->wanted = 0;
+  for(e = Curl_llist_head(&pw->origins); e; e = Curl_node_next(e)) {
+    o = Curl_node_elem(e);
+    pw->wanted += o->min_idle;
+  }
+  pw->check = TRUE;
+  Curl_expire(multi->admin, 0, EXPIRE_PREWARM);
+
+out:
+  free(origin);
+  free(url);
+  return mresult;
+}
+
+struct cprewarm_check {
+  const struct Curl_easy *tmpl;
+  struct curltime now;
+  timediff_t refresh_ms;  /* time until the connection gets replaced */
+  BIT(keep);              /* the connection is still warm */
+};
+
+/* Under the pool lock, see if the connection kept warm is still good. */
+static void cprewarm_check_conn(struct connectdata *conn,
+                                struct Curl_easy *data,
+                                void *userdata)
+{
+  struct cprewarm_check *chk = userdata;
+  const struct UserDefined *set = &chk->tmpl->set;
+  timediff_t left_ms = CPREWARM_CHECK_MS;
+
+  if(CONN_INUSE(conn)) {
+    /* Taken by a transfer. A multiplexed connection is still there for
+     * others, any other needs a replacement. */
+    chk->keep = Curl_conn_is_multiplex(conn, FIRSTSOCKET);
+    return;
+  }
+  if(conn->bits.close || conn->bits.no_reuse)
+    return;
+
+  /* Replace connections before transfers find them too old to reuse */
+  if(set->conn_max_idle_ms)
+    left_ms = CURLMIN(left_ms, (set->conn_max_idle_ms / 4 * 3) -
+                      curlx_timediff(chk->now, conn->lastused));
+  if(set->conn_max_age_ms)
+    left_ms = CURLMIN(left_ms, (set->conn_max_age_ms / 4 * 3) -
+                      curlx_timediff(chk->now, conn->created));
+  if((left_ms <= 0) || Curl_conn_seems_dead(conn, data, &chk->now)) {
+    CURL_TRC_M(data, "replacing warm connection #%" FMT_OFF_T,
+               conn->connection_id);
+    Curl_conn_terminate(data, conn, FALSE);
+    return;
+  }
+  Curl_conn_upkeep(data, conn, &chk->now);
+  chk->keep = TRUE;
+  chk->refresh_ms = left_ms;
+}
+
+static timediff_t cprewarm_origin_run(struct Curl_multi *multi,
+                                      struct cprewarm_origin *o,
+                                      struct curltime now)
+{
+  timediff_t next_ms = CPREWARM_CHECK_MS;
+  unsigned int i;
+
+  for(i = 0; i < o->min_idle; i++) {
+    struct cprewarm_slot *slot = &o->slots[i];
+
+    if(slot->mid != UINT_MAX) {
+      if(!slot->done)
+        continue; /* still connecting */
+      cprewarm_slot_reap(multi, slot);
+    }
+
+    if(slot->conn_id >= 0) {
+      struct cprewarm_check chk;
+      chk.tmpl = o->tmpl;
+      chk.now = now;
+      chk.refresh_ms = CPREWARM_CHECK_MS;
+      chk.keep = FALSE;
+      Curl_cpool_do_by_id(multi->admin, slot->conn_id,
+                          cprewarm_check_conn, &chk);
+      if(chk.keep) {
+        next_ms = CURLMIN(next_ms, chk.refresh_ms);
+        continue;
+      }
+      slot->conn_id = -1;
+    }
+
+    if(o->backoff_ms) {
+      timediff_t wait_ms = o->backoff_ms - curlx_timediff(now, o->failed);
+      if(wait_ms > 0) {
+        next_ms = CURLMIN(next_ms, wait_ms);
+        continue;
+      }
+    }
+
+    {
+      struct Curl_easy *data;
+      if(Curl_open_internal(o->tmpl, o->tmpl->set.str[STRING_SET_URL],
+                            &data))
+        break;
+      data->set.reuse_fresh = TRUE;
+      data->state.prewarm = TRUE;
+      data->master_mid = multi->admin->mid;
+      if(curl_multi_add_handle(multi, data)) {
+        Curl_close(&data);
+        break;
+      }
+      slot->mid = data->mid;
+      CURL_TRC_M(data, "warming up a connection to %s", o->origin);
+    }
+  }
+  return next_ms;
+}
+
+void Curl_cprewarm_perform(struct Curl_multi *multi)
+{
+  struct cprewarm *pw = multi->prewarm;
+  struct Curl_llist_node *e;
+  struct curltime now;
+  timediff_t next_ms = CPREWARM_CHECK_MS;
+
+  if(!pw || !Curl_llist_count(&pw->origins))
+    return;
+  now = curlx_now();
+  if(!pw->check && (curlx_timediff(now, pw->last_check) < pw->check_ms))
+    return;
+
+  pw->check = FALSE;
+  for(e = Curl_llist_head(&pw->origins); e; e = Curl_node_next(e)) {
+    timediff_t ms = cprewarm_origin_run(multi, Curl_node_elem(e), now);
+    next_ms = CURLMIN(next_ms, ms);
+  }
+  pw->last_check = now;
+  pw->check_ms = next_ms;
+  Curl_expire(multi->admin, next_ms, EXPIRE_PREWARM);
+}
+
+void Curl_cprewarm_conn_reused(struct Curl_easy *data)
+{
+  struct Curl_multi *multi = data->multi;
+  if(multi && multi->prewarm && !data->state.prewarm) {
+    multi->prewarm->check = TRUE;
+    Curl_expire(multi->admin, 0, EXPIRE_PREWARM);
+  }
+}
+
+unsigned int Curl_cprewarm_wanted(struct Curl_multi *multi)
+{
+  return multi->prewarm ? multi->prewarm->wanted : 0;
+}
+
+void Curl_cprewarm_destroy(struct Curl_multi *multi)
+{
+  struct cprewarm *pw = multi->prewarm;
+  if(pw) {
+    while(Curl_llist_count(&pw->origins))
+      cprewarm_origin_free(multi,
+                           Curl_node_elem(Curl_llist_head(&pw->origins)));
+    multi->admin->sub_xfer_done = NULL;
+    free(pw);
+    multi->prewarm = NULL;
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef HEADER_CURL_CPREWARM_H
+#define HEADER_CURL_CPREWARM_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include <curl/curl.h>
+
+struct Curl_easy;
+struct Curl_multi;
+
+/* Keep `min_idle` connections to the origin of the URL set in `tmpl`
+ * connected and idle in the multi's connection pool. The transfer
+ * options of `tmpl` are copied. A call for an origin already known
+ * replaces its settings, a `min_idle` of 0 removes the origin. */
+CURLMcode Curl_cprewarm_set(struct Curl_multi *multi,
+                            struct Curl_easy *tmpl,
+                            unsigned int min_idle);
+
+/* Start warm-up transfers for missing connections, refresh the ones
+ * kept and reap finished warm-ups. Does nothing unless a check is due. */
+void Curl_cprewarm_perform(struct Curl_multi *multi);
+
+/* A transfer reuses a connection from the pool, which may have been
+ * one kept warm. Have the pre-warmed connections checked soon. */
+void Curl_cprewarm_conn_reused(struct Curl_easy *data);
+
+/* Number of idle connections the multi keeps warm in total. */
+unsigned int Curl_cprewarm_wanted(struct Curl_multi *multi);
+
+/* Stop running warm-up transfers and free all pre-warm settings. */
+void Curl_cprewarm_destroy(struct Curl_multi *multi);
+
+#endif /* HEADER_CURL_CPREWARM_H */
@@ -87,6 +87,53 @@ Curl_freeaddrinfo(struct Curl_addrinfo *cahead)
   }
 }
 
+/*
+ * Curl_addrinfo_dup()
+ *
+ * Returns a deep copy of the given Curl_addrinfo list, allocated the same
+ * way as the original so that it must be free'd with Curl_freeaddrinfo().
+ * Returns NULL on out of memory.
+ */
+struct Curl_addrinfo *
+Curl_addrinfo_dup(const struct Curl_addrinfo *orig)
+{
+  struct Curl_addrinfo *cafirst = NULL;
+  struct Curl_addrinfo *calast = NULL;
+  struct Curl_addrinfo *ca;
+  const struct Curl_addrinfo *ai;
+
+  for(ai = orig; ai; ai = ai->ai_next) {
+    size_t ss_size = (size_t)ai->ai_addrlen;
+    size_t namelen = ai->ai_canonname ? strlen(ai->ai_canonname) + 1 : 0;
+
+    ca = malloc(sizeof(struct Curl_addrinfo) + ss_size + namelen);
+    if(!ca) {
+      Curl_freeaddrinfo(cafirst);
+      return NULL;
+    }
+    *ca = *ai;
+    ca->ai_addr = NULL;
+    ca->ai_canonname = NULL;
+    ca->ai_next = NULL;
+
+    if(ss_size) {
+      ca->ai_addr = (void *)((char *)ca + sizeof(struct Curl_addrinfo));
+      memcpy(ca->ai_addr, ai->ai_addr, ss_size);
+    }
+    if(namelen) {
+      ca->ai_canonname = (char *)ca + sizeof(struct Curl_addrinfo) + ss_size;
+      memcpy(ca->ai_canonname, ai->ai_canonname, namelen);
+    }
+
+    if(!cafirst)
+      cafirst = ca;
+    if(calast)
+      calast->ai_next = ca;
+    calast = ca;
+  }
+  return cafirst;
+}
+
 
 #ifdef HAVE_GETADDRINFO
 /*
@@ -464,6 +464,16 @@
 #define USE_EVENTFD
 #endif
 
+/* Whether to send unencoded mime file parts with sendfile() */
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+#define USE_SENDFILE
+#endif
+
+/* Whether an epoll backend is available for curl_multi_wait() */
+#if defined(HAVE_EPOLL_CREATE1) && defined(HAVE_SYS_EPOLL_H)
+#define USE_EPOLL
+#endif
+
 #include <stdio.h>
 #include <assert.h>
 
@@ -30,6 +30,47 @@
 #include "warnless.h"
 #include "base64.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+  ((defined(__clang__) && (__clang_major__ >= 4)) ||                    \
+   (!defined(__clang__) && (__GNUC__ >= 5)))
+/* The vector functions are built for their instruction sets and used when
+   the CPU running them has them. Unless enabled at compile time, that is
+   checked with the CPU features the compiler runtime detected at
+   startup. */
+#include <immintrin.h>
+#define BASE64_AVX2
+#define BASE64_SSSE3
+#define BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+#define BASE64_TARGET_SSSE3 __attribute__((target("ssse3")))
+#ifdef __AVX2__
+#define BASE64_USE_AVX2 1
+#else
+#define BASE64_USE_AVX2 __builtin_cpu_supports("avx2")
+#endif
+#ifdef __SSSE3__
+#define BASE64_USE_SSSE3 1
+#else
+#define BASE64_USE_SSSE3 __builtin_cpu_supports("ssse3")
+#endif
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define BASE64_AVX2
+#define BASE64_SSSE3
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BASE64_SSSE3
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BASE64_NEON
+#endif
+
+#ifndef BASE64_TARGET_AVX2
+#define BASE64_TARGET_AVX2
+#define BASE64_TARGET_SSSE3
+#define BASE64_USE_AVX2 1
+#define BASE64_USE_SSSE3 1
+#endif
+
 /* The last 2 #include files should be in this order */
 #ifdef BUILDING_LIBCURL
 #include "../curl_memory.h"
@@ -51,6 +92,234 @@ static const unsigned char decodetable[] =
   17, 18, 19, 20, 21, 22, 23, 24, 25, 255, 255, 255, 255, 255, 255, 26, 27, 28,
   29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47,
   48, 49, 50, 51 };
+
+#ifdef BASE64_SSSE3
+/* The vector code encodes and decodes four quantums per 128 bit register,
+   using the method described by Wojciech Muła and Daniel Lemire in "Faster
+   Base64 Encoding and Decoding using AVX2 Instructions". */
+
+/* spread the twelve bytes in the lower part of the lanes of `in` into
+   sixteen 6-bit values */
+#define BASE64_SPLIT_MASK                                               \
+  10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1
+
+BASE64_TARGET_SSSE3
+static __m128i base64_sse_split(__m128i in)
+{
+  __m128i t0, t1;
+  in = _mm_shuffle_epi8(in, _mm_set_epi8(BASE64_SPLIT_MASK));
+  t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                       _mm_set1_epi32(0x04000040));
+  t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                       _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(t0, t1);
+}
+
+/* map the 6-bit values in `v` to characters. Values below 26 get the
+   offset of 'A', up to 51 the one of 'a' and up to 61 the one of '0'. The
+   last two offsets in `shift` depend on the alphabet. */
+BASE64_TARGET_SSSE3
+static __m128i base64_sse_chars(__m128i v, __m128i shift)
+{
+  __m128i r = _mm_subs_epu8(v, _mm_set1_epi8(51));
+  __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), v);
+  r = _mm_or_si128(r, _mm_and_si128(less, _mm_set1_epi8(13)));
+  return _mm_add_epi8(_mm_shuffle_epi8(shift, r), v);
+}
+
+#define BASE64_DEC_LUT_LO                                               \
+  0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,                       \
+  0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a
+#define BASE64_DEC_LUT_HI                                               \
+  0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,                       \
+  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+#define BASE64_DEC_LUT_ROLL                                             \
+  0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+#define BASE64_PACK_MASK                                                \
+  2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+
+/* decode sixteen characters of the standard alphabet in `in` to twelve
+   bytes at the start of `out`. Returns FALSE if a character is not part of
+   the alphabet. */
+BASE64_TARGET_SSSE3
+static bool base64_sse_decode(__m128i in, __m128i *out)
+{
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+  __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask_2f);
+  __m128i lo = _mm_shuffle_epi8(_mm_setr_epi8(BASE64_DEC_LUT_LO),
+                                _mm_and_si128(in, mask_2f));
+  __m128i hi = _mm_shuffle_epi8(_mm_setr_epi8(BASE64_DEC_LUT_HI),
+                                hi_nibbles);
+  __m128i roll = _mm_shuffle_epi8(_mm_setr_epi8(BASE64_DEC_LUT_ROLL),
+                                  _mm_add_epi8(_mm_cmpeq_epi8(in, mask_2f),
+                                               hi_nibbles));
+  if(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                                      _mm_setzero_si128())))
+    return FALSE;
+  in = _mm_add_epi8(in, roll);
+  in = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+  in = _mm_madd_epi16(in, _mm_set1_epi32(0x00011000));
+  *out = _mm_shuffle_epi8(in, _mm_setr_epi8(BASE64_PACK_MASK));
+  return TRUE;
+}
+#endif
+
+#ifdef BASE64_AVX2
+/* the same as the 128 bit functions above, for two lanes of twelve bytes
+   or sixteen characters each */
+BASE64_TARGET_AVX2
+static __m256i base64_avx2_split(__m256i in)
+{
+  __m256i t0, t1;
+  in = _mm256_shuffle_epi8(in, _mm256_set_epi8(BASE64_SPLIT_MASK,
+                                               BASE64_SPLIT_MASK));
+  t0 = _mm256_mulhi_epu16(_mm256_and_si256(in,
+                                           _mm256_set1_epi32(0x0fc0fc00)),
+                          _mm256_set1_epi32(0x04000040));
+  t1 = _mm256_mullo_epi16(_mm256_and_si256(in,
+                                           _mm256_set1_epi32(0x003f03f0)),
+                          _mm256_set1_epi32(0x01000010));
+  return _mm256_or_si256(t0, t1);
+}
+
+BASE64_TARGET_AVX2
+static __m256i base64_avx2_chars(__m256i v, __m256i shift)
+{
+  __m256i r = _mm256_subs_epu8(v, _mm256_set1_epi8(51));
+  __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), v);
+  r = _mm256_or_si256(r, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+  return _mm256_add_epi8(_mm256_shuffle_epi8(shift, r), v);
+}
+
+/* decode 32 characters to 24 bytes at the start of `out` */
+BASE64_TARGET_AVX2
+static bool base64_avx2_decode(__m256i in, __m256i *out)
+{
+  const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+  __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+  __m256i lo = _mm256_shuffle_epi8(_mm256_setr_epi8(BASE64_DEC_LUT_LO,
+                                                    BASE64_DEC_LUT_LO),
+                                   _mm256_and_si256(in, mask_2f));
+  __m256i hi = _mm256_shuffle_epi8(_mm256_setr_epi8(BASE64_DEC_LUT_HI,
+                                                    BASE64_DEC_LUT_HI),
+                                   hi_nibbles);
+  __m256i roll = _mm256_shuffle_epi8(
+    _mm256_setr_epi8(BASE64_DEC_LUT_ROLL, BASE64_DEC_LUT_ROLL),
+    _mm256_add_epi8(_mm256_cmpeq_epi8(in, mask_2f), hi_nibbles));
+  if(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(lo, hi),
+                                            _mm256_setzero_si256())))
+    return FALSE;
+  in = _mm256_add_epi8(in, roll);
+  in = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+  in = _mm256_madd_epi16(in, _mm256_set1_epi32(0x00011000));
+  in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(BASE64_PACK_MASK,
+                                                BASE64_PACK_MASK));
+  *out = _mm256_permutevar8x32_epi32(in, _mm256_setr_epi32(0, 1, 2, 4, 5, 6,
+                                                           7, 7));
+  return TRUE;
+}
+
+/* stores 32 bytes for eight quantums */
+BASE64_TARGET_AVX2
+static size_t base64_decode_avx2(const char *src, unsigned char *out,
+                                 size_t quantums)
+{
+  size_t done = 0;
+  while(quantums - done >= 11) {
+    __m256i v;
+    if(!base64_avx2_decode(
+         _mm256_loadu_si256((const __m256i *)(const void *)src), &v))
+      break;
+    _mm256_storeu_si256((__m256i *)(void *)out, v);
+    src += 32;
+    out += 24;
+    done += 8;
+  }
+  return done;
+}
+#endif
+
+#ifdef BASE64_SSSE3
+/* stores sixteen bytes for four quantums */
+BASE64_TARGET_SSSE3
+static size_t base64_decode_sse(const char *src, unsigned char *out,
+                                size_t quantums)
+{
+  size_t done = 0;
+  while(quantums - done >= 6) {
+    __m128i v;
+    if(!base64_sse_decode(
+         _mm_loadu_si128((const __m128i *)(const void *)src), &v))
+      break;
+    _mm_storeu_si128((__m128i *)(void *)out, v);
+    src += 16;
+    out += 12;
+    done += 4;
+  }
+  return done;
+}
+#endif
+
+/*
+ * Decode complete quantums of the standard alphabet at `src` to `out` for
+ * as long as the vector code can do it without writing beyond the output of
+ * `quantums`. Stops before the first block with a character that is not
+ * part of the alphabet. Returns the number of quantums decoded.
+ */
+static size_t base64_decode_blocks(const unsigned char *lookup,
+                                   const char *src, unsigned char *out,
+                                   size_t quantums)
+{
+  size_t done = 0;
+#ifdef BASE64_SSSE3
+#ifdef BASE64_AVX2
+  if(BASE64_USE_AVX2)
+    done = base64_decode_avx2(src, out, quantums);
+#endif
+  if(BASE64_USE_SSSE3)
+    done += base64_decode_sse(src + done * 4, out + done * 3,
+                              quantums - done);
+#elif defined(BASE64_NEON)
+  if(quantums >= 16) {
+    const uint8x16_t invalid = vdupq_n_u8(0xc0);
+    uint8x16x4_t tlo, thi;
+    int k;
+    for(k = 0; k < 4; k++) {
+      tlo.val[k] = vld1q_u8(&lookup[k * 16]);
+      thi.val[k] = vld1q_u8(&lookup[64 + k * 16]);
+    }
+    do {
+      uint8x16x4_t c = vld4q_u8((const uint8_t *)src);
+      uint8x16_t bad = vdupq_n_u8(0);
+      uint8x16x3_t o;
+      for(k = 0; k < 4; k++) {
+        /* characters from 128 on are not in any of the two tables */
+        uint8x16_t x = vorrq_u8(vqtbl4q_u8(tlo, c.val[k]),
+                                vqtbl4q_u8(thi, vsubq_u8(c.val[k],
+                                                         vdupq_n_u8(64))));
+        bad = vorrq_u8(bad, vorrq_u8(x, vcgeq_u8(c.val[k],
+                                                 vdupq_n_u8(128))));
+        c.val[k] = x;
+      }
+      if(vmaxvq_u8(vandq_u8(bad, invalid)))
+        return done;
+      o.val[0] = vorrq_u8(vshlq_n_u8(c.val[0], 2), vshrq_n_u8(c.val[1], 4));
+      o.val[1] = vorrq_u8(vshlq_n_u8(c.val[1], 4), vshrq_n_u8(c.val[2], 2));
+      o.val[2] = vorrq_u8(vshlq_n_u8(c.val[2], 6), c.val[3]);
+      vst3q_u8(out, o);
+      src += 64;
+      out += 48;
+      done += 16;
+    } while(quantums - done >= 16);
+  }
+#endif
+  (void)lookup;
+  (void)src;
+  (void)out;
+  (void)quantums;
+  return done;
+}
+
 /*
  * curlx_base64_decode()
  *
@@ -112,8 +381,11 @@ CURLcode curlx_base64_decode(const char *src,
   memset(lookup, 0xff, sizeof(lookup));
   memcpy(&lookup['+'], decodetable, sizeof(decodetable));
 
-  /* Decode the complete quantums first */
-  for(i = 0; i < fullQuantums; i++) {
+  /* Decode the complete quantums first, as many as possible in blocks */
+  i = base64_decode_blocks(lookup, src, pos, fullQuantums);
+  src += i * 4;
+  pos += i * 3;
+  for(; i < fullQuantums; i++) {
     unsigned char val;
     unsigned int x = 0;
     int j;
@@ -169,6 +441,127 @@ bad:
   return CURLE_BAD_CONTENT_ENCODING;
 }
 
+#ifdef BASE64_SSSE3
+/* the offsets base64_sse_chars() adds for the alphabet `table64` */
+BASE64_TARGET_SSSE3
+static __m128i base64_sse_shift(const char *table64)
+{
+  return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                       '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                       '0' - 52, '0' - 52, '0' - 52,
+                       (char)(table64[62] - 62),
+                       (char)(table64[63] - 63), 'A', 0, 0);
+}
+
+/* loads sixteen bytes for four groups, returns the groups encoded */
+BASE64_TARGET_SSSE3
+static size_t base64_groups_sse(const char *table64, char *out,
+                                const unsigned char *in, size_t groups)
+{
+  const __m128i shift = base64_sse_shift(table64);
+  size_t done = 0;
+  while(groups - done >= 6) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(const void *)in);
+    v = base64_sse_chars(base64_sse_split(v), shift);
+    _mm_storeu_si128((__m128i *)(void *)out, v);
+    in += 12;
+    out += 16;
+    done += 4;
+  }
+  return done;
+}
+#endif
+
+#ifdef BASE64_AVX2
+/* loads 28 bytes for eight groups, returns the groups encoded */
+BASE64_TARGET_AVX2
+static size_t base64_groups_avx2(const char *table64, char *out,
+                                 const unsigned char *in, size_t groups)
+{
+  const __m128i shift = base64_sse_shift(table64);
+  const __m256i shift2 =
+    _mm256_inserti128_si256(_mm256_castsi128_si256(shift), shift, 1);
+  size_t done = 0;
+  while(groups - done >= 10) {
+    __m256i v = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(
+        _mm_loadu_si128((const __m128i *)(const void *)in)),
+      _mm_loadu_si128((const __m128i *)(const void *)(in + 12)), 1);
+    v = base64_avx2_chars(base64_avx2_split(v), shift2);
+    _mm256_storeu_si256((__m256i *)(void *)out, v);
+    in += 24;
+    out += 32;
+    done += 8;
+  }
+  return done;
+}
+#endif
+
+/* Encode `groups` complete groups of three bytes at `in` as four characters
+   of the alphabet `table64` each. */
+static void base64_groups(const char *table64, char *out,
+                          const unsigned char *in, size_t groups)
+{
+#ifdef BASE64_SSSE3
+  size_t done = 0;
+#ifdef BASE64_AVX2
+  if(BASE64_USE_AVX2)
+    done = base64_groups_avx2(table64, out, in, groups);
+#endif
+  if(BASE64_USE_SSSE3)
+    done += base64_groups_sse(table64, out + done * 4, in + done * 3,
+                              groups - done);
+  in += done * 3;
+  out += done * 4;
+  groups -= done;
+#elif defined(BASE64_NEON)
+  if(groups >= 16) {
+    const uint8x16_t mask = vdupq_n_u8(0x3f);
+    uint8x16x4_t tbl;
+    int k;
+    for(k = 0; k < 4; k++)
+      tbl.val[k] = vld1q_u8((const uint8_t *)&table64[k * 16]);
+    do {
+      uint8x16x3_t b = vld3q_u8(in);
+      uint8x16x4_t c;
+      c.val[0] = vshrq_n_u8(b.val[0], 2);
+      c.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(b.val[0], 4),
+                                   vshrq_n_u8(b.val[1], 4)), mask);
+      c.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(b.val[1], 2),
+                                   vshrq_n_u8(b.val[2], 6)), mask);
+      c.val[3] = vandq_u8(b.val[2], mask);
+      for(k = 0; k < 4; k++)
+        c.val[k] = vqtbl4q_u8(tbl, c.val[k]);
+      vst4q_u8((uint8_t *)out, c);
+      in += 48;
+      out += 64;
+      groups -= 16;
+    } while(groups >= 16);
+  }
+#endif
+  for(; groups; groups--) {
+    *out++ = table64[ in[0] >> 2 ];
+    *out++ = table64[ ((in[0] & 0x03) << 4) | (in[1] >> 4) ];
+    *out++ = table64[ ((in[1] & 0x0F) << 2) | ((in[2] & 0xC0) >> 6) ];
+    *out++ = table64[ in[2] & 0x3F ];
+    in += 3;
+  }
+}
+
+/*
+ * curlx_base64_encode_groups()
+ *
+ * Encode `groups` complete groups of three bytes at `in` as four characters
+ * each to `out`, without padding or terminating the output.
+ *
+ * @unittest: 3223
+ */
+void curlx_base64_encode_groups(char *out, const unsigned char *in,
+                                size_t groups)
+{
+  base64_groups(Curl_base64encdec, out, in, groups);
+}
+
 static CURLcode base64_encode(const char *table64,
                               unsigned char padbyte,
                               const char *inputbuff, size_t insize,
@@ -193,14 +586,10 @@ static CURLcode base64_encode(const char *table64,
   if(!output)
     return CURLE_OUT_OF_MEMORY;
 
-  while(insize >= 3) {
-    *output++ = table64[ in[0] >> 2 ];
-    *output++ = table64[ ((in[0] & 0x03) << 4) | (in[1] >> 4) ];
-    *output++ = table64[ ((in[1] & 0x0F) << 2) | ((in[2] & 0xC0) >> 6) ];
-    *output++ = table64[ in[2] & 0x3F ];
-    insize -= 3;
-    in += 3;
-  }
+  base64_groups(table64, output, in, insize / 3);
+  output += insize / 3 * 4;
+  in += insize / 3 * 3;
+  insize %= 3;
   if(insize) {
     /* this is only one or two bytes now */
     *output++ = table64[ in[0] >> 2 ];
@@ -30,6 +30,8 @@ CURLcode curlx_base64url_encode(const char *inputbuff, size_t insize,
                                 char **outptr, size_t *outlen);
 CURLcode curlx_base64_decode(const char *src,
                              unsigned char **outptr, size_t *outlen);
+void curlx_base64_encode_groups(char *out, const unsigned char *in,
+                                size_t groups);
 
 extern const char Curl_base64encdec[];
 
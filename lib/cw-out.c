@@ -70,6 +70,7 @@
  *
  * The amount of bytes being buffered is limited by `DYN_PAUSE_BUFFER`
  * and when that is exceeded `CURLE_TOO_LARGE` is returned as error.
+ * Buffered bytes count against the multi handle's CURLMOPT_MAX_MEMORY.
  */
 typedef enum {
   CW_OUT_NONE,
@@ -104,6 +105,7 @@ static void cw_out_buf_free(struct cw_out_buf *cwbuf)
 struct cw_out_ctx {
   struct Curl_cwriter super;
   struct cw_out_buf *buf;
+  size_t mem_charged; /* buffered bytes accounted in the multi */
   BIT(paused);
   BIT(errored);
 };
@@ -130,6 +132,7 @@ static CURLcode cw_out_init(struct Curl_easy *data,
   struct cw_out_ctx *ctx = writer->ctx;
   (void)data;
   ctx->buf = NULL;
+  ctx->mem_charged = 0;
   return CURLE_OK;
 }
 
@@ -153,12 +156,19 @@ static size_t cw_out_bufs_len(struct cw_out_ctx *ctx)
   return len;
 }
 
+static void cw_out_mem_update(struct cw_out_ctx *ctx,
+                              struct Curl_easy *data)
+{
+  if(ctx->buf || ctx->mem_charged)
+    Curl_multi_mem_out(data, &ctx->mem_charged, cw_out_bufs_len(ctx));
+}
+
 static void cw_out_close(struct Curl_easy *data, struct Curl_cwriter *writer)
 {
   struct cw_out_ctx *ctx = writer->ctx;
 
-  (void)data;
   cw_out_bufs_free(ctx);
+  cw_out_mem_update(ctx, data);
 }
 
 /**
@@ -408,23 +418,18 @@ static CURLcode cw_out_write(struct Curl_easy *data,
                              const char *buf, size_t blen)
 {
   struct cw_out_ctx *ctx = writer->ctx;
-  CURLcode result;
+  CURLcode result = CURLE_OK;
   bool flush_all = !!(type & CLIENTWRITE_EOS);
 
   if((type & CLIENTWRITE_BODY) ||
-     ((type & CLIENTWRITE_HEADER) && data->set.include_header)) {
+     ((type & CLIENTWRITE_HEADER) && data->set.include_header))
     result = cw_out_do_write(ctx, data, CW_OUT_BODY, flush_all, buf, blen);
-    if(result)
-      return result;
-  }
 
-  if(type & (CLIENTWRITE_HEADER|CLIENTWRITE_INFO)) {
+  if(!result && (type & (CLIENTWRITE_HEADER|CLIENTWRITE_INFO)))
     result = cw_out_do_write(ctx, data, CW_OUT_HDS, flush_all, buf, blen);
-    if(result)
-      return result;
-  }
 
-  return CURLE_OK;
+  cw_out_mem_update(ctx, data);
+  return result;
 }
 
 bool Curl_cw_out_is_paused(struct Curl_easy *data)
@@ -456,8 +461,8 @@ static CURLcode cw_out_flush(struct Curl_easy *data,
   if(result) {
     ctx->errored = TRUE;
     cw_out_bufs_free(ctx);
-    return result;
   }
+  cw_out_mem_update(ctx, data);
   return result;
 }
 
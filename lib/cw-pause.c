@@ -77,6 +77,7 @@ struct cw_pause_ctx {
   struct Curl_cwriter super;
   struct cw_pause_buf *buf;
   size_t buf_total;
+  size_t mem_charged; /* buffered bytes accounted in the multi */
 };
 
 static CURLcode cw_pause_write(struct Curl_easy *data,
@@ -102,6 +103,7 @@ static CURLcode cw_pause_init(struct Curl_easy *data,
   struct cw_pause_ctx *ctx = writer->ctx;
   (void)data;
   ctx->buf = NULL;
+  ctx->mem_charged = 0;
   return CURLE_OK;
 }
 
@@ -118,8 +120,9 @@ static void cw_pause_close(struct Curl_easy *data, struct Curl_cwriter *writer)
 {
   struct cw_pause_ctx *ctx = writer->ctx;
 
-  (void)data;
   cw_pause_bufs_free(ctx);
+  ctx->buf_total = 0;
+  Curl_multi_mem_out(data, &ctx->mem_charged, 0);
 }
 
 static CURLcode cw_pause_flush(struct Curl_easy *data,
@@ -148,7 +151,7 @@ static CURLcode cw_pause_flush(struct Curl_easy *data,
       DEBUGASSERT(ctx->buf_total >= wlen);
       ctx->buf_total -= wlen;
       if(result)
-        return result;
+        break;
     }
     else if((*plast)->type & CLIENTWRITE_EOS) {
       result = Curl_cwriter_write(data, cw_pause->next, (*plast)->type,
@@ -162,6 +165,7 @@ static CURLcode cw_pause_flush(struct Curl_easy *data,
       *plast = NULL;
     }
   }
+  Curl_multi_mem_out(data, &ctx->mem_charged, ctx->buf_total);
   return result;
 }
 
@@ -226,6 +230,7 @@ static CURLcode cw_pause_write(struct Curl_easy *data,
     ctx->buf_total += nwritten;
   } while(blen);
 
+  Curl_multi_mem_out(data, &ctx->mem_charged, ctx->buf_total);
   return result;
 }
 
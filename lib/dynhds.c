@@ -25,6 +25,7 @@
 #include "curl_setup.h"
 #include "dynhds.h"
 #include "strcase.h"
+#include "memscan.h"
 
 /* The last 3 #include files should be in this order */
 #ifdef USE_NGHTTP2
@@ -260,9 +261,7 @@ CURLcode Curl_dynhds_h1_add_line(struct dynhds *dynhds,
     value = p;
     valuelen = line_len - i;
 
-    p = memchr(value, '\r', valuelen);
-    if(!p)
-      p = memchr(value, '\n', valuelen);
+    p = Curl_memscan2(value, valuelen, '\r', '\n');
     if(p)
       valuelen = (size_t)(p - value);
 
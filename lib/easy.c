@@ -628,20 +628,23 @@ static CURLcode wait_or_timeout(struct Curl_multi *multi, struct events *ev)
     }
     else {
       /* here pollrc is > 0 */
-      /* loop over the monitored sockets to see which ones had activity */
-      unsigned int i;
+      /* collect the monitored sockets that had activity */
+      struct curl_sockaction acts[4];
+      unsigned int i, nacts = 0;
       for(i = 0; i < numfds; i++) {
         if(fds[i].revents) {
           /* socket activity, tell libcurl */
-          int act = poll2cselect(fds[i].revents); /* convert */
+          acts[nacts].fd = fds[i].fd;
+          acts[nacts].ev_bitmask = poll2cselect(fds[i].revents); /* convert */
 
           /* sending infof "randomly" to the first easy handle */
-          infof(multi->admin, "call curl_multi_socket_action(socket "
+          infof(multi->admin, "call curl_multi_socket_actions(socket "
                 "%" FMT_SOCKET_T ")", (curl_socket_t)fds[i].fd);
-          mcode = curl_multi_socket_action(multi, fds[i].fd, act,
-                                           &ev->running_handles);
+          nacts++;
         }
       }
+      mcode = curl_multi_socket_actions(multi, acts, nacts,
+                                        &ev->running_handles);
 
 
       if(!ev->msbump && ev->ms >= 0) {
@@ -62,6 +62,7 @@ const struct curl_easyoption Curl_easyopts[] = {
   {"COOKIE", CURLOPT_COOKIE, CURLOT_STRING, 0},
   {"COOKIEFILE", CURLOPT_COOKIEFILE, CURLOT_STRING, 0},
   {"COOKIEJAR", CURLOPT_COOKIEJAR, CURLOT_STRING, 0},
+  {"COOKIEJOURNAL", CURLOPT_COOKIEJOURNAL, CURLOT_LONG, 0},
   {"COOKIELIST", CURLOPT_COOKIELIST, CURLOT_STRING, 0},
   {"COOKIESESSION", CURLOPT_COOKIESESSION, CURLOT_LONG, 0},
   {"COPYPOSTFIELDS", CURLOPT_COPYPOSTFIELDS, CURLOT_OBJECT, 0},
@@ -75,6 +76,10 @@ const struct curl_easyoption Curl_easyopts[] = {
   {"DIRLISTONLY", CURLOPT_DIRLISTONLY, CURLOT_LONG, 0},
   {"DISALLOW_USERNAME_IN_URL", CURLOPT_DISALLOW_USERNAME_IN_URL,
    CURLOT_LONG, 0},
+  {"DNS_CACHE_NEGATIVE_TIMEOUT", CURLOPT_DNS_CACHE_NEGATIVE_TIMEOUT,
+   CURLOT_LONG, 0},
+  {"DNS_CACHE_STALE_TIMEOUT", CURLOPT_DNS_CACHE_STALE_TIMEOUT,
+   CURLOT_LONG, 0},
   {"DNS_CACHE_TIMEOUT", CURLOPT_DNS_CACHE_TIMEOUT, CURLOT_LONG, 0},
   {"DNS_INTERFACE", CURLOPT_DNS_INTERFACE, CURLOT_STRING, 0},
   {"DNS_LOCAL_IP4", CURLOPT_DNS_LOCAL_IP4, CURLOT_STRING, 0},
@@ -252,6 +257,8 @@ const struct curl_easyoption Curl_easyopts[] = {
   {"RANGE", CURLOPT_RANGE, CURLOT_STRING, 0},
   {"READDATA", CURLOPT_READDATA, CURLOT_CBPTR, 0},
   {"READFUNCTION", CURLOPT_READFUNCTION, CURLOT_FUNCTION, 0},
+  {"RECVBUFFERDATA", CURLOPT_RECVBUFFERDATA, CURLOT_CBPTR, 0},
+  {"RECVBUFFERFUNCTION", CURLOPT_RECVBUFFERFUNCTION, CURLOT_FUNCTION, 0},
   {"REDIR_PROTOCOLS", CURLOPT_REDIR_PROTOCOLS, CURLOT_LONG, 0},
   {"REDIR_PROTOCOLS_STR", CURLOPT_REDIR_PROTOCOLS_STR, CURLOT_STRING, 0},
   {"REFERER", CURLOPT_REFERER, CURLOT_STRING, 0},
@@ -380,6 +387,6 @@ const struct curl_easyoption Curl_easyopts[] = {
  */
 int Curl_easyopts_check(void)
 {
-  return (CURLOPT_LASTENTRY % 10000) != (328 + 1);
+  return (CURLOPT_LASTENTRY % 10000) != (333 + 1);
 }
 #endif
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "curl_setup.h"
+
+#include "urldata.h"
+#include "flowctl.h"
+
+/* The last 3 #include files should be in this order */
+#include "curl_printf.h"
+#include "curl_memory.h"
+#include "memdebug.h"
+
+void Curl_flowctl_init(struct flowctl *fc, uint32_t window,
+                       uint32_t window_max)
+{
+  memset(fc, 0, sizeof(*fc));
+  fc->window = CURLMIN(window, window_max);
+  fc->window_max = window_max;
+}
+
+bool Curl_flowctl_recvd(struct flowctl *fc, size_t nbytes)
+{
+  if(fc->probing) {
+    fc->probe_bytes += nbytes;
+    return FALSE;
+  }
+  if(fc->window >= fc->window_max)
+    return FALSE;
+  if(fc->skip_bytes > nbytes) {
+    fc->skip_bytes -= nbytes;
+    return FALSE;
+  }
+  fc->skip_bytes = 0;
+  return TRUE;
+}
+
+void Curl_flowctl_probe_start(struct flowctl *fc, struct curltime now)
+{
+  fc->probe_start = now;
+  fc->probe_bytes = 0;
+  fc->probing = TRUE;
+}
+
+/* A probe's round trip is over, evaluate the data received meanwhile */
+static bool flowctl_sample(struct flowctl *fc)
+{
+  uint64_t wsize;
+
+  fc->probing = FALSE;
+  /* The sample filling less than 2/3 of the window means the window
+   * is not what holds the peer back. Take the next sample only after
+   * another window of data to not flood the peer with probes. */
+  if((fc->probe_bytes * 3) < ((uint64_t)fc->window * 2)) {
+    fc->skip_bytes = fc->window;
+    return FALSE;
+  }
+  wsize = CURLMIN(fc->probe_bytes * 2, fc->window_max);
+  if(wsize <= fc->window)
+    return FALSE;
+  fc->window = (uint32_t)wsize;
+  return TRUE;
+}
+
+bool Curl_flowctl_probe_done(struct flowctl *fc, struct curltime now)
+{
+  timediff_t rtt_us;
+
+  if(!fc->probing)
+    return FALSE;
+
+  rtt_us = curlx_timediff_us(now, fc->probe_start);
+  if(rtt_us <= 0)
+    rtt_us = 1;
+  /* smoothed like TCP's SRTT */
+  fc->rtt_us = fc->rtt_us ? ((fc->rtt_us * 7) + rtt_us) / 8 : rtt_us;
+  return flowctl_sample(fc);
+}
+
+bool Curl_flowctl_recvd_rtt(struct flowctl *fc, size_t nbytes,
+                            timediff_t rtt_us, struct curltime now)
+{
+  if(rtt_us <= 0)
+    return FALSE;
+  fc->rtt_us = rtt_us;
+  if(!fc->probing) {
+    /* the sample period starts now */
+    if(Curl_flowctl_recvd(fc, nbytes))
+      Curl_flowctl_probe_start(fc, now);
+    return FALSE;
+  }
+  fc->probe_bytes += nbytes;
+  if(curlx_timediff_us(now, fc->probe_start) < rtt_us)
+    return FALSE;
+  return flowctl_sample(fc);
+}
+
+void Curl_flowctl_get_stats(const struct flowctl *fc,
+                            struct flowctl_stats *stats)
+{
+  stats->window = (curl_off_t)fc->window;
+  stats->rtt_us = (curl_off_t)fc->rtt_us;
+}
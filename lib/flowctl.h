@@ -0,0 +1,74 @@
+#ifndef HEADER_CURL_FLOWCTL_H
+#define HEADER_CURL_FLOWCTL_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "curl_setup.h"
+
+#include "curlx/timeval.h"
+
+struct flowctl_stats;
+
+/*
+ * Receive window sizing from the bandwidth-delay product (BDP) of a
+ * connection. While a probe (a HTTP/2 PING for example) makes its round
+ * trip, the data received is a sample of the BDP. When a sample fills
+ * most of the window, the window limits the throughput and it grows to
+ * twice the sample, up to `window_max`.
+ */
+struct flowctl {
+  struct curltime probe_start; /* when the probe in flight was sent */
+  uint64_t probe_bytes;        /* data received since `probe_start` */
+  uint64_t skip_bytes;         /* data to receive before probing again */
+  timediff_t rtt_us;           /* smoothed round-trip time, 0 if unknown */
+  uint32_t window;             /* the receive window to use */
+  uint32_t window_max;         /* the window never grows beyond this */
+  BIT(probing);                /* a probe is in flight */
+};
+
+void Curl_flowctl_init(struct flowctl *fc, uint32_t window,
+                       uint32_t window_max);
+
+/* `nbytes` of data have been received. Returns TRUE when the caller
+ * should send a probe now and call Curl_flowctl_probe_start(). */
+bool Curl_flowctl_recvd(struct flowctl *fc, size_t nbytes);
+
+/* The probe has been sent at `now`. */
+void Curl_flowctl_probe_start(struct flowctl *fc, struct curltime now);
+
+/* The probe came back at `now`. Returns TRUE when the window grew. */
+bool Curl_flowctl_probe_done(struct flowctl *fc, struct curltime now);
+
+/* For stacks measuring the round-trip time themselves, like QUIC: `nbytes`
+ * of data have been received at `now` with a smoothed `rtt_us`. The data
+ * of one round trip is the sample, no probe is sent. Returns TRUE when the
+ * window grew. */
+bool Curl_flowctl_recvd_rtt(struct flowctl *fc, size_t nbytes,
+                            timediff_t rtt_us, struct curltime now);
+
+/* Fill `stats` with the current window and round-trip time. */
+void Curl_flowctl_get_stats(const struct flowctl *fc,
+                            struct flowctl_stats *stats);
+
+#endif /* HEADER_CURL_FLOWCTL_H */
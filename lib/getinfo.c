@@ -81,6 +81,8 @@ CURLcode Curl_initinfo(struct Curl_easy *data)
   info->wouldredirect = NULL;
 
   memset(&info->primary, 0, sizeof(info->primary));
+  memset(&info->udp_io, 0, sizeof(info->udp_io));
+  memset(&info->flowctl, 0, sizeof(info->flowctl));
   info->primary.remote_port = -1;
   info->primary.local_port = -1;
   info->retry_after = 0;
@@ -470,6 +472,38 @@ static CURLcode getinfo_offt(struct Curl_easy *data, CURLINFO info,
   case CURLINFO_EARLYDATA_SENT_T:
     *param_offt = data->progress.earlydata_sent;
     break;
+  case CURLINFO_QUIC_RECV_PACKETS:
+  case CURLINFO_QUIC_RECV_CALLS:
+  case CURLINFO_QUIC_SEND_PACKETS:
+  case CURLINFO_QUIC_SEND_CALLS: {
+    struct udp_io_stats stats = data->info.udp_io;
+    /* live counters while the transfer has its connection */
+    if(data->conn)
+      (void)Curl_conn_get_udp_io_stats(data, data->conn, FIRSTSOCKET,
+                                       &stats);
+    if(info == CURLINFO_QUIC_RECV_PACKETS)
+      *param_offt = stats.pkts_recvd;
+    else if(info == CURLINFO_QUIC_RECV_CALLS)
+      *param_offt = stats.recv_calls;
+    else if(info == CURLINFO_QUIC_SEND_PACKETS)
+      *param_offt = stats.pkts_sent;
+    else
+      *param_offt = stats.send_calls;
+    break;
+  }
+  case CURLINFO_RECV_WINDOW_T:
+  case CURLINFO_RTT_T: {
+    struct flowctl_stats stats = data->info.flowctl;
+    /* live values while the transfer has its connection */
+    if(data->conn)
+      (void)Curl_conn_get_flowctl_stats(data, data->conn, FIRSTSOCKET,
+                                        &stats);
+    if(info == CURLINFO_RECV_WINDOW_T)
+      *param_offt = stats.window;
+    else
+      *param_offt = stats.rtt_us;
+    break;
+  }
   default:
     return CURLE_UNKNOWN_OPTION;
   }
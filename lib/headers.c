@@ -28,6 +28,7 @@
 #include "strdup.h"
 #include "sendf.h"
 #include "headers.h"
+#include "memscan.h"
 #include "curlx/strparse.h"
 
 /* The last 3 #include files should be in this order */
@@ -189,6 +190,7 @@ static CURLcode namevalue(char *header, size_t hlen, unsigned int type,
                           char **name, char **value)
 {
   char *end = header + hlen - 1; /* point to the last byte */
+  const char *colon;
   DEBUGASSERT(hlen);
   *name = header;
 
@@ -199,12 +201,12 @@ static CURLcode namevalue(char *header, size_t hlen, unsigned int type,
   }
 
   /* Find the end of the header name */
-  while(*header && (*header != ':'))
-    ++header;
-
-  if(*header)
+  colon = Curl_memscan2(header, end + 1 - header, ':', '\0');
+  if(colon && *colon) {
     /* Skip over colon, null it */
+    header += colon - header;
     *header++ = 0;
+  }
   else
     return CURLE_BAD_FUNCTION_ARGUMENT;
 
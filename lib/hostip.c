@@ -54,6 +54,7 @@
 #include "rand.h"
 #include "share.h"
 #include "url.h"
+#include "setopt.h"
 #include "curlx/inet_ntop.h"
 #include "curlx/inet_pton.h"
 #include "multiif.h"
@@ -82,6 +83,12 @@
 
 #define MAX_DNS_CACHE_SIZE 29999
 
+#ifdef DNSCACHE_SHARDS
+#define DNSCACHE_SHARDED(c)   ((c)->num_shards > 1)
+#else
+#define DNSCACHE_SHARDED(c)   FALSE
+#endif
+
 /*
  * hostip.c explained
  * ==================
@@ -182,6 +189,7 @@ create_dnscache_id(const char *name,
 struct dnscache_prune_data {
   time_t now;
   time_t oldest; /* oldest time in cache not pruned. */
+  time_t oldest_ts; /* timestamp of the oldest entry not pruned, or 0 */
   int max_age_sec;
 };
 
@@ -206,16 +214,18 @@ dnscache_entry_is_stale(void *datap, void *hc)
       return TRUE;
     if(age > prune->oldest)
       prune->oldest = age;
+    if(!prune->oldest_ts || (dns->timestamp < prune->oldest_ts))
+      prune->oldest_ts = dns->timestamp;
   }
   return FALSE;
 }
 
 /*
- * Prune the DNS cache. This assumes that a lock has already been taken.
- * Returns the 'age' of the oldest still kept entry.
+ * Prune a shard of the DNS cache. This assumes that its lock has already
+ * been taken. Returns the 'age' of the oldest still kept entry.
  */
 static time_t
-dnscache_prune(struct Curl_hash *hostcache, int cache_timeout,
+dnscache_prune(struct dnscache_shard *shard, int cache_timeout,
                time_t now)
 {
   struct dnscache_prune_data user;
@@ -223,14 +233,29 @@ dnscache_prune(struct Curl_hash *hostcache, int cache_timeout,
   user.max_age_sec = cache_timeout;
   user.now = now;
   user.oldest = 0;
+  user.oldest_ts = 0;
 
-  Curl_hash_clean_with_criterium(hostcache,
+  Curl_hash_clean_with_criterium(&shard->entries,
                                  (void *) &user,
                                  dnscache_entry_is_stale);
+  shard->oldest = user.oldest_ts;
 
   return user.oldest;
 }
 
+/* Seconds an entry is kept in the cache for the transfer, including the
+ * time expired entries are still used while being refreshed. */
+static int dnscache_max_age(struct Curl_easy *data)
+{
+  int timeout = data->set.dns_cache_timeout;
+#ifdef CURLRES_ASYNCH
+  if((timeout >= 0) && data->set.dns_stale_timeout)
+    timeout = (data->set.dns_stale_timeout > (INT_MAX - timeout)) ?
+      INT_MAX : (timeout + data->set.dns_stale_timeout);
+#endif
+  return timeout;
+}
+
 static struct Curl_dnscache *dnscache_get(struct Curl_easy *data)
 {
   if(data->share && data->share->specifier & (1 << CURL_LOCK_DATA_DNS))
@@ -240,20 +265,59 @@ static struct Curl_dnscache *dnscache_get(struct Curl_easy *data)
   return NULL;
 }
 
+/* Get the shard for the entry id, its length including the null
+ * terminator. */
+static struct dnscache_shard *dnscache_shard(struct Curl_dnscache *dnscache,
+                                             const char *id, size_t idlen)
+{
+  if(!dnscache)
+    return NULL;
+  if(!DNSCACHE_SHARDED(dnscache))
+    return dnscache->shards;
+  return &dnscache->shards[Curl_hash_str(CURL_UNCONST(id), idlen,
+                                         dnscache->num_shards)];
+}
+
 static void dnscache_lock(struct Curl_easy *data,
-                          struct Curl_dnscache *dnscache)
+                          struct Curl_dnscache *dnscache,
+                          struct dnscache_shard *shard)
 {
+#ifdef DNSCACHE_SHARDS
+  if(dnscache && DNSCACHE_SHARDED(dnscache)) {
+    Curl_mutex_acquire(&shard->mutex);
+    return;
+  }
+#else
+  (void)shard;
+#endif
   if(data->share && dnscache == &data->share->dnscache)
     Curl_share_lock(data, CURL_LOCK_DATA_DNS, CURL_LOCK_ACCESS_SINGLE);
 }
 
 static void dnscache_unlock(struct Curl_easy *data,
-                            struct Curl_dnscache *dnscache)
+                            struct Curl_dnscache *dnscache,
+                            struct dnscache_shard *shard)
 {
+#ifdef DNSCACHE_SHARDS
+  if(dnscache && DNSCACHE_SHARDED(dnscache)) {
+    Curl_mutex_release(&shard->mutex);
+    return;
+  }
+#else
+  (void)shard;
+#endif
   if(data->share && dnscache == &data->share->dnscache)
     Curl_share_unlock(data, CURL_LOCK_DATA_DNS);
 }
 
+/* Note an entry added to the shard, its lock held. */
+static void dnscache_shard_added(struct dnscache_shard *shard,
+                                 struct Curl_dns_entry *dns)
+{
+  if(dns->timestamp && (!shard->oldest || (dns->timestamp < shard->oldest)))
+    shard->oldest = dns->timestamp;
+}
+
 /*
  * Library-wide function for pruning the DNS cache. This function takes and
  * returns the appropriate locks.
@@ -261,42 +325,56 @@ static void dnscache_unlock(struct Curl_easy *data,
 void Curl_dnscache_prune(struct Curl_easy *data)
 {
   struct Curl_dnscache *dnscache = dnscache_get(data);
+  size_t i, max_entries;
   time_t now;
-  /* the timeout may be set -1 (forever) */
-  int timeout = data->set.dns_cache_timeout;
 
   if(!dnscache)
     /* NULL hostcache means we cannot do it */
     return;
 
-  dnscache_lock(data, dnscache);
-
   now = time(NULL);
-
-  do {
-    /* Remove outdated and unused entries from the hostcache */
-    time_t oldest = dnscache_prune(&dnscache->entries, timeout, now);
-
-    if(oldest < INT_MAX)
-      timeout = (int)oldest; /* we know it fits */
-    else
-      timeout = INT_MAX - 1;
-
-    /* if the cache size is still too big, use the oldest age as new
-       prune limit */
-  } while(timeout &&
-          (Curl_hash_count(&dnscache->entries) > MAX_DNS_CACHE_SIZE));
-
-  dnscache_unlock(data, dnscache);
+  max_entries = MAX_DNS_CACHE_SIZE / dnscache->num_shards;
+
+  for(i = 0; i < dnscache->num_shards; ++i) {
+    struct dnscache_shard *shard = &dnscache->shards[i];
+    /* the timeout may be set -1 (forever) */
+    int timeout = dnscache_max_age(data);
+
+    dnscache_lock(data, dnscache, shard);
+    /* Only walk the entries when one of them may be stale or there are
+       too many of them */
+    if((shard->oldest && ((now - shard->oldest) >= (time_t)timeout)) ||
+       (Curl_hash_count(&shard->entries) > max_entries)) {
+      do {
+        /* Remove outdated and unused entries from the hostcache */
+        time_t oldest = dnscache_prune(shard, timeout, now);
+
+        if(oldest < INT_MAX)
+          timeout = (int)oldest; /* we know it fits */
+        else
+          timeout = INT_MAX - 1;
+
+        /* if the cache size is still too big, use the oldest age as new
+           prune limit */
+      } while(timeout &&
+              (Curl_hash_count(&shard->entries) > max_entries));
+    }
+    dnscache_unlock(data, dnscache, shard);
+  }
 }
 
 void Curl_dnscache_clear(struct Curl_easy *data)
 {
   struct Curl_dnscache *dnscache = dnscache_get(data);
+  size_t i;
   if(dnscache) {
-    dnscache_lock(data, dnscache);
-    Curl_hash_clean(&dnscache->entries);
-    dnscache_unlock(data, dnscache);
+    for(i = 0; i < dnscache->num_shards; ++i) {
+      struct dnscache_shard *shard = &dnscache->shards[i];
+      dnscache_lock(data, dnscache, shard);
+      Curl_hash_clean(&shard->entries);
+      shard->oldest = 0;
+      dnscache_unlock(data, dnscache, shard);
+    }
   }
 }
 
@@ -308,52 +386,73 @@ static sigjmp_buf curl_jmpenv;
 static curl_simple_lock curl_jmpenv_lock;
 #endif
 
-/* lookup address, returns entry if found and not stale */
-static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
-                                         struct Curl_dnscache *dnscache,
-                                         const char *hostname,
-                                         int port,
-                                         int ip_version)
+/* lookup address in the shard for its id, returns entry with a reference
+ * taken if found and not stale.
+ * Lookups by a transfer about to resolve the name pass `refresh`. They
+ * also get failed resolves and, when an expired entry is returned that
+ * nobody refreshes yet, get `*refresh` set to do that. */
+static struct Curl_dns_entry *fetch_addr_id(struct Curl_easy *data,
+                                            struct Curl_dnscache *dnscache,
+                                            const char *hostname,
+                                            size_t hlen, /* or zero */
+                                            int port,
+                                            int ip_version,
+                                            bool *refresh)
 {
   struct Curl_dns_entry *dns = NULL;
+  struct dnscache_shard *shard;
   char entry_id[MAX_HOSTCACHE_LEN];
   size_t entry_len;
 
-  if(!dnscache)
-    return NULL;
-
   /* Create an entry id, based upon the hostname and port */
-  entry_len = create_dnscache_id(hostname, 0, port,
+  entry_len = create_dnscache_id(hostname, hlen, port,
                                  entry_id, sizeof(entry_id));
+  shard = dnscache_shard(dnscache, entry_id, entry_len + 1);
 
-  /* See if it is already in our dns cache */
-  dns = Curl_hash_pick(&dnscache->entries, entry_id, entry_len + 1);
-
-  /* No entry found in cache, check if we might have a wildcard entry */
-  if(!dns && data->state.wildcard_resolve) {
-    entry_len = create_dnscache_id("*", 1, port, entry_id, sizeof(entry_id));
+  dnscache_lock(data, dnscache, shard);
 
-    /* See if it is already in our dns cache */
-    dns = Curl_hash_pick(&dnscache->entries, entry_id, entry_len + 1);
+  /* See if it is already in our dns cache */
+  dns = Curl_hash_pick(&shard->entries, entry_id, entry_len + 1);
+
+  if(dns && dns->negative) {
+    /* a failed resolve, used for as long as the transfer asks for */
+    if((time(NULL) - dns->timestamp) >= (time_t)data->set.dns_neg_timeout) {
+      infof(data, "Failed resolve in DNS cache expired, zapped");
+      Curl_hash_delete(&shard->entries, entry_id, entry_len + 1);
+      dns = NULL;
+    }
+    else if(!refresh)
+      dns = NULL;
   }
-
-  if(dns && (data->set.dns_cache_timeout != -1)) {
+  else if(dns && (data->set.dns_cache_timeout != -1)) {
     /* See whether the returned entry is stale. Done before we release lock */
     struct dnscache_prune_data user;
 
     user.now = time(NULL);
     user.max_age_sec = data->set.dns_cache_timeout;
     user.oldest = 0;
+    user.oldest_ts = 0;
 
     if(dnscache_entry_is_stale(&user, dns)) {
-      infof(data, "Hostname in DNS cache was stale, zapped");
-      dns = NULL; /* the memory deallocation is being handled by the hash */
-      Curl_hash_delete(&dnscache->entries, entry_id, entry_len + 1);
+      user.max_age_sec = dnscache_max_age(data);
+      if(!dnscache_entry_is_stale(&user, dns)) {
+        /* still usable while the name is resolved again */
+        if(refresh && !dns->refreshing) {
+          infof(data, "Hostname in DNS cache is stale, refreshing");
+          dns->refreshing = TRUE;
+          *refresh = TRUE;
+        }
+      }
+      else {
+        infof(data, "Hostname in DNS cache was stale, zapped");
+        dns = NULL; /* the memory deallocation is being handled by the hash */
+        Curl_hash_delete(&shard->entries, entry_id, entry_len + 1);
+      }
     }
   }
 
   /* See if the returned entry matches the required resolve mode */
-  if(dns && ip_version != CURL_IPRESOLVE_WHATEVER) {
+  if(dns && !dns->negative && (ip_version != CURL_IPRESOLVE_WHATEVER)) {
     int pf = PF_INET;
     bool found = FALSE;
     struct Curl_addrinfo *addr = dns->addr;
@@ -374,9 +473,37 @@ static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
     if(!found) {
       infof(data, "Hostname in DNS cache does not have needed family, zapped");
       dns = NULL; /* the memory deallocation is being handled by the hash */
-      Curl_hash_delete(&dnscache->entries, entry_id, entry_len + 1);
+      Curl_hash_delete(&shard->entries, entry_id, entry_len + 1);
     }
   }
+  if(dns)
+    dns->refcount++; /* we pass out the reference. */
+
+  dnscache_unlock(data, dnscache, shard);
+  return dns;
+}
+
+/* lookup address, returns entry with a reference taken if found and not
+ * stale */
+static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
+                                         struct Curl_dnscache *dnscache,
+                                         const char *hostname,
+                                         int port,
+                                         int ip_version,
+                                         bool *refresh)
+{
+  struct Curl_dns_entry *dns;
+
+  if(!dnscache)
+    return NULL;
+
+  dns = fetch_addr_id(data, dnscache, hostname, 0, port, ip_version,
+                      refresh);
+
+  /* No entry found in cache, check if we might have a wildcard entry */
+  if(!dns && data->state.wildcard_resolve)
+    dns = fetch_addr_id(data, dnscache, "*", 1, port, ip_version, refresh);
+
   return dns;
 }
 
@@ -390,6 +517,8 @@ static struct Curl_dns_entry *fetch_addr(struct Curl_easy *data,
  * lookups for the same hostname requested by different handles.
  *
  * Returns the Curl_dns_entry entry pointer or NULL if not in the cache.
+ * Expired entries still used while refreshed are returned, failed
+ * resolves are not.
  *
  * The returned data *MUST* be "released" with Curl_resolv_unlink() after
  * use, or we will leak memory!
@@ -400,18 +529,8 @@ Curl_dnscache_get(struct Curl_easy *data,
                   int port,
                   int ip_version)
 {
-  struct Curl_dnscache *dnscache = dnscache_get(data);
-  struct Curl_dns_entry *dns = NULL;
-
-  dnscache_lock(data, dnscache);
-
-  dns = fetch_addr(data, dnscache, hostname, port, ip_version);
-  if(dns)
-    dns->refcount++; /* we use it! */
-
-  dnscache_unlock(data, dnscache);
-
-  return dns;
+  return fetch_addr(data, dnscache_get(data), hostname, port, ip_version,
+                    NULL);
 }
 
 #ifndef CURL_DISABLE_SHUFFLE_DNS
@@ -544,9 +663,10 @@ Curl_dnscache_mk_entry(struct Curl_easy *data,
   return dns;
 }
 
+/* Add an entry for `addr` to the shard, its lock held. */
 static struct Curl_dns_entry *
 dnscache_add_addr(struct Curl_easy *data,
-                  struct Curl_dnscache *dnscache,
+                  struct dnscache_shard *shard,
                   struct Curl_addrinfo *addr,
                   const char *hostname,
                   size_t hlen, /* length or zero */
@@ -567,7 +687,7 @@ dnscache_add_addr(struct Curl_easy *data,
                                  entry_id, sizeof(entry_id));
 
   /* Store the resolved data in our DNS cache. */
-  dns2 = Curl_hash_add(&dnscache->entries, entry_id, entry_len + 1,
+  dns2 = Curl_hash_add(&shard->entries, entry_id, entry_len + 1,
                        (void *)dns);
   if(!dns2) {
     dnscache_entry_free(dns);
@@ -576,6 +696,7 @@ dnscache_add_addr(struct Curl_easy *data,
 
   dns = dns2;
   dns->refcount++;         /* mark entry as in-use */
+  dnscache_shard_added(shard, dns);
   return dns;
 }
 
@@ -583,6 +704,7 @@ CURLcode Curl_dnscache_add(struct Curl_easy *data,
                            struct Curl_dns_entry *entry)
 {
   struct Curl_dnscache *dnscache = dnscache_get(data);
+  struct dnscache_shard *shard;
   char id[MAX_HOSTCACHE_LEN];
   size_t idlen;
 
@@ -591,15 +713,17 @@ CURLcode Curl_dnscache_add(struct Curl_easy *data,
   /* Create an entry id, based upon the hostname and port */
   idlen = create_dnscache_id(entry->hostname, 0, entry->hostport,
                              id, sizeof(id));
+  shard = dnscache_shard(dnscache, id, idlen + 1);
 
   /* Store the resolved data in our DNS cache and up ref count */
-  dnscache_lock(data, dnscache);
-  if(!Curl_hash_add(&dnscache->entries, id, idlen + 1, (void *)entry)) {
-    dnscache_unlock(data, dnscache);
+  dnscache_lock(data, dnscache, shard);
+  if(!Curl_hash_add(&shard->entries, id, idlen + 1, (void *)entry)) {
+    dnscache_unlock(data, dnscache, shard);
     return CURLE_OUT_OF_MEMORY;
   }
   entry->refcount++;
-  dnscache_unlock(data, dnscache);
+  dnscache_shard_added(shard, entry);
+  dnscache_unlock(data, dnscache, shard);
   return CURLE_OK;
 }
 
@@ -794,6 +918,107 @@ static bool can_resolve_ip_version(struct Curl_easy *data, int ip_version)
   return TRUE;
 }
 
+/* Remember that resolving `hostname` failed, for transfers using
+ * CURLOPT_DNS_CACHE_NEGATIVE_TIMEOUT. */
+static void dnscache_add_negative(struct Curl_easy *data,
+                                  const char *hostname, int port,
+                                  int ip_version)
+{
+  struct Curl_dns_entry *dns;
+
+  /* A failure for one IP version says nothing about the others. A failed
+     refresh leaves the stale entry in place. */
+  if(!data->set.dns_neg_timeout || (ip_version != CURL_IPRESOLVE_WHATEVER) ||
+     data->state.dns_refresh)
+    return;
+  dns = Curl_dnscache_mk_entry(data, NULL, hostname, 0, port, FALSE);
+  if(!dns)
+    return;
+  dns->negative = TRUE;
+  (void)Curl_dnscache_add(data, dns);
+  Curl_resolv_unlink(data, &dns);
+}
+
+/* Clear the refreshing mark of the entry for `hostname` and `port`, if it
+ * is still in the cache. */
+static void dnscache_unmark(struct Curl_easy *data,
+                            const char *hostname, int port)
+{
+  struct Curl_dnscache *dnscache = dnscache_get(data);
+  struct dnscache_shard *shard;
+  struct Curl_dns_entry *dns;
+  char entry_id[MAX_HOSTCACHE_LEN];
+  size_t entry_len;
+
+  if(!dnscache)
+    return;
+  entry_len = create_dnscache_id(hostname, 0, port,
+                                 entry_id, sizeof(entry_id));
+  shard = dnscache_shard(dnscache, entry_id, entry_len + 1);
+  dnscache_lock(data, dnscache, shard);
+  dns = Curl_hash_pick(&shard->entries, entry_id, entry_len + 1);
+  if(dns)
+    dns->refreshing = FALSE;
+  dnscache_unlock(data, dnscache, shard);
+}
+
+void Curl_dnscache_refresh_done(struct Curl_easy *data)
+{
+  if(data->state.dns_refresh_host) {
+    dnscache_unmark(data, data->state.dns_refresh_host,
+                    data->state.dns_refresh_port);
+    Curl_safefree(data->state.dns_refresh_host);
+  }
+}
+
+#ifdef CURLRES_ASYNCH
+/* Resolve the stale `hostname` and `port` again in an internal transfer of
+ * the multi, which replaces the entry in the DNS cache when done. The
+ * transfer copies the options of `data` to resolve the name the same way,
+ * connects to that name directly and stops before connecting. */
+static void dnscache_refresh(struct Curl_easy *data,
+                             const char *hostname, int port)
+{
+  struct Curl_multi *multi = data->multi;
+  struct Curl_easy *refresh = NULL;
+  char *url = NULL;
+
+  if(!multi || !multi->admin || !data->conn || !data->conn->handler)
+    goto fail;
+  url = aprintf("%s://%s:%d/", data->conn->handler->scheme, hostname, port);
+  if(!url || Curl_open_internal(data, url, &refresh))
+    goto fail;
+  refresh->state.dns_refresh_host = strdup(hostname);
+  if(!refresh->state.dns_refresh_host)
+    goto fail;
+  refresh->state.dns_refresh_port = port;
+  /* resolve the name itself, not a proxy or connect-to host for it */
+  refresh->set.connect_to = NULL;
+#ifndef CURL_DISABLE_PROXY
+  if(Curl_setstropt(&refresh->set.str[STRING_PROXY], "") ||
+     Curl_setstropt(&refresh->set.str[STRING_PRE_PROXY], NULL))
+    goto fail;
+#endif
+#ifdef USE_UNIX_SOCKETS
+  Curl_safefree(refresh->set.str[STRING_UNIX_SOCKET_PATH]);
+#endif
+  refresh->set.reuse_fresh = TRUE;
+  refresh->state.dns_refresh = TRUE;
+  /* closed by the multi when done, see multi.c */
+  refresh->master_mid = multi->admin->mid;
+  if(curl_multi_add_handle(multi, refresh))
+    goto fail;
+  free(url);
+  return;
+
+fail:
+  free(url);
+  Curl_close(&refresh);
+  /* not refreshed now, the next use tries again */
+  dnscache_unmark(data, hostname, port);
+}
+#endif
+
 /*
  * Curl_resolv() is the main name resolve function within libcurl. It resolves
  * a name and returns a pointer to the entry in the 'entry' argument (if one
@@ -841,15 +1066,22 @@ CURLcode Curl_resolv(struct Curl_easy *data,
     goto error;
   }
 
-  /* Let's check our DNS cache first */
-  dnscache_lock(data, dnscache);
-  dns = fetch_addr(data, dnscache, hostname, port, ip_version);
-  if(dns)
-    dns->refcount++; /* we pass out the reference. */
-  dnscache_unlock(data, dnscache);
-  if(dns) {
-    infof(data, "Hostname %s was found in DNS cache", hostname);
-    goto out;
+  /* Let's check our DNS cache first, unless refreshing it */
+  if(!data->state.dns_refresh) {
+    bool refresh = FALSE;
+    dns = fetch_addr(data, dnscache, hostname, port, ip_version, &refresh);
+    if(dns && dns->negative) {
+      infof(data, "Hostname %s failed to resolve recently", hostname);
+      goto error;
+    }
+    if(dns) {
+      infof(data, "Hostname %s was found in DNS cache", hostname);
+#ifdef CURLRES_ASYNCH
+      if(refresh)
+        dnscache_refresh(data, hostname, port);
+#endif
+      goto out;
+    }
   }
 
   /* No luck, we need to resolve hostname. Notify user callback. */
@@ -905,6 +1137,8 @@ CURLcode Curl_resolv(struct Curl_easy *data,
 #else
     respwait = 0; /* no async waiting here */
     addr = Curl_sync_getaddrinfo(data, hostname, port, ip_version);
+    if(!addr)
+      dnscache_add_negative(data, hostname, port, ip_version);
 #endif
   }
 
@@ -1185,13 +1419,24 @@ void Curl_resolv_unlink(struct Curl_easy *data, struct Curl_dns_entry **pdns)
 {
   if(*pdns) {
     struct Curl_dnscache *dnscache = dnscache_get(data);
+    struct dnscache_shard *shard = NULL;
     struct Curl_dns_entry *dns = *pdns;
     *pdns = NULL;
-    dnscache_lock(data, dnscache);
+    if(dnscache && DNSCACHE_SHARDED(dnscache)) {
+      /* the reference count is protected by the lock of the shard the
+         entry is in, found by its id */
+      char id[MAX_HOSTCACHE_LEN];
+      size_t idlen = create_dnscache_id(dns->hostname, 0, dns->hostport,
+                                        id, sizeof(id));
+      shard = dnscache_shard(dnscache, id, idlen + 1);
+    }
+    else if(dnscache)
+      shard = dnscache->shards;
+    dnscache_lock(data, dnscache, shard);
     dns->refcount--;
     if(dns->refcount == 0)
       dnscache_entry_free(dns);
-    dnscache_unlock(data, dnscache);
+    dnscache_unlock(data, dnscache, shard);
   }
 }
 
@@ -1207,15 +1452,49 @@ static void dnscache_entry_dtor(void *entry)
 /*
  * Curl_dnscache_init() inits a new DNS cache.
  */
-void Curl_dnscache_init(struct Curl_dnscache *dns, size_t size)
+CURLcode Curl_dnscache_init(struct Curl_dnscache *dns, size_t size,
+                            bool shared)
 {
-  Curl_hash_init(&dns->entries, size, Curl_hash_str, curlx_str_key_compare,
-                 dnscache_entry_dtor);
+  size_t i, num_shards = 1;
+
+#ifdef DNSCACHE_SHARDS
+  if(shared) {
+    /* transfers in several threads may use a shared cache */
+    num_shards = DNSCACHE_SHARDS;
+    size = (size + num_shards - 1) / num_shards;
+  }
+#else
+  (void)shared;
+#endif
+  dns->shards = calloc(num_shards, sizeof(*dns->shards));
+  if(!dns->shards)
+    return CURLE_OUT_OF_MEMORY;
+  dns->num_shards = num_shards;
+  for(i = 0; i < num_shards; ++i) {
+    Curl_hash_init(&dns->shards[i].entries, size, Curl_hash_str,
+                   curlx_str_key_compare, dnscache_entry_dtor);
+#ifdef DNSCACHE_SHARDS
+    if(DNSCACHE_SHARDED(dns))
+      Curl_mutex_init(&dns->shards[i].mutex);
+#endif
+  }
+  return CURLE_OK;
 }
 
 void Curl_dnscache_destroy(struct Curl_dnscache *dns)
 {
-  Curl_hash_destroy(&dns->entries);
+  size_t i;
+  if(!dns->shards)
+    return;
+  for(i = 0; i < dns->num_shards; ++i) {
+    Curl_hash_destroy(&dns->shards[i].entries);
+#ifdef DNSCACHE_SHARDS
+    if(DNSCACHE_SHARDED(dns))
+      Curl_mutex_destroy(&dns->shards[i].mutex);
+#endif
+  }
+  Curl_safefree(dns->shards);
+  dns->num_shards = 0;
 }
 
 CURLcode Curl_loadhostpairs(struct Curl_easy *data)
@@ -1231,6 +1510,7 @@ CURLcode Curl_loadhostpairs(struct Curl_easy *data)
 
   for(hostp = data->state.resolve; hostp; hostp = hostp->next) {
     char entry_id[MAX_HOSTCACHE_LEN];
+    struct dnscache_shard *shard;
     const char *host = hostp->data;
     struct Curl_str source;
     if(!host)
@@ -1257,10 +1537,11 @@ CURLcode Curl_loadhostpairs(struct Curl_easy *data)
         entry_len = create_dnscache_id(curlx_str(&source),
                                        curlx_strlen(&source), (int)num,
                                        entry_id, sizeof(entry_id));
-        dnscache_lock(data, dnscache);
+        shard = dnscache_shard(dnscache, entry_id, entry_len + 1);
+        dnscache_lock(data, dnscache, shard);
         /* delete entry, ignore if it did not exist */
-        Curl_hash_delete(&dnscache->entries, entry_id, entry_len + 1);
-        dnscache_unlock(data, dnscache);
+        Curl_hash_delete(&shard->entries, entry_id, entry_len + 1);
+        dnscache_unlock(data, dnscache, shard);
       }
     }
     else {
@@ -1364,11 +1645,12 @@ err:
       entry_len = create_dnscache_id(curlx_str(&source), curlx_strlen(&source),
                                      (int)port,
                                      entry_id, sizeof(entry_id));
+      shard = dnscache_shard(dnscache, entry_id, entry_len + 1);
 
-      dnscache_lock(data, dnscache);
+      dnscache_lock(data, dnscache, shard);
 
       /* See if it is already in our dns cache */
-      dns = Curl_hash_pick(&dnscache->entries, entry_id, entry_len + 1);
+      dns = Curl_hash_pick(&shard->entries, entry_id, entry_len + 1);
 
       if(dns) {
         infof(data, "RESOLVE %.*s:%" CURL_FORMAT_CURL_OFF_T
@@ -1385,11 +1667,11 @@ err:
          4. when adding a non-permanent entry, we want it to get a "fresh"
             timeout that starts _now_. */
 
-        Curl_hash_delete(&dnscache->entries, entry_id, entry_len + 1);
+        Curl_hash_delete(&shard->entries, entry_id, entry_len + 1);
       }
 
       /* put this new host in the cache */
-      dns = dnscache_add_addr(data, dnscache, head, curlx_str(&source),
+      dns = dnscache_add_addr(data, shard, head, curlx_str(&source),
                               curlx_strlen(&source), (int)port, permanent);
       if(dns) {
         /* release the returned reference; the cache itself will keep the
@@ -1397,7 +1679,7 @@ err:
         dns->refcount--;
       }
 
-      dnscache_unlock(data, dnscache);
+      dnscache_unlock(data, dnscache, shard);
 
       if(!dns)
         return CURLE_OUT_OF_MEMORY;
@@ -1497,9 +1779,10 @@ CURLcode Curl_resolv_check(struct Curl_easy *data,
     return CURLE_FAILED_INIT;
 
   /* check if we have the name resolved by now (from someone else) */
-  *dns = Curl_dnscache_get(data, data->state.async.hostname,
-                           data->state.async.port,
-                           data->state.async.ip_version);
+  *dns = data->state.dns_refresh ? NULL :
+    Curl_dnscache_get(data, data->state.async.hostname,
+                      data->state.async.port,
+                      data->state.async.ip_version);
   if(*dns) {
     /* Tell a possibly async resolver we no longer need the results. */
     infof(data, "Hostname '%s' was found in DNS cache",
@@ -1519,6 +1802,11 @@ CURLcode Curl_resolv_check(struct Curl_easy *data,
   result = Curl_async_is_resolved(data, dns);
   if(*dns)
     show_resolve_info(data, *dns);
+  else if((result == CURLE_COULDNT_RESOLVE_HOST) ||
+          (result == CURLE_COULDNT_RESOLVE_PROXY))
+    dnscache_add_negative(data, data->state.async.hostname,
+                          data->state.async.port,
+                          data->state.async.ip_version);
   return result;
 }
 #endif
@@ -30,6 +30,7 @@
 #include "curlx/timeval.h" /* for timediff_t */
 #include "asyn.h"
 #include "httpsrr.h"
+#include "curl_threads.h"
 
 #include <setjmp.h>
 
@@ -72,12 +73,36 @@ struct Curl_dns_entry {
   size_t refcount;
   /* hostname port number that resolved to addr. */
   int hostport;
+  /* a failed resolve, `addr` is NULL */
+  BIT(negative);
+  /* expired, a transfer is resolving the name again */
+  BIT(refreshing);
   /* hostname that resolved to addr. may be NULL (Unix domain sockets). */
   char hostname[1];
 };
 
-struct Curl_dnscache {
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+/* A DNS cache in a share is split into this many shards by host name and
+ * port, each with its own lock. Threads looking up different hosts then
+ * rarely wait on each other. */
+#define DNSCACHE_SHARDS 16
+#endif
+
+/* A part of the DNS cache. A cache that is not sharded has a single one,
+ * protected by the share's DNS lock when in a share. */
+struct dnscache_shard {
   struct Curl_hash entries;
+  /* timestamp of the oldest entry that may go stale, 0 for none. Pruning
+   * does not walk the entries before one of them can be stale. */
+  time_t oldest;
+#ifdef DNSCACHE_SHARDS
+  curl_mutex_t mutex;
+#endif
+};
+
+struct Curl_dnscache {
+  struct dnscache_shard *shards;
+  size_t num_shards;
 };
 
 bool Curl_host_is_ipnum(const char *hostname);
@@ -122,8 +147,11 @@ bool Curl_ipv6works(struct Curl_easy *data);
 void Curl_resolv_unlink(struct Curl_easy *data,
                         struct Curl_dns_entry **pdns);
 
-/* init a new dns cache */
-void Curl_dnscache_init(struct Curl_dnscache *dns, size_t hashsize);
+/* init a new dns cache. A cache in a share is sharded when curl is built
+ * with thread support and then does its own locking instead of using the
+ * share's CURL_LOCK_DATA_DNS lock. */
+CURLcode Curl_dnscache_init(struct Curl_dnscache *dns, size_t hashsize,
+                            bool shared);
 
 void Curl_dnscache_destroy(struct Curl_dnscache *dns);
 
@@ -133,6 +161,10 @@ void Curl_dnscache_prune(struct Curl_easy *data);
 /* clear the DNS cache */
 void Curl_dnscache_clear(struct Curl_easy *data);
 
+/* The internal transfer refreshing a stale entry is done, successful or
+   not. Unless replaced, the entry gets refreshed again on its next use. */
+void Curl_dnscache_refresh_done(struct Curl_easy *data);
+
 /* IPv4 threadsafe resolve function used for synch and asynch builds */
 struct Curl_addrinfo *Curl_ipv4_resolve_r(const char *hostname, int port);
 
@@ -32,6 +32,7 @@
 #include "urldata.h"
 #include "llist.h"
 #include "hsts.h"
+#include "binstore.h"
 #include "curl_get_line.h"
 #include "sendf.h"
 #include "parsedate.h"
@@ -39,6 +40,7 @@
 #include "rename.h"
 #include "share.h"
 #include "strdup.h"
+#include "strcase.h"
 #include "curlx/strparse.h"
 
 /* The last 3 #include files should be in this order */
@@ -50,6 +52,10 @@
 #define MAX_HSTS_HOSTLEN 2048
 #define MAX_HSTS_DATELEN 256
 #define UNLIMITED "unlimited"
+#define HSTS_HASH_SIZE 64 /* initial number of hash slots, a power of two */
+
+/* binary store record fields: expires, includeSubDomains */
+#define HSTS_BIN_FMT "ii"
 
 #if defined(DEBUGBUILD) || defined(UNITTESTS)
 /* to play well with debug builds, we can *set* a fixed time this will
@@ -76,13 +82,14 @@ struct hsts *Curl_hsts_init(void)
   struct hsts *h = calloc(1, sizeof(struct hsts));
   if(h) {
     Curl_llist_init(&h->list, NULL);
+    Curl_llist_init(&h->stores, NULL);
   }
   return h;
 }
 
 static void hsts_free(struct stsentry *e)
 {
-  free(CURL_UNCONST(e->host));
+  /* the hostname is stored in the same allocation */
   free(e);
 }
 
@@ -97,12 +104,100 @@ void Curl_hsts_cleanup(struct hsts **hp)
       n = Curl_node_next(e);
       hsts_free(sts);
     }
+    Curl_binstore_destroy(&h->stores);
+    free(h->slots);
     free(h->filename);
     free(h);
     *hp = NULL;
   }
 }
 
+/*
+ * The entries are indexed in a hash table on the case insensitive hostname,
+ * which doubles its number of slots when it holds more entries than slots.
+ */
+static size_t hsts_hash(const char *host, size_t len)
+{
+  const char *end = host + len;
+  size_t h = 5381;
+
+  while(host < end) {
+    size_t j = (size_t)Curl_raw_toupper(*host++);
+    h += h << 5;
+    h ^= j;
+  }
+
+  return h;
+}
+
+/* Find the cached entry for this exact hostname, expired or not */
+static struct stsentry *hsts_lookup(struct hsts *h, const char *hostname,
+                                    size_t hlen)
+{
+  struct stsentry *sts;
+  size_t hash;
+
+  if(!h->nslots)
+    return NULL;
+  hash = hsts_hash(hostname, hlen);
+  for(sts = h->slots[hash & (h->nslots - 1)]; sts; sts = sts->next) {
+    if((sts->hash == hash) && curl_strnequal(sts->host, hostname, hlen) &&
+       !sts->host[hlen])
+      return sts;
+  }
+  return NULL;
+}
+
+/* Double the number of hash slots. When this fails the table keeps working
+   with longer chains. */
+static void hsts_grow(struct hsts *h)
+{
+  size_t nslots = h->nslots ? h->nslots * 2 : HSTS_HASH_SIZE;
+  struct stsentry **slots = calloc(nslots, sizeof(*slots));
+  size_t i;
+
+  if(!slots)
+    return;
+  for(i = 0; i < h->nslots; i++) {
+    struct stsentry *sts = h->slots[i];
+    while(sts) {
+      struct stsentry *next = sts->next;
+      size_t slot = sts->hash & (nslots - 1);
+      sts->next = slots[slot];
+      slots[slot] = sts;
+      sts = next;
+    }
+  }
+  free(h->slots);
+  h->slots = slots;
+  h->nslots = nslots;
+}
+
+/* Unlink the entry from the list and the hash, then free it */
+static void hsts_remove(struct hsts *h, struct stsentry *sts)
+{
+  struct stsentry **pp = &h->slots[sts->hash & (h->nslots - 1)];
+  while(*pp != sts)
+    pp = &(*pp)->next;
+  *pp = sts->next;
+  Curl_node_remove(&sts->node);
+  hsts_free(sts);
+}
+
+/* Remove all expired entries */
+static void hsts_expire(struct hsts *h)
+{
+  time_t now = time(NULL);
+  struct Curl_llist_node *e;
+  struct Curl_llist_node *n;
+  for(e = Curl_llist_head(&h->list); e; e = n) {
+    struct stsentry *sts = Curl_node_elem(e);
+    n = Curl_node_next(e);
+    if(sts->expires <= now)
+      hsts_remove(h, sts);
+  }
+}
+
 static CURLcode hsts_create(struct hsts *h,
                             const char *hostname,
                             size_t hlen,
@@ -116,25 +211,92 @@ static CURLcode hsts_create(struct hsts *h,
     /* strip off any trailing dot */
     --hlen;
   if(hlen) {
-    char *duphost;
-    struct stsentry *sts = calloc(1, sizeof(struct stsentry));
-    if(!sts)
+    char *host;
+    struct stsentry *sts;
+    size_t slot;
+
+    if(Curl_llist_count(&h->list) >= h->nslots)
+      hsts_grow(h);
+    if(!h->nslots)
       return CURLE_OUT_OF_MEMORY;
 
-    duphost = Curl_memdup0(hostname, hlen);
-    if(!duphost) {
-      free(sts);
+    /* the entry and its hostname in one allocation */
+    sts = calloc(1, sizeof(struct stsentry) + hlen + 1);
+    if(!sts)
       return CURLE_OUT_OF_MEMORY;
-    }
 
-    sts->host = duphost;
+    host = (char *)&sts[1];
+    memcpy(host, hostname, hlen);
+    sts->host = host;
+    sts->hash = hsts_hash(hostname, hlen);
     sts->expires = expires;
     sts->includeSubDomains = subdomains;
     Curl_llist_append(&h->list, sts, &sts->node);
+    slot = sts->hash & (h->nslots - 1);
+    sts->next = h->slots[slot];
+    h->slots[slot] = sts;
   }
   return CURLE_OK;
 }
 
+/* Copy an entry from a binary store file into the cache. When the hostname
+   is cached already, the later expiry time is kept. */
+static CURLcode hsts_restore(struct hsts *h, const struct Curl_binrec *rec)
+{
+  curl_off_t expires = rec->f[0].num;
+  struct stsentry *sts;
+
+  if(!rec->keylen || (rec->keylen > MAX_HSTS_HOSTLEN))
+    return CURLE_OK;
+  if(expires == CURL_OFF_T_MAX)
+    expires = TIME_T_MAX;
+  sts = hsts_lookup(h, rec->key, rec->keylen);
+  if(!sts)
+    return hsts_create(h, rec->key, rec->keylen, !!rec->f[1].num, expires);
+  if(expires > sts->expires)
+    sts->expires = expires;
+  return CURLE_OK;
+}
+
+/* Copy the stored entries for this hostname into the cache */
+static void hsts_unstore(struct hsts *h, const char *hostname, size_t hlen)
+{
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(&h->stores); n; n = Curl_node_next(n)) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    struct Curl_binrec rec;
+    while(Curl_binstore_take(bs, hostname, hlen, &rec))
+      (void)hsts_restore(h, &rec);
+  }
+  Curl_binstore_prune(&h->stores);
+}
+
+/* Copy all stored entries into the cache */
+static CURLcode hsts_unstore_all(struct hsts *h)
+{
+  CURLcode result = CURLE_OK;
+  struct Curl_llist_node *n;
+
+  for(n = Curl_llist_head(&h->stores); n && !result; n = Curl_node_next(n)) {
+    struct Curl_binstore *bs = Curl_node_elem(n);
+    struct Curl_binrec rec;
+    while(!result && Curl_binstore_next(bs, &rec))
+      result = hsts_restore(h, &rec);
+  }
+  Curl_binstore_prune(&h->stores);
+  return result;
+}
+
+/* Find the entry for this exact hostname, expired or not */
+static struct stsentry *hsts_find(struct hsts *h, const char *hostname,
+                                  size_t hlen)
+{
+  if(Curl_llist_count(&h->stores))
+    hsts_unstore(h, hostname, hlen);
+  return hsts_lookup(h, hostname, hlen);
+}
+
 CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
                          const char *header)
 {
@@ -209,10 +371,8 @@ CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
   if(!expires) {
     /* remove the entry if present verbatim (without subdomain match) */
     sts = Curl_hsts(h, hostname, hlen, FALSE);
-    if(sts) {
-      Curl_node_remove(&sts->node);
-      hsts_free(sts);
-    }
+    if(sts)
+      hsts_remove(h, sts);
     return CURLE_OK;
   }
 
@@ -240,16 +400,16 @@ CURLcode Curl_hsts_parse(struct hsts *h, const char *hostname,
  *
  * The 'subdomain' argument tells the function if subdomain matching should be
  * attempted.
+ *
+ * Expired entries are removed when a lookup runs into them.
  */
 struct stsentry *Curl_hsts(struct hsts *h, const char *hostname,
                            size_t hlen, bool subdomain)
 {
-  struct stsentry *bestsub = NULL;
   if(h) {
     time_t now = time(NULL);
-    struct Curl_llist_node *e;
-    struct Curl_llist_node *n;
-    size_t blen = 0;
+    const char *end;
+    struct stsentry *sts;
 
     if((hlen > MAX_HSTS_HOSTLEN) || !hlen)
       return NULL;
@@ -257,33 +417,33 @@ struct stsentry *Curl_hsts(struct hsts *h, const char *hostname,
       /* remove the trailing dot */
       --hlen;
 
-    for(e = Curl_llist_head(&h->list); e; e = n) {
-      struct stsentry *sts = Curl_node_elem(e);
-      size_t ntail;
-      n = Curl_node_next(e);
-      if(sts->expires <= now) {
-        /* remove expired entries */
-        Curl_node_remove(&sts->node);
-        hsts_free(sts);
-        continue;
-      }
-      ntail = strlen(sts->host);
-      if((subdomain && sts->includeSubDomains) && (ntail < hlen)) {
-        size_t offs = hlen - ntail;
-        if((hostname[offs-1] == '.') &&
-           curl_strnequal(&hostname[offs], sts->host, ntail) &&
-           (ntail > blen)) {
-          /* save the tail match with the longest tail */
-          bestsub = sts;
-          blen = ntail;
-        }
-      }
-      /* avoid curl_strequal because the host name is not null-terminated */
-      if((hlen == ntail) && curl_strnequal(hostname, sts->host, hlen))
+    sts = hsts_find(h, hostname, hlen);
+    if(sts) {
+      if(sts->expires > now)
         return sts;
+      hsts_remove(h, sts);
+    }
+    if(!subdomain)
+      return NULL;
+
+    /* check the parent domains, longest first, for one that includes its
+       subdomains */
+    end = &hostname[hlen];
+    while(hostname < end) {
+      const char *dot = memchr(hostname, '.', end - hostname);
+      if(!dot)
+        break;
+      hostname = dot + 1;
+      sts = hsts_find(h, hostname, end - hostname);
+      if(sts) {
+        if(sts->expires <= now)
+          hsts_remove(h, sts);
+        else if(sts->includeSubDomains)
+          return sts;
+      }
     }
   }
-  return bestsub;
+  return NULL;
 }
 
 /*
@@ -344,7 +504,34 @@ static CURLcode hsts_out(struct stsentry *sts, FILE *fp)
 
 
 /*
- * Curl_https_save() writes the HSTS cache to file and callback.
+ * Write the HSTS cache as a binary store file
+ */
+static CURLcode hsts_out_bin(struct hsts *h, FILE *fp)
+{
+  struct Curl_binwriter w;
+  struct Curl_llist_node *e;
+  CURLcode result = CURLE_OK;
+
+  Curl_binwriter_init(&w, CURL_BINSTORE_HSTS, HSTS_BIN_FMT);
+  for(e = Curl_llist_head(&h->list); e && !result; e = Curl_node_next(e)) {
+    struct stsentry *sts = Curl_node_elem(e);
+    struct Curl_binrec rec;
+    rec.key = sts->host;
+    rec.keylen = strlen(sts->host);
+    rec.f[0].num = (sts->expires == TIME_T_MAX) ? CURL_OFF_T_MAX :
+      sts->expires;
+    rec.f[1].num = sts->includeSubDomains;
+    result = Curl_binwriter_add(&w, &rec);
+  }
+  if(!result)
+    result = Curl_binwriter_write(&w, fp);
+  Curl_binwriter_free(&w);
+  return result;
+}
+
+/*
+ * Curl_https_save() writes the HSTS cache to file and callback. A file that
+ * is a binary store is written as one.
  */
 CURLcode Curl_hsts_save(struct Curl_easy *data, struct hsts *h,
                         const char *file)
@@ -354,11 +541,18 @@ CURLcode Curl_hsts_save(struct Curl_easy *data, struct hsts *h,
   CURLcode result = CURLE_OK;
   FILE *out;
   char *tempstore = NULL;
+  bool binary;
 
   if(!h)
     /* no cache activated */
     return CURLE_OK;
 
+  /* all entries are saved, read what is left in the store files */
+  result = hsts_unstore_all(h);
+  if(result)
+    return result;
+  hsts_expire(h);
+
   /* if no new name is given, use the one we stored from the load */
   if(!file && h->filename)
     file = h->filename;
@@ -367,17 +561,22 @@ CURLcode Curl_hsts_save(struct Curl_easy *data, struct hsts *h,
     /* marked as read-only, no file or zero length filename */
     goto skipsave;
 
+  binary = Curl_binstore_is(file);
   result = Curl_fopen(data, file, &out, &tempstore);
   if(!result) {
-    fputs("# Your HSTS cache. https://curl.se/docs/hsts.html\n"
-          "# This file was generated by libcurl! Edit at your own risk.\n",
-          out);
-    for(e = Curl_llist_head(&h->list); e; e = n) {
-      struct stsentry *sts = Curl_node_elem(e);
-      n = Curl_node_next(e);
-      result = hsts_out(sts, out);
-      if(result)
-        break;
+    if(binary)
+      result = hsts_out_bin(h, out);
+    else {
+      fputs("# Your HSTS cache. https://curl.se/docs/hsts.html\n"
+            "# This file was generated by libcurl! Edit at your own risk.\n",
+            out);
+      for(e = Curl_llist_head(&h->list); e; e = n) {
+        struct stsentry *sts = Curl_node_elem(e);
+        n = Curl_node_next(e);
+        result = hsts_out(sts, out);
+        if(result)
+          break;
+      }
     }
     fclose(out);
     if(!result && tempstore && Curl_rename(tempstore, file))
@@ -506,6 +705,9 @@ static CURLcode hsts_pull(struct Curl_easy *data, struct hsts *h)
  * Load the HSTS cache from the given file. The text based line-oriented file
  * format is documented here: https://curl.se/docs/hsts.html
  *
+ * A binary store file is not read, its entries are copied into the cache
+ * when their hostnames are looked up.
+ *
  * This function only returns error on major problems that prevent hsts
  * handling to work completely. It will ignore individual syntactical errors
  * etc.
@@ -513,6 +715,7 @@ static CURLcode hsts_pull(struct Curl_easy *data, struct hsts *h)
 static CURLcode hsts_load(struct hsts *h, const char *file)
 {
   CURLcode result = CURLE_OK;
+  struct Curl_binstore *bs;
   FILE *fp;
 
   /* we need a private copy of the filename so that the hsts cache file
@@ -522,6 +725,13 @@ static CURLcode hsts_load(struct hsts *h, const char *file)
   if(!h->filename)
     return CURLE_OUT_OF_MEMORY;
 
+  result = Curl_binstore_open(file, CURL_BINSTORE_HSTS, HSTS_BIN_FMT, &bs);
+  if(bs)
+    Curl_llist_append(&h->stores, bs, &bs->node);
+  if(result || bs)
+    /* a broken store file is ignored */
+    return (result == CURLE_OUT_OF_MEMORY) ? result : CURLE_OK;
+
   fp = fopen(file, FOPEN_READTEXT);
   if(fp) {
     struct dynbuf buf;
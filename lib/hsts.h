@@ -35,14 +35,21 @@ extern time_t deltatime;
 
 struct stsentry {
   struct Curl_llist_node node;
+  struct stsentry *next; /* next entry in the same hash slot */
+  size_t hash; /* hash of the lowercase hostname */
   const char *host;
   curl_off_t expires; /* the timestamp of this entry's expiry */
   BIT(includeSubDomains);
 };
 
-/* The HSTS cache. Needs to be able to tailmatch hostnames. */
+/* The HSTS cache. Needs to be able to tailmatch hostnames. The list keeps
+   the entries in the order they were added, the hash table indexes them by
+   hostname. */
 struct hsts {
   struct Curl_llist list;
+  struct stsentry **slots;
+  size_t nslots; /* always zero or a power of two */
+  struct Curl_llist stores; /* binary store files not read in full */
   char *filename;
   unsigned int flags;
 };
@@ -4830,6 +4830,14 @@ static void cr_exp100_done(struct Curl_easy *data,
   Curl_expire_done(data, EXPIRE_100_TIMEOUT);
 }
 
+static bool cr_exp100_passes_through(struct Curl_easy *data,
+                                     struct Curl_creader *reader)
+{
+  struct cr_exp100_ctx *ctx = reader->ctx;
+  (void)data;
+  return ctx->state == EXP100_SEND_DATA;
+}
+
 static const struct Curl_crtype cr_exp100 = {
   "cr-exp100",
   Curl_creader_def_init,
@@ -4842,6 +4850,7 @@ static const struct Curl_crtype cr_exp100 = {
   Curl_creader_def_unpause,
   Curl_creader_def_is_paused,
   cr_exp100_done,
+  cr_exp100_passes_through,
   sizeof(struct cr_exp100_ctx)
 };
 
@@ -47,6 +47,7 @@
 #include "transfer.h"
 #include "curlx/dynbuf.h"
 #include "headers.h"
+#include "flowctl.h"
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
 #include "curl_memory.h"
@@ -74,7 +75,9 @@
 #define H2_NW_RECV_CHUNKS       (H2_CONN_WINDOW_SIZE / H2_CHUNK_SIZE)
 /* on send into TLS, we just want to accumulate small frames */
 #define H2_NW_SEND_CHUNKS       1
-/* this is how much we want "in flight" for a stream, unthrottled  */
+/* this is how much we allow "in flight" for a stream at most. The window
+ * grows up to this when the bandwidth-delay product of the connection
+ * asks for it. */
 #define H2_STREAM_WINDOW_SIZE_MAX   (10 * 1024 * 1024)
 /* this is how much we want "in flight" for a stream, initially, IFF
  * nghttp2 allows us to tweak the local window size. */
@@ -95,6 +98,11 @@
  * is blocked from sending us any data. See #10988 for an issue with this. */
 #define HTTP2_HUGE_WINDOW_SIZE (100 * H2_STREAM_WINDOW_SIZE_MAX)
 
+/* opaque data of the PINGs measuring the BDP, to tell their ACKs apart */
+static const uint8_t h2_bdp_ping[8] = {
+  'c', 'u', 'r', 'l', '-', 'b', 'd', 'p'
+};
+
 #define H2_SETTINGS_IV_LEN  3
 #define H2_BINSETTINGS_LEN 80
 
@@ -136,8 +144,10 @@ struct cf_h2_ctx {
   struct dynbuf scratch;        /* scratch buffer for temp use */
 
   struct uint_hash streams; /* hash of `data->mid` to `h2_stream_ctx` */
+  struct flowctl fc;            /* stream window from the measured BDP */
   size_t drain_total; /* sum of all stream's UrlState drain */
   uint32_t max_concurrent_streams;
+  uint32_t local_max_streams;   /* MAX_CONCURRENT_STREAMS we announced */
   uint32_t goaway_error;        /* goaway error code from server */
   int32_t remote_max_sid;       /* max id processed by server */
   int32_t local_max_sid;        /* max id processed by us */
@@ -160,9 +170,11 @@ struct cf_h2_ctx {
 
 static void h2_stream_hash_free(unsigned int id, void *stream);
 
-static void cf_h2_ctx_init(struct cf_h2_ctx *ctx, bool via_h1_upgrade)
+static void cf_h2_ctx_init(struct cf_h2_ctx *ctx, struct Curl_easy *data,
+                           bool via_h1_upgrade)
 {
-  Curl_bufcp_init(&ctx->stream_bufcp, H2_CHUNK_SIZE, H2_STREAM_POOL_SPARES);
+  Curl_bufcp_init2(&ctx->stream_bufcp, Curl_multi_bufcache(data),
+                   H2_CHUNK_SIZE, H2_STREAM_POOL_SPARES);
   Curl_bufq_initp(&ctx->inbufq, &ctx->stream_bufcp, H2_NW_RECV_CHUNKS, 0);
   Curl_bufq_initp(&ctx->outbufq, &ctx->stream_bufcp, H2_NW_SEND_CHUNKS, 0);
   curlx_dyn_init(&ctx->scratch, CURL_MAX_HTTP_HEADER);
@@ -180,6 +192,11 @@ static void cf_h2_ctx_init(struct cf_h2_ctx *ctx, bool via_h1_upgrade)
         ctx->stream_win_max = (int32_t)l;
     }
   }
+  Curl_flowctl_init(&ctx->fc, H2_STREAM_WINDOW_SIZE_INITIAL,
+                    (uint32_t)ctx->stream_win_max);
+#else
+  Curl_flowctl_init(&ctx->fc, H2_STREAM_WINDOW_SIZE_INITIAL,
+                    H2_STREAM_WINDOW_SIZE_MAX);
 #endif
   ctx->initialized = TRUE;
 }
@@ -197,6 +214,17 @@ static void cf_h2_ctx_free(struct cf_h2_ctx *ctx)
   free(ctx);
 }
 
+/* The connection window leaves room for the windows of all streams we
+ * allow, as PAUSED streams hold on to their part of it. */
+static int32_t cf_h2_conn_win(struct cf_h2_ctx *ctx)
+{
+  uint64_t wsize = (uint64_t)ctx->local_max_streams * ctx->fc.window;
+
+  if(wsize < NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE)
+    wsize = NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE;
+  return (int32_t)CURLMIN(wsize, HTTP2_HUGE_WINDOW_SIZE);
+}
+
 static void cf_h2_ctx_close(struct cf_h2_ctx *ctx)
 {
   if(ctx->h2) {
@@ -296,7 +324,8 @@ static void h2_stream_hash_free(unsigned int id, void *stream)
 static int32_t cf_h2_get_desired_local_win(struct Curl_cfilter *cf,
                                            struct Curl_easy *data)
 {
-  (void)cf;
+  struct cf_h2_ctx *ctx = cf->ctx;
+
   if(data->set.max_recv_speed && data->set.max_recv_speed < INT32_MAX) {
     /* The transfer should only receive `max_recv_speed` bytes per second.
      * We restrict the stream's local window size, so that the server cannot
@@ -304,15 +333,15 @@ static int32_t cf_h2_get_desired_local_win(struct Curl_cfilter *cf,
      * This gets less precise the higher the latency. */
     return (int32_t)data->set.max_recv_speed;
   }
-#ifdef DEBUGBUILD
-  else {
-    struct cf_h2_ctx *ctx = cf->ctx;
-    CURL_TRC_CF(data, cf, "stream_win_max=%d", ctx->stream_win_max);
-    return ctx->stream_win_max;
+  if(data->multi) {
+    /* stay within the transfer's share of the multi's budget, which
+     * shrinks to nothing while CURLMOPT_MAX_MEMORY is exceeded */
+    size_t share = CURLMAX(Curl_multi_rwin_share(data->multi),
+                           H2_CHUNK_SIZE);
+    if(share < ctx->fc.window)
+      return (int32_t)share;
   }
-#else
-  return H2_STREAM_WINDOW_SIZE_MAX;
-#endif
+  return (int32_t)ctx->fc.window;
 }
 
 static CURLcode cf_h2_update_local_win(struct Curl_cfilter *cf,
@@ -534,6 +563,7 @@ static CURLcode cf_h2_ctx_open(struct Curl_cfilter *cf,
     goto out;
   }
   ctx->max_concurrent_streams = DEFAULT_MAX_CONCURRENT_STREAMS;
+  ctx->local_max_streams = Curl_multi_max_concurrent_streams(data->multi);
 
   if(ctx->via_h1_upgrade) {
     /* HTTP/1.1 Upgrade issued. H2 Settings have already been submitted
@@ -590,7 +620,7 @@ static CURLcode cf_h2_ctx_open(struct Curl_cfilter *cf,
   }
 
   rc = nghttp2_session_set_local_window_size(ctx->h2, NGHTTP2_FLAG_NONE, 0,
-                                             HTTP2_HUGE_WINDOW_SIZE);
+                                             cf_h2_conn_win(ctx));
   if(rc) {
     failf(data, "nghttp2_session_set_local_window_size() failed: %s(%d)",
           nghttp2_strerror(rc), rc);
@@ -706,6 +736,45 @@ static bool http2_connisalive(struct Curl_cfilter *cf, struct Curl_easy *data,
   return alive;
 }
 
+/* Send a PING to measure the data received during its round trip. It
+ * goes out with the next frames we send. */
+static void cf_h2_bdp_probe(struct Curl_cfilter *cf,
+                            struct Curl_easy *data)
+{
+  struct cf_h2_ctx *ctx = cf->ctx;
+  int rc;
+
+  rc = nghttp2_submit_ping(ctx->h2, NGHTTP2_FLAG_NONE, h2_bdp_ping);
+  if(rc) {
+    CURL_TRC_CF(data, cf, "[0] BDP ping failed: %s(%d)",
+                nghttp2_strerror(rc), rc);
+    return;
+  }
+  Curl_flowctl_probe_start(&ctx->fc, curlx_now());
+}
+
+/* The ACK of a BDP PING arrived. When the data received meanwhile asks
+ * for larger windows, grow the connection window. Streams get theirs
+ * when data is written to them next. */
+static int cf_h2_bdp_ack(struct Curl_cfilter *cf, struct Curl_easy *data)
+{
+  struct cf_h2_ctx *ctx = cf->ctx;
+  int rc;
+
+  if(!Curl_flowctl_probe_done(&ctx->fc, curlx_now()))
+    return 0;
+  CURL_TRC_CF(data, cf, "[0] BDP stream window now %u, rtt=%"
+              FMT_TIMEDIFF_T "us", ctx->fc.window, ctx->fc.rtt_us);
+  rc = nghttp2_session_set_local_window_size(ctx->h2, NGHTTP2_FLAG_NONE, 0,
+                                             cf_h2_conn_win(ctx));
+  if(rc) {
+    failf(data, "nghttp2_session_set_local_window_size() failed: %s(%d)",
+          nghttp2_strerror(rc), rc);
+    return NGHTTP2_ERR_CALLBACK_FAILURE;
+  }
+  return 0;
+}
+
 static CURLcode http2_send_ping(struct Curl_cfilter *cf,
                                 struct Curl_easy *data)
 {
@@ -1368,6 +1437,11 @@ static int on_frame_recv(nghttp2_session *session, const nghttp2_frame *frame,
         Curl_multi_connchanged(data->multi);
       }
       break;
+    case NGHTTP2_PING:
+      if((frame->hd.flags & NGHTTP2_FLAG_ACK) &&
+         !memcmp(frame->ping.opaque_data, h2_bdp_ping, sizeof(h2_bdp_ping)))
+        return cf_h2_bdp_ack(cf, data);
+      break;
     default:
       break;
     }
@@ -1450,6 +1524,8 @@ static int on_data_chunk_recv(nghttp2_session *session, uint8_t flags,
 
   nghttp2_session_consume(ctx->h2, stream_id, len);
   stream->nrcvd_data += (curl_off_t)len;
+  if(Curl_flowctl_recvd(&ctx->fc, len))
+    cf_h2_bdp_probe(cf, data_s);
   return 0;
 }
 
@@ -2779,6 +2855,9 @@ static CURLcode cf_h2_query(struct Curl_cfilter *cf,
   case CF_QUERY_HTTP_VERSION:
     *pres1 = 20;
     return CURLE_OK;
+  case CF_QUERY_FLOWCTL_STATS:
+    Curl_flowctl_get_stats(&ctx->fc, pres2);
+    return CURLE_OK;
   default:
     break;
   }
@@ -2819,7 +2898,7 @@ static CURLcode http2_cfilter_add(struct Curl_cfilter **pcf,
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx)
     goto out;
-  cf_h2_ctx_init(ctx, via_h1_upgrade);
+  cf_h2_ctx_init(ctx, data, via_h1_upgrade);
 
   result = Curl_cf_create(&cf, &Curl_cft_nghttp2, ctx);
   if(result)
@@ -2843,11 +2922,10 @@ static CURLcode http2_cfilter_insert_after(struct Curl_cfilter *cf,
   struct cf_h2_ctx *ctx;
   CURLcode result = CURLE_OUT_OF_MEMORY;
 
-  (void)data;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx)
     goto out;
-  cf_h2_ctx_init(ctx, via_h1_upgrade);
+  cf_h2_ctx_init(ctx, data, via_h1_upgrade);
 
   result = Curl_cf_create(&cf_h2, &Curl_cft_nghttp2, ctx);
   if(result)
@@ -34,6 +34,7 @@
 #include "content_encoding.h"
 #include "http.h"
 #include "multiif.h"
+#include "memscan.h"
 #include "curlx/strparse.h"
 #include "curlx/warnless.h"
 
@@ -146,16 +147,19 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
     switch(ch->state) {
     case CHUNK_HEX:
       if(ISXDIGIT(*buf)) {
-        if(ch->hexindex >= CHUNK_MAXNUM_LEN) {
-          failf(data, "chunk hex-length longer than %d", CHUNK_MAXNUM_LEN);
-          ch->state = CHUNK_FAILED;
-          ch->last_code = CHUNKE_TOO_LONG_HEX; /* longer than we support */
-          return CURLE_RECV_ERROR;
-        }
-        ch->hexbuffer[ch->hexindex++] = *buf;
-        buf++;
-        blen--;
-        (*pconsumed)++;
+        /* take all hex digits at hand in one go */
+        do {
+          if(ch->hexindex >= CHUNK_MAXNUM_LEN) {
+            failf(data, "chunk hex-length longer than %d", CHUNK_MAXNUM_LEN);
+            ch->state = CHUNK_FAILED;
+            ch->last_code = CHUNKE_TOO_LONG_HEX; /* longer than we support */
+            return CURLE_RECV_ERROR;
+          }
+          ch->hexbuffer[ch->hexindex++] = *buf;
+          buf++;
+          blen--;
+          (*pconsumed)++;
+        } while(blen && ISXDIGIT(*buf));
       }
       else {
         const char *p;
@@ -180,9 +184,11 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
       }
       break;
 
-    case CHUNK_LF:
-      /* waiting for the LF after a chunk size */
-      if(*buf == 0x0a) {
+    case CHUNK_LF: {
+      /* waiting for the LF after a chunk size, skip any chunk extension */
+      const char *lf = memchr(buf, 0x0a, blen);
+      piece = lf ? (size_t)(lf - buf) + 1 : blen;
+      if(lf) {
         /* we are now expecting data to come, unless size was zero! */
         if(ch->datasize == 0) {
           ch->state = CHUNK_TRAILER; /* now check for trailers */
@@ -194,10 +200,11 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
         }
       }
 
-      buf++;
-      blen--;
-      (*pconsumed)++;
+      buf += piece;
+      blen -= piece;
+      *pconsumed += piece;
       break;
+    }
 
     case CHUNK_DATA:
       /* We expect 'datasize' of data. We have 'blen' right now, it can be
@@ -294,12 +301,19 @@ static CURLcode httpchunk_readwrite(struct Curl_easy *data,
         }
       }
       else {
-        result = curlx_dyn_addn(&ch->trailer, buf, 1);
+        /* add everything up to the line end to the trailer */
+        const char *eol = Curl_memscan2(buf, blen, 0x0d, 0x0a);
+        piece = eol ? (size_t)(eol - buf) : blen;
+        result = curlx_dyn_addn(&ch->trailer, buf, piece);
         if(result) {
           ch->state = CHUNK_FAILED;
           ch->last_code = CHUNKE_OUT_OF_MEMORY;
           return result;
         }
+        buf += piece;
+        blen -= piece;
+        *pconsumed += piece;
+        break;
       }
       buf++;
       blen--;
@@ -660,6 +674,7 @@ const struct Curl_crtype Curl_httpchunk_encoder = {
   Curl_creader_def_unpause,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_passes_through,
   sizeof(struct chunked_reader)
 };
 
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "curl_setup.h"
+
+#include "memscan.h"
+#include "uint-bset.h" /* for CURL_CTZ64() */
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#define MEMSCAN_AVX2
+#define MEMSCAN_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MEMSCAN_SSE2
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MEMSCAN_NEON
+#endif
+
+const char *Curl_memscan2(const char *buf, size_t len, char c1, char c2)
+{
+  const char *p = buf;
+
+#ifdef MEMSCAN_AVX2
+  if(len >= 32) {
+    const __m256i v1 = _mm256_set1_epi8(c1);
+    const __m256i v2 = _mm256_set1_epi8(c2);
+    do {
+      __m256i d = _mm256_loadu_si256((const __m256i *)(const void *)p);
+      unsigned int m = (unsigned int)_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(d, v1), _mm256_cmpeq_epi8(d, v2)));
+      if(m)
+        return p + CURL_CTZ64(m);
+      p += 32;
+      len -= 32;
+    } while(len >= 32);
+  }
+#endif
+#ifdef MEMSCAN_SSE2
+  if(len >= 16) {
+    const __m128i v1 = _mm_set1_epi8(c1);
+    const __m128i v2 = _mm_set1_epi8(c2);
+    do {
+      __m128i d = _mm_loadu_si128((const __m128i *)(const void *)p);
+      unsigned int m = (unsigned int)_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(d, v1), _mm_cmpeq_epi8(d, v2)));
+      if(m)
+        return p + CURL_CTZ64(m);
+      p += 16;
+      len -= 16;
+    } while(len >= 16);
+  }
+#elif defined(MEMSCAN_NEON)
+  if(len >= 16) {
+    const uint8x16_t v1 = vdupq_n_u8((uint8_t)c1);
+    const uint8x16_t v2 = vdupq_n_u8((uint8_t)c2);
+    do {
+      uint8x16_t d = vld1q_u8((const uint8_t *)p);
+      uint8x16_t m = vorrq_u8(vceqq_u8(d, v1), vceqq_u8(d, v2));
+      /* narrow to 4 bits per byte to get a 64-bit mask */
+      curl_uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+      if(bits)
+        return p + (CURL_CTZ64(bits) >> 2);
+      p += 16;
+      len -= 16;
+    } while(len >= 16);
+  }
+#endif
+
+  for(; len; ++p, --len) {
+    if((*p == c1) || (*p == c2))
+      return p;
+  }
+  return NULL;
+}
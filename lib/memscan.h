@@ -0,0 +1,38 @@
+#ifndef HEADER_CURL_MEMSCAN_H
+#define HEADER_CURL_MEMSCAN_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+
+/*
+ * Return a pointer to the first byte in `buf` of `len` bytes that is
+ * either `c1` or `c2`, or NULL if there is none.
+ *
+ * This is a memchr() for two bytes at once, e.g. for finding the end of a
+ * header line or the colon in a header. Uses SSE2, AVX2 or NEON when the
+ * compiler targets them and a plain loop otherwise.
+ */
+const char *Curl_memscan2(const char *buf, size_t len, char c1, char c2);
+
+#endif /* HEADER_CURL_MEMSCAN_H */
@@ -441,6 +441,8 @@ static size_t encoder_base64_read(char *buffer, size_t size, bool ateof,
   char *ptr = buffer;
 
   while(st->bufbeg < st->bufend) {
+    size_t groups;
+
     /* Line full ? */
     if(st->pos > MAX_ENCODED_LINE_LENGTH - 4) {
       /* Yes, we need 2 characters for CRLF. */
@@ -465,17 +467,20 @@ static size_t encoder_base64_read(char *buffer, size_t size, bool ateof,
     if(st->bufend - st->bufbeg < 3)
       break;
 
-    /* Encode three bytes as four characters. */
-    i = st->buf[st->bufbeg++] & 0xFF;
-    i = (i << 8) | (st->buf[st->bufbeg++] & 0xFF);
-    i = (i << 8) | (st->buf[st->bufbeg++] & 0xFF);
-    *ptr++ = Curl_base64encdec[(i >> 18) & 0x3F];
-    *ptr++ = Curl_base64encdec[(i >> 12) & 0x3F];
-    *ptr++ = Curl_base64encdec[(i >> 6) & 0x3F];
-    *ptr++ = Curl_base64encdec[i & 0x3F];
-    cursize += 4;
-    st->pos += 4;
-    size -= 4;
+    /* Encode as many groups as the line, the space and the input data
+       allow, three bytes as four characters each. */
+    groups = (MAX_ENCODED_LINE_LENGTH - st->pos) / 4;
+    if(groups > size / 4)
+      groups = size / 4;
+    if(groups > (st->bufend - st->bufbeg) / 3)
+      groups = (st->bufend - st->bufbeg) / 3;
+    curlx_base64_encode_groups(ptr, (const unsigned char *)st->buf +
+                               st->bufbeg, groups);
+    ptr += groups * 4;
+    st->bufbeg += groups * 3;
+    cursize += groups * 4;
+    st->pos += groups * 4;
+    size -= groups * 4;
   }
 
   /* If at eof, we have to flush the buffered data. */
@@ -737,8 +742,25 @@ static int mime_file_seek(void *instream, curl_off_t offset, int whence)
   if(mime_open_file(part))
     return CURL_SEEKFUNC_FAIL;
 
+#if defined(_WIN32) && defined(USE_WIN32_LARGE_FILES)
+  return _fseeki64(part->fp, (__int64)offset, whence) ?
+    CURL_SEEKFUNC_CANTSEEK : CURL_SEEKFUNC_OK;
+#elif defined(HAVE_FSEEKO) && defined(HAVE_DECL_FSEEKO)
+  return fseeko(part->fp, (off_t)offset, whence) ?
+    CURL_SEEKFUNC_CANTSEEK : CURL_SEEKFUNC_OK;
+#else
+  if(offset > LONG_MAX)
+    return CURL_SEEKFUNC_CANTSEEK;
   return fseek(part->fp, (long) offset, whence) ?
     CURL_SEEKFUNC_CANTSEEK : CURL_SEEKFUNC_OK;
+#endif
+}
+
+/* Only regular files have a seek function. */
+static bool mime_is_regular_file(curl_mimepart *part)
+{
+  return part->kind == MIMEKIND_FILE && part->readfunc == mime_file_read &&
+         part->seekfunc == mime_file_seek;
 }
 
 static void mime_file_free(void *ptr)
@@ -858,6 +880,7 @@ static size_t read_encoded_part_content(curl_mimepart *part, char *buffer,
   size_t cursize = 0;
   size_t sz;
   bool ateof = FALSE;
+  bool refill = FALSE;
 
   for(;;) {
     if(st->bufbeg < st->bufend || ateof) {
@@ -890,8 +913,17 @@ static size_t read_encoded_part_content(curl_mimepart *part, char *buffer,
     }
     if(st->bufend >= sizeof(st->buf))
       return cursize ? cursize : READ_ERROR;    /* Buffer full. */
-    sz = read_part_content(part, st->buf + st->bufend,
-                           sizeof(st->buf) - st->bufend, hasread);
+    if(refill) {
+      /* Reading a regular file does not block: keep encoding it until
+         the output buffer is full. */
+      bool fileread = FALSE;
+      sz = read_part_content(part, st->buf + st->bufend,
+                             sizeof(st->buf) - st->bufend, &fileread);
+    }
+    else
+      sz = read_part_content(part, st->buf + st->bufend,
+                             sizeof(st->buf) - st->bufend, hasread);
+    refill = mime_is_regular_file(part);
     switch(sz) {
     case 0:
       ateof = TRUE;
@@ -2189,6 +2221,7 @@ static const struct Curl_crtype cr_mime = {
   cr_mime_unpause,
   cr_mime_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_passes_through,
   sizeof(struct cr_mime_ctx)
 };
 
@@ -2214,6 +2247,102 @@ CURLcode Curl_creader_set_mime(struct Curl_easy *data, curl_mimepart *part)
   return Curl_creader_set(data, r);
 }
 
+#ifdef USE_SENDFILE
+/* Find the file part whose content the mime structure is positioned in,
+   when no encoder is involved on the way to it. */
+static curl_mimepart *mime_file_span_part(curl_mimepart *part)
+{
+  while(part && !part->encoder && part->state.state == MIMESTATE_CONTENT) {
+    curl_mime *mime;
+
+    switch(part->lastreadstatus) {
+    case 0:
+    case CURL_READFUNC_ABORT:
+    case CURL_READFUNC_PAUSE:
+    case READ_ERROR:
+      return NULL;
+    default:
+      break;
+    }
+    if(part->kind == MIMEKIND_FILE)
+      return mime_is_regular_file(part) ? part : NULL;
+    if(part->kind != MIMEKIND_MULTIPART)
+      return NULL;
+    mime = part->arg;
+    if(mime->state.state != MIMESTATE_CONTENT)
+      return NULL;
+    part = mime->state.ptr;
+  }
+  return NULL;
+}
+
+static struct cr_mime_ctx *cr_mime_direct_ctx(struct Curl_easy *data)
+{
+  /* Any reader that changes the data would need to see it. */
+  struct Curl_creader *r = Curl_creader_get_client(data);
+  return (r && r->crt == &cr_mime) ? r->ctx : NULL;
+}
+
+bool Curl_creader_mime_file_span(struct Curl_easy *data, int *pfd,
+                                 curl_off_t *poffset, curl_off_t *plen)
+{
+  struct cr_mime_ctx *ctx = cr_mime_direct_ctx(data);
+  curl_mimepart *part;
+  curl_off_t len;
+
+  if(!ctx || ctx->errored || ctx->seen_eos ||
+     !Curl_bufq_is_empty(&ctx->tmpbuf))
+    return FALSE;
+  part = mime_file_span_part(ctx->part);
+  if(!part || part->datasize < 0 || part->state.offset >= part->datasize)
+    return FALSE;
+  len = part->datasize - part->state.offset;
+  if(ctx->total_len >= 0 && ctx->total_len - ctx->read_len < len)
+    len = ctx->total_len - ctx->read_len;
+  if(len <= 0 || mime_open_file(part))
+    return FALSE;
+
+  *pfd = fileno(part->fp);
+  *poffset = part->state.offset;
+  *plen = len;
+  return TRUE;
+}
+
+CURLcode Curl_creader_mime_file_sent(struct Curl_easy *data, size_t nbytes)
+{
+  struct cr_mime_ctx *ctx = cr_mime_direct_ctx(data);
+  curl_mimepart *part;
+
+  DEBUGASSERT(ctx);
+  if(!ctx)
+    return CURLE_READ_ERROR;
+  part = ctx->part;
+  /* Advance the file part and all multiparts above it as if read. */
+  while(part) {
+    part->state.offset += (curl_off_t)nbytes;
+    part->lastreadstatus = nbytes;
+    if(part->kind != MIMEKIND_MULTIPART)
+      break;
+    part = ((curl_mime *)part->arg)->state.ptr;
+  }
+  DEBUGASSERT(part && part->kind == MIMEKIND_FILE);
+  if(!part ||
+     part->seekfunc(part->arg, part->state.offset, SEEK_SET) !=
+     CURL_SEEKFUNC_OK) {
+    failf(data, "cannot seek in mime file part");
+    ctx->errored = TRUE;
+    ctx->error_result = CURLE_READ_ERROR;
+    return CURLE_READ_ERROR;
+  }
+  ctx->read_len += (curl_off_t)nbytes;
+  if(ctx->total_len >= 0)
+    ctx->seen_eos = (ctx->read_len >= ctx->total_len);
+  CURL_TRC_READ(data, "cr_mime_file_sent(len=%zu, total=%" FMT_OFF_T
+                ", read=%"FMT_OFF_T")", nbytes, ctx->total_len, ctx->read_len);
+  return CURLE_OK;
+}
+#endif /* USE_SENDFILE */
+
 #else /* !CURL_DISABLE_MIME && (!CURL_DISABLE_HTTP ||
                                 !CURL_DISABLE_SMTP || !CURL_DISABLE_IMAP) */
 
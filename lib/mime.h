@@ -161,6 +161,23 @@ const char *Curl_mime_contenttype(const char *filename);
  */
 CURLcode Curl_creader_set_mime(struct Curl_easy *data, curl_mimepart *part);
 
+#ifdef USE_SENDFILE
+/**
+ * Return TRUE when the client reader of the transfer is a mime reader
+ * that is positioned in the unencoded content of a regular file part,
+ * with nothing read ahead. The file descriptor, its offset and the
+ * number of bytes that may be sent directly from it are returned.
+ */
+bool Curl_creader_mime_file_span(struct Curl_easy *data, int *pfd,
+                                 curl_off_t *poffset, curl_off_t *plen);
+
+/**
+ * Advance the mime reader by `nbytes` that were sent directly from the
+ * file returned by Curl_creader_mime_file_span().
+ */
+CURLcode Curl_creader_mime_file_sent(struct Curl_easy *data, size_t nbytes);
+#endif
+
 #else
 /* if disabled */
 #define Curl_mime_initpart(x)
@@ -170,6 +187,8 @@ CURLcode Curl_creader_set_mime(struct Curl_easy *data, curl_mimepart *part);
 #define Curl_mime_prepare_headers(a,b,c,d,e) CURLE_NOT_BUILT_IN
 #define Curl_mime_read NULL
 #define Curl_creader_set_mime(x,y) ((void)x, CURLE_NOT_BUILT_IN)
+#define Curl_creader_mime_file_span(a,b,c,d) FALSE
+#define Curl_creader_mime_file_sent(a,b) CURLE_NOT_BUILT_IN
 #endif
 
 
@@ -45,6 +45,7 @@
 #include "curlx/wait.h"
 #include "speedcheck.h"
 #include "conncache.h"
+#include "cprewarm.h"
 #include "multihandle.h"
 #include "sigpipe.h"
 #include "vtls/vtls.h"
@@ -83,6 +84,21 @@
 #define CURL_TLS_SESSION_SIZE 25
 #endif
 
+/* Spare buffer chunks per size class kept in the multi's chunk cache
+   while transfers are running (high) and when none are (low). */
+#ifndef CURL_BUFC_CACHE_LOW
+#define CURL_BUFC_CACHE_LOW   4
+#endif
+
+#ifndef CURL_BUFC_CACHE_HIGH
+#define CURL_BUFC_CACHE_HIGH  64
+#endif
+
+/* default number of threads resolving names for a multi handle */
+#ifndef CURL_RESOLVE_THREADS
+#define CURL_RESOLVE_THREADS  16
+#endif
+
 #define CURL_MULTI_HANDLE 0x000bab1e
 
 #ifdef DEBUGBUILD
@@ -97,6 +113,10 @@
   ((x) && (x)->magic == CURL_MULTI_HANDLE)
 #endif
 
+/* Internal transfers the multi runs on its own behalf. They do not count
+ * as running for the application. */
+#define MULTI_XFER_OWN(d) ((d)->state.prewarm || (d)->state.dns_refresh)
+
 static void move_pending_to_connect(struct Curl_multi *multi,
                                     struct Curl_easy *data);
 static CURLMcode add_next_timeout(struct curltime now,
@@ -106,11 +126,92 @@ static CURLMcode multi_timeout(struct Curl_multi *multi,
                                struct curltime *expire_time,
                                long *timeout_ms);
 static void process_pending_handles(struct Curl_multi *multi);
+#ifdef USE_EPOLL
+static CURLMcode multi_epoll_perform(struct Curl_multi *multi,
+                                     int *running_handles);
+#endif
 static void multi_xfer_bufs_free(struct Curl_multi *multi);
 #ifdef DEBUGBUILD
 static void multi_xfer_tbl_dump(struct Curl_multi *multi);
 #endif
 
+/*
+ * The transfers with a pending timer are kept sorted on their nearest expire
+ * time, in a splay tree or, with USE_TIMER_WHEEL, in a timing wheel. The
+ * multi_timer_*() functions hide which one is used.
+ */
+
+/* add the transfer using its current 'expiretime' */
+static void multi_timer_add(struct Curl_multi *multi,
+                            struct Curl_easy *data)
+{
+#ifdef USE_TIMER_WHEEL
+  Curl_twheel_nodeinit(&data->state.timenode, data);
+  Curl_twheel_insert(multi->timewheel, data->state.expiretime,
+                     &data->state.timenode);
+#else
+  Curl_splayset(&data->state.timenode, data);
+  multi->timetree = Curl_splayinsert(data->state.expiretime, multi->timetree,
+                                     &data->state.timenode);
+#endif
+}
+
+static int multi_timer_remove(struct Curl_multi *multi,
+                              struct Curl_easy *data)
+{
+#ifdef USE_TIMER_WHEEL
+  return Curl_twheel_remove(multi->timewheel, &data->state.timenode);
+#else
+  return Curl_splayremove(multi->timetree, &data->state.timenode,
+                          &multi->timetree);
+#endif
+}
+
+/* remove and return a transfer whose expire time is not later than 'now',
+   NULL if there is none */
+static struct Curl_easy *multi_timer_getbest(struct Curl_multi *multi,
+                                             struct curltime now)
+{
+#ifdef USE_TIMER_WHEEL
+  struct Curl_twheel_node *t = Curl_twheel_getbest(multi->timewheel, now);
+  return t ? Curl_twheel_get(t) : NULL;
+#else
+  struct Curl_tree *t = NULL;
+  multi->timetree = Curl_splaygetbest(now, multi->timetree, &t);
+  return t ? Curl_splayget(t) : NULL;
+#endif
+}
+
+/* get the time when the multi needs to act next on a timer. If that time
+   has passed, '*pdata' is set to the transfer it expired for. Returns FALSE
+   when no timer is set. */
+static bool multi_timer_next(struct Curl_multi *multi,
+                             struct curltime now,
+                             struct curltime *pexpire,
+                             struct Curl_easy **pdata)
+{
+#ifdef USE_TIMER_WHEEL
+  struct Curl_twheel_node *t;
+  if(!Curl_twheel_next(multi->timewheel, now, pexpire, &t))
+    return FALSE;
+  *pdata = t ? Curl_twheel_get(t) : NULL;
+#else
+  static const struct curltime tv_zero = {0, 0};
+  if(!multi->timetree)
+    return FALSE;
+  /* splay the lowest to the bottom */
+  multi->timetree = Curl_splay(tv_zero, multi->timetree);
+  /* this will not return NULL from a non-empty tree, but some compilers
+   * are not convinced of that. Analyzers are hard. */
+  if(!multi->timetree)
+    return FALSE;
+  *pexpire = multi->timetree->key;
+  *pdata = (curlx_timediff_us(*pexpire, now) > 0) ?
+    NULL : Curl_splayget(multi->timetree);
+#endif
+  return TRUE;
+}
+
 /* function pointer called once when switching TO a state */
 typedef void (*init_multistate_func)(struct Curl_easy *data);
 
@@ -181,6 +282,8 @@ static void mstate(struct Curl_easy *data, CURLMstate state
     if(Curl_uint_bset_empty(&data->multi->process)) {
       /* free the transfer buffer when we have no more active transfers */
       multi_xfer_bufs_free(data->multi);
+      if(data->multi->bufcache)
+        Curl_bufcache_trim(data->multi->bufcache);
     }
   }
 
@@ -231,7 +334,6 @@ struct Curl_multi *Curl_multi_handle(unsigned int xfer_table_size,
 
   multi->magic = CURL_MULTI_HANDLE;
 
-  Curl_dnscache_init(&multi->dnscache, dnssize);
   Curl_multi_ev_init(multi, ev_hashsize);
   Curl_uint_tbl_init(&multi->xfers, NULL);
   Curl_uint_bset_init(&multi->process);
@@ -244,15 +346,25 @@ struct Curl_multi *Curl_multi_handle(unsigned int xfer_table_size,
 
   multi->multiplexing = TRUE;
   multi->max_concurrent_streams = 100;
+  multi->rwin_budget = MULTI_RWIN_BUDGET;
+  multi->max_resolve_threads = CURL_RESOLVE_THREADS;
   multi->last_timeout_ms = -1;
 
-  if(Curl_uint_bset_resize(&multi->process, xfer_table_size) ||
+  if(Curl_dnscache_init(&multi->dnscache, dnssize, FALSE) ||
+     Curl_uint_bset_resize(&multi->process, xfer_table_size) ||
      Curl_uint_bset_resize(&multi->pending, xfer_table_size) ||
      Curl_uint_bset_resize(&multi->dirty, xfer_table_size) ||
      Curl_uint_bset_resize(&multi->msgsent, xfer_table_size) ||
      Curl_uint_tbl_resize(&multi->xfers, xfer_table_size))
     goto error;
 
+#ifdef USE_TIMER_WHEEL
+  multi->timewheel = malloc(sizeof(*multi->timewheel));
+  if(!multi->timewheel)
+    goto error;
+  Curl_twheel_init(multi->timewheel, curlx_now());
+#endif
+
   multi->admin = curl_easy_init();
   if(!multi->admin)
     goto error;
@@ -269,7 +381,8 @@ struct Curl_multi *Curl_multi_handle(unsigned int xfer_table_size,
   if(Curl_cshutdn_init(&multi->cshutdn, multi))
     goto error;
 
-  Curl_cpool_init(&multi->cpool, multi->admin, NULL, chashsize);
+  if(Curl_cpool_init(&multi->cpool, multi->admin, NULL, chashsize))
+    goto error;
 
 #ifdef USE_SSL
   if(Curl_ssl_scache_create(sesssize, 2, &multi->ssl_scache))
@@ -311,7 +424,9 @@ error:
   Curl_uint_bset_destroy(&multi->pending);
   Curl_uint_bset_destroy(&multi->msgsent);
   Curl_uint_tbl_destroy(&multi->xfers);
-
+#ifdef USE_TIMER_WHEEL
+  free(multi->timewheel);
+#endif
   free(multi);
   return NULL;
 }
@@ -464,6 +579,7 @@ CURLMcode curl_multi_add_handle(CURLM *m, CURL *d)
   /* make the Curl_easy refer back to this multi handle - before Curl_expire()
      is called. */
   data->multi = multi;
+  multi->mem_out += data->state.mem_out;
 
   /* set the easy handle */
   multistate(data, MSTATE_INIT);
@@ -478,7 +594,8 @@ CURLMcode curl_multi_add_handle(CURLM *m, CURL *d)
 
   /* add the easy handle to the process set */
   Curl_uint_bset_add(&multi->process, data->mid);
-  ++multi->xfers_alive;
+  if(!MULTI_XFER_OWN(data))
+    ++multi->xfers_alive;
 
   Curl_cpool_xfer_init(data);
   multi_warn_debug(multi, data);
@@ -670,8 +787,10 @@ static CURLcode multi_done(struct Curl_easy *data,
     break;
   }
 
-  /* this calls the protocol-specific function pointer previously set */
-  if(conn->handler->done && (data->mstate >= MSTATE_PROTOCONNECT))
+  /* this calls the protocol-specific function pointer previously set,
+     internal transfers of the multi never got to DO anything */
+  if(conn->handler->done && (data->mstate >= MSTATE_PROTOCONNECT) &&
+     !MULTI_XFER_OWN(data))
     result = conn->handler->done(data, status, premature);
   else
     result = status;
@@ -687,6 +806,13 @@ static CURLcode multi_done(struct Curl_easy *data,
   /* Make sure that transfer client writes are really done now. */
   result = Curl_1st_err(result, Curl_xfer_write_done(data, premature));
 
+  /* Keep the connection's UDP counters and flow-control state for
+     curl_easy_getinfo() */
+  (void)Curl_conn_get_udp_io_stats(data, conn, FIRSTSOCKET,
+                                   &data->info.udp_io);
+  (void)Curl_conn_get_flowctl_stats(data, conn, FIRSTSOCKET,
+                                    &data->info.flowctl);
+
   /* Inform connection filters that this transfer is done */
   Curl_conn_ev_data_done(data, premature);
 
@@ -775,12 +901,13 @@ CURLMcode curl_multi_remove_handle(CURLM *m, CURL *d)
   }
 
   /* The timer must be shut down before data->multi is set to NULL, else the
-     timenode will remain in the splay tree after curl_easy_cleanup is
+     timenode will remain in the timers after curl_easy_cleanup is
      called. Do it after multi_done() in case that sets another time! */
   removed_timer = Curl_expire_clear(data);
 
   /* If in `msgsent`, it was deducted from `multi->xfers_alive` already. */
-  if(!Curl_uint_bset_contains(&multi->msgsent, data->mid))
+  if(!Curl_uint_bset_contains(&multi->msgsent, data->mid) &&
+     !MULTI_XFER_OWN(data))
     --multi->xfers_alive;
 
   Curl_wildcard_dtor(&data->wildcard);
@@ -842,6 +969,7 @@ CURLMcode curl_multi_remove_handle(CURLM *m, CURL *d)
   Curl_uint_bset_remove(&multi->dirty, mid);
   Curl_uint_bset_remove(&multi->pending, mid);
   Curl_uint_bset_remove(&multi->msgsent, mid);
+  multi->mem_out -= data->state.mem_out;
   data->multi = NULL;
   data->mid = UINT_MAX;
   data->master_mid = UINT_MAX;
@@ -1264,6 +1392,87 @@ static void reset_socket_fdwrite(curl_socket_t s)
 }
 #endif
 
+#if defined(ENABLE_WAKEUP) && !defined(USE_WINSOCK)
+static void multi_wakeup_drain(struct Curl_multi *multi)
+{
+  char buf[64];
+  ssize_t nread;
+  while(1) {
+    /* the reading socket is non-blocking, try to read
+       data from it until it receives an error (except EINTR).
+       In normal cases it will get EAGAIN or EWOULDBLOCK
+       when there is no more data, breaking the loop. */
+    nread = wakeup_read(multi->wakeup_pair[0], buf, sizeof(buf));
+    if(nread <= 0) {
+      if(nread < 0 && SOCKEINTR == SOCKERRNO)
+        continue;
+      break;
+    }
+  }
+}
+#endif
+
+#ifdef USE_EPOLL
+/* Collect the ready sockets from the epoll instance, waiting at most
+ * `timeout_ms`. A wakeup seen by curl_multi_wait() is kept for the next
+ * curl_multi_poll(). */
+static CURLMcode multi_epoll_collect(struct Curl_multi *multi,
+                                     int timeout_ms, bool use_wakeup,
+                                     unsigned int *pnready)
+{
+  bool woken;
+  CURLMcode result = Curl_multi_ev_epoll_wait(multi, timeout_ms,
+                                              pnready, &woken);
+#if defined(ENABLE_WAKEUP) && !defined(USE_WINSOCK)
+  if(!result && woken) {
+    multi_wakeup_drain(multi);
+    if(!use_wakeup)
+      multi->ev.wakeup_pending = TRUE;
+  }
+#else
+  (void)woken;
+  (void)use_wakeup;
+#endif
+  return result;
+}
+
+/* multi_wait() with the epoll backend and nothing else to wait on: a
+ * single epoll_wait() whose events mark the ready transfers dirty for
+ * the following curl_multi_perform(). */
+static CURLMcode multi_epoll_wait(struct Curl_multi *multi,
+                                  int timeout_ms, int *ret,
+                                  bool use_wakeup)
+{
+  struct curltime expire_time;
+  long timeout_internal;
+  unsigned int nready = 0;
+  CURLMcode result;
+
+  if(use_wakeup && multi->ev.wakeup_pending) {
+    multi->ev.wakeup_pending = FALSE;
+    timeout_ms = 0;
+  }
+  else if(!use_wakeup && !multi->ev.epoll_nfds) {
+    /* like curl_multi_wait() without any sockets, return at once */
+    if(ret)
+      *ret = 0;
+    return CURLM_OK;
+  }
+
+  (void)multi_timeout(multi, &expire_time, &timeout_internal);
+  if((timeout_internal >= 0) && (timeout_internal < (long)timeout_ms))
+    timeout_ms = (int)timeout_internal;
+
+  CURL_TRC_M(multi->admin, "multi_wait(epoll fds=%u, timeout=%d) "
+             "tinternal=%ld", multi->ev.epoll_nfds, timeout_ms,
+             timeout_internal);
+  result = multi_epoll_collect(multi, timeout_ms, use_wakeup, &nready);
+  if(ret)
+    *ret = (nready < INT_MAX) ? (int)nready : INT_MAX;
+  return result;
+}
+#endif
+
 #define NUM_POLLS_ON_STACK 10
 
 static CURLMcode multi_wait(struct Curl_multi *multi,
@@ -1284,6 +1493,12 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
   struct Curl_easy *data = NULL;
   CURLMcode result = CURLM_OK;
   unsigned int mid;
+#ifdef USE_EPOLL
+  curl_socket_t epfd = CURL_SOCKET_BAD;
+#endif
+#if defined(ENABLE_WAKEUP) && !defined(USE_WINSOCK)
+  bool poll_wakeup = use_wakeup;
+#endif
 
 #ifdef USE_WINSOCK
   WSANETWORKEVENTS wsa_events;
@@ -1304,6 +1519,27 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
 
   Curl_pollfds_init(&cpfds, a_few_on_stack, NUM_POLLS_ON_STACK);
 
+#ifdef USE_EPOLL
+  if(Curl_multi_ev_epoll_get(multi, &epfd)) {
+    if(!extra_nfds && !Curl_llist_count(&multi->cshutdn.list))
+      return multi_epoll_wait(multi, timeout_ms, ret, use_wakeup);
+    /* The transfers' sockets and the wakeup socket are registered at the
+     * epoll instance already, poll it together with the others. */
+    data = multi->admin;
+    if(use_wakeup && multi->ev.wakeup_pending) {
+      multi->ev.wakeup_pending = FALSE;
+      timeout_ms = 0;
+    }
+#if defined(ENABLE_WAKEUP) && !defined(USE_WINSOCK)
+    poll_wakeup = FALSE;
+#endif
+    if(Curl_pollfds_add_sock(&cpfds, epfd, POLLIN)) {
+      result = CURLM_OUT_OF_MEMORY;
+      goto out;
+    }
+  }
+  else
+#endif
   /* Add the curl handles to our pollfds first */
   if(Curl_uint_bset_first(&multi->process, &mid)) {
     do {
@@ -1368,7 +1604,7 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
 
 #ifdef ENABLE_WAKEUP
 #ifndef USE_WINSOCK
-  if(use_wakeup && multi->wakeup_pair[0] != CURL_SOCKET_BAD) {
+  if(poll_wakeup && multi->wakeup_pair[0] != CURL_SOCKET_BAD) {
     if(Curl_pollfds_add_sock(&cpfds, multi->wakeup_pair[0], POLLIN)) {
       result = CURLM_OUT_OF_MEMORY;
       goto out;
@@ -1409,6 +1645,17 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
 
     if(pollrc > 0) {
       retcode = pollrc;
+#ifdef USE_EPOLL
+      /* the epoll descriptor is always first, count its ready sockets
+       * instead of itself */
+      if((epfd != CURL_SOCKET_BAD) && (cpfds.pfds[0].revents & POLLIN)) {
+        unsigned int nready;
+        result = multi_epoll_collect(multi, 0, use_wakeup, &nready);
+        if(result)
+          goto out;
+        retcode += (int)nready - 1;
+      }
+#endif
 #ifdef USE_WINSOCK
     }
     else { /* now wait... if not ready during the pre-check (pollrc == 0) */
@@ -1467,22 +1714,9 @@ static CURLMcode multi_wait(struct Curl_multi *multi,
       WSAResetEvent(multi->wsa_event);
 #else
 #ifdef ENABLE_WAKEUP
-      if(use_wakeup && multi->wakeup_pair[0] != CURL_SOCKET_BAD) {
+      if(poll_wakeup && multi->wakeup_pair[0] != CURL_SOCKET_BAD) {
         if(cpfds.pfds[curl_nfds + extra_nfds].revents & POLLIN) {
-          char buf[64];
-          ssize_t nread;
-          while(1) {
-            /* the reading socket is non-blocking, try to read
-               data from it until it receives an error (except EINTR).
-               In normal cases it will get EAGAIN or EWOULDBLOCK
-               when there is no more data, breaking the loop. */
-            nread = wakeup_read(multi->wakeup_pair[0], buf, sizeof(buf));
-            if(nread <= 0) {
-              if(nread < 0 && SOCKEINTR == SOCKERRNO)
-                continue;
-              break;
-            }
-          }
+          multi_wakeup_drain(multi);
           /* do not count the wakeup socket into the returned value */
           retcode--;
         }
@@ -2047,7 +2281,23 @@ static CURLMcode state_do(struct Curl_easy *data,
     }
   }
 
-  if(data->set.connect_only && !data->set.connect_only_ws) {
+  if(data->state.prewarm) {
+    /* connected, leave the connection idle in the pool. No response
+       tells the HTTP version, note the one connected with so that
+       transfers do not wait for a server upgrade on it. */
+#ifndef CURL_DISABLE_HTTP
+    struct connectdata *conn = data->conn;
+    if((conn->handler->protocol & PROTO_FAMILY_HTTP) &&
+       !conn->httpversion_seen) {
+      conn->httpversion_seen = Curl_conn_http_version(data, conn);
+      if(!conn->httpversion_seen)
+        conn->httpversion_seen = data->state.http_neg.only_10 ? 10 : 11;
+    }
+#endif
+    multistate(data, MSTATE_DONE);
+    rc = CURLM_CALL_MULTI_PERFORM;
+  }
+  else if(data->set.connect_only && !data->set.connect_only_ws) {
     /* keep connection open for application to use the socket */
     connkeep(data->conn, "CONNECT_ONLY");
     multistate(data, MSTATE_DONE);
@@ -2231,7 +2481,16 @@ static CURLMcode state_resolving(struct Curl_multi *multi,
   if(rc)
     return rc;
 
-  if(dns) {
+  if(dns && data->state.dns_refresh) {
+    /* the DNS cache has the new entry, no connection is wanted */
+    if(data->state.async.dns == dns)
+      data->state.async.dns = NULL;
+    Curl_resolv_unlink(data, &dns);
+    connclose(data->conn, "DNS cache refreshed");
+    multistate(data, MSTATE_DONE);
+    rc = CURLM_CALL_MULTI_PERFORM;
+  }
+  else if(dns) {
     bool connected;
     /* Perform the next step in the connection phase, and then move on to the
        WAITCONNECT state */
@@ -2290,6 +2549,12 @@ static CURLMcode state_connect(struct Curl_multi *multi,
     if(async)
       /* We are now waiting for an asynchronous name lookup */
       multistate(data, MSTATE_RESOLVING);
+    else if(data->state.dns_refresh) {
+      /* resolved right away, stop connecting */
+      connclose(data->conn, "DNS cache refreshed");
+      multistate(data, MSTATE_DONE);
+      rc = CURLM_CALL_MULTI_PERFORM;
+    }
     else {
       /* after the connect has been sent off, go WAITCONNECT unless the
          protocol connect is already done and we can go directly to WAITDO or
@@ -2682,8 +2947,13 @@ statemachine_end:
         struct Curl_easy *mdata;
 
         CURL_TRC_M(data, "sub xfer done for master %u", data->master_mid);
-        mdata = Curl_multi_get_easy(multi, data->master_mid);
-        if(mdata) {
+        /* the admin handle is master of the connection warm-ups */
+        mdata = (data->master_mid == multi->admin->mid) ? multi->admin :
+          Curl_multi_get_easy(multi, data->master_mid);
+        if(data->state.dns_refresh)
+          /* the DNS cache is updated, close it after this run */
+          multi->dns_refreshed = TRUE;
+        else if(mdata) {
           if(mdata->sub_xfer_done)
             mdata->sub_xfer_done(mdata, data, result);
           else
@@ -2712,7 +2982,8 @@ statemachine_end:
       Curl_uint_bset_remove(&multi->dirty, data->mid);
       Curl_uint_bset_remove(&multi->pending, data->mid);
       Curl_uint_bset_add(&multi->msgsent, data->mid);
-      --multi->xfers_alive;
+      if(!MULTI_XFER_OWN(data))
+        --multi->xfers_alive;
       return CURLM_OK;
     }
   } while((rc == CURLM_CALL_MULTI_PERFORM) || multi_ischanged(multi, FALSE));
@@ -2721,14 +2992,37 @@ statemachine_end:
   return rc;
 }
 
+/* Close the internal transfers done with refreshing DNS cache entries. */
+static void multi_reap_dns_refreshes(struct Curl_multi *multi)
+{
+  unsigned int mid;
+
+  if(!multi->dns_refreshed)
+    return;
+  multi->dns_refreshed = FALSE;
+  if(Curl_uint_bset_first(&multi->msgsent, &mid)) {
+    do {
+      struct Curl_easy *data = Curl_multi_get_easy(multi, mid);
+      if(data && data->state.dns_refresh) {
+        Curl_dnscache_refresh_done(data);
+        (void)curl_multi_remove_handle(multi, data);
+        Curl_close(&data);
+      }
+    }
+    while(Curl_uint_bset_next(&multi->msgsent, mid, &mid));
+  }
+}
 
 CURLMcode curl_multi_perform(CURLM *m, int *running_handles)
 {
   CURLMcode returncode = CURLM_OK;
-  struct Curl_tree *t = NULL;
+  struct Curl_easy *expired;
   struct curltime now = curlx_now();
   struct Curl_multi *multi = m;
   unsigned int mid;
+#ifdef USE_EPOLL
+  curl_socket_t epfd;
+#endif
   SIGPIPE_VARIABLE(pipe_st);
 
   if(!GOOD_MULTI_HANDLE(multi))
@@ -2737,6 +3031,11 @@ CURLMcode curl_multi_perform(CURLM *m, int *running_handles)
   if(multi->in_callback)
     return CURLM_RECURSIVE_API_CALL;
 
+#ifdef USE_EPOLL
+  if(Curl_multi_ev_epoll_get(multi, &epfd))
+    return multi_epoll_perform(multi, running_handles);
+#endif
+
   sigpipe_init(&pipe_st);
   if(Curl_uint_bset_first(&multi->process, &mid)) {
     CURL_TRC_M(multi->admin, "multi_perform(running=%u)",
@@ -2763,38 +3062,40 @@ CURLMcode curl_multi_perform(CURLM *m, int *running_handles)
 
   sigpipe_apply(multi->admin, &pipe_st);
   Curl_cshutdn_perform(&multi->cshutdn, multi->admin, CURL_SOCKET_TIMEOUT);
+  Curl_cprewarm_perform(multi);
+  multi_reap_dns_refreshes(multi);
   sigpipe_restore(&pipe_st);
 
   if(multi_ischanged(m, TRUE))
     process_pending_handles(m);
 
   /*
-   * Simply remove all expired timers from the splay since handles are dealt
-   * with unconditionally by this function and curl_multi_timeout() requires
-   * that already passed/handled expire times are removed from the splay.
+   * Simply remove all expired timers since handles are dealt with
+   * unconditionally by this function and curl_multi_timeout() requires that
+   * already passed/handled expire times are removed.
    *
    * It is important that the 'now' value is set at the entry of this function
    * and not for the current time as it may have ticked a little while since
    * then and then we risk this loop to remove timers that actually have not
    * been handled!
    */
-  do {
-    multi->timetree = Curl_splaygetbest(now, multi->timetree, &t);
-    if(t) {
-      /* the removed may have another timeout in queue */
-      struct Curl_easy *data = Curl_splayget(t);
-      if(data->mstate == MSTATE_PENDING) {
-        bool stream_unused;
-        CURLcode result_unused;
-        if(multi_handle_timeout(data, &now, &stream_unused, &result_unused)) {
-          infof(data, "PENDING handle timeout");
-          move_pending_to_connect(multi, data);
-          continue;
-        }
+  for(;;) {
+    expired = multi_timer_getbest(multi, now);
+    if(!expired)
+      break;
+    /* the removed may have another timeout in queue */
+    if(expired->mstate == MSTATE_PENDING) {
+      bool stream_unused;
+      CURLcode result_unused;
+      if(multi_handle_timeout(expired, &now, &stream_unused,
+                              &result_unused)) {
+        infof(expired, "PENDING handle timeout");
+        move_pending_to_connect(multi, expired);
+        continue;
       }
-      (void)add_next_timeout(now, multi, Curl_splayget(t));
     }
-  } while(t);
+    (void)add_next_timeout(now, multi, expired);
+  }
 
   if(running_handles) {
     unsigned int running = Curl_multi_xfers_running(multi);
@@ -2816,6 +3117,9 @@ CURLMcode curl_multi_cleanup(CURLM *m)
     if(multi->in_callback)
       return CURLM_RECURSIVE_API_CALL;
 
+    /* Stop warming up connections, that removes their transfers */
+    Curl_cprewarm_destroy(multi);
+
     /* First remove all remaining easy handles,
      * close internal ones. admin handle is special */
     if(Curl_uint_tbl_first(&multi->xfers, &mid, &entry)) {
@@ -2838,6 +3142,9 @@ CURLMcode curl_multi_cleanup(CURLM *m)
         if(!data->state.done && data->conn)
           /* if DONE was never called for this handle */
           (void)multi_done(data, CURLE_OK, TRUE);
+        if(data->state.dns_refresh)
+          /* a shared DNS cache outlives the refresh */
+          Curl_dnscache_refresh_done(data);
 
         data->multi = NULL; /* clear the association */
         Curl_uint_tbl_remove(&multi->xfers, mid);
@@ -2855,6 +3162,14 @@ CURLMcode curl_multi_cleanup(CURLM *m)
 
     Curl_cpool_destroy(&multi->cpool);
     Curl_cshutdn_destroy(&multi->cshutdn, multi->admin);
+    /* all connections are gone, no pool is attached to the cache now */
+    if(multi->bufcache) {
+      CURL_TRC_M(multi->admin, "multi_cleanup, chunk cache allocated %zu, "
+                 "reused %zu", multi->bufcache->n_alloc,
+                 multi->bufcache->n_reuse);
+      Curl_bufcache_free(multi->bufcache);
+      Curl_safefree(multi->bufcache);
+    }
     if(multi->admin) {
       CURL_TRC_M(multi->admin, "multi_cleanup, closing admin handle, done");
       multi->admin->multi = NULL;
@@ -2884,6 +3199,11 @@ CURLMcode curl_multi_cleanup(CURLM *m)
 #endif
 
     multi_xfer_bufs_free(multi);
+    Curl_decoder_cache_destroy(multi->decoders);
+    multi->decoders = NULL;
+#ifdef CURLRES_THREADED
+    Curl_async_thrdd_pool_destroy(multi);
+#endif
 #ifdef DEBUGBUILD
     if(Curl_uint_tbl_count(&multi->xfers)) {
       multi_xfer_tbl_dump(multi);
@@ -2895,6 +3215,9 @@ CURLMcode curl_multi_cleanup(CURLM *m)
     Curl_uint_bset_destroy(&multi->pending);
     Curl_uint_bset_destroy(&multi->msgsent);
     Curl_uint_tbl_destroy(&multi->xfers);
+#ifdef USE_TIMER_WHEEL
+    free(multi->timewheel);
+#endif
     free(multi);
 
     return CURLM_OK;
@@ -2956,12 +3279,12 @@ void Curl_multi_will_close(struct Curl_easy *data, curl_socket_t s)
  * add_next_timeout()
  *
  * Each Curl_easy has a list of timeouts. The add_next_timeout() is called
- * when it has just been removed from the splay tree because the timeout has
+ * when it has just been removed from the timers because the timeout has
  * expired. This function is then to advance in the list to pick the next
  * timeout to use (skip the already expired ones) and add this node back to
- * the splay tree again.
+ * the timers again.
  *
- * The splay tree only has each sessionhandle as a single node and the nearest
+ * The timers only have each sessionhandle as a single node and the nearest
  * timeout is used to sort it on.
  */
 static CURLMcode add_next_timeout(struct curltime now,
@@ -2990,7 +3313,7 @@ static CURLMcode add_next_timeout(struct curltime now,
   e = Curl_llist_head(list);
   if(!e) {
     /* clear the expire times within the handles that we remove from the
-       splay tree */
+       timers */
     tv->tv_sec = 0;
     tv->tv_usec = 0;
   }
@@ -2999,10 +3322,9 @@ static CURLMcode add_next_timeout(struct curltime now,
     /* copy the first entry to 'tv' */
     memcpy(tv, &node->time, sizeof(*tv));
 
-    /* Insert this node again into the splay. Keep the timer in the list in
+    /* Insert this node again into the timers. Keep the timer in the list in
        case we need to recompute future timers. */
-    multi->timetree = Curl_splayinsert(*tv, multi->timetree,
-                                       &d->state.timenode);
+    multi_timer_add(multi, d);
   }
   return CURLM_OK;
 }
@@ -3019,23 +3341,18 @@ static void multi_mark_expired_as_dirty(struct multi_run_ctx *mrc)
 {
   struct Curl_multi *multi = mrc->multi;
   struct Curl_easy *data = NULL;
-  struct Curl_tree *t = NULL;
 
   /*
    * The loop following here will go on as long as there are expire-times left
-   * to process (compared to mrc->now) in the splay and 'data' will be
-   * re-assigned for every expired handle we deal with.
+   * to process (compared to mrc->now) and 'data' will be re-assigned for
+   * every expired handle we deal with.
    */
   while(1) {
     /* Check if there is one (more) expired timer to deal with! This function
        extracts a matching node if there is one */
-    multi->timetree = Curl_splaygetbest(mrc->now, multi->timetree, &t);
-    if(!t)
-      return;
-
-    data = Curl_splayget(t); /* assign this for next loop */
+    data = multi_timer_getbest(multi, mrc->now);
     if(!data)
-      continue;
+      return;
 
     (void)add_next_timeout(mrc->now, multi, data);
     Curl_multi_mark_dirty(data);
@@ -3089,16 +3406,19 @@ out:
   return result;
 }
 
+/* Run the transfers affected by the socket `actions`. With `checkall`,
+ * `actions` is ignored and all transfers are run. */
 static CURLMcode multi_socket(struct Curl_multi *multi,
                               bool checkall,
-                              curl_socket_t s,
-                              int ev_bitmask,
+                              const struct curl_sockaction *actions,
+                              unsigned int count,
                               int *running_handles)
 {
   CURLMcode result = CURLM_OK;
   struct multi_run_ctx mrc;
+  curl_socket_t cpool_s = CURL_SOCKET_TIMEOUT;
+  unsigned int i;
 
-  (void)ev_bitmask;
   memset(&mrc, 0, sizeof(mrc));
   mrc.multi = multi;
   mrc.now = curlx_now();
@@ -3116,20 +3436,33 @@ static CURLMcode multi_socket(struct Curl_multi *multi,
     goto out;
   }
 
-  if(s != CURL_SOCKET_TIMEOUT) {
-    /* Mark all transfers of that socket as dirty */
-    Curl_multi_ev_dirty_xfers(multi, s, &mrc.run_cpool);
-  }
-  else {
-    /* Asked to run due to time-out. Clear the 'last_expire_ts' variable to
-       force Curl_update_timer() to trigger a callback to the app again even
-       if the same timeout is still the one to run after this call. That
-       handles the case when the application asks libcurl to run the timeout
-       prematurely. */
-    memset(&multi->last_expire_ts, 0, sizeof(multi->last_expire_ts));
-    mrc.run_cpool = TRUE;
+  for(i = 0; i < count; i++) {
+    curl_socket_t s = actions[i].fd;
+
+    if(s != CURL_SOCKET_TIMEOUT) {
+      bool run_cpool = FALSE;
+      /* Mark all transfers of that socket as dirty */
+      Curl_multi_ev_dirty_xfers(multi, s, &run_cpool);
+      if(run_cpool) {
+        /* a single shutdown socket is handled directly, more than one
+         * has the shutdowns all checked */
+        cpool_s = mrc.run_cpool ? CURL_SOCKET_TIMEOUT : s;
+        mrc.run_cpool = TRUE;
+      }
+    }
+    else {
+      /* Asked to run due to time-out. Clear the 'last_expire_ts' variable
+         to force Curl_update_timer() to trigger a callback to the app again
+         even if the same timeout is still the one to run after this call.
+         That handles the case when the application asks libcurl to run the
+         timeout prematurely. */
+      memset(&multi->last_expire_ts, 0, sizeof(multi->last_expire_ts));
+      mrc.run_cpool = TRUE;
+      cpool_s = CURL_SOCKET_TIMEOUT;
+    }
   }
 
+  /* expired timers are checked once for the whole batch */
   multi_mark_expired_as_dirty(&mrc);
   result = multi_run_dirty(&mrc);
   if(result)
@@ -3149,8 +3482,10 @@ static CURLMcode multi_socket(struct Curl_multi *multi,
 out:
   if(mrc.run_cpool) {
     sigpipe_apply(multi->admin, &mrc.pipe_st);
-    Curl_cshutdn_perform(&multi->cshutdn, multi->admin, s);
+    Curl_cshutdn_perform(&multi->cshutdn, multi->admin, cpool_s);
   }
+  Curl_cprewarm_perform(multi);
+  multi_reap_dns_refreshes(multi);
   sigpipe_restore(&mrc.pipe_st);
 
   if(multi_ischanged(multi, TRUE))
@@ -3166,6 +3501,29 @@ out:
   return result;
 }
 
+#ifdef USE_EPOLL
+/* curl_multi_perform() with the epoll backend runs only the transfers on
+ * ready sockets and those with expired timers, like a socket action on
+ * CURL_SOCKET_TIMEOUT does. The ready sockets were collected by the last
+ * curl_multi_wait() or, when the application did not wait, are now. */
+static CURLMcode multi_epoll_perform(struct Curl_multi *multi,
+                                     int *running_handles)
+{
+  struct curl_sockaction action;
+
+  if(!multi->ev.epoll_collected) {
+    unsigned int nready;
+    CURLMcode result = multi_epoll_collect(multi, 0, FALSE, &nready);
+    if(result)
+      return result;
+  }
+  multi->ev.epoll_collected = FALSE;
+  action.fd = CURL_SOCKET_TIMEOUT;
+  action.ev_bitmask = 0;
+  return multi_socket(multi, FALSE, &action, 1, running_handles);
+}
+#endif
+
 #undef curl_multi_setopt
 CURLMcode curl_multi_setopt(CURLM *m,
                             CURLMoption option, ...)
@@ -3185,7 +3543,8 @@ CURLMcode curl_multi_setopt(CURLM *m,
 
   switch(option) {
   case CURLMOPT_SOCKETFUNCTION:
-    multi->socket_cb = va_arg(param, curl_socket_callback);
+    res = Curl_multi_ev_set_socket_cb(multi,
+                                      va_arg(param, curl_socket_callback));
     break;
   case CURLMOPT_SOCKETDATA:
     multi->socket_userp = va_arg(param, void *);
@@ -3235,6 +3594,40 @@ CURLMcode curl_multi_setopt(CURLM *m,
       multi->max_concurrent_streams = (unsigned int)streams;
     }
     break;
+  case CURLMOPT_MAX_RESOLVE_THREADS:
+    {
+      long threads = va_arg(param, long);
+      if((threads < 1) || (threads > INT_MAX))
+        res = CURLM_BAD_FUNCTION_ARGUMENT;
+      else
+        multi->max_resolve_threads = (unsigned int)threads;
+    }
+    break;
+  case CURLMOPT_MAX_RESOLVE_QUEUE:
+    {
+      long queue = va_arg(param, long);
+      if((queue < 0) || (queue > INT_MAX))
+        res = CURLM_BAD_FUNCTION_ARGUMENT;
+      else
+        multi->max_resolve_queue = (unsigned int)queue;
+    }
+    break;
+  case CURLMOPT_MAX_MEMORY:
+    {
+      curl_off_t max = va_arg(param, curl_off_t);
+      if(max < 0)
+        res = CURLM_BAD_FUNCTION_ARGUMENT;
+#if SIZEOF_CURL_OFF_T > SIZEOF_SIZE_T
+      else if(max > (curl_off_t)SIZE_MAX)
+        multi->max_memory = SIZE_MAX;
+#endif
+      else
+        multi->max_memory = (size_t)max;
+    }
+    break;
+  case CURLMOPT_POLL_BACKEND:
+    res = Curl_multi_ev_set_backend(multi, va_arg(param, long));
+    break;
   case CURLMOPT_NETWORK_CHANGED: {
       long val = va_arg(param, long);
       if(val & CURLM_NWCOPT_CLEAR_DNS) {
@@ -3259,18 +3652,63 @@ CURLMcode curl_multi_setopt(CURLM *m,
 CURLMcode curl_multi_socket(CURLM *m, curl_socket_t s, int *running_handles)
 {
   struct Curl_multi *multi = m;
+  struct curl_sockaction action;
   if(multi->in_callback)
     return CURLM_RECURSIVE_API_CALL;
-  return multi_socket(multi, FALSE, s, 0, running_handles);
+  action.fd = s;
+  action.ev_bitmask = 0;
+  return multi_socket(multi, FALSE, &action, 1, running_handles);
 }
 
 CURLMcode curl_multi_socket_action(CURLM *m, curl_socket_t s,
                                    int ev_bitmask, int *running_handles)
 {
   struct Curl_multi *multi = m;
+  struct curl_sockaction action;
   if(multi->in_callback)
     return CURLM_RECURSIVE_API_CALL;
-  return multi_socket(multi, FALSE, s, ev_bitmask, running_handles);
+  action.fd = s;
+  action.ev_bitmask = ev_bitmask;
+  return multi_socket(multi, FALSE, &action, 1, running_handles);
+}
+
+CURLMcode curl_multi_socket_actions(CURLM *m,
+                                    const struct curl_sockaction *actions,
+                                    unsigned int count,
+                                    int *running_handles)
+{
+  struct Curl_multi *multi = m;
+  if(!GOOD_MULTI_HANDLE(multi))
+    return CURLM_BAD_HANDLE;
+  if(!actions && count)
+    return CURLM_BAD_FUNCTION_ARGUMENT;
+  if(multi->in_callback)
+    return CURLM_RECURSIVE_API_CALL;
+  return multi_socket(multi, FALSE, actions, count, running_handles);
+}
+
+CURLMcode curl_multi_prewarm(CURLM *m, CURL *d, unsigned int min_idle)
+{
+  struct Curl_multi *multi = m;
+  struct Curl_easy *data = d;
+  CURLMcode mresult;
+
+  if(!GOOD_MULTI_HANDLE(multi))
+    return CURLM_BAD_HANDLE;
+  if(!GOOD_EASY_HANDLE(data))
+    return CURLM_BAD_EASY_HANDLE;
+  if(multi->in_callback)
+    return CURLM_RECURSIVE_API_CALL;
+  /* the connections are kept in the multi's own pool, a transfer using a
+     shared pool would never find them there */
+  if(CURL_SHARE_KEEP_CONNECT(data->share))
+    return CURLM_BAD_EASY_HANDLE;
+
+  mresult = Curl_cprewarm_set(multi, data, min_idle);
+  if(!mresult)
+    /* let event based applications know there is something to do */
+    mresult = Curl_update_timer(multi);
+  return mresult;
 }
 
 CURLMcode curl_multi_socket_all(CURLM *m, int *running_handles)
@@ -3278,7 +3716,7 @@ CURLMcode curl_multi_socket_all(CURLM *m, int *running_handles)
   struct Curl_multi *multi = m;
   if(multi->in_callback)
     return CURLM_RECURSIVE_API_CALL;
-  return multi_socket(multi, TRUE, CURL_SOCKET_BAD, 0, running_handles);
+  return multi_socket(multi, TRUE, NULL, 0, running_handles);
 }
 
 
@@ -3320,39 +3758,29 @@ static CURLMcode multi_timeout(struct Curl_multi *multi,
     *timeout_ms = 0;
     return CURLM_OK;
   }
-  else if(multi->timetree) {
-    /* we have a tree of expire times */
+  else {
     struct curltime now = curlx_now();
+    struct Curl_easy *data = NULL;
 
-    /* splay the lowest to the bottom */
-    multi->timetree = Curl_splay(tv_zero, multi->timetree);
-    /* this will not return NULL from a non-empty tree, but some compilers
-     * are not convinced of that. Analyzers are hard. */
-    *expire_time = multi->timetree ? multi->timetree->key : tv_zero;
-
-    /* 'multi->timetree' will be non-NULL here but the compilers sometimes
-       yell at us if we assume so */
-    if(multi->timetree &&
-       curlx_timediff_us(multi->timetree->key, now) > 0) {
+    if(!multi_timer_next(multi, now, expire_time, &data)) {
+      /* no timer set */
+      *expire_time = tv_zero;
+      *timeout_ms = -1;
+    }
+    else if(curlx_timediff_us(*expire_time, now) > 0) {
       /* some time left before expiration */
-      timediff_t diff = curlx_timediff_ceil(multi->timetree->key, now);
+      timediff_t diff = curlx_timediff_ceil(*expire_time, now);
       /* this should be safe even on 32-bit archs, as we do not use that
          overly long timeouts */
       *timeout_ms = (long)diff;
     }
     else {
-      if(multi->timetree) {
-        struct Curl_easy *data = Curl_splayget(multi->timetree);
+      if(data)
         CURL_TRC_M(data, "multi_timeout() says this has expired");
-      }
       /* 0 means immediately */
       *timeout_ms = 0;
     }
   }
-  else {
-    *expire_time = tv_zero;
-    *timeout_ms = -1;
-  }
 
   return CURLM_OK;
 }
@@ -3542,32 +3970,29 @@ void Curl_expire_ex(struct Curl_easy *data,
   multi_addtimeout(data, &set, id);
 
   if(curr_expire->tv_sec || curr_expire->tv_usec) {
-    /* This means that the struct is added as a node in the splay tree.
+    /* This means that the struct is added as a node in the timers.
        Compare if the new time is earlier, and only remove-old/add-new if it
        is. */
     timediff_t diff = curlx_timediff(set, *curr_expire);
     int rc;
 
     if(diff > 0) {
-      /* The current splay tree entry is sooner than this new expiry time.
-         We do not need to update our splay tree entry. */
+      /* The current timer entry is sooner than this new expiry time.
+         We do not need to update our timer entry. */
       return;
     }
 
     /* Since this is an updated time, we must remove the previous entry from
-       the splay tree first and then re-add the new value */
-    rc = Curl_splayremove(multi->timetree, &data->state.timenode,
-                          &multi->timetree);
+       the timers first and then re-add the new value */
+    rc = multi_timer_remove(multi, data);
     if(rc)
-      infof(data, "Internal error removing splay node = %d", rc);
+      infof(data, "Internal error removing timer node = %d", rc);
   }
 
-  /* Indicate that we are in the splay tree and insert the new timer expiry
+  /* Indicate that we are in the timers and insert the new timer expiry
      value since it is our local minimum. */
   *curr_expire = set;
-  Curl_splayset(&data->state.timenode, data);
-  multi->timetree = Curl_splayinsert(*curr_expire, multi->timetree,
-                                     &data->state.timenode);
+  multi_timer_add(multi, data);
   if(data->id >= 0)
     CURL_TRC_M(data, "set expire[%d] in %" FMT_TIMEDIFF_T "ns",
                id, curlx_timediff_us(set, *nowp));
@@ -3619,14 +4044,13 @@ bool Curl_expire_clear(struct Curl_easy *data)
 
   if(nowp->tv_sec || nowp->tv_usec) {
     /* Since this is an cleared time, we must remove the previous entry from
-       the splay tree */
+       the timers */
     struct Curl_llist *list = &data->state.timeoutlist;
     int rc;
 
-    rc = Curl_splayremove(multi->timetree, &data->state.timenode,
-                          &multi->timetree);
+    rc = multi_timer_remove(multi, data);
     if(rc)
-      infof(data, "Internal error clearing splay node = %d", rc);
+      infof(data, "Internal error clearing timer node = %d", rc);
 
     /* clear the timeout list too */
     Curl_llist_destroy(list, NULL);
@@ -3711,6 +4135,69 @@ unsigned int Curl_multi_max_concurrent_streams(struct Curl_multi *multi)
   return multi->max_concurrent_streams;
 }
 
+size_t Curl_multi_rwin_share(struct Curl_multi *multi)
+{
+  size_t budget;
+
+  DEBUGASSERT(multi);
+  budget = multi->rwin_budget;
+  if(multi->max_memory) {
+    /* over the limit, streams get no more than the minimum */
+    if(Curl_multi_mem_used(multi) >= multi->max_memory)
+      return 0;
+    budget = CURLMIN(budget, multi->max_memory);
+  }
+  return budget / (multi->xfers_alive ? multi->xfers_alive : 1);
+}
+
+size_t Curl_multi_mem_used(struct Curl_multi *multi)
+{
+  size_t used;
+
+  DEBUGASSERT(multi);
+  used = multi->xfer_buf_len + multi->xfer_ulbuf_len +
+         multi->xfer_sockbuf_len + multi->mem_out;
+  if(multi->bufcache)
+    used += multi->bufcache->mem_used;
+  return used;
+}
+
+void Curl_multi_mem_out(struct Curl_easy *data, size_t *pcharged,
+                        size_t nbytes)
+{
+  struct Curl_multi *multi = data->multi;
+
+  if(*pcharged == nbytes)
+    return;
+  DEBUGASSERT(data->state.mem_out >= *pcharged);
+  data->state.mem_out = data->state.mem_out - *pcharged + nbytes;
+  if(multi) {
+    DEBUGASSERT(multi->mem_out >= *pcharged);
+    multi->mem_out = multi->mem_out - *pcharged + nbytes;
+  }
+  *pcharged = nbytes;
+}
+
+CURLMcode curl_multi_get_offt(CURLM *m, CURLMinfo_offt info,
+                              curl_off_t *pvalue)
+{
+  struct Curl_multi *multi = m;
+
+  if(!GOOD_MULTI_HANDLE(multi))
+    return CURLM_BAD_HANDLE;
+  if(!pvalue)
+    return CURLM_BAD_FUNCTION_ARGUMENT;
+
+  switch(info) {
+  case CURLMINFO_MEMORY_USED:
+    *pvalue = (curl_off_t)Curl_multi_mem_used(multi);
+    return CURLM_OK;
+  default:
+    *pvalue = -1;
+    return CURLM_UNKNOWN_OPTION;
+  }
+}
+
 CURL **curl_multi_get_handles(CURLM *m)
 {
   struct Curl_multi *multi = m;
@@ -3911,6 +4398,30 @@ struct Curl_easy *Curl_multi_get_easy(struct Curl_multi *multi,
   return NULL;
 }
 
+static struct bufc_cache *multi_bufcache(struct Curl_multi *multi)
+{
+  if(!multi->bufcache) {
+    multi->bufcache = malloc(sizeof(*multi->bufcache));
+    if(multi->bufcache)
+      Curl_bufcache_init(multi->bufcache, CURL_BUFC_CACHE_LOW,
+                         CURL_BUFC_CACHE_HIGH);
+  }
+  return multi->bufcache;
+}
+
+struct bufc_cache *Curl_multi_bufcache(struct Curl_easy *data)
+{
+  /* Connections in a shared pool may be used by transfers from other
+   * multi handles in other threads and must not use our cache. */
+  if(!data || CURL_SHARE_KEEP_CONNECT(data->share))
+    return NULL;
+  if(data->multi_easy)
+    return multi_bufcache(data->multi_easy);
+  if(data->multi)
+    return multi_bufcache(data->multi);
+  return NULL;
+}
+
 unsigned int Curl_multi_xfers_running(struct Curl_multi *multi)
 {
   return multi->xfers_alive;
@@ -40,6 +40,11 @@
 #include "curlx/warnless.h"
 #include "multihandle.h"
 #include "socks.h"
+
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 /* The last 3 #include files should be in this order */
 #include "curl_printf.h"
 #include "curl_memory.h"
@@ -68,6 +73,89 @@ struct mev_sh_entry {
                            callback at least once */
 };
 
+#ifdef USE_EPOLL
+/* Tell the epoll instance about the `action` on socket `s`. A socket
+ * that was closed without us being told has been dropped from the
+ * epoll set already and a new socket with the same descriptor number
+ * needs to be added instead of modified. */
+static int mev_epoll_update(struct Curl_multi *multi,
+                            struct mev_sh_entry *entry,
+                            curl_socket_t s, int action)
+{
+  struct epoll_event ev;
+  int op = entry->announced ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = ((action & CURL_POLL_IN) ? EPOLLIN : 0) |
+              ((action & CURL_POLL_OUT) ? EPOLLOUT : 0);
+  ev.data.fd = s;
+  if(epoll_ctl(multi->ev.epfd, op, s, &ev)) {
+    if(op == EPOLL_CTL_MOD && errno == ENOENT)
+      op = EPOLL_CTL_ADD;
+    else if(op == EPOLL_CTL_ADD && errno == EEXIST)
+      op = EPOLL_CTL_MOD;
+    else
+      return -1;
+    if(epoll_ctl(multi->ev.epfd, op, s, &ev))
+      return -1;
+  }
+  if(!entry->announced)
+    multi->ev.epoll_nfds++;
+  return 0;
+}
+
+static void mev_epoll_remove(struct Curl_multi *multi, curl_socket_t s)
+{
+  struct epoll_event ev;
+
+  /* the socket may already be closed, ignore errors */
+  memset(&ev, 0, sizeof(ev));
+  (void)epoll_ctl(multi->ev.epfd, EPOLL_CTL_DEL, s, &ev);
+  DEBUGASSERT(multi->ev.epoll_nfds);
+  if(multi->ev.epoll_nfds)
+    multi->ev.epoll_nfds--;
+}
+
+static bool mev_epoll_active(struct Curl_multi *multi)
+{
+  return !multi->socket_cb && (multi->ev.epfd != -1);
+}
+
+/* Create the epoll instance. The wakeup socket is registered for the
+ * lifetime of the instance, the transfers' sockets come and go. */
+static CURLMcode mev_epoll_open(struct Curl_multi *multi)
+{
+  multi->ev.epfd = epoll_create1(EPOLL_CLOEXEC);
+  if(multi->ev.epfd == -1)
+    return CURLM_OUT_OF_MEMORY;
+  multi->ev.epoll_nfds = 0;
+#if defined(ENABLE_WAKEUP) && !defined(USE_WINSOCK)
+  if(multi->wakeup_pair[0] != CURL_SOCKET_BAD) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = multi->wakeup_pair[0];
+    if(epoll_ctl(multi->ev.epfd, EPOLL_CTL_ADD, multi->wakeup_pair[0], &ev)) {
+      close(multi->ev.epfd);
+      multi->ev.epfd = -1;
+      return CURLM_OUT_OF_MEMORY;
+    }
+  }
+#endif
+  return CURLM_OK;
+}
+
+static void mev_epoll_close(struct Curl_multi *multi)
+{
+  if(multi->ev.epfd != -1) {
+    close(multi->ev.epfd);
+    multi->ev.epfd = -1;
+  }
+  multi->ev.epoll_nfds = 0;
+  multi->ev.epoll_collected = FALSE;
+}
+#endif /* USE_EPOLL */
+
 static size_t mev_sh_entry_hash(void *key, size_t key_length, size_t slots_num)
 {
   curl_socket_t fd = *((curl_socket_t *) key);
@@ -216,6 +304,13 @@ static CURLMcode mev_forget_socket(struct Curl_multi *multi,
     mev_in_callback(multi, FALSE);
     entry->announced = FALSE;
   }
+#ifdef USE_EPOLL
+  else if(entry->announced && mev_epoll_active(multi)) {
+    CURL_TRC_M(data, "ev %s, epoll remove fd=%" FMT_SOCKET_T, cause, s);
+    mev_epoll_remove(multi, s);
+    entry->announced = FALSE;
+  }
+#endif
 
   mev_sh_entry_kill(multi, s);
   if(rc == -1) {
@@ -234,9 +329,9 @@ static CURLMcode mev_sh_entry_update(struct Curl_multi *multi,
 {
   int rc, comboaction;
 
-  /* we should only be called when the callback exists */
-  DEBUGASSERT(multi->socket_cb);
-  if(!multi->socket_cb)
+  /* we should only be called when someone listens to socket events */
+  DEBUGASSERT(Curl_multi_ev_is_active(multi));
+  if(!Curl_multi_ev_is_active(multi))
     return CURLM_OK;
 
   /* Transfer `data` goes from `last_action` to `cur_action` on socket `s`
@@ -281,6 +376,18 @@ static CURLMcode mev_sh_entry_update(struct Curl_multi *multi,
   CURL_TRC_M(data, "ev update call(fd=%" FMT_SOCKET_T ", ev=%s%s)",
              s, (comboaction & CURL_POLL_IN) ? "IN" : "",
              (comboaction & CURL_POLL_OUT) ? "OUT" : "");
+#ifdef USE_EPOLL
+  if(!multi->socket_cb) {
+    if(mev_epoll_update(multi, entry, s, comboaction)) {
+      failf(data, "epoll update of fd=%" FMT_SOCKET_T " failed, errno %d",
+            s, SOCKERRNO);
+      return CURLM_OUT_OF_MEMORY;
+    }
+    entry->announced = TRUE;
+    entry->action = (unsigned int)comboaction;
+    return CURLM_OK;
+  }
+#endif
   mev_in_callback(multi, TRUE);
   rc = multi->socket_cb(data, s, comboaction, multi->socket_userp,
                         entry->user_data);
@@ -501,7 +608,7 @@ static CURLMcode mev_assess(struct Curl_multi *multi,
                             struct Curl_easy *data,
                             struct connectdata *conn)
 {
-  if(multi && multi->socket_cb) {
+  if(multi && Curl_multi_ev_is_active(multi)) {
     struct easy_pollset ps, *last_ps;
 
     mev_init_cur_pollset(&ps, data, conn);
@@ -543,7 +650,8 @@ CURLMcode Curl_multi_ev_assess_xfer_bset(struct Curl_multi *multi,
   unsigned int mid;
   CURLMcode result = CURLM_OK;
 
-  if(multi && multi->socket_cb && Curl_uint_bset_first(set, &mid)) {
+  if(multi && Curl_multi_ev_is_active(multi) &&
+     Curl_uint_bset_first(set, &mid)) {
     do {
       struct Curl_easy *data = Curl_multi_get_easy(multi, mid);
       if(data)
@@ -627,15 +735,170 @@ void Curl_multi_ev_conn_done(struct Curl_multi *multi,
   Curl_conn_meta_remove(conn, CURL_META_MEV_POLLSET);
 }
 
+/* Forget all sockets and the pollsets the transfers last reported,
+ * without telling anyone. All transfers are marked dirty, their next
+ * run announces their sockets to whoever listens for them now. */
+static void mev_reset(struct Curl_multi *multi)
+{
+  unsigned int mid;
+  void *entry;
+
+  Curl_hash_clean(&multi->ev.sh_entries);
+  if(Curl_uint_tbl_first(&multi->xfers, &mid, &entry)) {
+    do {
+      struct Curl_easy *data = entry;
+      Curl_meta_remove(data, CURL_META_MEV_POLLSET);
+      if(data != multi->admin)
+        Curl_multi_mark_dirty(data);
+    }
+    while(Curl_uint_tbl_next(&multi->xfers, mid, &mid, &entry));
+  }
+}
+
 #define CURL_MEV_PS_HASH_SLOTS   (991)  /* nice prime */
 
+bool Curl_multi_ev_is_active(struct Curl_multi *multi)
+{
+#ifdef USE_EPOLL
+  if(mev_epoll_active(multi))
+    return TRUE;
+#endif
+  return multi->socket_cb != NULL;
+}
+
+CURLMcode Curl_multi_ev_set_backend(struct Curl_multi *multi, long backend)
+{
+  switch(backend) {
+  case CURLMPOLL_DEFAULT:
+#ifdef USE_EPOLL
+    if(multi->ev.epfd != -1) {
+      mev_epoll_close(multi);
+      /* without a socket callback, the entries only served epoll */
+      if(!multi->socket_cb)
+        mev_reset(multi);
+    }
+#endif
+    return CURLM_OK;
+#ifdef USE_EPOLL
+  case CURLMPOLL_EPOLL:
+    if(multi->ev.epfd == -1) {
+      CURLMcode result = mev_epoll_open(multi);
+      if(result)
+        return result;
+      /* sockets of running transfers were never tracked */
+      if(!multi->socket_cb)
+        mev_reset(multi);
+    }
+    return CURLM_OK;
+#endif
+  default:
+    return CURLM_BAD_FUNCTION_ARGUMENT;
+  }
+}
+
+CURLMcode Curl_multi_ev_set_socket_cb(struct Curl_multi *multi,
+                                      curl_socket_callback cb)
+{
+#ifdef USE_EPOLL
+  if((multi->ev.epfd != -1) && (!multi->socket_cb != !cb)) {
+    /* The sockets move between the epoll instance and the application.
+     * Start over with an empty epoll set and let the transfers announce
+     * their sockets again. */
+    CURLMcode result;
+    mev_epoll_close(multi);
+    multi->socket_cb = cb;
+    result = mev_epoll_open(multi);
+    if(result)
+      return result;
+    mev_reset(multi);
+    /* the application learns about the dirty transfers via its timer */
+    return cb ? Curl_update_timer(multi) : CURLM_OK;
+  }
+#endif
+  multi->socket_cb = cb;
+  return CURLM_OK;
+}
+
+#ifdef USE_EPOLL
+bool Curl_multi_ev_epoll_get(struct Curl_multi *multi, curl_socket_t *pfd)
+{
+  *pfd = CURL_SOCKET_BAD;
+  if(!mev_epoll_active(multi))
+    return FALSE;
+  *pfd = multi->ev.epfd;
+  return TRUE;
+}
+
+CURLMcode Curl_multi_ev_epoll_wait(struct Curl_multi *multi, int timeout_ms,
+                                   unsigned int *pnready, bool *pwoken)
+{
+  unsigned int need, i;
+  int rc;
+
+  *pnready = 0;
+  *pwoken = FALSE;
+  if(!mev_epoll_active(multi))
+    return CURLM_OK;
+
+  /* room for every registered socket and the wakeup one, so that a single
+   * wait reports all of them */
+  need = multi->ev.epoll_nfds + 1;
+  if(need > multi->ev.events_len) {
+    struct epoll_event *events;
+    unsigned int len = multi->ev.events_len ? multi->ev.events_len : 16;
+    while(len < need)
+      len *= 2;
+    events = realloc(multi->ev.events, len * sizeof(*events));
+    if(!events)
+      return CURLM_OUT_OF_MEMORY;
+    multi->ev.events = events;
+    multi->ev.events_len = len;
+  }
+
+  rc = epoll_wait(multi->ev.epfd, multi->ev.events,
+                  (int)multi->ev.events_len, timeout_ms);
+  if(rc < 0) {
+    if(SOCKERRNO != SOCKEINTR)
+      return CURLM_UNRECOVERABLE_POLL;
+    rc = 0;
+  }
+  multi->ev.epoll_collected = TRUE;
+
+  for(i = 0; i < (unsigned int)rc; i++) {
+    curl_socket_t s = multi->ev.events[i].data.fd;
+    bool run_cpool = FALSE;
+#if defined(ENABLE_WAKEUP) && !defined(USE_WINSOCK)
+    if(s == multi->wakeup_pair[0]) {
+      *pwoken = TRUE;
+      continue;
+    }
+#endif
+    Curl_multi_ev_dirty_xfers(multi, s, &run_cpool);
+    ++*pnready;
+  }
+  return CURLM_OK;
+}
+#endif /* USE_EPOLL */
+
 void Curl_multi_ev_init(struct Curl_multi *multi, size_t hashsize)
 {
   Curl_hash_init(&multi->ev.sh_entries, hashsize, mev_sh_entry_hash,
                  mev_sh_entry_compare, mev_sh_entry_dtor);
+#ifdef USE_EPOLL
+  multi->ev.events = NULL;
+  multi->ev.events_len = 0;
+  multi->ev.epfd = -1;
+  multi->ev.epoll_nfds = 0;
+  multi->ev.epoll_collected = FALSE;
+#endif
 }
 
 void Curl_multi_ev_cleanup(struct Curl_multi *multi)
 {
   Curl_hash_destroy(&multi->ev.sh_entries);
+#ifdef USE_EPOLL
+  mev_epoll_close(multi);
+  Curl_safefree(multi->ev.events);
+  multi->ev.events_len = 0;
+#endif
 }
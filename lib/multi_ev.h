@@ -30,18 +30,55 @@ struct Curl_easy;
 struct Curl_multi;
 struct easy_pollset;
 struct uint_bset;
+#ifdef USE_EPOLL
+struct epoll_event;
+#endif
 
 /* meta key for event pollset at easy handle or connection */
 #define CURL_META_MEV_POLLSET   "meta:mev:ps"
 
 struct curl_multi_ev {
   struct Curl_hash sh_entries;
+#ifdef USE_EPOLL
+  struct epoll_event *events; /* results of the last epoll_wait() */
+  unsigned int events_len; /* number of `events` allocated */
+  int epfd;                /* epoll instance for curl_multi_wait/poll or -1 */
+  unsigned int epoll_nfds; /* number of sockets registered at `epfd` */
+  BIT(epoll_collected);    /* ready sockets marked dirty since the last
+                              curl_multi_perform() */
+  BIT(wakeup_pending);     /* curl_multi_wait() consumed a wakeup meant
+                              for curl_multi_poll() */
+#endif
 };
 
 /* Setup/teardown of multi event book-keeping. */
 void Curl_multi_ev_init(struct Curl_multi *multi, size_t hashsize);
 void Curl_multi_ev_cleanup(struct Curl_multi *multi);
 
+/* Select the backend used by curl_multi_wait() and curl_multi_poll(),
+ * one of the CURLMPOLL_* values. */
+CURLMcode Curl_multi_ev_set_backend(struct Curl_multi *multi, long backend);
+
+/* TRUE when socket events are tracked in the socket hash, either for the
+ * application's socket callback or for a persistent poll backend. */
+bool Curl_multi_ev_is_active(struct Curl_multi *multi);
+
+/* Install the application's socket callback. Moves the sockets between
+ * the epoll backend and the callback when one of them takes over. */
+CURLMcode Curl_multi_ev_set_socket_cb(struct Curl_multi *multi,
+                                      curl_socket_callback cb);
+
+#ifdef USE_EPOLL
+/* TRUE when curl_multi_wait() uses the epoll backend. `*pfd` is set to
+ * the epoll descriptor to wait on. */
+bool Curl_multi_ev_epoll_get(struct Curl_multi *multi, curl_socket_t *pfd);
+/* Wait up to `timeout_ms` on the epoll instance and mark the transfers
+ * on ready sockets dirty. `*pnready` is the number of ready transfer
+ * sockets, `*pwoken` is TRUE when the wakeup socket was ready. */
+CURLMcode Curl_multi_ev_epoll_wait(struct Curl_multi *multi, int timeout_ms,
+                                   unsigned int *pnready, bool *pwoken);
+#endif
+
 /* Assign a 'user_data' to be passed to the socket callback when
  * invoked with the given socket. This will fail if this socket
  * is not active, e.g. the application has not been told to monitor it. */
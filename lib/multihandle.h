@@ -25,6 +25,8 @@
  ***************************************************************************/
 
 #include "llist.h"
+#include "bufq.h"
+#include "content_encoding.h"
 #include "hash.h"
 #include "conncache.h"
 #include "cshutdn.h"
@@ -37,6 +39,7 @@
 #include "uint-table.h"
 
 struct connectdata;
+struct cprewarm;
 struct Curl_easy;
 
 struct Curl_message {
@@ -87,6 +90,9 @@ typedef enum {
 /* value for MAXIMUM CONCURRENT STREAMS upper limit */
 #define INITIAL_MAX_CONCURRENT_STREAMS ((1U << 31) - 1)
 
+/* receive windows of all transfers together should not exceed this */
+#define MULTI_RWIN_BUDGET (256 * 1024 * 1024)
+
 /* This is the struct known as CURLM on the outside */
 struct Curl_multi {
   /* First a simple identifier to easier detect if a user mix up
@@ -123,9 +129,15 @@ struct Curl_multi {
   struct PslCache psl;
 #endif
 
+#ifdef USE_TIMER_WHEEL
+  /* timing wheel of time nodes to figure out expire times of all currently
+     set timers */
+  struct Curl_twheel *timewheel;
+#else
   /* timetree points to the splay-tree of time nodes to figure out expire
      times of all currently set timers */
   struct Curl_tree *timetree;
+#endif
 
   /* buffer used for transfer data, lazy initialized */
   char *xfer_buf; /* the actual buffer */
@@ -150,6 +162,14 @@ struct Curl_multi {
 
   struct cshutdn cshutdn; /* connection shutdown handling */
   struct cpool cpool;     /* connection pool (bundles) */
+  struct cprewarm *prewarm; /* connections kept warm, allocated on
+                               first use */
+  struct bufc_cache *bufcache; /* spare chunks for connection filters,
+                                  allocated on first use */
+  struct Curl_decoder_cache *decoders; /* content decoders for reuse */
+#ifdef CURLRES_THREADED
+  struct async_thrdd_pool *resolve_pool; /* resolver threads, lazy init */
+#endif
 
   long max_host_connections; /* if >0, a fixed limit of the maximum number
                                 of connections per host */
@@ -173,6 +193,11 @@ struct Curl_multi {
 #endif
 #endif
   unsigned int max_concurrent_streams;
+  size_t rwin_budget; /* receive window bytes to split between transfers */
+  size_t max_memory; /* if >0, limit of buffer bytes in use */
+  size_t mem_out; /* bytes buffered for client writes of paused transfers */
+  unsigned int max_resolve_threads; /* limit of resolver threads */
+  unsigned int max_resolve_queue; /* if >0, limit of queued name lookups */
   unsigned int maxconnects; /* if >0, a fixed limit of the maximum number of
                                entries we are allowed to grow the connection
                                cache to */
@@ -191,6 +216,7 @@ struct Curl_multi {
   BIT(xfer_buf_borrowed);      /* xfer_buf is currently being borrowed */
   BIT(xfer_ulbuf_borrowed);    /* xfer_ulbuf is currently being borrowed */
   BIT(xfer_sockbuf_borrowed);  /* xfer_sockbuf is currently being borrowed */
+  BIT(dns_refreshed);          /* a DNS cache refresh is done, reap it */
 #ifdef DEBUGBUILD
   BIT(warned);                 /* true after user warned of DEBUGBUILD */
 #endif
@@ -86,6 +86,20 @@ CURLMcode Curl_multi_add_perform(struct Curl_multi *multi,
 /* Return the value of the CURLMOPT_MAX_CONCURRENT_STREAMS option */
 unsigned int Curl_multi_max_concurrent_streams(struct Curl_multi *multi);
 
+/* The receive window a transfer's stream may grow to, so that the windows
+ * of all transfers in the multi stay within its budget. Returns 0 while
+ * CURLMOPT_MAX_MEMORY is exceeded, streams keep a minimal window then. */
+size_t Curl_multi_rwin_share(struct Curl_multi *multi);
+
+/* Bytes in buffers accounted against CURLMOPT_MAX_MEMORY: the shared
+ * transfer buffers, connection filter chunks and paused client writes. */
+size_t Curl_multi_mem_used(struct Curl_multi *multi);
+
+/* A client writer of the transfer now buffers `nbytes` while paused.
+ * `*pcharged` is what the writer accounted before and gets updated. */
+void Curl_multi_mem_out(struct Curl_easy *data, size_t *pcharged,
+                        size_t nbytes);
+
 void Curl_multi_getsock(struct Curl_easy *data,
                         struct easy_pollset *ps,
                         const char *caller);
@@ -170,6 +184,13 @@ void Curl_multi_xfer_sockbuf_release(struct Curl_easy *data, char *buf);
 struct Curl_easy *Curl_multi_get_easy(struct Curl_multi *multi,
                                       unsigned int mid);
 
+/**
+ * Get the cache for buffer chunks that connection filters of the
+ * transfer's connection may attach their pools to. Returns NULL when
+ * connections are shared with other multi handles.
+ */
+struct bufc_cache *Curl_multi_bufcache(struct Curl_easy *data);
+
 /* Get the # of transfers current in process/pending. */
 unsigned int Curl_multi_xfers_running(struct Curl_multi *multi);
 
@@ -28,6 +28,7 @@
 #include "cfilters.h"
 #include "curlx/dynbuf.h"
 #include "doh.h"
+#include "mime.h"
 #include "multiif.h"
 #include "progress.h"
 #include "request.h"
@@ -60,6 +61,7 @@ CURLcode Curl_req_soft_reset(struct SingleRequest *req,
   req->eos_sent = FALSE;
   req->ignorebody = FALSE;
   req->shutdown = FALSE;
+  req->no_sendfile = FALSE;
   req->bytecount = 0;
   req->writebytecount = 0;
   req->header = TRUE; /* assume header */
@@ -164,6 +166,7 @@ void Curl_req_hard_reset(struct SingleRequest *req, struct Curl_easy *data)
   req->no_body = data->set.opt_no_body;
   req->authneg = FALSE;
   req->shutdown = FALSE;
+  req->no_sendfile = FALSE;
 }
 
 void Curl_req_free(struct SingleRequest *req, struct Curl_easy *data)
@@ -425,10 +428,61 @@ bool Curl_req_done_sending(struct Curl_easy *data)
   return data->req.upload_done && !Curl_req_want_send(data);
 }
 
+#ifdef USE_SENDFILE
+/* Send upload data directly from a file, bypassing the send buffer, when
+ * the client reader allows it. Returns CURLE_AGAIN when the upload needs
+ * to go the usual way. */
+static CURLcode req_sendfile(struct Curl_easy *data)
+{
+  curl_off_t offset, len;
+  size_t nwritten;
+  int fd;
+  CURLcode result;
+
+  if(data->req.no_sendfile ||
+     data->req.upload_aborted ||
+     data->req.eos_read ||
+     Curl_xfer_send_is_paused(data) ||
+     !Curl_bufq_is_empty(&data->req.sendbuf) ||
+     Curl_xfer_needs_flush(data) ||
+     /* the debug callback wants to see the data */
+     (data->set.verbose && data->set.fdebug) ||
+     !Curl_creader_mime_file_span(data, &fd, &offset, &len))
+    return CURLE_AGAIN;
+
+  /* The max send speed applies as on a buffered send. */
+  if(data->set.max_send_speed && len > data->set.max_send_speed)
+    len = data->set.max_send_speed;
+  if(len > (curl_off_t)(SIZE_MAX >> 1))
+    len = (curl_off_t)(SIZE_MAX >> 1);
+
+  result = Curl_xfer_sendfile(data, fd, offset, (size_t)len, &nwritten);
+  if(result == CURLE_NOT_BUILT_IN) {
+    data->req.no_sendfile = TRUE;
+    return CURLE_AGAIN;
+  }
+  if(result || !nwritten)
+    return result;
+
+  result = Curl_creader_mime_file_sent(data, nwritten);
+  if(result)
+    return result;
+  data->req.writebytecount += nwritten;
+  Curl_pgrsSetUploadCounter(data, data->req.writebytecount);
+  return CURLE_OK;
+}
+#endif
+
 CURLcode Curl_req_send_more(struct Curl_easy *data)
 {
   CURLcode result;
 
+#ifdef USE_SENDFILE
+  result = req_sendfile(data);
+  if(result != CURLE_AGAIN)
+    return result;
+#endif
+
   /* Fill our send buffer if more from client can be read. */
   if(!data->req.upload_aborted &&
      !data->req.eos_read &&
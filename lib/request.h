@@ -132,6 +132,7 @@ struct SingleRequest {
   BIT(sendbuf_init); /* sendbuf is initialized */
   BIT(shutdown);     /* request end will shutdown connection */
   BIT(shutdown_err_ignore); /* errors in shutdown will not fail request */
+  BIT(no_sendfile);  /* upload data cannot be sent directly from a file */
 };
 
 /**
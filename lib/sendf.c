@@ -630,6 +630,14 @@ void Curl_creader_def_done(struct Curl_easy *data,
   (void)premature;
 }
 
+bool Curl_creader_def_passes_through(struct Curl_easy *data,
+                                     struct Curl_creader *reader)
+{
+  (void)data;
+  (void)reader;
+  return FALSE;
+}
+
 struct cr_in_ctx {
   struct Curl_creader super;
   curl_read_callback read_cb;
@@ -920,6 +928,7 @@ static const struct Curl_crtype cr_in = {
   cr_in_unpause,
   cr_in_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_passes_through,
   sizeof(struct cr_in_ctx)
 };
 
@@ -1081,6 +1090,7 @@ static const struct Curl_crtype cr_lc = {
   Curl_creader_def_unpause,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_passes_through,
   sizeof(struct cr_lc_ctx)
 };
 
@@ -1255,6 +1265,7 @@ static const struct Curl_crtype cr_null = {
   Curl_creader_def_unpause,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_passes_through,
   sizeof(struct Curl_creader)
 };
 
@@ -1364,6 +1375,7 @@ static const struct Curl_crtype cr_buf = {
   Curl_creader_def_unpause,
   Curl_creader_def_is_paused,
   Curl_creader_def_done,
+  Curl_creader_def_passes_through,
   sizeof(struct cr_buf_ctx)
 };
 
@@ -1457,3 +1469,14 @@ struct Curl_creader *Curl_creader_get_by_type(struct Curl_easy *data,
   return NULL;
 
 }
+
+struct Curl_creader *Curl_creader_get_client(struct Curl_easy *data)
+{
+  struct Curl_creader *r;
+  for(r = data->req.reader_stack; r && r->phase != CURL_CR_CLIENT;
+      r = r->next) {
+    if(!r->crt->passes_through(data, r))
+      return NULL;
+  }
+  return r;
+}
@@ -220,6 +220,9 @@ struct Curl_crtype {
   bool (*is_paused)(struct Curl_easy *data, struct Curl_creader *reader);
   void (*done)(struct Curl_easy *data,
                struct Curl_creader *reader, int premature);
+  /* TRUE iff the reader passes on the data of the next one unchanged */
+  bool (*passes_through)(struct Curl_easy *data,
+                         struct Curl_creader *reader);
   size_t creader_size;  /* sizeof() allocated struct Curl_creader */
 };
 
@@ -272,6 +275,8 @@ bool Curl_creader_def_is_paused(struct Curl_easy *data,
                                 struct Curl_creader *reader);
 void Curl_creader_def_done(struct Curl_easy *data,
                            struct Curl_creader *reader, int premature);
+bool Curl_creader_def_passes_through(struct Curl_easy *data,
+                                     struct Curl_creader *reader);
 
 /**
  * Convenience method for calling `reader->do_read()` that
@@ -394,6 +399,12 @@ void Curl_creader_done(struct Curl_easy *data, int premature);
 struct Curl_creader *Curl_creader_get_by_type(struct Curl_easy *data,
                                               const struct Curl_crtype *crt);
 
+/**
+ * Get the reader at phase CURL_CR_CLIENT iff all readers before it
+ * pass on its data unchanged, NULL otherwise.
+ */
+struct Curl_creader *Curl_creader_get_client(struct Curl_easy *data);
+
 
 /**
  * Set the client reader to provide 0 bytes, immediate EOS.
@@ -539,6 +539,13 @@ static CURLcode setopt_bool(struct Curl_easy *data, CURLoption option,
      */
     s->cookiesession = enabled;
     break;
+  case CURLOPT_COOKIEJOURNAL:
+    /*
+     * Append the cookies changed since the last write to the cookie jar
+     * instead of rewriting it every time.
+     */
+    s->cookiejournal = enabled;
+    break;
 #endif
   case CURLOPT_AUTOREFERER:
     /*
@@ -873,6 +880,22 @@ static CURLcode setopt_long(struct Curl_easy *data, CURLoption option,
 
     s->dns_cache_timeout = (int)arg;
     break;
+  case CURLOPT_DNS_CACHE_NEGATIVE_TIMEOUT:
+    if(arg < 0)
+      return CURLE_BAD_FUNCTION_ARGUMENT;
+    else if(arg > INT_MAX)
+      arg = INT_MAX;
+
+    s->dns_neg_timeout = (int)arg;
+    break;
+  case CURLOPT_DNS_CACHE_STALE_TIMEOUT:
+    if(arg < 0)
+      return CURLE_BAD_FUNCTION_ARGUMENT;
+    else if(arg > INT_MAX)
+      arg = INT_MAX;
+
+    s->dns_stale_timeout = (int)arg;
+    break;
   case CURLOPT_CA_CACHE_TIMEOUT:
     if(Curl_ssl_supports(data, SSLSUPP_CA_CACHE)) {
       if(arg < -1)
@@ -2087,6 +2110,9 @@ static CURLcode setopt_cptr(struct Curl_easy *data, CURLoption option,
   case CURLOPT_PREREQDATA:
     s->prereq_userp = ptr;
     break;
+  case CURLOPT_RECVBUFFERDATA:
+    s->recvbuffer_userp = ptr;
+    break;
 
   case CURLOPT_ERRORBUFFER:
     /*
@@ -2902,6 +2928,9 @@ static CURLcode setopt_func(struct Curl_easy *data, CURLoption option,
   case CURLOPT_PREREQFUNCTION:
     s->fprereq = va_arg(param, curl_prereq_callback);
     break;
+  case CURLOPT_RECVBUFFERFUNCTION:
+    s->frecvbuffer = va_arg(param, curl_recvbuffer_callback);
+    break;
   default:
     return CURLE_UNKNOWN_OPTION;
   }
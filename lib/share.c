@@ -46,9 +46,13 @@ curl_share_init(void)
   if(share) {
     share->magic = CURL_GOOD_SHARE;
     share->specifier |= (1 << CURL_LOCK_DATA_SHARE);
-    Curl_dnscache_init(&share->dnscache, 23);
+    if(Curl_dnscache_init(&share->dnscache, 23, TRUE)) {
+      free(share);
+      return NULL;
+    }
     share->admin = curl_easy_init();
     if(!share->admin) {
+      Curl_dnscache_destroy(&share->dnscache);
       free(share);
       return NULL;
     }
@@ -124,8 +128,7 @@ curl_share_setopt(CURLSH *sh, CURLSHoption option, ...)
       if(!share->ssl_scache) {
         /* There is no way (yet) for the application to configure the
          * session cache size, shared between many transfers. As for curl
-         * itself, a high session count will impact startup time. Also, the
-         * scache is not optimized for several hundreds of peers. So,
+         * itself, a high session count will impact startup time. So,
          * keep it at a reasonable level. */
         if(Curl_ssl_scache_create(25, 2, &share->ssl_scache))
           res = CURLSHE_NOMEM;
@@ -138,7 +141,8 @@ curl_share_setopt(CURLSH *sh, CURLSHoption option, ...)
     case CURL_LOCK_DATA_CONNECT:
       /* It is safe to set this option several times on a share. */
       if(!share->cpool.initialised) {
-        Curl_cpool_init(&share->cpool, share->admin, share, 103);
+        if(Curl_cpool_init(&share->cpool, share->admin, share, 103))
+          res = CURLSHE_NOMEM;
       }
       break;
 
@@ -246,9 +250,8 @@ curl_share_cleanup(CURLSH *sh)
     return CURLSHE_IN_USE;
   }
 
-  if(share->specifier & (1 << CURL_LOCK_DATA_CONNECT)) {
-    Curl_cpool_destroy(&share->cpool);
-  }
+  /* the pool may have been unshared again after it was set up */
+  Curl_cpool_destroy(&share->cpool);
 
   Curl_dnscache_destroy(&share->dnscache);
 
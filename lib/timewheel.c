@@ -0,0 +1,301 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+#include "curl_setup.h"
+
+#if defined(USE_TIMER_WHEEL) || defined(UNITTESTS)
+
+#include "curlx/timeval.h"
+#include "timewheel.h"
+#include "uint-bset.h"
+
+/* The last 3 #include files should be in this order */
+#include "curl_printf.h"
+#include "curl_memory.h"
+#include "memdebug.h"
+
+#define TWHEEL_MASK  ((curl_uint64_t)CURL_TWHEEL_SLOTS - 1)
+
+/* special values for `node->level` */
+#define TWHEEL_DUE   CURL_TWHEEL_LEVELS
+#define TWHEEL_NONE  0xff
+
+#define TWHEEL_SHIFT(l)  ((l) * CURL_TWHEEL_BITS)
+
+static curl_uint64_t twheel_ms(struct curltime t)
+{
+  return ((curl_uint64_t)t.tv_sec * 1000) + (curl_uint64_t)(t.tv_usec / 1000);
+}
+
+static struct curltime twheel_time(curl_uint64_t ms)
+{
+  struct curltime t;
+  t.tv_sec = (time_t)(ms / 1000);
+  t.tv_usec = (int)((ms % 1000) * 1000);
+  return t;
+}
+
+/* rotate a slot bitmap right by `n`, 0 <= n < 64 */
+static curl_uint64_t twheel_rotr(curl_uint64_t x, unsigned int n)
+{
+  return n ? ((x >> n) | (x << (64 - n))) : x;
+}
+
+static struct Curl_twheel_node **twheel_head(struct Curl_twheel *wheel,
+                                             struct Curl_twheel_node *node)
+{
+  if(node->level == TWHEEL_DUE)
+    return &wheel->due;
+  return &wheel->slots[node->level][node->slot];
+}
+
+static void twheel_link(struct Curl_twheel_node **head,
+                        struct Curl_twheel_node *node)
+{
+  node->prev = NULL;
+  node->next = *head;
+  if(*head)
+    (*head)->prev = node;
+  *head = node;
+}
+
+/* Put `node` into the level and slot matching its key, relative to the
+ * wheel's current time. */
+static void twheel_place(struct Curl_twheel *wheel,
+                         struct Curl_twheel_node *node)
+{
+  curl_uint64_t tick = twheel_ms(node->key);
+  curl_uint64_t diff;
+  unsigned int level = 0;
+
+  if(tick <= wheel->now_ms) {
+    node->level = TWHEEL_DUE;
+    node->slot = 0;
+    twheel_link(&wheel->due, node);
+    return;
+  }
+
+  /* the lowest level where `tick` and `now_ms` share all higher bits */
+  diff = tick ^ wheel->now_ms;
+  while((level < CURL_TWHEEL_LEVELS - 1) &&
+        (diff >> TWHEEL_SHIFT(level + 1)))
+    level++;
+
+  if(diff >> TWHEEL_SHIFT(CURL_TWHEEL_LEVELS))
+    /* too far out, park it in the last slot of the top level. It gets placed
+       again when the top level has turned around. */
+    node->slot = (unsigned char)
+      (((wheel->now_ms >> TWHEEL_SHIFT(level)) - 1) & TWHEEL_MASK);
+  else
+    node->slot = (unsigned char)((tick >> TWHEEL_SHIFT(level)) & TWHEEL_MASK);
+
+  node->level = (unsigned char)level;
+  twheel_link(&wheel->slots[level][node->slot], node);
+  wheel->pending[level] |= ((curl_uint64_t)1 << node->slot);
+}
+
+/* Move the wheel forward to `now_ms`. All slots passed over are emptied and
+ * their nodes are placed again. */
+static void twheel_advance(struct Curl_twheel *wheel, curl_uint64_t now_ms)
+{
+  struct Curl_twheel_node *todo = NULL;
+  unsigned int level;
+
+  if(now_ms <= wheel->now_ms)
+    return;
+
+  for(level = 0; level < CURL_TWHEEL_LEVELS; level++) {
+    curl_uint64_t c = wheel->now_ms >> TWHEEL_SHIFT(level);
+    curl_uint64_t n = now_ms >> TWHEEL_SHIFT(level);
+    curl_uint64_t passed;
+
+    if(c == n)
+      /* no higher level moves either */
+      break;
+
+    if(n - c >= CURL_TWHEEL_SLOTS)
+      passed = ~(curl_uint64_t)0;
+    else {
+      /* the slots for c + 1 up to and including n */
+      curl_uint64_t span = ((curl_uint64_t)1 << (n - c)) - 1;
+      unsigned int first = (unsigned int)((c + 1) & TWHEEL_MASK);
+      passed = twheel_rotr(span, (64 - first) & 63);
+    }
+
+    passed &= wheel->pending[level];
+    wheel->pending[level] &= ~passed;
+    while(passed) {
+      unsigned int slot = CURL_CTZ64(passed);
+      struct Curl_twheel_node *node = wheel->slots[level][slot];
+      passed &= passed - 1;
+      wheel->slots[level][slot] = NULL;
+      while(node) {
+        struct Curl_twheel_node *next = node->next;
+        node->next = todo;
+        todo = node;
+        node = next;
+      }
+    }
+  }
+
+  wheel->now_ms = now_ms;
+
+  while(todo) {
+    struct Curl_twheel_node *node = todo;
+    todo = node->next;
+    twheel_place(wheel, node);
+  }
+}
+
+void Curl_twheel_init(struct Curl_twheel *wheel, struct curltime now)
+{
+  memset(wheel, 0, sizeof(*wheel));
+  wheel->now_ms = twheel_ms(now);
+}
+
+void Curl_twheel_nodeinit(struct Curl_twheel_node *node, void *payload)
+{
+  node->next = node->prev = NULL;
+  node->ptr = payload;
+  node->level = TWHEEL_NONE;
+  node->slot = 0;
+}
+
+void *Curl_twheel_get(struct Curl_twheel_node *node)
+{
+  return node->ptr;
+}
+
+void Curl_twheel_insert(struct Curl_twheel *wheel, struct curltime key,
+                        struct Curl_twheel_node *node)
+{
+  DEBUGASSERT(node->level == TWHEEL_NONE);
+  node->key = key;
+  twheel_place(wheel, node);
+  wheel->count++;
+}
+
+int Curl_twheel_remove(struct Curl_twheel *wheel,
+                       struct Curl_twheel_node *node)
+{
+  struct Curl_twheel_node **head;
+
+  if(node->level == TWHEEL_NONE)
+    return 1;
+
+  head = twheel_head(wheel, node);
+  if(node->prev)
+    node->prev->next = node->next;
+  else
+    *head = node->next;
+  if(node->next)
+    node->next->prev = node->prev;
+
+  if(!*head && (node->level != TWHEEL_DUE))
+    wheel->pending[node->level] &= ~((curl_uint64_t)1 << node->slot);
+
+  node->next = node->prev = NULL;
+  node->level = TWHEEL_NONE;
+  DEBUGASSERT(wheel->count);
+  wheel->count--;
+  return 0;
+}
+
+struct Curl_twheel_node *Curl_twheel_getbest(struct Curl_twheel *wheel,
+                                             struct curltime now)
+{
+  struct Curl_twheel_node *node;
+
+  if(!wheel->count)
+    return NULL;
+
+  twheel_advance(wheel, twheel_ms(now));
+
+  /* due nodes may still be a fraction of a millisecond away */
+  for(node = wheel->due; node; node = node->next) {
+    if(curlx_timediff_us(node->key, now) <= 0) {
+      (void)Curl_twheel_remove(wheel, node);
+      return node;
+    }
+  }
+  return NULL;
+}
+
+bool Curl_twheel_next(struct Curl_twheel *wheel, struct curltime now,
+                      struct curltime *pexpire,
+                      struct Curl_twheel_node **pnode)
+{
+  struct Curl_twheel_node *node, *best = NULL;
+  unsigned int level;
+
+  *pnode = NULL;
+  if(!wheel->count)
+    return FALSE;
+
+  twheel_advance(wheel, twheel_ms(now));
+
+  if(wheel->due)
+    best = wheel->due;
+  else if(wheel->pending[0]) {
+    /* the nearest non-empty slot holds nodes of a single millisecond */
+    unsigned int first = (unsigned int)((wheel->now_ms + 1) & TWHEEL_MASK);
+    unsigned int slot = (unsigned int)
+      ((first + CURL_CTZ64(twheel_rotr(wheel->pending[0], first))) &
+       TWHEEL_MASK);
+    best = wheel->slots[0][slot];
+  }
+
+  if(best) {
+    for(node = best->next; node; node = node->next) {
+      if(curlx_timediff_us(node->key, best->key) < 0)
+        best = node;
+    }
+    *pexpire = best->key;
+    if(curlx_timediff_us(best->key, now) <= 0)
+      *pnode = best;
+    return TRUE;
+  }
+
+  /* The next thing to happen is a higher level slot moving down */
+  for(level = 1; level < CURL_TWHEEL_LEVELS; level++) {
+    if(wheel->pending[level]) {
+      curl_uint64_t c = wheel->now_ms >> TWHEEL_SHIFT(level);
+      unsigned int first = (unsigned int)((c + 1) & TWHEEL_MASK);
+      curl_uint64_t p = c + 1 +
+        CURL_CTZ64(twheel_rotr(wheel->pending[level], first));
+      *pexpire = twheel_time(p << TWHEEL_SHIFT(level));
+      return TRUE;
+    }
+  }
+  /* not reached with a non-zero count */
+  DEBUGASSERT(0);
+  return FALSE;
+}
+
+size_t Curl_twheel_count(struct Curl_twheel *wheel)
+{
+  return wheel->count;
+}
+
+#endif /* USE_TIMER_WHEEL || UNITTESTS */
@@ -0,0 +1,96 @@
+#ifndef HEADER_CURL_TIMEWHEEL_H
+#define HEADER_CURL_TIMEWHEEL_H
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "curl_setup.h"
+#include "curlx/timeval.h"
+
+/* A hierarchical timing wheel with millisecond ticks.
+ *
+ * Each level has CURL_TWHEEL_SLOTS slots, one slot in level `n` covers
+ * CURL_TWHEEL_SLOTS^n milliseconds. A node is kept in the lowest level
+ * where its expire time differs from the wheel's current time. Insert and
+ * remove are O(1). When the wheel advances, the slots passed over are
+ * emptied and their nodes get placed again, on a lower level or into the
+ * list of due nodes.
+ *
+ * Nodes that are due at the same time are handed out in no particular
+ * order. */
+
+#define CURL_TWHEEL_BITS   6
+#define CURL_TWHEEL_SLOTS  (1 << CURL_TWHEEL_BITS)
+#define CURL_TWHEEL_LEVELS 6
+
+/* only use function calls to access this struct */
+struct Curl_twheel_node {
+  struct Curl_twheel_node *next;
+  struct Curl_twheel_node *prev;
+  struct curltime key;  /* the expire time */
+  void *ptr;            /* data the wheel does not care about */
+  unsigned char level;  /* level the node is in, or a special value */
+  unsigned char slot;   /* slot in the level */
+};
+
+struct Curl_twheel {
+  struct Curl_twheel_node *slots[CURL_TWHEEL_LEVELS][CURL_TWHEEL_SLOTS];
+  curl_uint64_t pending[CURL_TWHEEL_LEVELS]; /* bitmaps of non-empty slots */
+  struct Curl_twheel_node *due; /* nodes at or before `now_ms` */
+  curl_uint64_t now_ms;         /* the wheel's current time */
+  size_t count;                 /* number of nodes in the wheel */
+};
+
+/* Init the wheel with the current time. */
+void Curl_twheel_init(struct Curl_twheel *wheel, struct curltime now);
+
+/* Set the custom payload for this node. This also marks the node as not
+ * being in any wheel. */
+void Curl_twheel_nodeinit(struct Curl_twheel_node *node, void *payload);
+void *Curl_twheel_get(struct Curl_twheel_node *node);
+
+/* Add `node` to expire at `key`. The node must not be in the wheel. */
+void Curl_twheel_insert(struct Curl_twheel *wheel, struct curltime key,
+                        struct Curl_twheel_node *node);
+
+/* Remove `node` from the wheel. Returns 1 when the node is not in it. */
+int Curl_twheel_remove(struct Curl_twheel *wheel,
+                       struct Curl_twheel_node *node);
+
+/* Remove and return a node whose key is not later than `now`, or
+ * return NULL if there is none. */
+struct Curl_twheel_node *Curl_twheel_getbest(struct Curl_twheel *wheel,
+                                             struct curltime now);
+
+/* Get the time of the next expiry. This is exact when the nearest node
+ * is due within the wheel's lowest level, otherwise it is the time when the
+ * wheel needs to advance to move nodes closer. If the returned time is due,
+ * `*pnode` is set to a node that has expired, otherwise it is NULL.
+ * Returns FALSE if the wheel is empty. */
+bool Curl_twheel_next(struct Curl_twheel *wheel, struct curltime now,
+                      struct curltime *pexpire,
+                      struct Curl_twheel_node **pnode);
+
+/* Number of nodes in the wheel. */
+size_t Curl_twheel_count(struct Curl_twheel *wheel);
+
+#endif /* HEADER_CURL_TIMEWHEEL_H */
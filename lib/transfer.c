@@ -254,6 +254,42 @@ static ssize_t xfer_recv_resp(struct Curl_easy *data,
   return (ssize_t)nread;
 }
 
+/*
+ * Get the buffer provided by the application via CURLOPT_RECVBUFFERFUNCTION
+ * to receive into. This is only done for response body data that is passed
+ * to the client writer unchanged, so the write callback gets pointers into
+ * the application's own buffer.
+ * @param data         the transfer
+ * @param is_multiplex if the connection is multiplexed
+ * @param pbuf         in: the transfer buffer, out: the buffer to use
+ * @param pblen        in: length of the transfer buffer, out: length of
+ *                     the buffer to use
+ */
+static void xfer_recv_app_buf(struct Curl_easy *data,
+                              bool is_multiplex,
+                              char **pbuf, size_t *pblen)
+{
+  char *buf;
+  size_t blen = *pblen;
+
+  /* Multiplexed connections write to the client from their stream buffers
+   * and while headers are parsed or decoders are active, the client does
+   * not get the bytes as received. */
+  if(!data->set.frecvbuffer || is_multiplex ||
+     data->req.header || data->req.ignorebody ||
+     Curl_cwriter_count(data, CURL_CW_TRANSFER_DECODE) ||
+     Curl_cwriter_count(data, CURL_CW_CONTENT_DECODE))
+    return;
+
+  Curl_set_in_callback(data, TRUE);
+  buf = data->set.frecvbuffer(&blen, data->set.recvbuffer_userp);
+  Curl_set_in_callback(data, FALSE);
+  if(buf && blen) {
+    *pbuf = buf;
+    *pblen = blen;
+  }
+}
+
 /*
  * Go ahead and do a read if we have a readable socket or if
  * the stream was rewound (in which case we have data in a
@@ -292,6 +328,7 @@ static CURLcode sendrecv_dl(struct Curl_easy *data,
 
     buf = xfer_buf;
     bytestoread = xfer_blen;
+    xfer_recv_app_buf(data, is_multiplex, &buf, &bytestoread);
 
     if(bytestoread && data->set.max_recv_speed > 0) {
       /* In case of speed limit on receiving: if this loop already got
@@ -925,6 +962,33 @@ CURLcode Curl_xfer_send(struct Curl_easy *data,
   return result;
 }
 
+#ifdef USE_SENDFILE
+CURLcode Curl_xfer_sendfile(struct Curl_easy *data,
+                            int fd, curl_off_t offset, size_t len,
+                            size_t *pnwritten)
+{
+  CURLcode result;
+  int sockindex;
+
+  DEBUGASSERT(data);
+  DEBUGASSERT(data->conn);
+
+  sockindex = ((data->conn->writesockfd != CURL_SOCKET_BAD) &&
+               (data->conn->writesockfd == data->conn->sock[SECONDARYSOCKET]));
+  result = Curl_conn_sendfile(data, sockindex, fd, offset, len, pnwritten);
+  if(result == CURLE_AGAIN) {
+    result = CURLE_OK;
+    *pnwritten = 0;
+  }
+  else if(!result && *pnwritten)
+    data->info.request_size += *pnwritten;
+
+  DEBUGF(infof(data, "Curl_xfer_sendfile(len=%zu) -> %d, %zu",
+               len, result, *pnwritten));
+  return result;
+}
+#endif
+
 CURLcode Curl_xfer_recv(struct Curl_easy *data,
                         char *buf, size_t blen,
                         size_t *pnrcvd)
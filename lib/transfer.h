@@ -125,6 +125,18 @@ CURLcode Curl_xfer_send(struct Curl_easy *data,
                         const void *buf, size_t blen, bool eos,
                         size_t *pnwritten);
 
+#ifdef USE_SENDFILE
+/**
+ * Send `len` bytes of file `fd` at `offset` directly on the socket
+ * designated for transfer's outgoing data, see Curl_conn_sendfile().
+ * Will return CURLE_OK on blocking with (*pnwritten == 0) and
+ * CURLE_NOT_BUILT_IN when the connection does not allow it.
+ */
+CURLcode Curl_xfer_sendfile(struct Curl_easy *data,
+                            int fd, curl_off_t offset, size_t len,
+                            size_t *pnwritten);
+#endif
+
 /**
  * Receive data on the socket/connection filter designated
  * for transfer's incoming data.
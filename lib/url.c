@@ -120,6 +120,7 @@
 #include "mqtt.h"
 #include "http_proxy.h"
 #include "conncache.h"
+#include "cprewarm.h"
 #include "multihandle.h"
 #include "strdup.h"
 #include "setopt.h"
@@ -271,6 +272,7 @@ CURLcode Curl_close(struct Curl_easy **datap)
   /* Close down all open SSL info and sessions */
   Curl_ssl_close_all(data);
   Curl_safefree(data->state.first_host);
+  Curl_safefree(data->state.dns_refresh_host);
   Curl_ssl_free_certinfo(data);
 
   if(data->state.referer_alloc) {
@@ -572,6 +574,194 @@ CURLcode Curl_open(struct Curl_easy **curl)
   return result;
 }
 
+/* The strings that decide where and how a transfer connects and resolves
+ * names. Transfer specific ones, like cookies or the files for alt-svc and
+ * HSTS, are left out. */
+static const enum dupstring internal_strings[] = {
+  STRING_CERT,
+  STRING_CERT_TYPE,
+  STRING_KEY,
+  STRING_KEY_PASSWD,
+  STRING_KEY_TYPE,
+  STRING_SSL_CAPATH,
+  STRING_SSL_CAFILE,
+  STRING_SSL_PINNEDPUBLICKEY,
+  STRING_SSL_CIPHER_LIST,
+  STRING_SSL_CIPHER13_LIST,
+  STRING_SSL_CRLFILE,
+  STRING_SSL_ISSUERCERT,
+  STRING_SSL_EC_CURVES,
+  STRING_SSL_SIGNATURE_ALGORITHMS,
+  STRING_SSL_ENGINE,
+  STRING_ECH_CONFIG,
+  STRING_ECH_PUBLIC,
+#ifdef USE_TLS_SRP
+  STRING_TLSAUTH_USERNAME,
+  STRING_TLSAUTH_PASSWORD,
+#ifndef CURL_DISABLE_PROXY
+  STRING_TLSAUTH_USERNAME_PROXY,
+  STRING_TLSAUTH_PASSWORD_PROXY,
+#endif
+#endif
+#ifndef CURL_DISABLE_PROXY
+  STRING_CERT_PROXY,
+  STRING_CERT_TYPE_PROXY,
+  STRING_KEY_PROXY,
+  STRING_KEY_PASSWD_PROXY,
+  STRING_KEY_TYPE_PROXY,
+  STRING_SSL_CAPATH_PROXY,
+  STRING_SSL_CAFILE_PROXY,
+  STRING_SSL_PINNEDPUBLICKEY_PROXY,
+  STRING_SSL_CIPHER_LIST_PROXY,
+  STRING_SSL_CIPHER13_LIST_PROXY,
+  STRING_SSL_CRLFILE_PROXY,
+  STRING_SSL_ISSUERCERT_PROXY,
+  STRING_PROXY_SERVICE_NAME,
+  STRING_PROXY,
+  STRING_PRE_PROXY,
+  STRING_PROXYUSERNAME,
+  STRING_PROXYPASSWORD,
+  STRING_NOPROXY,
+  STRING_HAPROXY_CLIENT_IP,
+#endif
+  STRING_DEVICE,
+  STRING_INTERFACE,
+  STRING_BINDHOST,
+#ifdef USE_UNIX_SOCKETS
+  STRING_UNIX_SOCKET_PATH,
+#endif
+#ifndef CURL_DISABLE_DOH
+  STRING_DOH,
+#endif
+#ifdef USE_ARES
+  STRING_DNS_SERVERS,
+  STRING_DNS_INTERFACE,
+  STRING_DNS_LOCAL_IP4,
+  STRING_DNS_LOCAL_IP6,
+#endif
+};
+
+/*
+ * Curl_open_internal() creates a handle for a transfer that libcurl runs
+ * on its own behalf to `url`, connecting and resolving the way `data` does.
+ *
+ * Unlike curl_easy_duphandle(), it does not get the cookies, HSTS and
+ * alt-svc caches of `data` or their files, nor any of its callbacks that
+ * deal with the transfer itself. Closing it writes no files.
+ */
+CURLcode Curl_open_internal(struct Curl_easy *data, const char *url,
+                            struct Curl_easy **pinternal)
+{
+  struct Curl_easy *internal;
+  struct UserDefined *s;
+  const struct UserDefined *src = &data->set;
+  CURLcode result;
+  size_t i;
+
+  *pinternal = NULL;
+  result = Curl_open(&internal);
+  if(result)
+    return result;
+  s = &internal->set;
+
+  for(i = 0; i < CURL_ARRAYSIZE(internal_strings); i++) {
+    result = Curl_setstropt(&s->str[internal_strings[i]],
+                            src->str[internal_strings[i]]);
+    if(result)
+      goto out;
+  }
+  for(i = 0; i < BLOB_LAST; i++) {
+    result = Curl_setblobopt(&s->blobs[i], src->blobs[i]);
+    if(result)
+      goto out;
+  }
+  if(s->str[STRING_SSL_ENGINE]) {
+    result = Curl_ssl_set_engine(internal, s->str[STRING_SSL_ENGINE]);
+    if(result)
+      goto out;
+  }
+
+  s->ssl = src->ssl;
+#ifndef CURL_DISABLE_PROXY
+  s->proxy_ssl = src->proxy_ssl;
+  s->proxyheaders = src->proxyheaders;
+  s->proxyport = src->proxyport;
+  s->proxytype = src->proxytype;
+  s->socks5auth = src->socks5auth;
+  s->proxyauth = src->proxyauth;
+  s->tunnel_thru_httpproxy = src->tunnel_thru_httpproxy;
+  s->haproxyprotocol = src->haproxyprotocol;
+  s->sep_headers = src->sep_headers;
+#endif
+  s->general_ssl = src->general_ssl;
+  s->ssl_enable_alpn = src->ssl_enable_alpn;
+#ifdef USE_ECH
+  s->tls_ech = src->tls_ech;
+#endif
+  s->use_ssl = src->use_ssl;
+  s->httpwant = src->httpwant;
+  s->allowed_protocols = src->allowed_protocols;
+  s->connect_to = src->connect_to;
+  s->ipver = src->ipver;
+#ifdef USE_IPV6
+  s->scope_id = src->scope_id;
+#endif
+#ifndef CURL_DISABLE_BINDLOCAL
+  s->localport = src->localport;
+  s->localportrange = src->localportrange;
+#endif
+#ifdef USE_UNIX_SOCKETS
+  s->abstract_unix_socket = src->abstract_unix_socket;
+#endif
+#ifndef CURL_DISABLE_DOH
+  s->doh = src->doh;
+  s->doh_verifypeer = src->doh_verifypeer;
+  s->doh_verifyhost = src->doh_verifyhost;
+  s->doh_verifystatus = src->doh_verifystatus;
+#endif
+  s->dns_cache_timeout = src->dns_cache_timeout;
+  s->dns_neg_timeout = src->dns_neg_timeout;
+  s->dns_stale_timeout = src->dns_stale_timeout;
+  s->dns_shuffle_addresses = src->dns_shuffle_addresses;
+  s->connecttimeout = src->connecttimeout;
+  s->happy_eyeballs_timeout = src->happy_eyeballs_timeout;
+  s->shutdowntimeout = src->shutdowntimeout;
+  s->conn_max_idle_ms = src->conn_max_idle_ms;
+  s->conn_max_age_ms = src->conn_max_age_ms;
+  s->tcp_nodelay = src->tcp_nodelay;
+  s->tcp_keepalive = src->tcp_keepalive;
+  s->tcp_keepidle = src->tcp_keepidle;
+  s->tcp_keepintvl = src->tcp_keepintvl;
+  s->tcp_keepcnt = src->tcp_keepcnt;
+  s->tcp_fastopen = src->tcp_fastopen;
+  /* the sockets end up in connections the application uses */
+  s->fsockopt = src->fsockopt;
+  s->sockopt_client = src->sockopt_client;
+  s->fopensocket = src->fopensocket;
+  s->opensocket_client = src->opensocket_client;
+  s->fclosesocket = src->fclosesocket;
+  s->closesocket_client = src->closesocket_client;
+  s->no_signal = src->no_signal;
+  s->quick_exit = src->quick_exit;
+  s->verbose = src->verbose;
+  s->err = src->err;
+  s->fdebug = src->fdebug;
+  s->debugdata = src->debugdata;
+
+  result = curl_easy_setopt(internal, CURLOPT_SHARE, (CURLSH *)data->share);
+  if(!result)
+    result = curl_easy_setopt(internal, CURLOPT_URL, url);
+out:
+  if(result) {
+    Curl_close(&internal);
+    return result;
+  }
+  internal->progress.callback = FALSE;
+  internal->state.internal = TRUE;
+  *pinternal = internal;
+  return CURLE_OK;
+}
+
 void Curl_conn_free(struct Curl_easy *data, struct connectdata *conn)
 {
   size_t i;
@@ -3797,6 +3987,7 @@ static CURLcode create_conn(struct Curl_easy *data,
        idnconvert_hostname() was called already in create_conn() for the reuse
        case. */
     *reusedp = TRUE;
+    Curl_cprewarm_conn_reused(data);
   }
 
   /* persist the scheme and handler the transfer is using */
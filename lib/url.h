@@ -31,6 +31,8 @@
 
 CURLcode Curl_init_do(struct Curl_easy *data, struct connectdata *conn);
 CURLcode Curl_open(struct Curl_easy **curl);
+CURLcode Curl_open_internal(struct Curl_easy *data, const char *url,
+                            struct Curl_easy **pinternal);
 CURLcode Curl_init_userdefined(struct Curl_easy *data);
 
 void Curl_freeset(struct Curl_easy *data);
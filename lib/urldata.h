@@ -153,6 +153,7 @@ typedef unsigned int curl_prot_t;
 #include "hostip.h"
 #include "hash.h"
 #include "splay.h"
+#include "timewheel.h"
 #include "curlx/dynbuf.h"
 #include "dynhds.h"
 #include "request.h"
@@ -623,6 +624,20 @@ struct ip_quadruple {
   int local_port;
 };
 
+/* UDP datagrams and the system calls it took to move them */
+struct udp_io_stats {
+  curl_off_t pkts_recvd;
+  curl_off_t recv_calls;
+  curl_off_t pkts_sent;
+  curl_off_t send_calls;
+};
+
+/* Receive flow-control window and the round-trip time it is sized by */
+struct flowctl_stats {
+  curl_off_t window;
+  curl_off_t rtt_us;
+};
+
 struct proxy_info {
   struct hostname host;
   int port;
@@ -826,6 +841,8 @@ struct PureInfo {
      session handle without disturbing information which is still alive, and
      that might be reused, in the connection pool. */
   struct ip_quadruple primary;
+  struct udp_io_stats udp_io; /* copied from the connection when done */
+  struct flowctl_stats flowctl; /* copied from the connection when done */
   int conn_remote_port;  /* this is the "remote port", which is the port
                             number of the used URL, independent of proxy or
                             not */
@@ -960,6 +977,7 @@ typedef enum {
   EXPIRE_FTP_ACCEPT,
   EXPIRE_ALPN_EYEBALLS,
   EXPIRE_SHUTDOWN,
+  EXPIRE_PREWARM,
   EXPIRE_LAST /* not an actual timer, used as a marker only */
 } expire_id;
 
@@ -1019,6 +1037,11 @@ struct UrlState {
   int first_remote_port;
   curl_prot_t first_remote_protocol;
 
+  /* name and port of the stale DNS cache entry a dns_refresh transfer
+     resolves again. This is strdup()ed data. */
+  char *dns_refresh_host;
+  int dns_refresh_port;
+
   int retrycount; /* number of retries on a new connection */
   int os_errno;  /* filled in with errno whenever an error occurs */
   long followlocation; /* redirect counter */
@@ -1051,7 +1074,11 @@ struct UrlState {
   BIT(provider_loaded);
 #endif /* USE_OPENSSL */
   struct curltime expiretime; /* set this with Curl_expire() only */
+#ifdef USE_TIMER_WHEEL
+  struct Curl_twheel_node timenode; /* for the timing wheel */
+#else
   struct Curl_tree timenode; /* for the splay stuff */
+#endif
   struct Curl_llist timeoutlist; /* list of pending timeouts */
   struct time_node expires[EXPIRE_LAST]; /* nodes for each expire type */
 
@@ -1073,6 +1100,8 @@ struct UrlState {
 
   curl_off_t infilesize; /* size of file to upload, -1 means unknown.
                             Copied from set.filesize at start of operation */
+  size_t mem_out; /* bytes buffered for client writes while paused,
+                     accounted in the multi handle */
 #if defined(USE_HTTP2) || defined(USE_HTTP3)
   struct Curl_data_priority priority; /* shallow copy of data->set */
 #endif
@@ -1141,6 +1170,10 @@ struct UrlState {
   } aptr;
 #ifndef CURL_DISABLE_HTTP
   struct http_negotiation http_neg;
+#endif
+#ifdef CPOOL_SHARDS
+  const void *cpool_locked; /* the connection pool, or shard of it, this
+                               transfer holds the lock of */
 #endif
   unsigned char httpreq; /* Curl_HttpReq; what kind of HTTP request (if any)
                             is this */
@@ -1183,6 +1216,10 @@ struct UrlState {
   BIT(internal); /* internal: true if this easy handle was created for
                     internal use and the user does not have ownership of the
                     handle. */
+  BIT(prewarm); /* internal transfer connecting for the pool, see
+                   cprewarm.c */
+  BIT(dns_refresh); /* internal transfer resolving a stale DNS cache entry
+                       again, see hostip.c */
   BIT(http_ignorecustom); /* ignore custom method from now */
 };
 
@@ -1383,6 +1420,8 @@ struct UserDefined {
   void *closesocket_client;
   curl_prereq_callback fprereq; /* pre-initial request callback */
   void *prereq_userp; /* pre-initial request user data */
+  curl_recvbuffer_callback frecvbuffer; /* provides the body receive buffer */
+  void *recvbuffer_userp; /* pointer to pass to the receive buffer callback */
 
   void *seek_client;    /* pointer to pass to the seek callback */
 #ifndef CURL_DISABLE_HSTS
@@ -1432,6 +1471,8 @@ struct UserDefined {
 #endif
   struct ssl_general_config general_ssl; /* general user defined SSL stuff */
   int dns_cache_timeout; /* DNS cache timeout (seconds) */
+  int dns_neg_timeout; /* seconds failed resolves are cached */
+  int dns_stale_timeout; /* seconds expired DNS entries are still used */
   unsigned int buffer_size;      /* size of receive buffer to use */
   unsigned int upload_buffer_size; /* size of upload buffer to use,
                                       keep it >= CURL_MAX_WRITE_SIZE */
@@ -1565,6 +1606,7 @@ struct UserDefined {
   BIT(sep_headers);     /* handle host and proxy headers separately */
 #ifndef CURL_DISABLE_COOKIES
   BIT(cookiesession);   /* new cookie session? */
+  BIT(cookiejournal);   /* append changed cookies to the jar */
 #endif
   BIT(crlf);            /* convert crlf on ftp upload(?) */
 #ifdef USE_SSH
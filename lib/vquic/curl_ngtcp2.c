@@ -166,14 +166,15 @@ struct cf_ngtcp2_ctx {
 
 static void h3_stream_hash_free(unsigned int id, void *stream);
 
-static void cf_ngtcp2_ctx_init(struct cf_ngtcp2_ctx *ctx)
+static void cf_ngtcp2_ctx_init(struct cf_ngtcp2_ctx *ctx,
+                               struct Curl_easy *data)
 {
   DEBUGASSERT(!ctx->initialized);
   ctx->qlogfd = -1;
   ctx->version = NGTCP2_PROTO_VER_MAX;
   ctx->max_stream_window = H3_STREAM_WINDOW_SIZE;
-  Curl_bufcp_init(&ctx->stream_bufcp, H3_STREAM_CHUNK_SIZE,
-                  H3_STREAM_POOL_SPARES);
+  Curl_bufcp_init2(&ctx->stream_bufcp, Curl_multi_bufcache(data),
+                   H3_STREAM_CHUNK_SIZE, H3_STREAM_POOL_SPARES);
   curlx_dyn_init(&ctx->scratch, CURL_MAX_HTTP_HEADER);
   Curl_uint_hash_init(&ctx->streams, 63, h3_stream_hash_free);
   ctx->initialized = TRUE;
@@ -1721,7 +1722,8 @@ static CURLcode cf_progress_ingress(struct Curl_cfilter *cf,
   if(result)
     return result;
 
-  return vquic_recv_packets(cf, data, &ctx->q, 1000, recv_pkt, pktx);
+  return vquic_recv_packets(cf, data, &ctx->q, VQUIC_MAX_RECV_PKTS,
+                            recv_pkt, pktx);
 }
 
 /**
@@ -2654,6 +2656,9 @@ static CURLcode cf_ngtcp2_query(struct Curl_cfilter *cf,
   case CF_QUERY_HTTP_VERSION:
     *pres1 = 30;
     return CURLE_OK;
+  case CF_QUERY_UDP_IO_STATS:
+    *((struct udp_io_stats *)pres2) = ctx->q.stats;
+    return CURLE_OK;
   case CF_QUERY_SSL_INFO:
   case CF_QUERY_SSL_CTX_INFO: {
     struct curl_tlssessioninfo *info = pres2;
@@ -2746,13 +2751,12 @@ CURLcode Curl_cf_ngtcp2_create(struct Curl_cfilter **pcf,
   struct Curl_cfilter *cf = NULL, *udp_cf = NULL;
   CURLcode result;
 
-  (void)data;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx) {
     result = CURLE_OUT_OF_MEMORY;
     goto out;
   }
-  cf_ngtcp2_ctx_init(ctx);
+  cf_ngtcp2_ctx_init(ctx, data);
 
   result = Curl_cf_create(&cf, &Curl_cft_http3, ctx);
   if(result)
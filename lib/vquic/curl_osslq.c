@@ -302,11 +302,12 @@ struct cf_osslq_ctx {
 
 static void h3_stream_hash_free(unsigned int id, void *stream);
 
-static void cf_osslq_ctx_init(struct cf_osslq_ctx *ctx)
+static void cf_osslq_ctx_init(struct cf_osslq_ctx *ctx,
+                              struct Curl_easy *data)
 {
   DEBUGASSERT(!ctx->initialized);
-  Curl_bufcp_init(&ctx->stream_bufcp, H3_STREAM_CHUNK_SIZE,
-                  H3_STREAM_POOL_SPARES);
+  Curl_bufcp_init2(&ctx->stream_bufcp, Curl_multi_bufcache(data),
+                   H3_STREAM_CHUNK_SIZE, H3_STREAM_POOL_SPARES);
   Curl_uint_hash_init(&ctx->streams, 63, h3_stream_hash_free);
   ctx->poll_items = NULL;
   ctx->curl_items = NULL;
@@ -2397,13 +2398,12 @@ CURLcode Curl_cf_osslq_create(struct Curl_cfilter **pcf,
   struct Curl_cfilter *cf = NULL, *udp_cf = NULL;
   CURLcode result;
 
-  (void)data;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx) {
     result = CURLE_OUT_OF_MEMORY;
     goto out;
   }
-  cf_osslq_ctx_init(ctx);
+  cf_osslq_ctx_init(ctx, data);
 
   result = Curl_cf_create(&cf, &Curl_cft_http3, ctx);
   if(result)
@@ -117,7 +117,8 @@ static void quiche_debug_log(const char *line, void *argp)
 
 static void h3_stream_hash_free(unsigned int id, void *stream);
 
-static void cf_quiche_ctx_init(struct cf_quiche_ctx *ctx)
+static void cf_quiche_ctx_init(struct cf_quiche_ctx *ctx,
+                               struct Curl_easy *data)
 {
   DEBUGASSERT(!ctx->initialized);
 #ifdef DEBUG_QUICHE
@@ -126,8 +127,8 @@ static void cf_quiche_ctx_init(struct cf_quiche_ctx *ctx)
     debug_log_init = 1;
   }
 #endif
-  Curl_bufcp_init(&ctx->stream_bufcp, H3_STREAM_CHUNK_SIZE,
-                  H3_STREAM_POOL_SPARES);
+  Curl_bufcp_init2(&ctx->stream_bufcp, Curl_multi_bufcache(data),
+                   H3_STREAM_CHUNK_SIZE, H3_STREAM_POOL_SPARES);
   Curl_uint_hash_init(&ctx->streams, 63, h3_stream_hash_free);
   ctx->data_recvd = 0;
   ctx->initialized = TRUE;
@@ -691,7 +692,8 @@ static CURLcode cf_process_ingress(struct Curl_cfilter *cf,
   rctx.data = data;
   rctx.pkts = 0;
 
-  result = vquic_recv_packets(cf, data, &ctx->q, 1000, recv_pkt, &rctx);
+  result = vquic_recv_packets(cf, data, &ctx->q, VQUIC_MAX_RECV_PKTS,
+                              recv_pkt, &rctx);
   if(result)
     return result;
 
@@ -1547,6 +1549,9 @@ static CURLcode cf_quiche_query(struct Curl_cfilter *cf,
   case CF_QUERY_HTTP_VERSION:
     *pres1 = 30;
     return CURLE_OK;
+  case CF_QUERY_UDP_IO_STATS:
+    *((struct udp_io_stats *)pres2) = ctx->q.stats;
+    return CURLE_OK;
   case CF_QUERY_SSL_INFO:
   case CF_QUERY_SSL_CTX_INFO: {
     struct curl_tlssessioninfo *info = pres2;
@@ -1633,14 +1638,13 @@ CURLcode Curl_cf_quiche_create(struct Curl_cfilter **pcf,
   struct Curl_cfilter *cf = NULL, *udp_cf = NULL;
   CURLcode result;
 
-  (void)data;
   (void)conn;
   ctx = calloc(1, sizeof(*ctx));
   if(!ctx) {
     result = CURLE_OUT_OF_MEMORY;
     goto out;
   }
-  cf_quiche_ctx_init(ctx);
+  cf_quiche_ctx_init(ctx, data);
 
   result = Curl_cf_create(&cf, &Curl_cft_http3, ctx);
   if(result)
@@ -158,6 +158,7 @@ static CURLcode do_sendmsg(struct Curl_cfilter *cf,
   while((sent = sendmsg(qctx->sockfd, &msg, 0)) == -1 &&
         SOCKERRNO == SOCKEINTR)
     ;
+  qctx->stats.send_calls++;
 
   if(sent == -1) {
     switch(SOCKERRNO) {
@@ -185,6 +186,8 @@ static CURLcode do_sendmsg(struct Curl_cfilter *cf,
   }
   else {
     assert(pktlen == (size_t)sent);
+    qctx->stats.pkts_sent += (pktlen > gsolen) ?
+      (curl_off_t)((pktlen + gsolen - 1) / gsolen) : 1;
   }
 #else
   ssize_t sent;
@@ -196,6 +199,7 @@ static CURLcode do_sendmsg(struct Curl_cfilter *cf,
                      (const char *)pkt, (SEND_TYPE_ARG3)pktlen, 0)) == -1 &&
         SOCKERRNO == SOCKEINTR)
     ;
+  qctx->stats.send_calls++;
 
   if(sent == -1) {
     if(SOCKERRNO == EAGAIN || SOCKERRNO == SOCKEWOULDBLOCK) {
@@ -210,6 +214,8 @@ static CURLcode do_sendmsg(struct Curl_cfilter *cf,
          lost. */
     }
   }
+  else
+    qctx->stats.pkts_sent++;
 #endif
   (void)cf;
   *psent = pktlen;
@@ -217,12 +223,77 @@ static CURLcode do_sendmsg(struct Curl_cfilter *cf,
   return CURLE_OK;
 }
 
+#ifdef HAVE_SENDMMSG
+/* Send the `gsolen` sized packets in `pkt` as separate datagrams, up to
+ * VQUIC_MMSG_BATCH of them in one system call. */
+static CURLcode sendmmsg_packets(struct Curl_cfilter *cf,
+                                 struct Curl_easy *data,
+                                 struct cf_quic_ctx *qctx,
+                                 const uint8_t *pkt, size_t pktlen,
+                                 size_t gsolen, size_t *psent)
+{
+  struct iovec msg_iov[VQUIC_MMSG_BATCH];
+  struct mmsghdr mmsg[VQUIC_MMSG_BATCH];
+  const uint8_t *p, *end = pkt + pktlen;
+  int i, n, mcount;
+
+  (void)cf;
+  *psent = 0;
+
+  while(*psent < pktlen) {
+    memset(&mmsg, 0, sizeof(mmsg));
+    p = pkt + *psent;
+    for(n = 0; (n < VQUIC_MMSG_BATCH) && (p < end); ++n) {
+      size_t len = CURLMIN(gsolen, (size_t)(end - p));
+      msg_iov[n].iov_base = (uint8_t *)CURL_UNCONST(p);
+      msg_iov[n].iov_len = len;
+      mmsg[n].msg_hdr.msg_iov = &msg_iov[n];
+      mmsg[n].msg_hdr.msg_iovlen = 1;
+      p += len;
+    }
+
+    while((mcount = sendmmsg(qctx->sockfd, mmsg, (unsigned int)n, 0)) == -1 &&
+          SOCKERRNO == SOCKEINTR)
+      ;
+    qctx->stats.send_calls++;
+
+    if(mcount == -1) {
+      switch(SOCKERRNO) {
+      case EAGAIN:
+#if EAGAIN != SOCKEWOULDBLOCK
+      case SOCKEWOULDBLOCK:
+#endif
+        return CURLE_AGAIN;
+      case SOCKEMSGSIZE:
+        /* The first datagram is too large; caused by PMTUD. Just let it
+           be lost. */
+        mcount = 1;
+        break;
+      default:
+        failf(data, "sendmmsg() returned %d (errno %d)", mcount, SOCKERRNO);
+        return CURLE_SEND_ERROR;
+      }
+    }
+    else
+      qctx->stats.pkts_sent += mcount;
+
+    for(i = 0; i < mcount; ++i)
+      *psent += msg_iov[i].iov_len;
+  }
+
+  return CURLE_OK;
+}
+#endif /* HAVE_SENDMMSG */
+
 static CURLcode send_packet_no_gso(struct Curl_cfilter *cf,
                                    struct Curl_easy *data,
                                    struct cf_quic_ctx *qctx,
                                    const uint8_t *pkt, size_t pktlen,
                                    size_t gsolen, size_t *psent)
 {
+#ifdef HAVE_SENDMMSG
+  return sendmmsg_packets(cf, data, qctx, pkt, pktlen, gsolen, psent);
+#else
   const uint8_t *p, *end = pkt + pktlen;
   size_t sent;
 
@@ -238,6 +309,7 @@ static CURLcode send_packet_no_gso(struct Curl_cfilter *cf,
   }
 
   return CURLE_OK;
+#endif
 }
 
 static CURLcode vquic_send_packets(struct Curl_cfilter *cf,
@@ -362,11 +434,10 @@ static CURLcode recvmmsg_packets(struct Curl_cfilter *cf,
                                  size_t max_pkts,
                                  vquic_recv_pkt_cb *recv_cb, void *userp)
 {
-#define MMSG_NUM  16
-  struct iovec msg_iov[MMSG_NUM];
-  struct mmsghdr mmsg[MMSG_NUM];
-  uint8_t msg_ctrl[MMSG_NUM * CMSG_SPACE(sizeof(int))];
-  struct sockaddr_storage remote_addr[MMSG_NUM];
+  struct iovec msg_iov[VQUIC_MMSG_BATCH];
+  struct mmsghdr mmsg[VQUIC_MMSG_BATCH];
+  uint8_t msg_ctrl[VQUIC_MMSG_BATCH * CMSG_SPACE(sizeof(int))];
+  struct sockaddr_storage remote_addr[VQUIC_MMSG_BATCH];
   size_t total_nread = 0, pkts = 0;
   int mcount, i, n;
   char errstr[STRERROR_LEN];
@@ -378,7 +449,8 @@ static CURLcode recvmmsg_packets(struct Curl_cfilter *cf,
   uint8_t (*bufs)[64*1024] = NULL;
 
   DEBUGASSERT(max_pkts > 0);
-  result = Curl_multi_xfer_sockbuf_borrow(data, MMSG_NUM * sizeof(bufs[0]),
+  result = Curl_multi_xfer_sockbuf_borrow(data,
+                                          VQUIC_MMSG_BATCH * sizeof(bufs[0]),
                                           &sockbuf);
   if(result)
     goto out;
@@ -386,7 +458,7 @@ static CURLcode recvmmsg_packets(struct Curl_cfilter *cf,
 
   total_nread = 0;
   while(pkts < max_pkts) {
-    n = (int)CURLMIN(CURLMIN(MMSG_NUM, IOV_MAX), max_pkts);
+    n = (int)CURLMIN(CURLMIN(VQUIC_MMSG_BATCH, IOV_MAX), max_pkts);
     memset(&mmsg, 0, sizeof(mmsg));
     for(i = 0; i < n; ++i) {
       msg_iov[i].iov_base = bufs[i];
@@ -402,6 +474,7 @@ static CURLcode recvmmsg_packets(struct Curl_cfilter *cf,
     while((mcount = recvmmsg(qctx->sockfd, mmsg, n, 0, NULL)) == -1 &&
           SOCKERRNO == SOCKEINTR)
       ;
+    qctx->stats.recv_calls++;
     if(mcount == -1) {
       if(SOCKERRNO == EAGAIN || SOCKERRNO == SOCKEWOULDBLOCK) {
         CURL_TRC_CF(data, cf, "ingress, recvmmsg -> EAGAIN");
@@ -451,6 +524,7 @@ static CURLcode recvmmsg_packets(struct Curl_cfilter *cf,
   }
 
 out:
+  qctx->stats.pkts_recvd += (curl_off_t)pkts;
   if(total_nread || result)
     CURL_TRC_CF(data, cf, "recvd %zu packets with %zu bytes -> %d",
                 pkts, total_nread, result);
@@ -495,6 +569,7 @@ static CURLcode recvmsg_packets(struct Curl_cfilter *cf,
     while((nread = recvmsg(qctx->sockfd, &msg, 0)) == -1 &&
           SOCKERRNO == SOCKEINTR)
       ;
+    qctx->stats.recv_calls++;
     if(nread == -1) {
       if(SOCKERRNO == EAGAIN || SOCKERRNO == SOCKEWOULDBLOCK) {
         goto out;
@@ -540,6 +615,7 @@ static CURLcode recvmsg_packets(struct Curl_cfilter *cf,
   }
 
 out:
+  qctx->stats.pkts_recvd += (curl_off_t)pkts;
   if(total_nread || result)
     CURL_TRC_CF(data, cf, "recvd %zu packets with %zu bytes -> %d",
                 pkts, total_nread, result);
@@ -569,6 +645,7 @@ static CURLcode recvfrom_packets(struct Curl_cfilter *cf,
                             &remote_addrlen)) == -1 &&
           SOCKERRNO == SOCKEINTR)
       ;
+    qctx->stats.recv_calls++;
     if(nread == -1) {
       if(SOCKERRNO == EAGAIN || SOCKERRNO == SOCKEWOULDBLOCK) {
         CURL_TRC_CF(data, cf, "ingress, recvfrom -> EAGAIN");
@@ -598,6 +675,7 @@ static CURLcode recvfrom_packets(struct Curl_cfilter *cf,
   }
 
 out:
+  qctx->stats.pkts_recvd += (curl_off_t)pkts;
   if(total_nread || result)
     CURL_TRC_CF(data, cf, "recvd %zu packets with %zu bytes -> %d",
                 pkts, total_nread, result);
@@ -605,6 +683,27 @@ out:
 }
 #endif /* !HAVE_SENDMMSG && !HAVE_SENDMSG */
 
+/* Have the kernel coalesce received datagrams of the connection into
+ * larger buffers. The receive functions split them up again. */
+static void vquic_enable_gro(struct Curl_cfilter *cf,
+                             struct Curl_easy *data,
+                             struct cf_quic_ctx *qctx)
+{
+#if defined(__linux__) && defined(UDP_GRO) && \
+  (defined(HAVE_SENDMMSG) || defined(HAVE_SENDMSG))
+  int on = 1;
+  if(setsockopt(qctx->sockfd, IPPROTO_UDP, UDP_GRO,
+                (void *)&on, sizeof(on)) == -1)
+    CURL_TRC_CF(data, cf, "UDP_GRO not available (errno %d)", SOCKERRNO);
+  else
+    CURL_TRC_CF(data, cf, "UDP_GRO enabled");
+#else
+  (void)cf;
+  (void)data;
+#endif
+  qctx->gro_tried = TRUE;
+}
+
 CURLcode vquic_recv_packets(struct Curl_cfilter *cf,
                             struct Curl_easy *data,
                             struct cf_quic_ctx *qctx,
@@ -612,6 +711,8 @@ CURLcode vquic_recv_packets(struct Curl_cfilter *cf,
                             vquic_recv_pkt_cb *recv_cb, void *userp)
 {
   CURLcode result;
+  if(!qctx->gro_tried)
+    vquic_enable_gro(cf, data, qctx);
 #ifdef HAVE_SENDMMSG
   result = recvmmsg_packets(cf, data, qctx, max_pkts, recv_cb, userp);
 #elif defined(HAVE_SENDMSG)
@@ -32,6 +32,17 @@
 #define MAX_PKT_BURST 10
 #define MAX_UDP_PAYLOAD_SIZE  1452
 
+/* Number of datagrams received or sent in one recvmmsg()/sendmmsg() call.
+ * Receiving needs a 64KB buffer per datagram. */
+#ifndef VQUIC_MMSG_BATCH
+#define VQUIC_MMSG_BATCH 16
+#endif
+
+/* Max number of packets to take in from the socket in one go */
+#ifndef VQUIC_MAX_RECV_PKTS
+#define VQUIC_MAX_RECV_PKTS 1000
+#endif
+
 struct cf_quic_ctx {
   curl_socket_t sockfd; /* connected UDP socket */
   struct sockaddr_storage local_addr; /* address socket is bound to */
@@ -44,11 +55,13 @@ struct cf_quic_ctx {
   size_t gsolen; /* length of individual packets in send buf */
   size_t split_len; /* if != 0, buffer length after which GSO differs */
   size_t split_gsolen; /* length of individual packets after split_len */
+  struct udp_io_stats stats; /* datagrams and system calls */
 #ifdef DEBUGBUILD
   int wblock_percent; /* percent of writes doing EAGAIN */
 #endif
   BIT(got_first_byte); /* if first byte was received */
   BIT(no_gso); /* do not use gso on sending */
+  BIT(gro_tried); /* tried to switch on UDP_GRO for the socket */
 };
 
 #define H3_STREAM_CTX(ctx,data)                                         \
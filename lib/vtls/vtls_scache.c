@@ -66,12 +66,14 @@ struct Curl_ssl_scache_peer {
   char *srp_username;
   char *srp_password;
   struct Curl_llist sessions;
+  struct Curl_llist_node lnode; /* in the scache `lru` or `free` list */
+  struct Curl_ssl_scache_peer *next; /* in the same hash slot */
+  size_t hash;             /* hash of `ssl_peer_key` when set */
   void *sobj;              /* object instance or NULL */
   Curl_ssl_scache_obj_dtor *sobj_free; /* free `sobj` callback */
   unsigned char key_salt[CURL_SHA256_DIGEST_LENGTH]; /* for entry export */
   unsigned char key_hmac[CURL_SHA256_DIGEST_LENGTH]; /* for entry export */
   size_t max_sessions;
-  long age;                /* just a number, the higher the more recent */
   BIT(hmac_set);           /* if key_salt and key_hmac are present */
   BIT(exportable);         /* sessions for this peer can be exported */
 };
@@ -80,12 +82,19 @@ struct Curl_ssl_scache_peer {
 
 #define GOOD_SCACHE(x) ((x) && (x)->magic == CURL_SCACHE_MAGIC)
 
+/* The peers with a known `ssl_peer_key` are found via a hash table on the
+ * key. Peers in use are kept in the `lru` list, the least recently used
+ * first, the others are in the `free` list. */
 struct Curl_ssl_scache {
   unsigned int magic;
   struct Curl_ssl_scache_peer *peers;
   size_t peer_count;
+  struct Curl_ssl_scache_peer **slots;
+  size_t slot_count;       /* a power of two */
+  struct Curl_llist lru;
+  struct Curl_llist free;
+  size_t keyless;          /* number of peers with only salt+hmac */
   int default_lifetime_secs;
-  long age;
 };
 
 static struct Curl_ssl_scache *cf_ssl_scache_get(struct Curl_easy *data)
@@ -178,8 +187,62 @@ void Curl_ssl_session_destroy(struct Curl_ssl_session *s)
   }
 }
 
-static void cf_ssl_scache_clear_peer(struct Curl_ssl_scache_peer *peer)
+static size_t cf_ssl_scache_hash(const char *ssl_peer_key)
 {
+  size_t h = 5381;
+
+  /* peer keys are compared case insensitively */
+  while(*ssl_peer_key) {
+    h += h << 5;
+    h ^= (size_t)Curl_raw_toupper(*ssl_peer_key++);
+  }
+  return h;
+}
+
+/* Add a peer with a known `ssl_peer_key` to the hash table */
+static void cf_ssl_scache_link_key(struct Curl_ssl_scache *scache,
+                                   struct Curl_ssl_scache_peer *peer)
+{
+  struct Curl_ssl_scache_peer **slot;
+
+  DEBUGASSERT(peer->ssl_peer_key);
+  peer->hash = cf_ssl_scache_hash(peer->ssl_peer_key);
+  slot = &scache->slots[peer->hash & (scache->slot_count - 1)];
+  peer->next = *slot;
+  *slot = peer;
+}
+
+static void cf_ssl_scache_unlink_key(struct Curl_ssl_scache *scache,
+                                     struct Curl_ssl_scache_peer *peer)
+{
+  struct Curl_ssl_scache_peer **pp =
+    &scache->slots[peer->hash & (scache->slot_count - 1)];
+
+  while(*pp != peer)
+    pp = &(*pp)->next;
+  *pp = peer->next;
+  peer->next = NULL;
+}
+
+/* Mark the peer as the most recently used one */
+static void cf_ssl_scache_peer_used(struct Curl_ssl_scache *scache,
+                                    struct Curl_ssl_scache_peer *peer)
+{
+  Curl_node_remove(&peer->lnode);
+  Curl_llist_append(&scache->lru, peer, &peer->lnode);
+}
+
+static void cf_ssl_scache_clear_peer(struct Curl_ssl_scache *scache,
+                                     struct Curl_ssl_scache_peer *peer)
+{
+  if(peer->ssl_peer_key)
+    cf_ssl_scache_unlink_key(scache, peer);
+  else if(peer->hmac_set)
+    scache->keyless--;
+  if(Curl_node_llist(&peer->lnode) != &scache->free) {
+    Curl_node_remove(&peer->lnode);
+    Curl_llist_append(&scache->free, peer, &peer->lnode);
+  }
   Curl_llist_destroy(&peer->sessions, NULL);
   if(peer->sobj) {
     DEBUGASSERT(peer->sobj_free);
@@ -194,7 +257,6 @@ static void cf_ssl_scache_clear_peer(struct Curl_ssl_scache_peer *peer)
   Curl_safefree(peer->srp_password);
 #endif
   Curl_safefree(peer->ssl_peer_key);
-  peer->age = 0;
   peer->hmac_set = FALSE;
 }
 
@@ -224,7 +286,8 @@ static void cf_ssl_cache_peer_update(struct Curl_ssl_scache_peer *peer)
 }
 
 static CURLcode
-cf_ssl_scache_peer_init(struct Curl_ssl_scache_peer *peer,
+cf_ssl_scache_peer_init(struct Curl_ssl_scache *scache,
+                        struct Curl_ssl_scache_peer *peer,
                         const char *ssl_peer_key,
                         const char *clientcert,
                         const char *srp_username,
@@ -240,11 +303,13 @@ cf_ssl_scache_peer_init(struct Curl_ssl_scache_peer *peer,
     if(!peer->ssl_peer_key)
       goto out;
     peer->hmac_set = FALSE;
+    cf_ssl_scache_link_key(scache, peer);
   }
   else if(salt && hmac) {
     memcpy(peer->key_salt, salt, sizeof(peer->key_salt));
     memcpy(peer->key_hmac, hmac, sizeof(peer->key_hmac));
     peer->hmac_set = TRUE;
+    scache->keyless++;
   }
   else {
     result = CURLE_BAD_FUNCTION_ARGUMENT;
@@ -267,10 +332,11 @@ cf_ssl_scache_peer_init(struct Curl_ssl_scache_peer *peer,
   }
 
   cf_ssl_cache_peer_update(peer);
+  cf_ssl_scache_peer_used(scache, peer);
   result = CURLE_OK;
 out:
   if(result)
-    cf_ssl_scache_clear_peer(peer);
+    cf_ssl_scache_clear_peer(scache, peer);
   return result;
 }
 
@@ -317,16 +383,19 @@ CURLcode Curl_ssl_scache_create(size_t max_peers,
 {
   struct Curl_ssl_scache *scache;
   struct Curl_ssl_scache_peer *peers;
-  size_t i;
+  struct Curl_ssl_scache_peer **slots;
+  size_t i, slot_count = 1;
 
   *pscache = NULL;
+  while(slot_count < max_peers)
+    slot_count <<= 1;
   peers = calloc(max_peers, sizeof(*peers));
-  if(!peers)
-    return CURLE_OUT_OF_MEMORY;
-
+  slots = calloc(slot_count, sizeof(*slots));
   scache = calloc(1, sizeof(*scache));
-  if(!scache) {
+  if(!peers || !slots || !scache) {
     free(peers);
+    free(slots);
+    free(scache);
     return CURLE_OUT_OF_MEMORY;
   }
 
@@ -334,11 +403,16 @@ CURLcode Curl_ssl_scache_create(size_t max_peers,
   scache->default_lifetime_secs = (24*60*60); /* 1 day */
   scache->peer_count = max_peers;
   scache->peers = peers;
-  scache->age = 1;
+  scache->slot_count = slot_count;
+  scache->slots = slots;
+  Curl_llist_init(&scache->lru, NULL);
+  Curl_llist_init(&scache->free, NULL);
   for(i = 0; i < scache->peer_count; ++i) {
     scache->peers[i].max_sessions = max_sessions_per_peer;
     Curl_llist_init(&scache->peers[i].sessions,
                     cf_ssl_scache_session_ldestroy);
+    Curl_llist_append(&scache->free, &scache->peers[i],
+                      &scache->peers[i].lnode);
   }
 
   *pscache = scache;
@@ -351,9 +425,10 @@ void Curl_ssl_scache_destroy(struct Curl_ssl_scache *scache)
     size_t i;
     scache->magic = 0;
     for(i = 0; i < scache->peer_count; ++i) {
-      cf_ssl_scache_clear_peer(&scache->peers[i]);
+      cf_ssl_scache_clear_peer(scache, &scache->peers[i]);
     }
     free(scache->peers);
+    free(scache->slots);
     free(scache);
   }
 }
@@ -632,7 +707,10 @@ cf_ssl_find_peer_by_key(struct Curl_easy *data,
                         struct ssl_primary_config *conn_config,
                         struct Curl_ssl_scache_peer **ppeer)
 {
-  size_t i, peer_key_len = 0;
+  struct Curl_ssl_scache_peer *peer;
+  struct Curl_llist_node *n;
+  size_t peer_key_len = 0;
+  size_t hash;
   CURLcode result = CURLE_OK;
 
   *ppeer = NULL;
@@ -644,47 +722,56 @@ cf_ssl_find_peer_by_key(struct Curl_easy *data,
                 ssl_peer_key, scache->peer_count);
 
   /* check for entries with known peer_key */
-  for(i = 0; scache && i < scache->peer_count; i++) {
-    if(scache->peers[i].ssl_peer_key &&
-       curl_strequal(ssl_peer_key, scache->peers[i].ssl_peer_key) &&
-       cf_ssl_scache_match_auth(&scache->peers[i], conn_config)) {
+  hash = cf_ssl_scache_hash(ssl_peer_key);
+  for(peer = scache->slots[hash & (scache->slot_count - 1)]; peer;
+      peer = peer->next) {
+    if((peer->hash == hash) &&
+       curl_strequal(ssl_peer_key, peer->ssl_peer_key) &&
+       cf_ssl_scache_match_auth(peer, conn_config)) {
       /* yes, we have a cached session for this! */
-      *ppeer = &scache->peers[i];
+      *ppeer = peer;
       goto out;
     }
   }
+  if(!scache->keyless)
+    goto notfound;
+
   /* check for entries with HMAC set but no known peer_key */
-  for(i = 0; scache && i < scache->peer_count; i++) {
-    if(!scache->peers[i].ssl_peer_key &&
-       scache->peers[i].hmac_set &&
-       cf_ssl_scache_match_auth(&scache->peers[i], conn_config)) {
+  for(n = Curl_llist_head(&scache->lru); n; n = Curl_node_next(n)) {
+    peer = Curl_node_elem(n);
+    if(!peer->ssl_peer_key &&
+       peer->hmac_set &&
+       cf_ssl_scache_match_auth(peer, conn_config)) {
       /* possible entry with unknown peer_key, check hmac */
       unsigned char my_hmac[CURL_SHA256_DIGEST_LENGTH];
       if(!peer_key_len) /* we are lazy */
         peer_key_len = strlen(ssl_peer_key);
       result = Curl_hmacit(&Curl_HMAC_SHA256,
-                           scache->peers[i].key_salt,
-                           sizeof(scache->peers[i].key_salt),
+                           peer->key_salt,
+                           sizeof(peer->key_salt),
                            (const unsigned char *)ssl_peer_key,
                            peer_key_len,
                            my_hmac);
       if(result)
         goto out;
-      if(!memcmp(scache->peers[i].key_hmac, my_hmac, sizeof(my_hmac))) {
+      if(!memcmp(peer->key_hmac, my_hmac, sizeof(my_hmac))) {
         /* remember peer_key for future lookups */
         CURL_TRC_SSLS(data, "peer entry %zu key recovered: %s",
-                      i, ssl_peer_key);
-        scache->peers[i].ssl_peer_key = strdup(ssl_peer_key);
-        if(!scache->peers[i].ssl_peer_key) {
+                      (size_t)(peer - scache->peers), ssl_peer_key);
+        peer->ssl_peer_key = strdup(ssl_peer_key);
+        if(!peer->ssl_peer_key) {
           result = CURLE_OUT_OF_MEMORY;
           goto out;
         }
-        cf_ssl_cache_peer_update(&scache->peers[i]);
-        *ppeer = &scache->peers[i];
+        scache->keyless--;
+        cf_ssl_scache_link_key(scache, peer);
+        cf_ssl_cache_peer_update(peer);
+        *ppeer = peer;
         goto out;
       }
     }
   }
+notfound:
   CURL_TRC_SSLS(data, "peer not found for %s", ssl_peer_key);
 out:
   return result;
@@ -693,30 +780,18 @@ out:
 static struct Curl_ssl_scache_peer *
 cf_ssl_get_free_peer(struct Curl_ssl_scache *scache)
 {
+  struct Curl_llist_node *n;
   struct Curl_ssl_scache_peer *peer = NULL;
-  size_t i;
 
-  /* find empty or oldest peer */
-  for(i = 0; i < scache->peer_count; ++i) {
-    /* free peer entry? */
-    if(!scache->peers[i].ssl_peer_key && !scache->peers[i].hmac_set) {
-      peer = &scache->peers[i];
-      break;
-    }
-    /* peer without sessions and obj */
-    if(!scache->peers[i].sobj &&
-       !Curl_llist_count(&scache->peers[i].sessions)) {
-      peer = &scache->peers[i];
-      break;
-    }
-    /* remember "oldest" peer */
-    if(!peer || (scache->peers[i].age < peer->age)) {
-      peer = &scache->peers[i];
-    }
+  /* a free peer entry or else the least recently used one */
+  n = Curl_llist_head(&scache->free);
+  if(!n)
+    n = Curl_llist_head(&scache->lru);
+  DEBUGASSERT(n);
+  if(n) {
+    peer = Curl_node_elem(n);
+    cf_ssl_scache_clear_peer(scache, peer);
   }
-  DEBUGASSERT(peer);
-  if(peer)
-    cf_ssl_scache_clear_peer(peer);
   return peer;
 }
 
@@ -739,6 +814,7 @@ cf_ssl_add_peer(struct Curl_easy *data,
   }
 
   if(peer) {
+    cf_ssl_scache_peer_used(scache, peer);
     *ppeer = peer;
     return CURLE_OK;
   }
@@ -751,7 +827,7 @@ cf_ssl_add_peer(struct Curl_easy *data,
     username = conn_config ? conn_config->username : NULL;
     password = conn_config ? conn_config->password : NULL;
 #endif
-    result = cf_ssl_scache_peer_init(peer, ssl_peer_key, ccert,
+    result = cf_ssl_scache_peer_init(scache, peer, ssl_peer_key, ccert,
                                      username, password, NULL, NULL);
     if(result)
       goto out;
@@ -762,7 +838,7 @@ cf_ssl_add_peer(struct Curl_easy *data,
 
 out:
   if(result) {
-    cf_ssl_scache_clear_peer(peer);
+    cf_ssl_scache_clear_peer(scache, peer);
   }
   return result;
 }
@@ -901,8 +977,13 @@ CURLcode Curl_ssl_scache_take(struct Curl_cfilter *cf,
     n = Curl_llist_head(&peer->sessions);
     if(n) {
       s = Curl_node_take_elem(n);
-      (scache->age)++;            /* increase general age */
-      peer->age = scache->age; /* set this as used in this age */
+      if(Curl_llist_count(&peer->sessions) || peer->sobj)
+        cf_ssl_scache_peer_used(scache, peer);
+      else {
+        /* nothing left to resume with, make it the first to reuse */
+        Curl_node_remove(&peer->lnode);
+        Curl_llist_insert_next(&scache->lru, NULL, peer, &peer->lnode);
+      }
     }
   }
   Curl_ssl_scache_unlock(data);
@@ -996,7 +1077,7 @@ void Curl_ssl_scache_remove_all(struct Curl_cfilter *cf,
   result = cf_ssl_find_peer_by_key(data, scache, ssl_peer_key, conn_config,
                                    &peer);
   if(!result && peer)
-    cf_ssl_scache_clear_peer(peer);
+    cf_ssl_scache_clear_peer(scache, peer);
   Curl_ssl_scache_unlock(data);
 }
 
@@ -1126,7 +1207,7 @@ CURLcode Curl_ssl_session_import(struct Curl_easy *data,
     if(!peer) {
       peer = cf_ssl_get_free_peer(scache);
       if(peer) {
-        r = cf_ssl_scache_peer_init(peer, ssl_peer_key, NULL,
+        r = cf_ssl_scache_peer_init(scache, peer, ssl_peer_key, NULL,
                                     NULL, NULL, salt, hmac);
         if(r)
           goto out;
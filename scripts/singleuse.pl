@@ -111,13 +111,16 @@ my %api = (
     'curl_multi_cleanup' => 'API',
     'curl_multi_fdset' => 'API',
     'curl_multi_get_handles' => 'API',
+    'curl_multi_get_offt' => 'API',
     'curl_multi_info_read' => 'API',
     'curl_multi_init' => 'API',
     'curl_multi_perform' => 'API',
+    'curl_multi_prewarm' => 'API',
     'curl_multi_remove_handle' => 'API',
     'curl_multi_setopt' => 'API',
     'curl_multi_socket' => 'API',
     'curl_multi_socket_action' => 'API',
+    'curl_multi_socket_actions' => 'API',
     'curl_multi_socket_all' => 'API',
     'curl_multi_poll' => 'API',
     'curl_multi_strerror' => 'API',
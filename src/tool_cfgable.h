@@ -347,6 +347,9 @@ struct GlobalConfig {
   FILE *trace_stream;
   char *libcurl;                  /* Output libcurl code to this filename */
   char *ssl_sessions;             /* file to load/save SSL session tickets */
+  char **ssls_loaded;             /* salt+hmac of the loaded tickets, sorted */
+  size_t ssls_loaded_count;
+  size_t ssls_loaded_size;
   char *knownhosts;               /* known host path, if set. curl_free()
                                      this */
   struct tool_var *variables;
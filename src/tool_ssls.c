@@ -23,6 +23,11 @@
  ***************************************************************************/
 #include "tool_setup.h"
 
+#ifdef HAVE_FCNTL_H
+/* for open() and fcntl() */
+#include <fcntl.h>
+#endif
+
 #include "tool_cfgable.h"
 #include "tool_cb_dbg.h"
 #include "tool_msgs.h"
@@ -32,6 +37,73 @@
 
 /* The maximum line length for an ecoded session ticket */
 #define MAX_SSLS_LINE (64 * 1024)
+/* The maximum amount of tickets from other processes kept on save */
+#define MAX_SSLS_OTHERS (64 * 1024 * 1024)
+
+#ifdef _WIN32
+#define OPENMODE S_IREAD | S_IWRITE
+#else
+#define OPENMODE S_IRUSR | S_IWUSR
+#endif
+
+#if defined(HAVE_FCNTL) && defined(F_SETLKW)
+/* Take an advisory lock on the session file, waiting for other curl
+ * processes to finish reading or writing it. The lock is released when
+ * the file is closed. */
+static void tool_ssls_lock(int fd, bool exclusive)
+{
+  struct flock lck;
+  memset(&lck, 0, sizeof(lck));
+  lck.l_type = exclusive ? F_WRLCK : F_RDLCK;
+  lck.l_whence = SEEK_SET;
+  /* !checksrc! disable ERRNOVAR 1 */
+  while((fcntl(fd, F_SETLKW, &lck) == -1) && (errno == EINTR))
+    ;
+}
+#else
+#define tool_ssls_lock(x,y) Curl_nop_stmt
+#endif
+
+static int tool_ssls_strcmp(const void *a, const void *b)
+{
+  return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Remember the salt+hmac of a ticket line loaded from the file */
+static CURLcode tool_ssls_loaded(struct GlobalConfig *global,
+                                 const char *shmac)
+{
+  if(global->ssls_loaded_count == global->ssls_loaded_size) {
+    size_t n = global->ssls_loaded_size ? global->ssls_loaded_size * 2 : 32;
+    char **p = realloc(global->ssls_loaded, n * sizeof(char *));
+    if(!p)
+      return CURLE_OUT_OF_MEMORY;
+    global->ssls_loaded = p;
+    global->ssls_loaded_size = n;
+  }
+  global->ssls_loaded[global->ssls_loaded_count] = strdup(shmac);
+  if(!global->ssls_loaded[global->ssls_loaded_count])
+    return CURLE_OUT_OF_MEMORY;
+  global->ssls_loaded_count++;
+  return CURLE_OK;
+}
+
+static bool tool_ssls_was_loaded(struct GlobalConfig *global,
+                                 const char *shmac)
+{
+  return global->ssls_loaded_count &&
+         bsearch(&shmac, global->ssls_loaded, global->ssls_loaded_count,
+                 sizeof(char *), tool_ssls_strcmp);
+}
+
+static void tool_ssls_loaded_free(struct GlobalConfig *global)
+{
+  size_t i;
+  for(i = 0; i < global->ssls_loaded_count; ++i)
+    free(global->ssls_loaded[i]);
+  tool_safefree(global->ssls_loaded);
+  global->ssls_loaded_count = global->ssls_loaded_size = 0;
+}
 
 
 static CURLcode tool_ssls_easy(struct OperationConfig *config,
@@ -73,6 +145,7 @@ CURLcode tool_ssls_load(struct OperationConfig *config,
     notef(global, "SSL session file does not exist (yet?): %s", filename);
     goto out;
   }
+  tool_ssls_lock(fileno(fp), FALSE);
 
   r = tool_ssls_easy(config, share, &easy);
   if(r)
@@ -92,6 +165,9 @@ CURLcode tool_ssls_load(struct OperationConfig *config,
       continue;
     }
     *c = '\0';
+    r = tool_ssls_loaded(global, line);
+    if(r)
+      goto out;
     r = curlx_base64_decode(line, &shmac, &shmac_len);
     if(r) {
       warnf(global, "invalid shmax base64 encoding in line %d", i);
@@ -122,6 +198,11 @@ CURLcode tool_ssls_load(struct OperationConfig *config,
     r = CURLE_OK;
 
 out:
+  if(r)
+    tool_ssls_loaded_free(global);
+  else if(global->ssls_loaded_count)
+    qsort(global->ssls_loaded, global->ssls_loaded_count, sizeof(char *),
+          tool_ssls_strcmp);
   if(easy)
     curl_easy_cleanup(easy);
   if(fp)
@@ -136,8 +217,18 @@ struct tool_ssls_ctx {
   struct GlobalConfig *global;
   FILE *fp;
   int exported;
+  BIT(header);
 };
 
+static void tool_ssls_header(struct tool_ssls_ctx *ctx)
+{
+  if(!ctx->header)
+    fputs("# Your SSL session cache. https://curl.se/docs/ssl-sessions.html\n"
+        "# This file was generated by libcurl! Edit at your own risk.\n",
+        ctx->fp);
+  ctx->header = TRUE;
+}
+
 static CURLcode tool_ssls_exp(CURL *easy, void *userptr,
                               const char *session_key,
                               const unsigned char *shmac, size_t shmac_len,
@@ -155,10 +246,7 @@ static CURLcode tool_ssls_exp(CURL *easy, void *userptr,
   (void)ietf_tls_id;
   (void)alpn;
   (void)earlydata_max;
-  if(!ctx->exported)
-    fputs("# Your SSL session cache. https://curl.se/docs/ssl-sessions.html\n"
-        "# This file was generated by libcurl! Edit at your own risk.\n",
-        ctx->fp);
+  tool_ssls_header(ctx);
 
   r = curlx_base64_encode((const char *)shmac, shmac_len, &enc, &enc_len);
   if(r)
@@ -187,15 +275,80 @@ out:
   return r;
 }
 
+/* Collect the lines of the session file that other curl processes added
+ * since it was loaded. */
+static CURLcode tool_ssls_others(struct GlobalConfig *global, FILE *fp,
+                                 const char *filename,
+                                 struct dynbuf *others)
+{
+  struct dynbuf buf;
+  bool error = FALSE;
+  CURLcode r = CURLE_OK;
+
+  curlx_dyn_init(&buf, MAX_SSLS_LINE);
+  while(!r && my_get_line(fp, &buf, &error)) {
+    char *line = curlx_dyn_ptr(&buf);
+    char *c = strchr(line, ':');
+    size_t len;
+    if((line[0] == '#') || !c)
+      continue;
+    *c = '\0';
+    if(tool_ssls_was_loaded(global, line))
+      continue; /* ours to save or to drop */
+    *c = ':';
+    len = strlen(line);
+    while(len && ((line[len - 1] == '\n') || (line[len - 1] == '\r')))
+      --len;
+    if(curlx_dyn_len(others) + len + 1 >= MAX_SSLS_OTHERS) {
+      warnf(global, "Warning: too many sessions in SSL session file, "
+            "dropping some");
+      break;
+    }
+    r = curlx_dyn_addn(others, line, len);
+    if(!r)
+      r = curlx_dyn_addn(others, "\n", 1);
+  }
+  if(!r && error) {
+    /* replacing the file would lose the sessions not read */
+    warnf(global, "Warning: failed to read SSL session file %s, "
+          "not saving sessions", filename);
+    r = CURLE_FAILED_INIT;
+  }
+  curlx_dyn_free(&buf);
+  return r;
+}
+
 CURLcode tool_ssls_save(struct OperationConfig *config,
                         CURLSH *share, const char *filename)
 {
   struct tool_ssls_ctx ctx;
+  struct dynbuf others;
+  FILE *in = NULL;
   CURL *easy = NULL;
   CURLcode r = CURLE_OK;
+  int fd;
 
   ctx.global = config->global;
   ctx.exported = 0;
+  ctx.header = FALSE;
+  ctx.fp = NULL;
+  curlx_dyn_init(&others, MAX_SSLS_OTHERS);
+
+  /* Other curl processes may have saved sessions to the file since it was
+   * loaded. Keep those, while holding a lock on the file. */
+  fd = open(filename, O_CREAT | O_RDWR | CURL_O_BINARY, OPENMODE);
+  if(fd != -1) {
+    tool_ssls_lock(fd, TRUE);
+    in = fdopen(fd, FOPEN_READTEXT);
+    if(!in)
+      close(fd);
+    else {
+      r = tool_ssls_others(config->global, in, filename, &others);
+      if(r)
+        goto out;
+    }
+  }
+
   ctx.fp = fopen(filename, FOPEN_WRITETEXT);
   if(!ctx.fp) {
     warnf(config->global, "Warning: Failed to create SSL session file %s",
@@ -208,11 +361,21 @@ CURLcode tool_ssls_save(struct OperationConfig *config,
     goto out;
 
   r = curl_easy_ssls_export(easy, tool_ssls_exp, &ctx);
+  if(!r && curlx_dyn_len(&others)) {
+    tool_ssls_header(&ctx);
+    if(fwrite(curlx_dyn_ptr(&others), 1, curlx_dyn_len(&others), ctx.fp) !=
+       curlx_dyn_len(&others))
+      r = CURLE_WRITE_ERROR;
+  }
 
 out:
   if(easy)
     curl_easy_cleanup(easy);
   if(ctx.fp)
     fclose(ctx.fp);
+  if(in)
+    fclose(in);
+  curlx_dyn_free(&others);
+  tool_ssls_loaded_free(config->global);
   return r;
 }
@@ -30,6 +30,7 @@ import json
 import logging
 import os
 import re
+import subprocess
 import sys
 from statistics import mean
 from typing import Dict, Any, Optional, List
@@ -120,6 +121,8 @@ class Card:
         if 'curl_features' in score["meta"]:
             print(f'Features: {score["meta"]["curl_features"]}')
         print(f'Samples Size: {score["meta"]["samples"]}')
+        if 'latencies' in score["meta"]:
+            print(f'Added RTT: {", ".join(f"{ms}ms" for ms in score["meta"]["latencies"])}')
         if 'handshakes' in score:
             print(f'{"Handshakes":<24} {"ipv4":25} {"ipv6":28}')
             print(f'  {"Host":<17} {"Connect":>12} {"Handshake":>12} '
@@ -188,7 +191,8 @@ class ScoreRunner:
                  server_addr: Optional[str] = None,
                  with_dtrace: bool = False,
                  with_flame: bool = False,
-                 socks_args: Optional[List[str]] = None):
+                 socks_args: Optional[List[str]] = None,
+                 latencies: Optional[List[int]] = None):
         self.verbose = verbose
         self.env = env
         self.protocol = protocol
@@ -200,6 +204,7 @@ class ScoreRunner:
         self._with_dtrace = with_dtrace
         self._with_flame = with_flame
         self._socks_args = socks_args
+        self._latencies = latencies
 
     def info(self, msg):
         if self.verbose > 0:
@@ -247,6 +252,18 @@ class ScoreRunner:
             self.info('ok.\n')
         return props
 
+    def _set_latency(self, rtt_ms: int):
+        # delay packets on the loopback device, half of it each way
+        if rtt_ms > 0:
+            cmd = ['tc', 'qdisc', 'replace', 'dev', 'lo', 'root', 'netem',
+                   'delay', f'{rtt_ms / 2}ms']
+        else:
+            cmd = ['tc', 'qdisc', 'del', 'dev', 'lo', 'root']
+        p = subprocess.run(cmd, capture_output=True, text=True)
+        if rtt_ms > 0 and p.returncode != 0:
+            raise ScoreCardError(f'unable to add latency: {" ".join(cmd)}: '
+                                 f'{p.stderr.strip()}')
+
     def _make_docs_file(self, docs_dir: str, fname: str, fsize: int):
         fpath = os.path.join(docs_dir, fname)
         data1k = 1024*'x'
@@ -349,6 +366,8 @@ class ScoreRunner:
         nsamples = meta['samples']
         max_parallel = self._download_parallel if self._download_parallel > 0 else count
         cols = ['size']
+        if self._latencies:
+            cols.append('rtt')
         if not self._download_parallel:
             cols.append('single')
             if count > 1:
@@ -356,21 +375,35 @@ class ScoreRunner:
         if count > 1:
             cols.append(f'parallel({count}x{max_parallel})')
         rows = []
-        for fsize in fsizes:
-            row = [{
-                'val': fsize,
-                'sval': Card.fmt_size(fsize)
-            }]
-            self.info(f'{row[0]["sval"]} downloads...')
-            url = f'https://{self.env.domain1}:{self.server_port}/score{row[0]["sval"]}.data'
-            if 'single' in cols:
-                row.append(self.dl_single(url=url, nsamples=nsamples))
-            if count > 1:
-                if 'single' in cols:
-                    row.append(self.dl_serial(url=url, count=count, nsamples=nsamples))
-                row.append(self.dl_parallel(url=url, count=count, nsamples=nsamples))
-            rows.append(row)
-            self.info('done.\n')
+        for rtt_ms in (self._latencies or [None]):
+            try:
+                if rtt_ms is not None:
+                    self._set_latency(rtt_ms)
+                for fsize in fsizes:
+                    row = [{
+                        'val': fsize,
+                        'sval': Card.fmt_size(fsize)
+                    }]
+                    if rtt_ms is not None:
+                        row.append({
+                            'val': rtt_ms,
+                            'sval': f'{rtt_ms}ms'
+                        })
+                        self.info(f'{row[0]["sval"]} downloads at {rtt_ms}ms...')
+                    else:
+                        self.info(f'{row[0]["sval"]} downloads...')
+                    url = f'https://{self.env.domain1}:{self.server_port}/score{row[0]["sval"]}.data'
+                    if 'single' in cols:
+                        row.append(self.dl_single(url=url, nsamples=nsamples))
+                    if count > 1:
+                        if 'single' in cols:
+                            row.append(self.dl_serial(url=url, count=count, nsamples=nsamples))
+                        row.append(self.dl_parallel(url=url, count=count, nsamples=nsamples))
+                    rows.append(row)
+                    self.info('done.\n')
+            finally:
+                if rtt_ms is not None:
+                    self._set_latency(0)
         title = f'Downloads from {meta["server"]}'
         if self._socks_args:
             title += f' via {self._socks_args}'
@@ -610,6 +643,8 @@ class ScoreRunner:
 
         if handshakes:
             score['handshakes'] = self.handshakes()
+        if self._latencies:
+            score['meta']['latencies'] = self._latencies
         if downloads and len(downloads) > 0:
             score['downloads'] = self.downloads(count=download_count,
                                                 fsizes=downloads,
@@ -653,6 +688,14 @@ def run_score(args, protocol):
         for x in args.request_parallels:
             request_parallels.extend([int(s) for s in x.split(',')])
 
+    latencies = None
+    if args.latency:
+        if args.remote:
+            sys.stderr.write('ERROR: --latency does not work with --remote\n')
+            sys.exit(1)
+        latencies = []
+        for x in args.latency:
+            latencies.extend([int(s) for s in x.split(',')])
 
     if args.downloads or args.uploads or args.requests or args.handshakes:
         handshakes = args.handshakes
@@ -737,7 +780,8 @@ def run_score(args, protocol):
                                download_parallel=args.download_parallel,
                                with_dtrace=args.dtrace,
                                with_flame=args.flame,
-                               socks_args=socks_args)
+                               socks_args=socks_args,
+                               latencies=latencies)
             card.setup_resources(server_docs, downloads)
             cards.append(card)
 
@@ -763,7 +807,8 @@ def run_score(args, protocol):
                                verbose=args.verbose, curl_verbose=args.curl_verbose,
                                download_parallel=args.download_parallel,
                                with_dtrace=args.dtrace,
-                               socks_args=socks_args)
+                               socks_args=socks_args,
+                               latencies=latencies)
             card.setup_resources(server_docs, downloads)
             cards.append(card)
 
@@ -856,6 +901,10 @@ def main():
     parser.add_argument("--download-sizes", action='append', type=str,
                         metavar='numberlist',
                         default=None, help="evaluate download size")
+    parser.add_argument("--latency", action='append', type=str,
+                        metavar='numberlist', default=None,
+                        help="evaluate downloads with these round-trip times "
+                        "in ms added on the loopback device (tc netem, root)")
     parser.add_argument("--download-count", action='store', type=int,
                         metavar='number',
                         default=50, help="perform that many downloads")
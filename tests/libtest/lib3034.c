@@ -0,0 +1,141 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+/*
+ * Benchmark the cost of a curl_multi_poll() wakeup against the number of
+ * transfers in the multi handle, once for each CURLMOPT_POLL_BACKEND.
+ *
+ * The server never answers, so all transfers sit in the PERFORMING state
+ * waiting for data. Pass the number of transfers as second argument, the
+ * timings are written to stderr.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+#define T3034_MAX_HANDLES 10000
+#define T3034_ROUNDS 1000
+
+static CURLcode t3034_run(const char *URL, long backend, const char *name,
+                          int num_handles)
+{
+  CURL **easy = NULL;
+  CURLM *multi = NULL;
+  CURLcode res = CURLE_OK;
+  CURLMcode mres;
+  struct curltime start;
+  timediff_t poll_us, loop_us;
+  unsigned int fd_count = 0;
+  int running, i, num;
+
+  start_test_timing();
+
+  easy = calloc((size_t)num_handles, sizeof(CURL *));
+  if(!easy)
+    return TEST_ERR_MAJOR_BAD;
+
+  multi_init(multi);
+
+  mres = curl_multi_setopt(multi, CURLMOPT_POLL_BACKEND, backend);
+  if(mres == CURLM_BAD_FUNCTION_ARGUMENT) {
+    curl_mfprintf(stderr, "%s: backend not supported, skipped\n", name);
+    goto test_cleanup;
+  }
+  else if(mres) {
+    res = TEST_ERR_MULTI;
+    goto test_cleanup;
+  }
+
+  for(i = 0; i < num_handles; i++) {
+    easy_init(easy[i]);
+    easy_setopt(easy[i], CURLOPT_URL, URL);
+    multi_add_handle(multi, easy[i]);
+  }
+
+  /* drive all transfers until each one waits on its socket */
+  do {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    multi_poll(multi, NULL, 0, 100, &num);
+    mres = curl_multi_waitfds(multi, NULL, 0, &fd_count);
+    if(mres) {
+      res = TEST_ERR_MULTI;
+      goto test_cleanup;
+    }
+  } while(running && (fd_count < (unsigned int)num_handles));
+
+  start = curlx_now();
+  for(i = 0; i < T3034_ROUNDS; i++)
+    multi_poll(multi, NULL, 0, 0, &num);
+  poll_us = curlx_timediff_us(curlx_now(), start);
+
+  start = curlx_now();
+  for(i = 0; i < T3034_ROUNDS; i++) {
+    multi_perform(multi, &running);
+    multi_poll(multi, NULL, 0, 0, &num);
+  }
+  loop_us = curlx_timediff_us(curlx_now(), start);
+
+  curl_mfprintf(stderr, "%s: %d transfers, poll %" CURL_FORMAT_CURL_OFF_T
+                " us/call, perform+poll %" CURL_FORMAT_CURL_OFF_T
+                " us/call\n", name, num_handles,
+                (curl_off_t)(poll_us / T3034_ROUNDS),
+                (curl_off_t)(loop_us / T3034_ROUNDS));
+
+test_cleanup:
+
+  for(i = 0; i < num_handles; i++) {
+    curl_multi_remove_handle(multi, easy[i]);
+    curl_easy_cleanup(easy[i]);
+  }
+  curl_multi_cleanup(multi);
+  free(easy);
+
+  return res;
+}
+
+static CURLcode test_lib3034(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  int num_handles = 10;
+
+  if(libtest_arg2) {
+    num_handles = atoi(libtest_arg2);
+    if(num_handles < 1 || num_handles > T3034_MAX_HANDLES) {
+      curl_mfprintf(stderr, "number of transfers out of range\n");
+      return TEST_ERR_USAGE;
+    }
+  }
+
+  global_init(CURL_GLOBAL_ALL);
+
+  res = t3034_run(URL, CURLMPOLL_DEFAULT, "poll", num_handles);
+  if(!res)
+    res = t3034_run(URL, CURLMPOLL_EPOLL, "epoll", num_handles);
+
+  curl_global_cleanup();
+
+  return res;
+}
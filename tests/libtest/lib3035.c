@@ -0,0 +1,206 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+/*
+ * Run parallel transfers with the socket callback API, handing all ready
+ * sockets to libcurl with a single curl_multi_socket_actions() call.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+#define T3035_TRANSFERS 3
+#define T3035_MAX_SOCKETS 16
+
+struct t3035_sock {
+  curl_socket_t fd;
+  int action; /* CURL_POLL_* */
+};
+
+struct t3035_ctx {
+  struct t3035_sock socks[T3035_MAX_SOCKETS];
+  int nsocks;
+  long timeout_ms;
+};
+
+static int t3035_socket_cb(CURL *easy, curl_socket_t s, int action,
+                           void *userp, void *socketp)
+{
+  struct t3035_ctx *ctx = userp;
+  int i;
+
+  (void)easy;
+  (void)socketp;
+  for(i = 0; i < ctx->nsocks; i++) {
+    if(ctx->socks[i].fd == s)
+      break;
+  }
+  if(action == CURL_POLL_REMOVE) {
+    if(i < ctx->nsocks)
+      ctx->socks[i] = ctx->socks[--ctx->nsocks];
+    return 0;
+  }
+  if(i == ctx->nsocks) {
+    if(ctx->nsocks == T3035_MAX_SOCKETS)
+      return -1;
+    ctx->nsocks++;
+  }
+  ctx->socks[i].fd = s;
+  ctx->socks[i].action = action;
+  return 0;
+}
+
+static int t3035_timer_cb(CURLM *multi, long timeout_ms, void *userp)
+{
+  struct t3035_ctx *ctx = userp;
+  (void)multi;
+  ctx->timeout_ms = timeout_ms;
+  return 0;
+}
+
+static size_t t3035_write_cb(char *ptr, size_t size, size_t nmemb, void *p)
+{
+  (void)ptr;
+  (void)p;
+  return size * nmemb;
+}
+
+static CURLcode test_lib3035(const char *URL)
+{
+  CURL *easy[T3035_TRANSFERS];
+  CURLM *multi = NULL;
+  CURLcode res = CURLE_OK;
+  struct t3035_ctx ctx;
+  int running = 1, done = 0, i;
+
+  memset(&ctx, 0, sizeof(ctx));
+  memset(easy, 0, sizeof(easy));
+  ctx.timeout_ms = -1;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+  multi_init(multi);
+  multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, t3035_socket_cb);
+  multi_setopt(multi, CURLMOPT_SOCKETDATA, &ctx);
+  multi_setopt(multi, CURLMOPT_TIMERFUNCTION, t3035_timer_cb);
+  multi_setopt(multi, CURLMOPT_TIMERDATA, &ctx);
+
+  for(i = 0; i < T3035_TRANSFERS; i++) {
+    easy_init(easy[i]);
+    easy_setopt(easy[i], CURLOPT_URL, URL);
+    easy_setopt(easy[i], CURLOPT_WRITEFUNCTION, t3035_write_cb);
+    multi_add_handle(multi, easy[i]);
+  }
+
+  /* kick things off */
+  if(curl_multi_socket_actions(multi, NULL, 0, &running)) {
+    res = TEST_ERR_MULTI;
+    goto test_cleanup;
+  }
+
+  while(running) {
+    struct curl_sockaction acts[T3035_MAX_SOCKETS + 1];
+    unsigned int nacts = 0;
+    fd_set readfds, writefds, errfds;
+    struct timeval tv;
+    int maxfd = -1, rc;
+    long wait_ms;
+
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    FD_ZERO(&errfds);
+    for(i = 0; i < ctx.nsocks; i++) {
+      curl_socket_t s = ctx.socks[i].fd;
+      if(ctx.socks[i].action & CURL_POLL_IN)
+        FD_SET(s, &readfds);
+      if(ctx.socks[i].action & CURL_POLL_OUT)
+        FD_SET(s, &writefds);
+      FD_SET(s, &errfds);
+      if((int)s > maxfd)
+        maxfd = (int)s;
+    }
+    wait_ms = (ctx.timeout_ms < 0 || ctx.timeout_ms > 1000) ?
+              1000 : ctx.timeout_ms;
+    tv.tv_sec = wait_ms / 1000;
+    tv.tv_usec = (int)((wait_ms % 1000) * 1000);
+    rc = select_wrapper(maxfd + 1, &readfds, &writefds, &errfds, &tv);
+    if(rc < 0) {
+      res = TEST_ERR_SELECT;
+      goto test_cleanup;
+    }
+
+    for(i = 0; i < ctx.nsocks; i++) {
+      curl_socket_t s = ctx.socks[i].fd;
+      int mask = (FD_ISSET(s, &readfds) ? CURL_CSELECT_IN : 0) |
+                 (FD_ISSET(s, &writefds) ? CURL_CSELECT_OUT : 0) |
+                 (FD_ISSET(s, &errfds) ? CURL_CSELECT_ERR : 0);
+      if(mask) {
+        acts[nacts].fd = s;
+        acts[nacts].ev_bitmask = mask;
+        nacts++;
+      }
+    }
+    if(!rc) {
+      acts[nacts].fd = CURL_SOCKET_TIMEOUT;
+      acts[nacts].ev_bitmask = 0;
+      nacts++;
+    }
+
+    if(curl_multi_socket_actions(multi, acts, nacts, &running)) {
+      res = TEST_ERR_MULTI;
+      goto test_cleanup;
+    }
+
+    for(;;) {
+      int msgs;
+      CURLMsg *msg = curl_multi_info_read(multi, &msgs);
+      if(!msg)
+        break;
+      if(msg->msg == CURLMSG_DONE) {
+        if(msg->data.result) {
+          res = msg->data.result;
+          goto test_cleanup;
+        }
+        done++;
+      }
+    }
+
+    abort_on_test_timeout();
+  }
+
+  curl_mprintf("%d transfers done\n", done);
+
+test_cleanup:
+
+  for(i = 0; i < T3035_TRANSFERS; i++) {
+    curl_multi_remove_handle(multi, easy[i]);
+    curl_easy_cleanup(easy[i]);
+  }
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+struct t3036_ctx {
+  char buf[512];
+  size_t buflen_in; /* buffer size libcurl offered in the last call */
+  size_t total;     /* body bytes written */
+  size_t in_buf;    /* body bytes written from 'buf' */
+  size_t calls;
+};
+
+static char *t3036_recvbuf_cb(size_t *buflen, void *clientp)
+{
+  struct t3036_ctx *ctx = clientp;
+  ctx->buflen_in = *buflen;
+  ctx->calls++;
+  *buflen = sizeof(ctx->buf);
+  return ctx->buf;
+}
+
+static size_t t3036_write_cb(char *ptr, size_t size, size_t nmemb,
+                             void *userp)
+{
+  struct t3036_ctx *ctx = userp;
+  size_t len = size * nmemb;
+
+  if(ptr >= ctx->buf && ptr < ctx->buf + sizeof(ctx->buf)) {
+    if(len > (size_t)(ctx->buf + sizeof(ctx->buf) - ptr))
+      return CURL_WRITEFUNC_ERROR;
+    ctx->in_buf += len;
+  }
+  ctx->total += len;
+  fwrite(ptr, size, nmemb, stdout);
+  return len;
+}
+
+static CURLcode test_lib3036(const char *URL)
+{
+  CURLcode code;
+  CURL *curl = NULL;
+  CURLcode res = CURLE_OK;
+  struct t3036_ctx ctx;
+
+  memset(&ctx, 0, sizeof(ctx));
+
+  global_init(CURL_GLOBAL_ALL);
+
+  easy_init(curl);
+
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_BUFFERSIZE, 1024L);
+  easy_setopt(curl, CURLOPT_RECVBUFFERFUNCTION, t3036_recvbuf_cb);
+  easy_setopt(curl, CURLOPT_RECVBUFFERDATA, &ctx);
+  easy_setopt(curl, CURLOPT_WRITEFUNCTION, t3036_write_cb);
+  easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
+
+  code = curl_easy_perform(curl);
+  if(CURLE_OK != code) {
+    curl_mfprintf(stderr, "%s:%d curl_easy_perform() failed, "
+                  "with code %d (%s)\n",
+                  __FILE__, __LINE__, code, curl_easy_strerror(code));
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+
+  /* the headers and the start of the body arrive in libcurl's own buffer,
+     the remainder has to come in the application's */
+  if(!ctx.calls || ctx.buflen_in != 1024 || !ctx.in_buf ||
+     ctx.total - ctx.in_buf >= 1024) {
+    curl_mfprintf(stderr, "recv buffer: %zu calls, offered %zu, "
+                  "%zu of %zu bytes in application buffer\n",
+                  ctx.calls, ctx.buflen_in, ctx.in_buf, ctx.total);
+    res = TEST_ERR_FAILURE;
+  }
+
+test_cleanup:
+
+  curl_easy_cleanup(curl);
+  curl_global_cleanup();
+
+  return res;
+}
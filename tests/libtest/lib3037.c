@@ -0,0 +1,61 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+/* Three compressed responses (gzip, deflate, gzip) fetched one after the
+   other with the same handle. The decoder states of the earlier transfers
+   are reset and used again by the later ones. */
+static CURLcode test_lib3037(const char *URL)
+{
+  CURL *curl = NULL;
+  CURLcode res = CURLE_OK;
+  int i;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  easy_init(curl);
+
+  easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
+  for(i = 1; i <= 3; i++) {
+    char url[256];
+    curl_msnprintf(url, sizeof(url), "%s%04d", URL, i);
+    easy_setopt(curl, CURLOPT_URL, url);
+    res = curl_easy_perform(curl);
+    if(res) {
+      curl_mfprintf(stderr, "transfer %d failed with code %d (%s)\n",
+                    i, res, curl_easy_strerror(res));
+      break;
+    }
+  }
+
+test_cleanup:
+
+  curl_easy_cleanup(curl);
+  curl_global_cleanup();
+
+  return res;
+}
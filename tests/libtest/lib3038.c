@@ -0,0 +1,109 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+#define RESOLVE_XFERS 6
+
+/* Transfers to a non-existing host on two different ports, resolved by a
+   multi handle with a single resolver thread. The transfers to the same
+   port share a lookup, all of them fail to resolve. */
+static CURLcode test_lib3038(const char *URL)
+{
+  CURL *curl[RESOLVE_XFERS] = {0};
+  CURLcode result[RESOLVE_XFERS];
+  CURLM *m = NULL;
+  CURLcode res = CURLE_OK;
+  CURLMcode mc;
+  CURLMsg *msg;
+  int running;
+  int msgs;
+  int numfds;
+  int i;
+
+  (void)URL;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(m);
+
+  mc = curl_multi_setopt(m, CURLMOPT_MAX_RESOLVE_QUEUE, -1L);
+  curl_mprintf("negative queue limit: %d\n", (int)mc);
+  mc = curl_multi_setopt(m, CURLMOPT_MAX_RESOLVE_THREADS, 0L);
+  curl_mprintf("zero thread limit: %d\n", (int)mc);
+  multi_setopt(m, CURLMOPT_MAX_RESOLVE_THREADS, 1L);
+  multi_setopt(m, CURLMOPT_MAX_RESOLVE_QUEUE, 0L);
+
+  for(i = 0; i < RESOLVE_XFERS; i++) {
+    char url[256];
+    result[i] = CURLE_OK;
+    easy_init(curl[i]);
+    curl_msnprintf(url, sizeof(url),
+                   "http://non-existing-host.haxx.se.:%d/%d",
+                   8990 + (i % 2), i);
+    easy_setopt(curl[i], CURLOPT_URL, url);
+    easy_setopt(curl[i], CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+    easy_setopt(curl[i], CURLOPT_PRIVATE, (void *)&result[i]);
+    multi_add_handle(m, curl[i]);
+  }
+
+  for(;;) {
+    multi_perform(m, &running);
+
+    abort_on_test_timeout();
+
+    if(!running)
+      break;
+
+    multi_poll(m, NULL, 0, 1000, &numfds);
+
+    abort_on_test_timeout();
+  }
+
+  for(msg = curl_multi_info_read(m, &msgs); msg;
+      msg = curl_multi_info_read(m, &msgs)) {
+    if(msg->msg == CURLMSG_DONE) {
+      CURLcode *xfer_result;
+      curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &xfer_result);
+      *xfer_result = msg->data.result;
+    }
+  }
+
+  for(i = 0; i < RESOLVE_XFERS; i++)
+    curl_mprintf("transfer %d: %d\n", i, (int)result[i]);
+
+test_cleanup:
+
+  for(i = 0; i < RESOLVE_XFERS; i++) {
+    curl_multi_remove_handle(m, curl[i]);
+    curl_easy_cleanup(curl[i]);
+  }
+  curl_multi_cleanup(m);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+/* Write a cookie jar in journal mode with a few flushes in between changes,
+   then read it into a new handle and write the cookies it holds to another
+   file. */
+static CURLcode test_lib3039(const char *URL)
+{
+  CURL *curl = NULL;
+  CURLcode res = CURLE_OK;
+  const char *jar = libtest_arg2;
+  const char *out = libtest_arg3;
+
+  (void)URL;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_COOKIEJAR, jar);
+  easy_setopt(curl, CURLOPT_COOKIEJOURNAL, 1L);
+
+  /* the first flush writes the jar in full */
+  easy_setopt(curl, CURLOPT_COOKIELIST,
+              "example.com\tFALSE\t/\tFALSE\t2000000000\tone\t1");
+  easy_setopt(curl, CURLOPT_COOKIELIST,
+              ".example.com\tTRUE\t/\tFALSE\t2000000000\ttwo\t2");
+  easy_setopt(curl, CURLOPT_COOKIELIST,
+              "example.org\tFALSE\t/a\tTRUE\t2000000000\tthree\t3");
+  easy_setopt(curl, CURLOPT_COOKIELIST, "FLUSH");
+
+  /* a new cookie, a changed one and a session cookie get appended */
+  easy_setopt(curl, CURLOPT_COOKIELIST,
+              "example.net\tFALSE\t/\tFALSE\t2000000000\tfour\t4");
+  easy_setopt(curl, CURLOPT_COOKIELIST,
+              ".example.com\tTRUE\t/\tFALSE\t2000000000\ttwo\ttwo");
+  easy_setopt(curl, CURLOPT_COOKIELIST,
+              "example.org\tFALSE\t/\tFALSE\t0\tsession\ts");
+  easy_setopt(curl, CURLOPT_COOKIELIST, "FLUSH");
+
+  /* the removed session cookie is appended as expired */
+  easy_setopt(curl, CURLOPT_COOKIELIST, "SESS");
+  easy_setopt(curl, CURLOPT_COOKIELIST, "FLUSH");
+
+  /* nothing changed, nothing is appended on cleanup */
+  curl_easy_cleanup(curl);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_COOKIEFILE, jar);
+  easy_setopt(curl, CURLOPT_COOKIEJAR, out);
+  easy_setopt(curl, CURLOPT_COOKIELIST, "RELOAD");
+
+test_cleanup:
+
+  curl_easy_cleanup(curl);
+  curl_global_cleanup();
+
+  return res;
+}
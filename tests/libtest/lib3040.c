@@ -0,0 +1,225 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+#ifdef USE_THREADS_POSIX
+#include <pthread.h>
+#endif
+
+#include "curl_threads.h"
+
+/*
+ * Threads doing transfers with new easy handles each time, reusing the
+ * connections kept in a shared connection pool. Every thread talks to its
+ * own hostname, so each is expected to create a single connection.
+ * The transfer rate is written to stderr.
+ */
+
+#define T3040_THREADS 8
+#define T3040_PER_THREAD 25
+
+struct t3040_ctx {
+  const char *URL;
+  CURLSH *share;
+  CURLcode result;
+  size_t thread_id;
+  long connects;
+  size_t bytes;
+};
+
+static size_t t3040_write_cb(char *ptr, size_t size, size_t nmemb,
+                             void *userp)
+{
+  struct t3040_ctx *ctx = userp;
+  (void)ptr;
+  ctx->bytes += size * nmemb;
+  return size * nmemb;
+}
+
+static CURL_THREAD_RETURN_T CURL_STDCALL t3040_thread(void *ptr)
+{
+  struct t3040_ctx *ctx = ptr;
+  CURLcode res = CURLE_OK;
+  struct curl_slist *connect_to = NULL;
+  char url[256];
+  char target[256];
+  int i;
+
+  curl_msnprintf(url, sizeof(url), "http://t%zu.example/3040",
+                 ctx->thread_id);
+  curl_msnprintf(target, sizeof(target), "t%zu.example:80:%s",
+                 ctx->thread_id, libtest_arg2);
+  connect_to = curl_slist_append(NULL, target);
+  if(!connect_to) {
+    res = CURLE_OUT_OF_MEMORY;
+    goto test_cleanup;
+  }
+
+  for(i = 0; i < T3040_PER_THREAD; i++) {
+    long connects = 0;
+    CURL *curl = curl_easy_init();
+    if(!curl) {
+      res = CURLE_OUT_OF_MEMORY;
+      goto test_cleanup;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_CONNECT_TO, connect_to);
+    curl_easy_setopt(curl, CURLOPT_SHARE, ctx->share);
+    curl_easy_setopt(curl, CURLOPT_MAXCONNECTS, 100L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, t3040_write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, ptr);
+
+    res = curl_easy_perform(curl);
+    if(!res)
+      res = curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    ctx->connects += connects;
+
+    curl_easy_cleanup(curl);
+    if(res) {
+      curl_mfprintf(stderr, "curl_easy_perform() failed: %s\n",
+                    curl_easy_strerror(res));
+      goto test_cleanup;
+    }
+  }
+
+test_cleanup:
+  curl_slist_free_all(connect_to);
+  ctx->result = res;
+  return 0;
+}
+
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+
+static void t3040_lock(CURL *handle, curl_lock_data data,
+                       curl_lock_access laccess, void *useptr)
+{
+  curl_mutex_t *mutexes = (curl_mutex_t *)useptr;
+  (void)handle;
+  (void)laccess;
+  Curl_mutex_acquire(&mutexes[data]);
+}
+
+static void t3040_unlock(CURL *handle, curl_lock_data data, void *useptr)
+{
+  curl_mutex_t *mutexes = (curl_mutex_t *)useptr;
+  (void)handle;
+  Curl_mutex_release(&mutexes[data]);
+}
+
+static void t3040_execute(CURLSH *share, struct t3040_ctx *ctx)
+{
+  size_t i;
+  curl_mutex_t mutexes[CURL_LOCK_DATA_LAST - 1];
+  curl_thread_t thread[T3040_THREADS];
+  for(i = 0; i < CURL_ARRAYSIZE(mutexes); i++) {
+    Curl_mutex_init(&mutexes[i]);
+  }
+  curl_share_setopt(share, CURLSHOPT_LOCKFUNC, t3040_lock);
+  curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, t3040_unlock);
+  curl_share_setopt(share, CURLSHOPT_USERDATA, (void *)mutexes);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+
+  for(i = 0; i < CURL_ARRAYSIZE(thread); i++) {
+    thread[i] = Curl_thread_create(t3040_thread, (void *)&ctx[i]);
+  }
+  for(i = 0; i < CURL_ARRAYSIZE(thread); i++) {
+    if(thread[i]) {
+      Curl_thread_join(&thread[i]);
+      Curl_thread_destroy(&thread[i]);
+    }
+  }
+  /* the pool is cleaned up without the lock functions */
+  curl_share_setopt(share, CURLSHOPT_LOCKFUNC, NULL);
+  curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, NULL);
+  for(i = 0; i < CURL_ARRAYSIZE(mutexes); i++) {
+    Curl_mutex_destroy(&mutexes[i]);
+  }
+}
+
+#else /* without threads, run serially */
+
+static void t3040_execute(CURLSH *share, struct t3040_ctx *ctx)
+{
+  size_t i;
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+  for(i = 0; i < T3040_THREADS; i++) {
+    t3040_thread((void *)&ctx[i]);
+  }
+}
+
+#endif
+
+static CURLcode test_lib3040(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  size_t i;
+  CURLSH *share;
+  struct t3040_ctx ctx[T3040_THREADS];
+  struct curltime start;
+  timediff_t ms;
+  long connects = 0;
+  size_t bytes = 0;
+
+  curl_global_init(CURL_GLOBAL_ALL);
+
+  share = curl_share_init();
+  if(!share) {
+    curl_mfprintf(stderr, "curl_share_init() failed\n");
+    goto test_cleanup;
+  }
+
+  for(i = 0; i < CURL_ARRAYSIZE(ctx); i++) {
+    ctx[i].share = share;
+    ctx[i].URL = URL;
+    ctx[i].thread_id = i;
+    ctx[i].result = CURLE_OK;
+    ctx[i].connects = 0;
+    ctx[i].bytes = 0;
+  }
+
+  start = curlx_now();
+  t3040_execute(share, ctx);
+  ms = curlx_timediff(curlx_now(), start);
+
+  for(i = 0; i < CURL_ARRAYSIZE(ctx); i++) {
+    if(ctx[i].result)
+      res = ctx[i].result;
+    connects += ctx[i].connects;
+    bytes += ctx[i].bytes;
+  }
+  curl_mfprintf(stderr, "%d transfers in %" FMT_OFF_T " ms, "
+                "%.0f transfers/s\n", T3040_THREADS * T3040_PER_THREAD, ms,
+                (double)(T3040_THREADS * T3040_PER_THREAD) * 1000.0 /
+                (double)(ms ? ms : 1));
+  curl_mprintf("%d transfers, %ld connections, %zu bytes\n",
+               T3040_THREADS * T3040_PER_THREAD, connects, bytes);
+
+test_cleanup:
+  if(share)
+    curl_share_cleanup(share);
+  curl_global_cleanup();
+  return res;
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+/*
+ * Have two connections kept warm with curl_multi_prewarm(), run a transfer
+ * that reuses one of them and see the replacement getting opened. The
+ * cookie jar the transfer saves must not be overwritten by the warm-up
+ * transfers.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+#define T3041_WARM 2
+
+static int t3041_sockopt_cb(void *clientp, curl_socket_t curlfd,
+                            curlsocktype purpose)
+{
+  int *sockets = clientp;
+  (void)curlfd;
+  (void)purpose;
+  (*sockets)++;
+  return CURL_SOCKOPT_OK;
+}
+
+/* Drive the multi handle until `sockets` reached `wanted`, then some
+ * more rounds for the connects to complete. */
+static CURLcode t3041_drive(CURLM *multi, int *sockets, int wanted,
+                            int *running)
+{
+  CURLcode res = CURLE_OK;
+  int rounds = 10;
+  int numfds;
+
+  while(rounds) {
+    multi_perform(multi, running);
+    abort_on_test_timeout();
+    if(*sockets >= wanted)
+      rounds--;
+    multi_poll(multi, NULL, 0, 20, &numfds);
+    abort_on_test_timeout();
+  }
+
+test_cleanup:
+  return res;
+}
+
+static CURLcode test_lib3041(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLM *multi = NULL;
+  CURL *warm = NULL;
+  CURL *curl = NULL;
+  CURLMsg *msg;
+  int sockets = 0;
+  int running = 0;
+  int msgs;
+  int numfds;
+  long connects = -1;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(multi);
+
+  easy_init(warm);
+  easy_setopt(warm, CURLOPT_URL, URL);
+  easy_setopt(warm, CURLOPT_SOCKOPTFUNCTION, t3041_sockopt_cb);
+  easy_setopt(warm, CURLOPT_SOCKOPTDATA, &sockets);
+  easy_setopt(warm, CURLOPT_COOKIEJAR, libtest_arg2);
+
+  if(curl_multi_prewarm(multi, warm, T3041_WARM)) {
+    curl_mfprintf(stderr, "curl_multi_prewarm() failed\n");
+    res = TEST_ERR_MULTI;
+    goto test_cleanup;
+  }
+  /* the settings are copied */
+  curl_easy_cleanup(warm);
+  warm = NULL;
+
+  res = t3041_drive(multi, &sockets, T3041_WARM, &running);
+  if(res)
+    goto test_cleanup;
+  curl_mprintf("warming up: %d running, %d sockets\n", running, sockets);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_SOCKOPTFUNCTION, t3041_sockopt_cb);
+  easy_setopt(curl, CURLOPT_SOCKOPTDATA, &sockets);
+  easy_setopt(curl, CURLOPT_COOKIEJAR, libtest_arg2);
+  /* close the connection taken, so that it needs replacing */
+  easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+  multi_add_handle(multi, curl);
+
+  do {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(running) {
+      multi_poll(multi, NULL, 0, 100, &numfds);
+      abort_on_test_timeout();
+    }
+  } while(running);
+
+  msg = curl_multi_info_read(multi, &msgs);
+  if(!msg || (msg->msg != CURLMSG_DONE) || msg->data.result) {
+    curl_mfprintf(stderr, "transfer failed\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+  curl_mprintf("transfer done, %ld new connections\n", connects);
+  /* saves the cookie received */
+  curl_multi_remove_handle(multi, curl);
+  curl_easy_cleanup(curl);
+  curl = NULL;
+
+  /* the connection closed gets replaced */
+  res = t3041_drive(multi, &sockets, T3041_WARM + 1, &running);
+  if(res)
+    goto test_cleanup;
+  curl_mprintf("replaced: %d running, %d sockets\n", running, sockets);
+
+  /* stop keeping connections warm, no new ones */
+  easy_init(warm);
+  easy_setopt(warm, CURLOPT_URL, URL);
+  if(curl_multi_prewarm(multi, warm, 0)) {
+    curl_mfprintf(stderr, "curl_multi_prewarm() failed\n");
+    res = TEST_ERR_MULTI;
+    goto test_cleanup;
+  }
+  res = t3041_drive(multi, &sockets, 0, &running);
+  curl_mprintf("stopped: %d sockets\n", sockets);
+
+test_cleanup:
+  if(curl)
+    curl_multi_remove_handle(multi, curl);
+  curl_easy_cleanup(curl);
+  curl_easy_cleanup(warm);
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+
+  return res;
+}
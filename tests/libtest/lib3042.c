@@ -0,0 +1,205 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "first.h"
+
+#include "memdebug.h"
+
+#ifdef USE_THREADS_POSIX
+#include <pthread.h>
+#endif
+
+#include "curl_threads.h"
+
+/*
+ * Threads doing transfers to a set of hostnames, resolved via a shared DNS
+ * cache. The names all end in ".localhost" and are resolved without
+ * asking the system. Built with thread support, the shared cache does its
+ * own locking and the DNS lock callback is never to be called.
+ */
+
+#define T3042_THREADS 8
+#define T3042_PER_THREAD 25
+#define T3042_HOSTS 12
+
+struct t3042_ctx {
+  const char *URL;
+  CURLSH *share;
+  CURLcode result;
+  size_t thread_id;
+  size_t bytes;
+};
+
+static size_t t3042_write_cb(char *ptr, size_t size, size_t nmemb,
+                             void *userp)
+{
+  struct t3042_ctx *ctx = userp;
+  (void)ptr;
+  ctx->bytes += size * nmemb;
+  return size * nmemb;
+}
+
+static CURL_THREAD_RETURN_T CURL_STDCALL t3042_thread(void *ptr)
+{
+  struct t3042_ctx *ctx = ptr;
+  CURLcode res = CURLE_OK;
+  char url[256];
+  int i;
+
+  for(i = 0; i < T3042_PER_THREAD; i++) {
+    CURL *curl = curl_easy_init();
+    if(!curl) {
+      res = CURLE_OUT_OF_MEMORY;
+      break;
+    }
+    curl_msnprintf(url, sizeof(url), "http://h%zu.localhost:%s/3042",
+                   (ctx->thread_id + (size_t)i) % T3042_HOSTS, libtest_arg2);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_SHARE, ctx->share);
+    curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, t3042_write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, ptr);
+
+    res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    if(res) {
+      curl_mfprintf(stderr, "curl_easy_perform() failed: %s\n",
+                    curl_easy_strerror(res));
+      break;
+    }
+  }
+
+  ctx->result = res;
+  return 0;
+}
+
+#if defined(USE_THREADS_POSIX) || defined(USE_THREADS_WIN32)
+
+static int t3042_dns_locks;
+
+static void t3042_lock(CURL *handle, curl_lock_data data,
+                       curl_lock_access laccess, void *useptr)
+{
+  curl_mutex_t *mutexes = (curl_mutex_t *)useptr;
+  (void)handle;
+  (void)laccess;
+  Curl_mutex_acquire(&mutexes[data]);
+  if(data == CURL_LOCK_DATA_DNS)
+    t3042_dns_locks++;
+}
+
+static void t3042_unlock(CURL *handle, curl_lock_data data, void *useptr)
+{
+  curl_mutex_t *mutexes = (curl_mutex_t *)useptr;
+  (void)handle;
+  Curl_mutex_release(&mutexes[data]);
+}
+
+static CURLcode t3042_execute(CURLSH *share, struct t3042_ctx *ctx)
+{
+  size_t i;
+  curl_mutex_t mutexes[CURL_LOCK_DATA_LAST - 1];
+  curl_thread_t thread[T3042_THREADS];
+  for(i = 0; i < CURL_ARRAYSIZE(mutexes); i++) {
+    Curl_mutex_init(&mutexes[i]);
+  }
+  curl_share_setopt(share, CURLSHOPT_LOCKFUNC, t3042_lock);
+  curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, t3042_unlock);
+  curl_share_setopt(share, CURLSHOPT_USERDATA, (void *)mutexes);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+
+  for(i = 0; i < CURL_ARRAYSIZE(thread); i++) {
+    thread[i] = Curl_thread_create(t3042_thread, (void *)&ctx[i]);
+  }
+  for(i = 0; i < CURL_ARRAYSIZE(thread); i++) {
+    if(thread[i]) {
+      Curl_thread_join(&thread[i]);
+      Curl_thread_destroy(&thread[i]);
+    }
+  }
+  curl_share_setopt(share, CURLSHOPT_LOCKFUNC, NULL);
+  curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, NULL);
+  for(i = 0; i < CURL_ARRAYSIZE(mutexes); i++) {
+    Curl_mutex_destroy(&mutexes[i]);
+  }
+  if(t3042_dns_locks) {
+    curl_mfprintf(stderr, "DNS lock called %d times\n", t3042_dns_locks);
+    return TEST_ERR_FAILURE;
+  }
+  return CURLE_OK;
+}
+
+#else /* without threads, run serially */
+
+static CURLcode t3042_execute(CURLSH *share, struct t3042_ctx *ctx)
+{
+  size_t i;
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  for(i = 0; i < T3042_THREADS; i++) {
+    t3042_thread((void *)&ctx[i]);
+  }
+  return CURLE_OK;
+}
+
+#endif
+
+static CURLcode test_lib3042(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  size_t i;
+  CURLSH *share;
+  struct t3042_ctx ctx[T3042_THREADS];
+  size_t bytes = 0;
+
+  curl_global_init(CURL_GLOBAL_ALL);
+
+  share = curl_share_init();
+  if(!share) {
+    curl_mfprintf(stderr, "curl_share_init() failed\n");
+    goto test_cleanup;
+  }
+
+  for(i = 0; i < CURL_ARRAYSIZE(ctx); i++) {
+    ctx[i].share = share;
+    ctx[i].URL = URL;
+    ctx[i].thread_id = i;
+    ctx[i].result = CURLE_OK;
+    ctx[i].bytes = 0;
+  }
+
+  res = t3042_execute(share, ctx);
+
+  for(i = 0; i < CURL_ARRAYSIZE(ctx); i++) {
+    if(ctx[i].result)
+      res = ctx[i].result;
+    bytes += ctx[i].bytes;
+  }
+  curl_mprintf("%d transfers, %zu bytes\n",
+               T3042_THREADS * T3042_PER_THREAD, bytes);
+
+test_cleanup:
+  if(share)
+    curl_share_cleanup(share);
+  curl_global_cleanup();
+  return res;
+}
@@ -0,0 +1,129 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+
+/*
+ * Transfers resolving via the DNS cache of a single easy handle: a failed
+ * resolve is remembered and an expired entry is used while getting
+ * refreshed. The names used never reach a name server: the one failing
+ * is not resolvable and ".localhost" names are resolved by libcurl.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+#define T3043_REFRESHING "Hostname in DNS cache is stale, refreshing"
+
+static int t3043_resolves;
+static int t3043_refreshes;
+
+static int t3043_resolver_start_cb(void *resolver_state, void *reserved,
+                                   void *userdata)
+{
+  (void)resolver_state;
+  (void)reserved;
+  (void)userdata;
+  t3043_resolves++;
+  return 0;
+}
+
+static int t3043_debug_cb(CURL *handle, curl_infotype type,
+                          char *data, size_t size, void *userp)
+{
+  size_t len = strlen(T3043_REFRESHING);
+  (void)handle;
+  (void)userp;
+  if((type == CURLINFO_TEXT) && (size >= len) &&
+     !memcmp(data, T3043_REFRESHING, len))
+    t3043_refreshes++;
+  return 0;
+}
+
+static CURLcode test_lib3043(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLcode res1, res2;
+  CURL *curl = NULL;
+  char url[256];
+
+  (void)URL;
+  global_init(CURL_GLOBAL_ALL);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_RESOLVER_START_FUNCTION,
+              t3043_resolver_start_cb);
+  easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+
+  /* the second transfer fails without resolving */
+  easy_setopt(curl, CURLOPT_URL, "http://non-existing-host.haxx.se./");
+  easy_setopt(curl, CURLOPT_DNS_CACHE_NEGATIVE_TIMEOUT, 60L);
+  res1 = curl_easy_perform(curl);
+  res2 = curl_easy_perform(curl);
+  curl_mprintf("negative: %d %d, resolves %d\n", res1, res2, t3043_resolves);
+
+  /* a transfer not wanting cached failures resolves again */
+  easy_setopt(curl, CURLOPT_DNS_CACHE_NEGATIVE_TIMEOUT, 0L);
+  res1 = curl_easy_perform(curl);
+  curl_mprintf("ignored: %d, resolves %d\n", res1, t3043_resolves);
+
+  curl_msnprintf(url, sizeof(url), "http://stale.localhost:%s/3043",
+                 libtest_arg2);
+  easy_setopt(curl, CURLOPT_URL, url);
+  easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+  easy_setopt(curl, CURLOPT_DEBUGFUNCTION, t3043_debug_cb);
+  easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, 1L);
+  easy_setopt(curl, CURLOPT_DNS_CACHE_STALE_TIMEOUT, 60L);
+  res = curl_easy_perform(curl);
+  if(res)
+    goto test_cleanup;
+
+  /* expired, the second transfer uses the entry and has it refreshed */
+  curlx_wait_ms(1100);
+  res = curl_easy_perform(curl);
+  if(res)
+    goto test_cleanup;
+  /* uses the refreshed entry, or the stale one if not done yet. The
+     refresh is internal and does not call the resolver start callback. */
+  res = curl_easy_perform(curl);
+  if(res)
+    goto test_cleanup;
+  curl_mprintf("stale: %d refresh, resolves %d\n", t3043_refreshes,
+               t3043_resolves);
+
+  /* once the refresh is done, the entry gets refreshed again when it
+     expires again */
+  curlx_wait_ms(1100);
+  res = curl_easy_perform(curl);
+  if(res)
+    goto test_cleanup;
+  curl_mprintf("stale again: %d refreshes, resolves %d\n", t3043_refreshes,
+               t3043_resolves);
+
+test_cleanup:
+  curl_easy_cleanup(curl);
+  curl_global_cleanup();
+
+  return res;
+}
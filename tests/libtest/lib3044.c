@@ -0,0 +1,110 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+/*
+ * Set CURLMOPT_MAX_MEMORY, pause a transfer in its write callback and see
+ * the receive buffer and the data kept for it in CURLMINFO_MEMORY_USED.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+static int t3044_paused;
+
+static size_t t3044_write_cb(char *ptr, size_t size, size_t nmemb,
+                             void *userp)
+{
+  (void)userp;
+  if(!t3044_paused) {
+    t3044_paused = 1;
+    return CURL_WRITEFUNC_PAUSE;
+  }
+  fwrite(ptr, size, nmemb, stdout);
+  return size * nmemb;
+}
+
+static CURLcode test_lib3044(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLM *multi = NULL;
+  CURL *curl = NULL;
+  CURLMcode mc;
+  curl_off_t used = -1;
+  curl_off_t paused_used = -1;
+  int running = 0;
+  int numfds;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(multi);
+
+  mc = curl_multi_setopt(multi, CURLMOPT_MAX_MEMORY, (curl_off_t)-1);
+  curl_mprintf("negative limit: %d\n", (int)mc);
+  mc = curl_multi_get_offt(multi, CURLMINFO_NONE, &used);
+  curl_mprintf("unknown info: %d\n", (int)mc);
+  mc = curl_multi_get_offt(multi, CURLMINFO_MEMORY_USED, &used);
+  curl_mprintf("idle: %d, %" CURL_FORMAT_CURL_OFF_T " bytes\n", (int)mc,
+               used);
+
+  /* a limit that is always exceeded, transfers still complete */
+  multi_setopt(multi, CURLMOPT_MAX_MEMORY, (curl_off_t)1);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_WRITEFUNCTION, t3044_write_cb);
+  easy_setopt(curl, CURLOPT_BUFFERSIZE, 16384L);
+  multi_add_handle(multi, curl);
+
+  do {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(t3044_paused == 1) {
+      t3044_paused = 2;
+      curl_multi_get_offt(multi, CURLMINFO_MEMORY_USED, &paused_used);
+      curl_easy_pause(curl, CURLPAUSE_CONT);
+    }
+    if(running) {
+      multi_poll(multi, NULL, 0, 100, &numfds);
+      abort_on_test_timeout();
+    }
+  } while(running);
+
+  /* the receive buffer and the body kept while paused */
+  curl_mprintf("paused: %" CURL_FORMAT_CURL_OFF_T " bytes\n", paused_used);
+  /* without transfers running, all buffers are released */
+  curl_multi_get_offt(multi, CURLMINFO_MEMORY_USED, &used);
+  curl_mprintf("done: %" CURL_FORMAT_CURL_OFF_T " bytes\n", used);
+
+test_cleanup:
+  if(curl)
+    curl_multi_remove_handle(multi, curl);
+  curl_easy_cleanup(curl);
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+/*
+ * Upload a mime post with file parts larger than the upload buffer, sent
+ * directly from the files where the platform allows it.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+static CURLcode test_lib3045(const char *URL)
+{
+  CURL *curl = NULL;
+  curl_mime *mime = NULL;
+  curl_mimepart *part;
+  curl_off_t uploaded = 0;
+  CURLcode res = CURLE_OK;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  easy_init(curl);
+
+  mime = curl_mime_init(curl);
+  part = curl_mime_addpart(mime);
+  curl_mime_name(part, "greeting");
+  curl_mime_data(part, "hello", CURL_ZERO_TERMINATED);
+  part = curl_mime_addpart(mime);
+  curl_mime_name(part, "first");
+  curl_mime_filedata(part, libtest_arg2);
+  part = curl_mime_addpart(mime);
+  curl_mime_name(part, "second");
+  curl_mime_filedata(part, libtest_arg2);
+  curl_mime_type(part, "application/octet-stream");
+
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+  /* smaller than the files */
+  easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, 16384L);
+
+  res = curl_easy_perform(curl);
+  if(res)
+    goto test_cleanup;
+
+  res = curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+  if(!res)
+    curl_mprintf("uploaded: %" CURL_FORMAT_CURL_OFF_T " bytes\n", uploaded);
+
+test_cleanup:
+  curl_easy_cleanup(curl);
+  curl_mime_free(mime);
+  curl_global_cleanup();
+
+  return res;
+}
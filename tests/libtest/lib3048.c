@@ -0,0 +1,130 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+/*
+ * Switch the poll backend and the socket callback while a transfer is
+ * running. Each switch has to hand the transfer's socket over to the new
+ * waiter, or the transfer stalls until its timeout.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+static int t3048_announced;
+
+static int t3048_socket_cb(CURL *easy, curl_socket_t s, int what,
+                           void *userp, void *socketp)
+{
+  (void)easy;
+  (void)s;
+  (void)userp;
+  (void)socketp;
+  if(what != CURL_POLL_REMOVE)
+    t3048_announced++;
+  return 0;
+}
+
+static int t3048_timer_cb(CURLM *multi, long timeout_ms, void *userp)
+{
+  (void)multi;
+  (void)timeout_ms;
+  (void)userp;
+  return 0;
+}
+
+static CURLcode test_lib3048(const char *URL)
+{
+  CURL *curl = NULL;
+  CURLM *multi = NULL;
+  CURLMsg *msg;
+  CURLcode res = CURLE_OK;
+  int running, num, msgs;
+  int round = 0;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(multi);
+  /* not all platforms have epoll, the switches are no-ops there */
+  (void)curl_multi_setopt(multi, CURLMOPT_POLL_BACKEND, CURLMPOLL_EPOLL);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+  multi_add_handle(multi, curl);
+
+  for(;;) {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(!running)
+      break;
+
+    switch(round++) {
+    case 2:
+      (void)curl_multi_setopt(multi, CURLMOPT_POLL_BACKEND,
+                              CURLMPOLL_DEFAULT);
+      break;
+    case 4:
+      (void)curl_multi_setopt(multi, CURLMOPT_POLL_BACKEND, CURLMPOLL_EPOLL);
+      break;
+    case 6:
+      /* the application takes over, it has to learn about the socket */
+      multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, t3048_socket_cb);
+      multi_setopt(multi, CURLMOPT_TIMERFUNCTION, t3048_timer_cb);
+      if(curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0,
+                                  &running)) {
+        res = TEST_ERR_MULTI;
+        goto test_cleanup;
+      }
+      /* and hands back to epoll */
+      multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, NULL);
+      multi_setopt(multi, CURLMOPT_TIMERFUNCTION, NULL);
+      break;
+    default:
+      break;
+    }
+
+    multi_poll(multi, NULL, 0, 1000, &num);
+    abort_on_test_timeout();
+  }
+
+  msg = curl_multi_info_read(multi, &msgs);
+  if(msg && msg->msg == CURLMSG_DONE)
+    res = msg->data.result;
+  else
+    res = TEST_ERR_MAJOR_BAD;
+
+  curl_mprintf("socket callback told: %s\n", t3048_announced ? "yes" : "no");
+
+test_cleanup:
+
+  curl_multi_remove_handle(multi, curl);
+  curl_easy_cleanup(curl);
+  curl_multi_cleanup(multi);
+  curl_global_cleanup();
+
+  return res;
+}
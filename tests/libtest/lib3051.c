@@ -0,0 +1,143 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+/*
+ * curl_multi_prewarm() with share handles: a handle sharing connections is
+ * refused, a handle only sharing DNS gets a warm connection the next
+ * transfer using the share reuses.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+static int t3051_sockopt_cb(void *clientp, curl_socket_t curlfd,
+                            curlsocktype purpose)
+{
+  int *sockets = clientp;
+  (void)curlfd;
+  (void)purpose;
+  (*sockets)++;
+  return CURL_SOCKOPT_OK;
+}
+
+static CURLcode test_lib3051(const char *URL)
+{
+  CURLcode res = CURLE_OK;
+  CURLM *multi = NULL;
+  CURLSH *connshare = NULL;
+  CURLSH *dnsshare = NULL;
+  CURL *warm = NULL;
+  CURL *curl = NULL;
+  CURLMsg *msg;
+  CURLMcode mc;
+  int sockets = 0;
+  int running = 0;
+  int rounds = 10;
+  int msgs;
+  int numfds;
+  long connects = -1;
+
+  start_test_timing();
+
+  global_init(CURL_GLOBAL_ALL);
+
+  multi_init(multi);
+
+  connshare = curl_share_init();
+  dnsshare = curl_share_init();
+  if(!connshare || !dnsshare) {
+    curl_mfprintf(stderr, "curl_share_init() failed\n");
+    res = TEST_ERR_MAJOR_BAD;
+    goto test_cleanup;
+  }
+  curl_share_setopt(connshare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+  curl_share_setopt(dnsshare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+
+  easy_init(warm);
+  easy_setopt(warm, CURLOPT_URL, URL);
+  easy_setopt(warm, CURLOPT_SOCKOPTFUNCTION, t3051_sockopt_cb);
+  easy_setopt(warm, CURLOPT_SOCKOPTDATA, &sockets);
+
+  /* the warm connections would not end up where the transfers look */
+  easy_setopt(warm, CURLOPT_SHARE, connshare);
+  mc = curl_multi_prewarm(multi, warm, 1);
+  curl_mprintf("connection share: %d\n", (int)mc);
+
+  easy_setopt(warm, CURLOPT_SHARE, dnsshare);
+  mc = curl_multi_prewarm(multi, warm, 1);
+  curl_mprintf("DNS share: %d\n", (int)mc);
+  if(mc) {
+    res = TEST_ERR_MULTI;
+    goto test_cleanup;
+  }
+  curl_easy_cleanup(warm);
+  warm = NULL;
+
+  while(rounds) {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(sockets)
+      rounds--;
+    multi_poll(multi, NULL, 0, 20, &numfds);
+    abort_on_test_timeout();
+  }
+  curl_mprintf("warming up: %d running, %d sockets\n", running, sockets);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_SOCKOPTFUNCTION, t3051_sockopt_cb);
+  easy_setopt(curl, CURLOPT_SOCKOPTDATA, &sockets);
+  easy_setopt(curl, CURLOPT_SHARE, dnsshare);
+  multi_add_handle(multi, curl);
+
+  do {
+    multi_perform(multi, &running);
+    abort_on_test_timeout();
+    if(running) {
+      multi_poll(multi, NULL, 0, 100, &numfds);
+      abort_on_test_timeout();
+    }
+  } while(running);
+
+  msg = curl_multi_info_read(multi, &msgs);
+  if(!msg || (msg->msg != CURLMSG_DONE) || msg->data.result) {
+    curl_mfprintf(stderr, "transfer failed\n");
+    res = TEST_ERR_FAILURE;
+    goto test_cleanup;
+  }
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+  curl_mprintf("transfer done, %ld new connections\n", connects);
+
+test_cleanup:
+  if(curl)
+    curl_multi_remove_handle(multi, curl);
+  curl_easy_cleanup(curl);
+  curl_easy_cleanup(warm);
+  curl_multi_cleanup(multi);
+  curl_share_cleanup(connshare);
+  curl_share_cleanup(dnsshare);
+  curl_global_cleanup();
+
+  return res;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+
+/*
+ * CURLINFO_RECV_WINDOW_T and CURLINFO_RTT_T are zero for a transfer not
+ * using HTTP/2 or HTTP/3: before, during and after it.
+ */
+
+#include "first.h"
+
+#include "memdebug.h"
+
+static int t3052_bad;
+
+static void t3052_check(CURL *curl, const char *when)
+{
+  curl_off_t window = -1;
+  curl_off_t rtt = -1;
+
+  if(curl_easy_getinfo(curl, CURLINFO_RECV_WINDOW_T, &window) ||
+     curl_easy_getinfo(curl, CURLINFO_RTT_T, &rtt) ||
+     window || rtt) {
+    curl_mprintf("%s: window %" CURL_FORMAT_CURL_OFF_T
+                 ", rtt %" CURL_FORMAT_CURL_OFF_T "\n", when, window, rtt);
+    t3052_bad++;
+  }
+}
+
+static size_t t3052_write_cb(char *ptr, size_t size, size_t nmemb,
+                             void *userp)
+{
+  (void)ptr;
+  t3052_check((CURL *)userp, "during");
+  return size * nmemb;
+}
+
+static CURLcode test_lib3052(const char *URL)
+{
+  CURL *curl = NULL;
+  CURLcode res = CURLE_OK;
+
+  global_init(CURL_GLOBAL_ALL);
+
+  easy_init(curl);
+  easy_setopt(curl, CURLOPT_URL, URL);
+  easy_setopt(curl, CURLOPT_WRITEFUNCTION, t3052_write_cb);
+  easy_setopt(curl, CURLOPT_WRITEDATA, curl);
+
+  t3052_check(curl, "before");
+  res = curl_easy_perform(curl);
+  if(res)
+    goto test_cleanup;
+  t3052_check(curl, "after");
+
+  curl_mprintf("window and rtt: %s\n", t3052_bad ? "wrong" : "zero");
+
+test_cleanup:
+
+  curl_easy_cleanup(curl);
+  curl_global_cleanup();
+
+  return res;
+}
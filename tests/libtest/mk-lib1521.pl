@@ -302,6 +302,7 @@ static curl_hstsread_callback hstsreadcb;
 static curl_hstswrite_callback hstswritecb;
 static curl_resolver_start_callback resolver_start_cb;
 static curl_prereq_callback prereqcb;
+static curl_recvbuffer_callback recvbuffercb;
 
 /* long options that are okay to return
    CURLE_BAD_FUNCTION_ARGUMENT */
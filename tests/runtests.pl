@@ -693,6 +693,8 @@ sub checksystemfeatures {
             $feature{"alt-svc"} = $feat =~ /alt-svc/i;
             # HSTS support
             $feature{"HSTS"} = $feat =~ /HSTS/i;
+            # SSL session import/export
+            $feature{"SSLS-EXPORT"} = $feat =~ /SSLS-EXPORT/;
             $feature{"asyn-rr"} = $feat =~ /asyn-rr/;
             if($feat =~ /AsynchDNS/i) {
                 if(!$feature{"c-ares"} || $feature{"asyn-rr"}) {
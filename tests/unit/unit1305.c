@@ -44,8 +44,7 @@ static struct Curl_dns_entry *data_node;
 
 static CURLcode t1305_setup(void)
 {
-  Curl_dnscache_init(&hp, 7);
-  return CURLE_OK;
+  return Curl_dnscache_init(&hp, 7, FALSE);
 }
 
 static void t1305_stop(void)
@@ -111,7 +110,8 @@ static CURLcode test_unit1305(const char *arg)
     key_len = strlen(data_key);
 
     data_node->refcount = 1; /* hash will hold the reference */
-    nodep = Curl_hash_add(&hp.entries, data_key, key_len + 1, data_node);
+    nodep = Curl_hash_add(&hp.shards[0].entries, data_key, key_len + 1,
+                          data_node);
     abort_unless(nodep, "insertion into hash failed");
     /* Freeing will now be done by Curl_hash_destroy */
     data_node = NULL;
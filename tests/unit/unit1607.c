@@ -133,7 +133,7 @@ static CURLcode test_unit1607(const char *arg)
     entry_id = (void *)curl_maprintf("%s:%d", tests[i].host, tests[i].port);
     if(!entry_id)
       goto error;
-    dns = Curl_hash_pick(&multi->dnscache.entries,
+    dns = Curl_hash_pick(&multi->dnscache.shards[0].entries,
                          entry_id, strlen(entry_id) + 1);
     free(entry_id);
     entry_id = NULL;
@@ -135,7 +135,7 @@ static CURLcode test_unit1609(const char *arg)
     if(!entry_id)
       goto error;
 
-    dns = Curl_hash_pick(&multi->dnscache.entries,
+    dns = Curl_hash_pick(&multi->dnscache.shards[0].entries,
                          entry_id, strlen(entry_id) + 1);
     free(entry_id);
     entry_id = NULL;
@@ -205,6 +205,75 @@ static void check_bufq(size_t pool_spares,
     Curl_bufcp_free(&pool);
 }
 
+static void check_bufcache(void)
+{
+  static unsigned char test_data[4*1024];
+  struct bufc_cache cache;
+  struct bufc_pool pool1, pool2, pool3;
+  struct bufq q;
+  size_t i, n;
+  CURLcode result;
+
+  Curl_bufcache_init(&cache, 2, 6);
+
+  /* fill a queue with 8 chunks of 1024 bytes, pool keeps 2 spares */
+  Curl_bufcp_init2(&pool1, &cache, 1024, 2);
+  Curl_bufq_initp(&q, &pool1, 8, BUFQ_OPT_NONE);
+  for(i = 0; i < 8; ++i) {
+    result = Curl_bufq_write(&q, test_data, 1024, &n);
+    fail_unless(!result && n == 1024, "cache: write failed");
+  }
+  fail_unless(cache.n_alloc == 8, "cache: expected 8 chunks allocated");
+  fail_unless(cache.n_reuse == 0, "cache: expected no chunks reused");
+  /* reading it empty gives 2 chunks to the pool and 6 to the cache */
+  while(!Curl_bufq_is_empty(&q)) {
+    result = Curl_bufq_read(&q, test_data, 1024, &n);
+    fail_unless(!result, "cache: read failed");
+  }
+  Curl_bufq_free(&q);
+  fail_unless(pool1.spare_count == 2, "cache: pool should keep 2 spares");
+  fail_unless(cache.classes[0].chunk_size == 1024, "cache: wrong class");
+  fail_unless(cache.classes[0].spare_count == 6, "cache: expected 6 spares");
+
+  /* freeing the pool hands its spares over, capped at the high mark */
+  Curl_bufcp_free(&pool1);
+  fail_unless(cache.classes[0].spare_count == 6, "cache: high mark ignored");
+
+  /* a new pool of the same size is served from the cache */
+  Curl_bufcp_init2(&pool2, &cache, 1024, 2);
+  Curl_bufq_initp(&q, &pool2, 8, BUFQ_OPT_NONE);
+  for(i = 0; i < 4; ++i) {
+    result = Curl_bufq_write(&q, test_data, 1024, &n);
+    fail_unless(!result && n == 1024, "cache: write failed");
+  }
+  fail_unless(cache.n_alloc == 8, "cache: expected no new allocations");
+  fail_unless(cache.n_reuse == 4, "cache: expected 4 chunks reused");
+  fail_unless(cache.classes[0].spare_count == 2, "cache: expected 2 spares");
+  Curl_bufq_free(&q);
+  Curl_bufcp_free(&pool2);
+
+  /* a different chunk size gets its own class */
+  Curl_bufcp_init2(&pool3, &cache, 2048, 1);
+  Curl_bufq_initp(&q, &pool3, 4, BUFQ_OPT_NONE);
+  for(i = 0; i < 4; ++i) {
+    result = Curl_bufq_write(&q, test_data, 2048, &n);
+    fail_unless(!result && n == 2048, "cache: write failed");
+  }
+  Curl_bufq_skip(&q, 4 * 2048);
+  Curl_bufq_free(&q);
+  Curl_bufcp_free(&pool3);
+  fail_unless(cache.classes[1].chunk_size == 2048, "cache: wrong class");
+  fail_unless(cache.classes[1].spare_count == 4, "cache: expected 4 spares");
+
+  /* trimming goes down to the low mark in all classes */
+  fail_unless(cache.classes[0].spare_count == 2, "cache: expected 2 spares");
+  Curl_bufcache_trim(&cache);
+  fail_unless(cache.classes[0].spare_count == 2, "cache: trimmed too much");
+  fail_unless(cache.classes[1].spare_count == 2, "cache: trim failed");
+
+  Curl_bufcache_free(&cache);
+}
+
 static CURLcode test_unit2601(const char *arg)
 {
   UNITTEST_BEGIN_SIMPLE
@@ -236,5 +305,7 @@ static CURLcode test_unit2601(const char *arg)
   check_bufq(8, 8000, 10, 1234, 1234, BUFQ_OPT_NONE);
   check_bufq(8, 1024, 4, 129, 127, BUFQ_OPT_NO_SPARES);
 
+  check_bufcache();
+
   UNITTEST_END_SIMPLE
 }
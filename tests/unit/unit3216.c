@@ -0,0 +1,151 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "timewheel.h"
+
+#define T3216_NODES 500
+
+static struct curltime t3216_ms(curl_uint64_t ms)
+{
+  struct curltime t;
+  t.tv_sec = (time_t)(ms / 1000);
+  t.tv_usec = (int)((ms % 1000) * 1000);
+  return t;
+}
+
+static CURLcode test_unit3216(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+
+  struct Curl_twheel wheel;
+  struct Curl_twheel_node nodes[T3216_NODES];
+  bool removed[T3216_NODES];
+  curl_uint64_t base = 1000000; /* wheel start, in milliseconds */
+  curl_uint64_t ms;
+  struct curltime now, expire, key;
+  struct Curl_twheel_node *node;
+  size_t i, count = 0;
+
+  Curl_twheel_init(&wheel, t3216_ms(base));
+  fail_unless(!Curl_twheel_next(&wheel, t3216_ms(base), &expire, &node),
+              "empty wheel has a next expire time");
+  fail_unless(!Curl_twheel_getbest(&wheel, t3216_ms(base + 1)),
+              "empty wheel returned a node");
+
+  /* spread the keys over all levels, some beyond the top level */
+  for(i = 0; i < T3216_NODES; i++) {
+    curl_uint64_t off = (i * 7919) % 100000;
+    if(i % 50 == 0)
+      off = off * 1000000;
+    else if(i % 10 == 0)
+      off = off * 100;
+    key = t3216_ms(base + off);
+    key.tv_usec += (int)(i % 1000);
+    removed[i] = FALSE;
+    Curl_twheel_nodeinit(&nodes[i], &removed[i]);
+    Curl_twheel_insert(&wheel, key, &nodes[i]);
+  }
+  fail_unless(Curl_twheel_count(&wheel) == T3216_NODES, "wrong count");
+
+  /* remove every third node */
+  for(i = 0; i < T3216_NODES; i += 3) {
+    fail_unless(!Curl_twheel_remove(&wheel, &nodes[i]), "remove failed");
+    fail_unless(Curl_twheel_remove(&wheel, &nodes[i]) == 1,
+                "removed a node twice");
+    removed[i] = TRUE;
+  }
+
+  /* walk time forward in uneven, growing steps. Every node has to come out
+     exactly once and not before its time */
+  for(ms = base; Curl_twheel_count(&wheel);
+      ms += 1 + ((ms % 4099) * 13) + ((ms - base) / 32)) {
+    now = t3216_ms(ms);
+
+    fail_unless(Curl_twheel_next(&wheel, now, &expire, &node),
+                "no next expire time");
+    if(curlx_timediff_us(expire, now) > 0)
+      fail_unless(!node, "expired node for a time in the future");
+
+    for(;;) {
+      bool *gone;
+      node = Curl_twheel_getbest(&wheel, now);
+      if(!node)
+        break;
+      gone = Curl_twheel_get(node);
+      abort_unless(!*gone, "node returned twice or after removal");
+      *gone = TRUE;
+      fail_unless(curlx_timediff_us(node->key, now) <= 0,
+                  "node returned before its time");
+      count++;
+    }
+
+    /* nothing left that is due */
+    for(i = 0; i < T3216_NODES; i++) {
+      if(!removed[i])
+        abort_unless(curlx_timediff_us(nodes[i].key, now) > 0,
+                     "due node was not returned");
+    }
+
+    /* the next expire time is never after the nearest node */
+    if(Curl_twheel_next(&wheel, now, &expire, &node)) {
+      for(i = 0; i < T3216_NODES; i++) {
+        if(!removed[i])
+          abort_unless(curlx_timediff_us(expire, nodes[i].key) <= 0,
+                       "next expire time after a pending node");
+      }
+    }
+  }
+  fail_unless(count == T3216_NODES - ((T3216_NODES + 2) / 3),
+              "wrong number of nodes returned");
+
+  /* a key within the current millisecond is only due when reached */
+  Curl_twheel_init(&wheel, t3216_ms(base));
+  key = t3216_ms(base + 5);
+  key.tv_usec += 500;
+  Curl_twheel_nodeinit(&nodes[0], NULL);
+  Curl_twheel_insert(&wheel, key, &nodes[0]);
+  fail_unless(Curl_twheel_next(&wheel, t3216_ms(base), &expire, &node) &&
+              !curlx_timediff_us(expire, key) && !node,
+              "next expire time is not exact");
+  now = t3216_ms(base + 5);
+  fail_unless(!Curl_twheel_getbest(&wheel, now), "node returned too early");
+  fail_unless(Curl_twheel_next(&wheel, now, &expire, &node) &&
+              !curlx_timediff_us(expire, key) && !node,
+              "next expire time is not exact");
+  now.tv_usec += 500;
+  fail_unless(Curl_twheel_getbest(&wheel, now) == &nodes[0],
+              "node not returned in time");
+  fail_unless(!Curl_twheel_count(&wheel), "wheel not empty");
+
+  /* a key before the wheel's time is due at once */
+  Curl_twheel_nodeinit(&nodes[1], NULL);
+  Curl_twheel_insert(&wheel, t3216_ms(base - 100), &nodes[1]);
+  fail_unless(Curl_twheel_next(&wheel, now, &expire, &node) &&
+              node == &nodes[1], "past node not expired");
+  fail_unless(Curl_twheel_getbest(&wheel, now) == &nodes[1],
+              "past node not returned");
+
+  UNITTEST_END_SIMPLE
+}
@@ -0,0 +1,185 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "splay.h"
+#include "timewheel.h"
+#include "memdebug.h"
+
+/*
+ * Compare the timing wheel with the splay tree on a load resembling many
+ * transfers: every transfer has a timer that is moved around often and
+ * expired timers are set again. The timings are written to stderr.
+ */
+
+#define T3217_NODES  50000
+#define T3217_ROUNDS 1000
+#define T3217_REARM  (T3217_NODES / 20)  /* timers moved per round */
+
+static unsigned int t3217_rand(unsigned int *seed)
+{
+  *seed = (*seed * 1103515245) + 12345;
+  return (*seed >> 8) & 0xffffff;
+}
+
+static struct curltime t3217_at(struct curltime now, unsigned int ms)
+{
+  now.tv_sec += (time_t)(ms / 1000);
+  now.tv_usec += (int)(ms % 1000) * 1000;
+  if(now.tv_usec >= 1000000) {
+    now.tv_sec++;
+    now.tv_usec -= 1000000;
+  }
+  return now;
+}
+
+/* a connect timer, a speed check or a timeout. Depends only on the timer
+   and the round so that both runs do the same thing. */
+static unsigned int t3217_delay(size_t idx, int rnd)
+{
+  unsigned int r = ((unsigned int)idx * 2654435761U) ^
+                   ((unsigned int)rnd * 40503U);
+  r = (r >> 7) ^ (r << 3);
+  switch(r % 3) {
+  case 0:
+    return 1 + (r % 200);
+  case 1:
+    return 1000;
+  default:
+    return 1000 + (r % 300000);
+  }
+}
+
+static size_t t3217_splay(struct Curl_tree *nodes, struct curltime start)
+{
+  struct Curl_tree *root = NULL, *t;
+  struct curltime now = start;
+  unsigned int seed = 1;
+  size_t i, expired = 0;
+  int r;
+
+  for(i = 0; i < T3217_NODES; i++) {
+    Curl_splayset(&nodes[i], &nodes[i]);
+    root = Curl_splayinsert(t3217_at(now, t3217_delay(i, 0)), root,
+                            &nodes[i]);
+  }
+  for(r = 0; r < T3217_ROUNDS; r++) {
+    now = t3217_at(now, 1);
+    for(i = 0; i < T3217_REARM; i++) {
+      size_t idx = t3217_rand(&seed) % T3217_NODES;
+      if(!Curl_splayremove(root, &nodes[idx], &root))
+        root = Curl_splayinsert(t3217_at(now, t3217_delay(idx, r)), root,
+                                &nodes[idx]);
+    }
+    for(;;) {
+      size_t idx;
+      root = Curl_splaygetbest(now, root, &t);
+      if(!t)
+        break;
+      idx = (size_t)(t - nodes);
+      expired++;
+      root = Curl_splayinsert(t3217_at(now, t3217_delay(idx, r)), root, t);
+    }
+  }
+  return expired;
+}
+
+static size_t t3217_wheel(struct Curl_twheel_node *nodes,
+                          struct curltime start)
+{
+  struct Curl_twheel wheel;
+  struct Curl_twheel_node *t;
+  struct curltime now = start;
+  unsigned int seed = 1;
+  size_t i, expired = 0;
+  int r;
+
+  Curl_twheel_init(&wheel, now);
+  for(i = 0; i < T3217_NODES; i++) {
+    Curl_twheel_nodeinit(&nodes[i], &nodes[i]);
+    Curl_twheel_insert(&wheel, t3217_at(now, t3217_delay(i, 0)), &nodes[i]);
+  }
+  for(r = 0; r < T3217_ROUNDS; r++) {
+    now = t3217_at(now, 1);
+    for(i = 0; i < T3217_REARM; i++) {
+      size_t idx = t3217_rand(&seed) % T3217_NODES;
+      if(!Curl_twheel_remove(&wheel, &nodes[idx]))
+        Curl_twheel_insert(&wheel, t3217_at(now, t3217_delay(idx, r)),
+                           &nodes[idx]);
+    }
+    for(;;) {
+      size_t idx;
+      t = Curl_twheel_getbest(&wheel, now);
+      if(!t)
+        break;
+      idx = (size_t)(t - nodes);
+      expired++;
+      Curl_twheel_insert(&wheel, t3217_at(now, t3217_delay(idx, r)), t);
+    }
+  }
+  return expired;
+}
+
+static CURLcode test_unit3217(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+
+  struct Curl_tree *tnodes;
+  struct Curl_twheel_node *wnodes;
+  struct curltime start = {1000, 0}, t0;
+  timediff_t splay_us, wheel_us;
+  size_t splay_expired, wheel_expired;
+
+  tnodes = calloc(T3217_NODES, sizeof(*tnodes));
+  wnodes = calloc(T3217_NODES, sizeof(*wnodes));
+  if(!tnodes || !wnodes) {
+    free(tnodes);
+    free(wnodes);
+    fail("out of memory");
+    goto unit_test_abort;
+  }
+
+  t0 = curlx_now();
+  splay_expired = t3217_splay(tnodes, start);
+  splay_us = curlx_timediff_us(curlx_now(), t0);
+
+  t0 = curlx_now();
+  wheel_expired = t3217_wheel(wnodes, start);
+  wheel_us = curlx_timediff_us(curlx_now(), t0);
+
+  /* same load, same outcome */
+  fail_unless(splay_expired == wheel_expired,
+              "different number of expired timers");
+
+  curl_mfprintf(stderr, "%d timers, %d rounds, %zu expired: "
+                "splay %" FMT_TIMEDIFF_T " us, "
+                "wheel %" FMT_TIMEDIFF_T " us\n",
+                T3217_NODES, T3217_ROUNDS, wheel_expired,
+                splay_us, wheel_us);
+
+  free(tnodes);
+  free(wnodes);
+
+  UNITTEST_END_SIMPLE
+}
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "memscan.h"
+#include "memdebug.h"
+
+/*
+ * Check Curl_memscan2() against a plain loop for all alignments and
+ * lengths, then time splitting a response header block into lines and
+ * names with both. The timings are written to stderr.
+ */
+
+#define T3218_HEADERS 40
+#define T3218_ROUNDS  20000
+
+static const char *t3218_scan(const char *p, size_t len, char c1, char c2)
+{
+  for(; len; ++p, --len) {
+    if((*p == c1) || (*p == c2))
+      return p;
+  }
+  return NULL;
+}
+
+typedef const char *t3218_scanner(const char *p, size_t len,
+                                  char c1, char c2);
+
+/* count the bytes of all header names in the block */
+static size_t t3218_split(t3218_scanner *scan, const char *block, size_t len)
+{
+  size_t names = 0;
+  while(len) {
+    const char *eol = scan(block, len, '\r', '\n');
+    const char *colon;
+    size_t llen = eol ? (size_t)(eol - block) : len;
+
+    colon = scan(block, llen, ':', '\0');
+    if(colon)
+      names += (size_t)(colon - block);
+    if(!eol)
+      break;
+    /* skip CRLF */
+    while(llen < len && (block[llen] == '\r' || block[llen] == '\n'))
+      llen++;
+    block += llen;
+    len -= llen;
+  }
+  return names;
+}
+
+static CURLcode test_unit3218(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+
+  static const char alphabet[] = "abcdefghijklmnop:\r\n";
+  char buf[200];
+  char *block;
+  size_t i, start, len, blen = 0;
+  size_t plain_names = 0, simd_names = 0;
+  unsigned int seed = 7;
+  struct curltime t0;
+  timediff_t plain_us, simd_us;
+  int r;
+
+  for(i = 0; i < sizeof(buf); i++) {
+    seed = (seed * 1103515245) + 12345;
+    buf[i] = alphabet[(seed >> 8) % (sizeof(alphabet) - 1)];
+  }
+  buf[150] = '\0';
+
+  for(start = 0; start < 64; start++) {
+    for(len = 0; start + len <= sizeof(buf); len++) {
+      fail_unless(Curl_memscan2(&buf[start], len, ':', '\0') ==
+                  t3218_scan(&buf[start], len, ':', '\0'),
+                  "':' or NUL found at wrong place");
+      fail_unless(Curl_memscan2(&buf[start], len, '\r', '\n') ==
+                  t3218_scan(&buf[start], len, '\r', '\n'),
+                  "CR or LF found at wrong place");
+      fail_unless(!Curl_memscan2(&buf[start], len, 'x', 'y'),
+                  "found a byte that is not there");
+    }
+  }
+
+  block = malloc(T3218_HEADERS * 256);
+  if(!block) {
+    fail("out of memory");
+    goto unit_test_abort;
+  }
+  blen = (size_t)curl_msnprintf(block, 256, "HTTP/1.1 200 OK\r\n");
+  for(i = 1; i < T3218_HEADERS; i++) {
+    size_t vlen = 20 + ((i * 37) % 180);
+    blen += (size_t)curl_msnprintf(&block[blen], 256, "X-Header-%zu: ", i);
+    memset(&block[blen], 'v', vlen);
+    blen += vlen;
+    block[blen++] = '\r';
+    block[blen++] = '\n';
+  }
+  block[blen++] = '\r';
+  block[blen++] = '\n';
+
+  t0 = curlx_now();
+  for(r = 0; r < T3218_ROUNDS; r++)
+    plain_names += t3218_split(t3218_scan, block, blen);
+  plain_us = curlx_timediff_us(curlx_now(), t0);
+
+  t0 = curlx_now();
+  for(r = 0; r < T3218_ROUNDS; r++)
+    simd_names += t3218_split(Curl_memscan2, block, blen);
+  simd_us = curlx_timediff_us(curlx_now(), t0);
+
+  fail_unless(plain_names == simd_names, "different header names found");
+
+  curl_mfprintf(stderr, "%d rounds of %zu header bytes: "
+                "plain %" FMT_TIMEDIFF_T " us, "
+                "memscan %" FMT_TIMEDIFF_T " us\n",
+                T3218_ROUNDS, blen, plain_us, simd_us);
+
+  free(block);
+
+  UNITTEST_END_SIMPLE
+}
@@ -0,0 +1,257 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+#include "urldata.h"
+#include "sendf.h"
+#include "http_chunks.h"
+#include "curlx/dynbuf.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Feed generated chunked streams, valid and randomly damaged ones, to the
+ * chunked decoder in one piece, in random pieces and byte by byte. Fed
+ * byte by byte, the decoder steps through its states one byte at a time as
+ * it always did. All ways must give the same result and the same output.
+ */
+
+#define T3219_STREAMS 400
+#define T3219_OUTMAX  (64 * 1024)
+
+struct t3219_writer {
+  struct Curl_cwriter super;
+  struct dynbuf body;
+  struct dynbuf trailer;
+};
+
+static CURLcode t3219_init(struct Curl_easy *data,
+                           struct Curl_cwriter *writer)
+{
+  struct t3219_writer *ctx = writer->ctx;
+  (void)data;
+  curlx_dyn_init(&ctx->body, T3219_OUTMAX);
+  curlx_dyn_init(&ctx->trailer, T3219_OUTMAX);
+  return CURLE_OK;
+}
+
+static CURLcode t3219_write(struct Curl_easy *data,
+                            struct Curl_cwriter *writer, int type,
+                            const char *buf, size_t blen)
+{
+  struct t3219_writer *ctx = writer->ctx;
+  (void)data;
+  if(type & CLIENTWRITE_TRAILER)
+    return curlx_dyn_addn(&ctx->trailer, buf, blen);
+  if(type & CLIENTWRITE_BODY)
+    return curlx_dyn_addn(&ctx->body, buf, blen);
+  return CURLE_OK;
+}
+
+static void t3219_close(struct Curl_easy *data, struct Curl_cwriter *writer)
+{
+  struct t3219_writer *ctx = writer->ctx;
+  (void)data;
+  curlx_dyn_free(&ctx->body);
+  curlx_dyn_free(&ctx->trailer);
+}
+
+static const struct Curl_cwtype t3219_collect = {
+  "collect",
+  NULL,
+  t3219_init,
+  t3219_write,
+  t3219_close,
+  sizeof(struct t3219_writer)
+};
+
+struct t3219_result {
+  CURLcode result;
+  bool done;
+  struct dynbuf out; /* body, then trailer */
+};
+
+static unsigned int t3219_rand(unsigned int *seed)
+{
+  *seed = (*seed * 1103515245) + 12345;
+  return (*seed >> 8) & 0xffffff;
+}
+
+static CURLcode t3219_gen(struct dynbuf *s, unsigned int *seed)
+{
+  static const char hex[] = "0123456789abcdef0123456789ABCDEF";
+  int nchunks = (int)(t3219_rand(seed) % 20);
+  CURLcode result = CURLE_OK;
+  int i;
+
+  curlx_dyn_reset(s);
+  for(i = 0; !result && (i <= nchunks); i++) {
+    size_t len = (i < nchunks) ? 1 + (t3219_rand(seed) % 300) : 0;
+    size_t upper = (t3219_rand(seed) & 1) ? 16 : 0;
+    char num[20];
+    size_t n = 0, j;
+
+    if(!(t3219_rand(seed) % 8))
+      num[n++] = '0';
+    if(!len)
+      num[n++] = '0';
+    else {
+      char tmp[16];
+      size_t k = 0;
+      for(j = len; j; j >>= 4)
+        tmp[k++] = hex[upper + (j & 0xf)];
+      while(k)
+        num[n++] = tmp[--k];
+    }
+    result = curlx_dyn_addn(s, num, n);
+    if(!result && !(t3219_rand(seed) % 4))
+      result = curlx_dyn_addf(s, ";ext%u=\"v\"", t3219_rand(seed) % 100);
+    if(!result)
+      result = curlx_dyn_addn(s, STRCONST("\r\n"));
+    for(j = 0; !result && (j < len); j++) {
+      char c = (char)(t3219_rand(seed) & 0xff);
+      result = curlx_dyn_addn(s, &c, 1);
+    }
+    if(!result && len)
+      result = curlx_dyn_addn(s, STRCONST("\r\n"));
+  }
+  for(i = (int)(t3219_rand(seed) % 3); !result && i; i--)
+    result = curlx_dyn_addf(s, "X-Trailer-%d: value %u\r\n", i,
+                            t3219_rand(seed));
+  if(!result)
+    result = curlx_dyn_addn(s, STRCONST("\r\n"));
+  return result;
+}
+
+/* step 0 feeds random pieces */
+static void t3219_feed(struct Curl_easy *data, const char *in, size_t inlen,
+                       size_t step, unsigned int *seed,
+                       struct t3219_result *res)
+{
+  struct Curl_cwriter *chunked = NULL, *collect = NULL;
+  struct t3219_writer *ctx;
+
+  curlx_dyn_init(&res->out, 2 * T3219_OUTMAX);
+  res->result = Curl_cwriter_create(&chunked, data, &Curl_httpchunk_unencoder,
+                                    CURL_CW_TRANSFER_DECODE);
+  if(!res->result)
+    res->result = Curl_cwriter_create(&collect, data, &t3219_collect,
+                                      CURL_CW_CLIENT);
+  if(res->result)
+    goto out;
+  chunked->next = collect;
+  data->req.download_done = FALSE;
+
+  while(inlen) {
+    size_t n = step ? step : 1 + (t3219_rand(seed) % 64);
+    if(n > inlen)
+      n = inlen;
+    res->result = Curl_cwriter_write(data, chunked, CLIENTWRITE_BODY, in, n);
+    if(res->result)
+      break;
+    in += n;
+    inlen -= n;
+  }
+  res->done = data->req.download_done;
+  ctx = collect->ctx;
+  if(curlx_dyn_addn(&res->out, curlx_dyn_ptr(&ctx->body),
+                    curlx_dyn_len(&ctx->body)) ||
+     curlx_dyn_addn(&res->out, STRCONST("|")) ||
+     curlx_dyn_addn(&res->out, curlx_dyn_ptr(&ctx->trailer),
+                    curlx_dyn_len(&ctx->trailer)))
+    res->result = CURLE_OUT_OF_MEMORY;
+out:
+  Curl_cwriter_free(data, chunked);
+  Curl_cwriter_free(data, collect);
+}
+
+static bool t3219_same(struct t3219_result *a, struct t3219_result *b)
+{
+  return (a->result == b->result) && (a->done == b->done) &&
+    (curlx_dyn_len(&a->out) == curlx_dyn_len(&b->out)) &&
+    !memcmp(curlx_dyn_ptr(&a->out), curlx_dyn_ptr(&b->out),
+            curlx_dyn_len(&a->out));
+}
+
+static CURLcode t3219_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  return res;
+}
+
+static CURLcode test_unit3219(const char *arg)
+{
+  UNITTEST_BEGIN(t3219_setup())
+
+  struct Curl_easy *data = curl_easy_init();
+  struct dynbuf stream;
+  unsigned int seed = 3219;
+  int i;
+
+  if(!data) {
+    fail("curl_easy_init() failed");
+    goto unit_test_abort;
+  }
+  curlx_dyn_init(&stream, T3219_OUTMAX);
+
+  for(i = 0; i < 2 * T3219_STREAMS; i++) {
+    struct t3219_result whole, pieces, bytes;
+    char *in;
+    size_t inlen;
+
+    if(t3219_gen(&stream, &seed)) {
+      fail("out of memory");
+      break;
+    }
+    in = curlx_dyn_ptr(&stream);
+    inlen = curlx_dyn_len(&stream);
+    if(i >= T3219_STREAMS) {
+      /* damage the second half of the streams */
+      int n = 1 + (int)(t3219_rand(&seed) % 3);
+      while(n--)
+        in[t3219_rand(&seed) % inlen] = (char)(t3219_rand(&seed) & 0xff);
+    }
+
+    t3219_feed(data, in, inlen, inlen, &seed, &whole);
+    t3219_feed(data, in, inlen, 0, &seed, &pieces);
+    t3219_feed(data, in, inlen, 1, &seed, &bytes);
+
+    if(i < T3219_STREAMS) {
+      fail_unless(!whole.result && whole.done, "valid stream not decoded");
+    }
+    fail_unless(t3219_same(&whole, &bytes),
+                "whole and byte-wise decoding differ");
+    fail_unless(t3219_same(&pieces, &bytes),
+                "piece-wise and byte-wise decoding differ");
+
+    curlx_dyn_free(&whole.out);
+    curlx_dyn_free(&pieces.out);
+    curlx_dyn_free(&bytes.out);
+  }
+
+  curlx_dyn_free(&stream);
+  curl_easy_cleanup(data);
+
+  UNITTEST_END(curl_global_cleanup())
+}
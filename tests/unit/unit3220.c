@@ -0,0 +1,278 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+#include "urldata.h"
+#include "cookie.h"
+#include "hostip.h"
+#include "strcase.h"
+#include "curlx/strparse.h"
+
+#include "memdebug.h" /* LAST include file */
+
+/*
+ * Load a large generated Netscape cookie file and check that the cookies
+ * found for a set of hosts and paths are exactly the ones a plain scan of
+ * all cookies with the RFC6265 domain and path matching rules finds.
+ */
+
+#define T3220_COOKIES 20000
+#define T3220_DOMAINS 1000
+#define T3220_QUERIES 2000
+
+struct t3220_cookie {
+  char domain[40];
+  const char *path;
+  bool tailmatch;
+  bool secure;
+  bool session;
+  bool expired;
+};
+
+static const char *t3220_paths[] = {
+  "/", "/a", "/a/b", "/a/bc", "/b", "/A", "/a/b/c", "/a/b/", "/a//b"
+};
+
+static const char *t3220_reqpaths[] = {
+  "/", "/a", "/a/b", "/a/bc", "/a/b/c/d", "/ab", "/a?x", "/A/b", "",
+  "/b/", "/a/b/", "/a//b/c"
+};
+
+static unsigned int t3220_rand(unsigned int *seed)
+{
+  *seed = (*seed * 1103515245) + 12345;
+  return (*seed >> 8) & 0xffffff;
+}
+
+static void t3220_domain(char *buf, size_t len, unsigned int d)
+{
+  if(d % 10 == 9)
+    curl_msnprintf(buf, len, "10.0.%u.%u", d / 256, d % 256);
+  else if(d < 100)
+    curl_msnprintf(buf, len, "example%u.com", d);
+  else
+    curl_msnprintf(buf, len, "s%u.example%u.com", d / 100, d % 100);
+}
+
+static bool t3220_pathmatch(const char *spath, const char *uri)
+{
+  size_t clen = strlen(spath);
+  size_t ulen;
+
+  if(clen == 1)
+    return TRUE;
+  if(uri[0] != '/')
+    uri = "/";
+  ulen = strlen(uri);
+  if((ulen < clen) || strncmp(spath, uri, clen))
+    return FALSE;
+  return (ulen == clen) || (uri[clen] == '/');
+}
+
+static bool t3220_match(const struct t3220_cookie *c, const char *host,
+                        const char *path, bool secure)
+{
+  char spath[16];
+  size_t plen = strlen(c->path);
+
+  if(c->expired || (c->secure && !secure))
+    return FALSE;
+
+  if(c->tailmatch && !Curl_host_is_ipnum(host)) {
+    size_t hlen = strlen(host);
+    size_t dlen = strlen(c->domain);
+    if((hlen < dlen) || !curl_strequal(c->domain, host + hlen - dlen) ||
+       ((hlen > dlen) && (host[hlen - dlen - 1] != '.')))
+      return FALSE;
+  }
+  else if(!curl_strequal(c->domain, host))
+    return FALSE;
+
+  /* the sanitized path has no trailing slash */
+  if((plen > 1) && (c->path[plen - 1] == '/'))
+    plen--;
+  memcpy(spath, c->path, plen);
+  spath[plen] = 0;
+  return t3220_pathmatch(spath, path);
+}
+
+static CURLcode t3220_write(const char *file,
+                            struct t3220_cookie *jar, unsigned int *seed)
+{
+  FILE *fp = fopen(file, "wb");
+  unsigned int i;
+
+  if(!fp)
+    return CURLE_WRITE_ERROR;
+  fputs("# Netscape HTTP Cookie File\n", fp);
+  for(i = 0; i < T3220_COOKIES; i++) {
+    struct t3220_cookie *c = &jar[i];
+    unsigned int r = t3220_rand(seed);
+    t3220_domain(c->domain, sizeof(c->domain),
+                 t3220_rand(seed) % T3220_DOMAINS);
+    if(r & 0x100)
+      /* domains match case-insensitively */
+      Curl_strntoupper(c->domain, c->domain, sizeof(c->domain));
+    c->path = t3220_paths[r % CURL_ARRAYSIZE(t3220_paths)];
+    c->tailmatch = !!(r & 0x200);
+    c->secure = !(r & 0xc00);
+    c->expired = !(r & 0xf000);
+    c->session = !c->expired && !(r & 0x30000);
+    curl_mfprintf(fp, "%s%s\t%s\t%s\t%s\t%s\tc%u\tv%u\n",
+                  c->tailmatch ? "." : "", c->domain,
+                  c->tailmatch ? "TRUE" : "FALSE", c->path,
+                  c->secure ? "TRUE" : "FALSE",
+                  c->expired ? "1" : (c->session ? "0" : "2147483647"),
+                  i, i);
+  }
+  fclose(fp);
+  return CURLE_OK;
+}
+
+static void t3220_query(struct Curl_easy *data, struct CookieInfo *ci,
+                        struct t3220_cookie *jar, unsigned int *seed,
+                        unsigned char *found)
+{
+  char host[64];
+  unsigned int r = t3220_rand(seed);
+  const char *path = t3220_reqpaths[r % CURL_ARRAYSIZE(t3220_reqpaths)];
+  bool secure = !!(r & 0x100);
+  struct Curl_llist list;
+  struct Curl_llist_node *n;
+  size_t expected = 0;
+  size_t matches = 0;
+  size_t prevlen = (size_t)-1;
+  unsigned int i;
+
+  t3220_domain(host, sizeof(host), t3220_rand(seed) % T3220_DOMAINS);
+  switch((r >> 9) & 3) {
+  case 1:
+    if(!Curl_host_is_ipnum(host)) {
+      char sub[64];
+      curl_msnprintf(sub, sizeof(sub), "x.%s", host);
+      strcpy(host, sub);
+    }
+    break;
+  case 2:
+    Curl_strntoupper(host, host, sizeof(host));
+    break;
+  case 3:
+    strcpy(host, "nomatch.example");
+    break;
+  default:
+    break;
+  }
+
+  memset(found, 0, T3220_COOKIES);
+  if(!Curl_cookie_getlist(data, ci, host, path, secure, &list)) {
+    for(n = Curl_llist_head(&list); n; n = Curl_node_next(n)) {
+      struct Cookie *co = Curl_node_elem(n);
+      size_t plen = co->path ? strlen(co->path) : 0;
+      const char *p = co->name + 1;
+      curl_off_t num;
+      if(!curlx_str_number(&p, &num, T3220_COOKIES - 1))
+        found[num] = 1;
+      else
+        fail("unexpected cookie name");
+      fail_unless(plen <= prevlen, "cookies not sorted by path length");
+      prevlen = plen;
+      matches++;
+    }
+    Curl_llist_destroy(&list, NULL);
+  }
+
+  for(i = 0; i < T3220_COOKIES; i++) {
+    if(t3220_match(&jar[i], host, path, secure)) {
+      expected++;
+      if(!found[i]) {
+        curl_mfprintf(stderr, "c%u for %s%s not found\n", i, host, path);
+        fail("matching cookie not found");
+      }
+    }
+  }
+  if(expected != matches) {
+    curl_mfprintf(stderr, "%s%s: %zu cookies found, %zu expected\n",
+                  host, path, matches, expected);
+    fail("wrong number of cookies found");
+  }
+}
+
+static CURLcode t3220_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  return res;
+}
+
+static CURLcode test_unit3220(const char *arg)
+{
+  UNITTEST_BEGIN(t3220_setup())
+
+  struct Curl_easy *data = curl_easy_init();
+  struct t3220_cookie *jar = calloc(T3220_COOKIES, sizeof(*jar));
+  unsigned char *found = malloc(T3220_COOKIES);
+  struct CookieInfo *ci = NULL;
+  unsigned int seed = 3220;
+  unsigned int loaded = 0;
+  unsigned int i;
+
+  if(!data || !jar || !found)
+    fail("out of memory");
+  else if(t3220_write(arg, jar, &seed))
+    fail("cannot write cookie file");
+  else
+    ci = Curl_cookie_init(data, arg, NULL, FALSE);
+
+  if(ci) {
+    for(i = 0; i < T3220_COOKIES; i++)
+      if(!jar[i].expired)
+        loaded++;
+    fail_unless(ci->numcookies == loaded, "wrong number of cookies loaded");
+
+    for(i = 0; i < T3220_QUERIES; i++)
+      t3220_query(data, ci, jar, &seed, found);
+
+    /* drop the session cookies and check again */
+    Curl_cookie_clearsess(ci);
+    for(i = 0; i < T3220_COOKIES; i++) {
+      if(jar[i].session) {
+        jar[i].expired = TRUE;
+        loaded--;
+      }
+    }
+    fail_unless(ci->numcookies == loaded, "wrong number of cookies left");
+
+    for(i = 0; i < T3220_QUERIES; i++)
+      t3220_query(data, ci, jar, &seed, found);
+
+    Curl_cookie_cleanup(ci);
+  }
+  else if(data && jar && found)
+    fail("Curl_cookie_init() failed");
+
+  free(found);
+  free(jar);
+  curl_easy_cleanup(data);
+
+  UNITTEST_END(curl_global_cleanup())
+}
@@ -0,0 +1,340 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+#include "urldata.h"
+#include "hsts.h"
+#include "altsvc.h"
+#include "strcase.h"
+
+#include "memdebug.h" /* LAST include file */
+
+#if defined(CURL_DISABLE_HTTP) || defined(CURL_DISABLE_HSTS) || \
+  defined(CURL_DISABLE_ALTSVC)
+static CURLcode test_unit3221(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+  puts("nothing to do when HTTP, HSTS or alt-svc are disabled");
+  UNITTEST_END_SIMPLE
+}
+#else
+
+/*
+ * Load a large generated HSTS file and check that the entries found for a
+ * set of hostnames are the ones a plain scan of all entries finds. Then add
+ * alt-svc entries for many origins, and load them from a file, and look them
+ * up.
+ */
+
+#define T3221_ENTRIES 10000
+#define T3221_QUERIES 4000
+#define T3221_ORIGINS 2000
+
+struct t3221_sts {
+  char host[48];
+  bool subdomains;
+  bool expired;
+  bool added;
+};
+
+static unsigned int t3221_rand(unsigned int *seed)
+{
+  *seed = (*seed * 1103515245) + 12345;
+  return (*seed >> 8) & 0xffffff;
+}
+
+/* unique hostnames in three levels */
+static void t3221_host(char *buf, size_t len, unsigned int n)
+{
+  if(n % 4 == 0)
+    curl_msnprintf(buf, len, "example%u.com", n / 4);
+  else if(n % 4 == 1)
+    curl_msnprintf(buf, len, "s.example%u.com", n / 4);
+  else if(n % 4 == 2)
+    curl_msnprintf(buf, len, "t.s.example%u.com", n / 4);
+  else
+    curl_msnprintf(buf, len, "other%u.com", n / 4);
+}
+
+/* the entry for this hostname the way the HSTS cache is defined to find it:
+   an exact match or else the longest parent including its subdomains */
+static struct t3221_sts *t3221_find(struct t3221_sts *sts, size_t num,
+                                    const char *host, bool subdomain)
+{
+  struct t3221_sts *best = NULL;
+  size_t hlen = strlen(host);
+  size_t blen = 0;
+  size_t i;
+
+  if(hlen && (host[hlen - 1] == '.'))
+    hlen--;
+  for(i = 0; i < num; i++) {
+    size_t ntail = strlen(sts[i].host);
+    if(!sts[i].added || sts[i].expired)
+      continue;
+    if((ntail == hlen) && curl_strnequal(sts[i].host, host, hlen))
+      return &sts[i];
+    if(subdomain && sts[i].subdomains && (ntail < hlen) && (ntail > blen) &&
+       (host[hlen - ntail - 1] == '.') &&
+       curl_strnequal(sts[i].host, &host[hlen - ntail], ntail)) {
+      best = &sts[i];
+      blen = ntail;
+    }
+  }
+  return best;
+}
+
+static CURLcode t3221_write(const char *file, struct t3221_sts *sts,
+                            unsigned int *seed)
+{
+  FILE *fp = fopen(file, "wb");
+  unsigned int i;
+
+  if(!fp)
+    return CURLE_WRITE_ERROR;
+  fputs("# Your HSTS cache. https://curl.se/docs/hsts.html\n", fp);
+  for(i = 0; i < T3221_ENTRIES; i++) {
+    struct t3221_sts *s = &sts[i];
+    unsigned int r = t3221_rand(seed);
+    t3221_host(s->host, sizeof(s->host), i);
+    if(r & 0x100)
+      /* hostnames match case-insensitively */
+      Curl_strntoupper(s->host, s->host, sizeof(s->host));
+    s->subdomains = !!(r & 0x200);
+    s->expired = !(r & 0xc00);
+    /* a line with subdomains is not added when a parent covers it */
+    s->added = !s->subdomains || !t3221_find(sts, i, s->host, TRUE);
+    curl_mfprintf(fp, "%s%s \"%s\"\n", s->subdomains ? "." : "", s->host,
+                  s->expired ? "20180101 00:00:00" :
+                  (r & 0x1000) ? "unlimited" : "20300101 00:00:00");
+  }
+  fclose(fp);
+  return CURLE_OK;
+}
+
+static void t3221_query(struct hsts *h, struct t3221_sts *sts,
+                        unsigned int *seed)
+{
+  char host[64];
+  char buf[64];
+  unsigned int r = t3221_rand(seed);
+  bool subdomain = !!(r & 0x100);
+  struct t3221_sts *expected;
+  struct stsentry *e;
+
+  t3221_host(host, sizeof(host), t3221_rand(seed) % T3221_ENTRIES);
+  switch((r >> 9) & 3) {
+  case 1:
+    curl_msnprintf(buf, sizeof(buf), "x.%s", host);
+    strcpy(host, buf);
+    break;
+  case 2:
+    Curl_strntoupper(host, host, sizeof(host));
+    break;
+  case 3:
+    curl_msnprintf(buf, sizeof(buf), "%s.", host);
+    strcpy(host, buf);
+    break;
+  default:
+    break;
+  }
+
+  expected = t3221_find(sts, T3221_ENTRIES, host, subdomain);
+  e = Curl_hsts(h, host, strlen(host), subdomain);
+  if(!expected != !e) {
+    curl_mfprintf(stderr, "%s: %s\n", host,
+                  e ? "unexpected match" : "no match");
+    fail("wrong HSTS lookup result");
+  }
+  else if(e && strcmp(e->host, expected->host)) {
+    curl_mfprintf(stderr, "%s: matched %s, expected %s\n", host, e->host,
+                  expected->host);
+    fail("wrong HSTS entry found");
+  }
+}
+
+static void t3221_hsts(struct Curl_easy *data, const char *file)
+{
+  struct t3221_sts *sts = calloc(T3221_ENTRIES, sizeof(*sts));
+  struct hsts *h = Curl_hsts_init();
+  unsigned int seed = 3221;
+  char savename[256];
+  size_t loaded = 0;
+  unsigned int i;
+
+  if(!sts || !h)
+    fail("out of memory");
+  else if(t3221_write(file, sts, &seed))
+    fail("cannot write HSTS file");
+  else if(Curl_hsts_loadfile(data, h, file))
+    fail("Curl_hsts_loadfile() failed");
+  else {
+    for(i = 0; i < T3221_QUERIES; i++)
+      t3221_query(h, sts, &seed);
+
+    /* saving prunes the expired entries */
+    curl_msnprintf(savename, sizeof(savename), "%s.save", file);
+    (void)Curl_hsts_save(data, h, savename);
+    for(i = 0; i < T3221_ENTRIES; i++)
+      if(sts[i].added && !sts[i].expired)
+        loaded++;
+    fail_unless(Curl_llist_count(&h->list) == loaded,
+                "wrong number of HSTS entries");
+  }
+  Curl_hsts_cleanup(&h);
+  free(sts);
+}
+
+static void t3221_altsvc(struct Curl_easy *data)
+{
+  struct altsvcinfo *asi = Curl_altsvc_init();
+  struct altsvc *as;
+  char host[64];
+  char value[128];
+  unsigned int i;
+
+  if(!asi) {
+    fail("out of memory");
+    return;
+  }
+  for(i = 0; i < T3221_ORIGINS; i++) {
+    curl_msnprintf(host, sizeof(host), "h%u.example.org", i);
+    curl_msnprintf(value, sizeof(value),
+                   "h2=\"alt%u.example.net:443\", h3=\":8443\"\r\n", i);
+    fail_if(Curl_altsvc_parse(data, asi, value, ALPN_h1, host, 443),
+            "Curl_altsvc_parse() failed");
+  }
+  fail_unless(Curl_llist_count(&asi->list) == 2 * T3221_ORIGINS,
+              "wrong number of alt-svc entries");
+
+  for(i = 0; i < T3221_ORIGINS; i++) {
+    char alt[64];
+    curl_msnprintf(host, sizeof(host), "H%u.EXAMPLE.ORG.", i);
+    curl_msnprintf(alt, sizeof(alt), "alt%u.example.net", i);
+    if(!Curl_altsvc_lookup(asi, ALPN_h1, host, 443, &as, ALPN_h2 | ALPN_h3) ||
+       strcmp(as->dst.host, alt) || (as->dst.alpnid != ALPN_h2))
+      fail("first alternative not found");
+    if(!Curl_altsvc_lookup(asi, ALPN_h1, host, 443, &as, ALPN_h3) ||
+       (as->dst.port != 8443))
+      fail("h3 alternative not found");
+    fail_if(Curl_altsvc_lookup(asi, ALPN_h1, host, 80, &as, ALPN_h3),
+            "alt-svc for another port");
+    fail_if(Curl_altsvc_lookup(asi, ALPN_h2, host, 443, &as, ALPN_h3),
+            "alt-svc for another ALPN");
+  }
+
+  /* clear every other origin */
+  for(i = 0; i < T3221_ORIGINS; i += 2) {
+    curl_msnprintf(host, sizeof(host), "h%u.example.org", i);
+    fail_if(Curl_altsvc_parse(data, asi, "clear", ALPN_h1, host, 443),
+            "Curl_altsvc_parse() failed");
+  }
+  fail_unless(Curl_llist_count(&asi->list) == T3221_ORIGINS,
+              "wrong number of alt-svc entries after clear");
+  for(i = 0; i < T3221_ORIGINS; i++) {
+    bool hit;
+    curl_msnprintf(host, sizeof(host), "h%u.example.org", i);
+    hit = Curl_altsvc_lookup(asi, ALPN_h1, host, 443, &as, ALPN_h3);
+    fail_unless(hit == (i & 1), "wrong alt-svc lookup after clear");
+  }
+  Curl_altsvc_cleanup(&asi);
+}
+
+/* entries loaded from a file are found and can be cleared the same way */
+static void t3221_altsvc_file(struct Curl_easy *data, const char *file)
+{
+  struct altsvcinfo *asi = Curl_altsvc_init();
+  struct altsvc *as;
+  char altname[256];
+  char host[64];
+  unsigned int i;
+  FILE *fp;
+
+  curl_msnprintf(altname, sizeof(altname), "%s.altsvc", file);
+  fp = fopen(altname, "wb");
+  if(!asi || !fp) {
+    fail(asi ? "cannot write alt-svc file" : "out of memory");
+    if(fp)
+      fclose(fp);
+    Curl_altsvc_cleanup(&asi);
+    return;
+  }
+  fputs("# Your alt-svc cache. https://curl.se/docs/alt-svc.html\n", fp);
+  for(i = 0; i < T3221_ORIGINS; i++)
+    curl_mfprintf(fp, "h1 f%u.example.org 443 h3 alt%u.example.net 8443 "
+                  "\"20300101 00:00:00\" 0 0\n", i, i);
+  fclose(fp);
+
+  fail_if(Curl_altsvc_load(asi, altname), "Curl_altsvc_load() failed");
+  fail_unless(Curl_llist_count(&asi->list) == T3221_ORIGINS,
+              "wrong number of loaded alt-svc entries");
+  for(i = 0; i < T3221_ORIGINS; i++) {
+    char alt[64];
+    curl_msnprintf(host, sizeof(host), "f%u.example.org", i);
+    curl_msnprintf(alt, sizeof(alt), "alt%u.example.net", i);
+    if(!Curl_altsvc_lookup(asi, ALPN_h1, host, 443, &as, ALPN_h3) ||
+       strcmp(as->dst.host, alt) || (as->dst.port != 8443))
+      fail("loaded alternative not found");
+  }
+
+  /* a new header for an origin replaces its loaded entries */
+  for(i = 0; i < T3221_ORIGINS; i += 2) {
+    curl_msnprintf(host, sizeof(host), "f%u.example.org", i);
+    fail_if(Curl_altsvc_parse(data, asi, "clear", ALPN_h1, host, 443),
+            "Curl_altsvc_parse() failed");
+  }
+  fail_unless(Curl_llist_count(&asi->list) == T3221_ORIGINS / 2,
+              "wrong number of loaded alt-svc entries after clear");
+  for(i = 0; i < T3221_ORIGINS; i++) {
+    bool hit;
+    curl_msnprintf(host, sizeof(host), "f%u.example.org", i);
+    hit = Curl_altsvc_lookup(asi, ALPN_h1, host, 443, &as, ALPN_h3);
+    fail_unless(hit == (i & 1), "wrong loaded alt-svc lookup after clear");
+  }
+  Curl_altsvc_cleanup(&asi);
+}
+
+static CURLcode t3221_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  return res;
+}
+
+static CURLcode test_unit3221(const char *arg)
+{
+  UNITTEST_BEGIN(t3221_setup())
+
+  struct Curl_easy *data = curl_easy_init();
+  if(!data)
+    fail("out of memory");
+  else {
+    t3221_hsts(data, arg);
+    t3221_altsvc(data);
+    t3221_altsvc_file(data, arg);
+  }
+  curl_easy_cleanup(data);
+
+  UNITTEST_END(curl_global_cleanup())
+}
+#endif
@@ -0,0 +1,191 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+#include "urldata.h"
+#include "vtls/vtls.h"
+#include "vtls/vtls_scache.h"
+#include "vtls/vtls_spack.h"
+#include "curlx/dynbuf.h"
+
+#include "memdebug.h" /* LAST include file */
+
+#if !defined(USE_SSL) || !defined(USE_SSLS_EXPORT)
+static CURLcode test_unit3222(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+  puts("nothing to do without SSL session export support");
+  UNITTEST_END_SIMPLE
+}
+#else
+
+/*
+ * Import sessions for more peers than the shared session cache holds and
+ * check which peers get evicted, that peer keys are found case
+ * insensitively and that peers imported with only a salted hash of their
+ * key are found again by their key.
+ */
+
+#define T3222_PEERS 25  /* the size of a share's session cache */
+#define T3222_IMPORTS 100
+#define T3222_TOUCHED 60  /* used again after import 80 */
+
+struct t3222_export {
+  bool seen[T3222_IMPORTS];
+  size_t tickets[T3222_IMPORTS];
+  size_t count;
+  unsigned char shmac[T3222_IMPORTS][64];
+  size_t shmac_len;
+};
+
+static CURLcode t3222_export_cb(CURL *handle, void *userptr,
+                                const char *session_key,
+                                const unsigned char *shmac, size_t shmac_len,
+                                const unsigned char *sdata, size_t sdata_len,
+                                curl_off_t valid_until, int ietf_tls_id,
+                                const char *alpn, size_t earlydata_max)
+{
+  struct t3222_export *e = userptr;
+  int i;
+
+  (void)handle;
+  (void)sdata;
+  (void)sdata_len;
+  (void)valid_until;
+  (void)ietf_tls_id;
+  (void)alpn;
+  (void)earlydata_max;
+  if(!session_key)
+    return CURLE_OK;
+  if((sscanf(session_key, "peer%d.example:443:G", &i) != 1) ||
+     (i < 0) || (i >= T3222_IMPORTS) || (shmac_len > sizeof(e->shmac[0])))
+    return CURLE_BAD_FUNCTION_ARGUMENT;
+  if(!e->seen[i])
+    e->count++;
+  e->seen[i] = TRUE;
+  e->tickets[i]++;
+  memcpy(e->shmac[i], shmac, shmac_len);
+  e->shmac_len = shmac_len;
+  return CURLE_OK;
+}
+
+static CURLcode t3222_import(CURL *curl, const char *key,
+                             const unsigned char *shmac, size_t shmac_len)
+{
+  struct Curl_easy *data = curl;
+  struct Curl_ssl_session *s;
+  struct dynbuf buf;
+  CURLcode result;
+  char *sdata = strdup("ticket");
+
+  if(!sdata)
+    return CURLE_OUT_OF_MEMORY;
+  result = Curl_ssl_session_create(sdata, 6, CURL_IETF_PROTO_TLS1_3, NULL,
+                                   (curl_off_t)time(NULL) + 3600, 0, &s);
+  if(result)
+    return result;
+  curlx_dyn_init(&buf, 16 * 1024);
+  result = Curl_ssl_session_pack(data, s, &buf);
+  if(!result)
+    result = Curl_ssl_session_import(data, key, shmac, shmac_len,
+                                     curlx_dyn_uptr(&buf),
+                                     curlx_dyn_len(&buf));
+  curlx_dyn_free(&buf);
+  Curl_ssl_session_destroy(s);
+  return result;
+}
+
+static CURLcode t3222_setup(void)
+{
+  CURLcode res = CURLE_OK;
+  global_init(CURL_GLOBAL_ALL);
+  return res;
+}
+
+static CURLcode test_unit3222(const char *arg)
+{
+  UNITTEST_BEGIN(t3222_setup())
+
+  static struct t3222_export e, e2;
+  CURLSH *share = curl_share_init();
+  CURLSH *share2 = curl_share_init();
+  CURL *curl = curl_easy_init();
+  char key[64];
+  int i;
+
+  abort_unless(share && share2 && curl, "init failed");
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  curl_share_setopt(share2, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  curl_easy_setopt(curl, CURLOPT_SHARE, share);
+
+  for(i = 0; i < T3222_IMPORTS; ++i) {
+    msnprintf(key, sizeof(key), "peer%d.example:443:G", i);
+    fail_unless(!t3222_import(curl, key, NULL, 0), "import failed");
+    if(i == 80) {
+      /* peers 56-80 are in the cache now, use one of the oldest again */
+      msnprintf(key, sizeof(key), "PEER%d.EXAMPLE:443:G", T3222_TOUCHED);
+      fail_unless(!t3222_import(curl, key, NULL, 0), "import failed");
+    }
+  }
+
+  fail_unless(!curl_easy_ssls_export(curl, t3222_export_cb, &e),
+              "export failed");
+  fail_unless(e.count == T3222_PEERS, "wrong number of peers");
+  for(i = 0; i < T3222_IMPORTS; ++i) {
+    /* the used peer stays, in its place the next newer one is evicted */
+    bool kept = (i > T3222_IMPORTS - T3222_PEERS) || (i == T3222_TOUCHED);
+    fail_unless(e.seen[i] == kept, "wrong peer evicted");
+    if(kept)
+      fail_unless(e.tickets[i] == ((i == T3222_TOUCHED) ? 2 : 1),
+                  "wrong number of tickets");
+  }
+
+  /* import into another cache with only the salted hashes of the keys */
+  curl_easy_setopt(curl, CURLOPT_SHARE, share2);
+  for(i = 0; i < T3222_IMPORTS; ++i) {
+    if(e.seen[i])
+      fail_unless(!t3222_import(curl, NULL, e.shmac[i], e.shmac_len),
+                  "hmac import failed");
+  }
+  /* these find their peers by the hash, nothing gets evicted */
+  for(i = 0; i < T3222_IMPORTS; ++i) {
+    if(e.seen[i] && (i % 2)) {
+      msnprintf(key, sizeof(key), "peer%d.example:443:G", i);
+      fail_unless(!t3222_import(curl, key, NULL, 0), "import failed");
+    }
+  }
+  /* peers still without key are not exported with one */
+  curl_easy_ssls_export(curl, t3222_export_cb, &e2);
+  for(i = 0; i < T3222_IMPORTS; ++i) {
+    fail_unless(e2.seen[i] == (e.seen[i] && (i % 2)), "wrong peer keys");
+    if(e2.seen[i])
+      fail_unless(e2.tickets[i] == 2, "ticket not added to hmac peer");
+  }
+
+  curl_easy_cleanup(curl);
+  curl_share_cleanup(share);
+  curl_share_cleanup(share2);
+
+  UNITTEST_END(curl_global_cleanup())
+}
+#endif
@@ -0,0 +1,225 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "curlx/base64.h"
+#include "memdebug.h"
+
+/*
+ * Check the base64 encoder and decoder against a plain implementation for
+ * all lengths up to a few vector blocks and with bad characters at every
+ * position, then time encoding and decoding a larger buffer with both. The
+ * timings are written to stderr.
+ */
+
+#define T3223_LEN    400
+#define T3223_BIG    (1024 * 1024)
+#define T3223_ROUNDS 20
+
+static const char t3223_table[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* encode `len` bytes with padding, returns the length of the output */
+static size_t t3223_encode(char *out, const unsigned char *in, size_t len,
+                           const char *table, bool pad)
+{
+  char *p = out;
+  for(; len >= 3; len -= 3, in += 3) {
+    *p++ = table[in[0] >> 2];
+    *p++ = table[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+    *p++ = table[((in[1] & 0x0f) << 2) | (in[2] >> 6)];
+    *p++ = table[in[2] & 0x3f];
+  }
+  if(len) {
+    *p++ = table[in[0] >> 2];
+    if(len == 1)
+      *p++ = table[(in[0] & 0x03) << 4];
+    else {
+      *p++ = table[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+      *p++ = table[(in[1] & 0x0f) << 2];
+    }
+    if(pad) {
+      *p++ = '=';
+      if(len == 1)
+        *p++ = '=';
+    }
+  }
+  *p = '\0';
+  return (size_t)(p - out);
+}
+
+/* decode complete quantums without padding, returns FALSE on a bad one */
+static bool t3223_decode(unsigned char *out, const char *in, size_t len,
+                         const unsigned char *lookup)
+{
+  for(; len >= 4; len -= 4, in += 4) {
+    unsigned int x = 0;
+    int j;
+    for(j = 0; j < 4; j++) {
+      unsigned char val = lookup[(unsigned char)in[j]];
+      if(val == 0xff)
+        return FALSE;
+      x = (x << 6) | val;
+    }
+    *out++ = (unsigned char)(x >> 16);
+    *out++ = (unsigned char)(x >> 8);
+    *out++ = (unsigned char)x;
+  }
+  return TRUE;
+}
+
+static CURLcode test_unit3223(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+
+  static const char urltable[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  static const char badchars[] = "=.-_ \n\x80\xff";
+  unsigned char data[T3223_LEN];
+  unsigned char lookup[256];
+  char expect[T3223_LEN / 3 * 4 + 5];
+  char *big = NULL;
+  char *bigenc = NULL;
+  unsigned char *bigdec = NULL;
+  size_t i, len, elen;
+  unsigned int seed = 3;
+  struct curltime t0;
+  timediff_t plain_us, enc_us, dec_us;
+  bool ok = TRUE;
+  int r;
+
+  memset(lookup, 0xff, sizeof(lookup));
+  for(i = 0; i < 64; i++)
+    lookup[(unsigned char)t3223_table[i]] = (unsigned char)i;
+
+  for(i = 0; i < sizeof(data); i++) {
+    seed = (seed * 1103515245) + 12345;
+    data[i] = (unsigned char)(seed >> 16);
+  }
+
+  for(len = 1; len < sizeof(data); len++) {
+    char *enc;
+    unsigned char *dec;
+    size_t olen;
+
+    elen = t3223_encode(expect, data, len, t3223_table, TRUE);
+    abort_unless(!curlx_base64_encode((const char *)data, len, &enc, &olen),
+                 "encode failed");
+    fail_unless(olen == elen && !memcmp(enc, expect, elen + 1),
+                "encoded data differs");
+    abort_unless(!curlx_base64_decode(enc, &dec, &olen), "decode failed");
+    fail_unless(olen == len && !memcmp(dec, data, len),
+                "decoded data differs");
+    free(dec);
+
+    /* a bad character at any position is found */
+    for(i = 0; i < elen; i++) {
+      char c = enc[i];
+      if(c == '=')
+        continue;
+      enc[i] = badchars[i % (sizeof(badchars) - 1)];
+      fail_unless(curlx_base64_decode(enc, &dec, &olen) ==
+                  CURLE_BAD_CONTENT_ENCODING, "bad character accepted");
+      fail_unless(!dec && !olen, "output for bad data");
+      enc[i] = c;
+    }
+    free(enc);
+
+    elen = t3223_encode(expect, data, len, urltable, FALSE);
+    abort_unless(!curlx_base64url_encode((const char *)data, len, &enc,
+                                         &olen), "url encode failed");
+    fail_unless(olen == elen && !memcmp(enc, expect, elen + 1),
+                "url encoded data differs");
+    free(enc);
+
+    /* the groups alone at any offset */
+    memset(expect, '#', sizeof(expect));
+    curlx_base64_encode_groups(expect, &data[len % 3], (len - len % 3) / 3);
+    fail_unless(expect[(len - len % 3) / 3 * 4] == '#',
+                "groups written beyond their end");
+  }
+
+  big = malloc(T3223_BIG);
+  bigenc = malloc(T3223_BIG / 3 * 4 + 5);
+  bigdec = malloc(T3223_BIG);
+  if(!big || !bigenc || !bigdec) {
+    fail("out of memory");
+    free(big);
+    free(bigenc);
+    free(bigdec);
+    goto unit_test_abort;
+  }
+  for(i = 0; i < T3223_BIG; i++) {
+    seed = (seed * 1103515245) + 12345;
+    big[i] = (char)(seed >> 16);
+  }
+
+  t0 = curlx_now();
+  for(r = 0; r < T3223_ROUNDS; r++) {
+    elen = t3223_encode(bigenc, (unsigned char *)big, T3223_BIG,
+                        t3223_table, TRUE);
+    /* the last quantum is padded */
+    ok = ok && t3223_decode(bigdec, bigenc, elen - 4, lookup);
+  }
+  plain_us = curlx_timediff_us(curlx_now(), t0);
+  fail_unless(ok, "plain decode failed");
+
+  enc_us = dec_us = 0;
+  for(r = 0; r < T3223_ROUNDS; r++) {
+    char *enc;
+    unsigned char *dec;
+    size_t olen;
+
+    t0 = curlx_now();
+    if(curlx_base64_encode(big, T3223_BIG, &enc, &olen)) {
+      fail("encode failed");
+      break;
+    }
+    enc_us += curlx_timediff_us(curlx_now(), t0);
+    fail_unless(!strcmp(enc, bigenc), "encoded data differs");
+    t0 = curlx_now();
+    if(curlx_base64_decode(enc, &dec, &olen)) {
+      fail("decode failed");
+      free(enc);
+      break;
+    }
+    dec_us += curlx_timediff_us(curlx_now(), t0);
+    fail_unless(olen == T3223_BIG && !memcmp(dec, big, T3223_BIG),
+                "round trip differs");
+    free(enc);
+    free(dec);
+  }
+
+  curl_mfprintf(stderr, "%d rounds of %d bytes: "
+                "plain %" FMT_TIMEDIFF_T " us, "
+                "encode %" FMT_TIMEDIFF_T " us, "
+                "decode %" FMT_TIMEDIFF_T " us\n",
+                T3223_ROUNDS, T3223_BIG, plain_us, enc_us, dec_us);
+
+  free(big);
+  free(bigenc);
+  free(bigdec);
+
+  UNITTEST_END_SIMPLE
+}
@@ -0,0 +1,196 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "binstore.h"
+#include "memdebug.h"
+
+#ifdef CURL_DISABLE_HTTP
+static CURLcode test_unit3224(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+  puts("nothing to do when HTTP is disabled");
+  UNITTEST_END_SIMPLE
+}
+#else
+
+#define T3224_FMT "si"
+
+/* write the records as a store file, returns non-zero on error */
+static CURLcode t3224_write(const char *file, unsigned int kind,
+                            const char * const *keys, size_t nkeys)
+{
+  struct Curl_binwriter w;
+  CURLcode result = CURLE_OK;
+  FILE *out;
+  size_t i;
+
+  out = fopen(file, "wb");
+  if(!out)
+    return CURLE_WRITE_ERROR;
+  Curl_binwriter_init(&w, kind, T3224_FMT);
+  for(i = 0; !result && (i < nkeys); i++) {
+    struct Curl_binrec rec;
+    rec.key = keys[i];
+    rec.keylen = strlen(keys[i]);
+    rec.f[0].str = keys[i];
+    rec.f[0].len = strlen(keys[i]);
+    rec.f[1].num = (curl_off_t)i;
+    result = Curl_binwriter_add(&w, &rec);
+  }
+  if(!result)
+    result = Curl_binwriter_write(&w, out);
+  Curl_binwriter_free(&w);
+  fclose(out);
+  return result;
+}
+
+/* take all records for the key, return a bit set for each record number */
+static unsigned int t3224_take(struct Curl_binstore *bs, const char *key)
+{
+  struct Curl_binrec rec;
+  unsigned int found = 0;
+
+  while(Curl_binstore_take(bs, key, strlen(key), &rec)) {
+    if(rec.keylen != strlen(key) ||
+       !curl_strnequal(rec.key, key, rec.keylen) ||
+       rec.f[0].len != rec.keylen ||
+       memcmp(rec.f[0].str, rec.key, rec.keylen))
+      return 0x8000;
+    found |= 1U << rec.f[1].num;
+  }
+  return found;
+}
+
+static CURLcode test_unit3224(const char *arg)
+{
+  struct Curl_binstore *bs = NULL;
+
+  UNITTEST_BEGIN_SIMPLE
+
+  static const char * const keys[] = {
+    "example.com",      /* 0 */
+    "curl.se",          /* 1 */
+    "EXAMPLE.com",      /* 2 */
+    "a.example.com",    /* 3 */
+    "example.co",       /* 4 */
+    "",                 /* 5 */
+    "example.com",      /* 6 */
+    "zz.example",       /* 7 */
+  };
+  struct Curl_binrec rec;
+  char bad[256];
+  unsigned char buf[512];
+  size_t len;
+  unsigned int i;
+  unsigned int found;
+  FILE *f;
+
+  abort_unless(arg, "no file name given");
+  abort_unless(!t3224_write(arg, CURL_BINSTORE_HSTS, keys,
+                            CURL_ARRAYSIZE(keys)), "writing the store");
+  fail_unless(Curl_binstore_is(arg), "not detected as a store");
+
+  /* a store of another kind is an error */
+  fail_unless(Curl_binstore_open(arg, CURL_BINSTORE_COOKIE, T3224_FMT,
+                                 &bs) == CURLE_READ_ERROR, "kind mismatch");
+  fail_unless(!bs, "store for the wrong kind");
+
+  abort_unless(!Curl_binstore_open(arg, CURL_BINSTORE_HSTS, T3224_FMT, &bs),
+               "opening the store");
+  abort_unless(bs, "no store opened");
+  fail_unless(bs->count == CURL_ARRAYSIZE(keys), "record count");
+  fail_unless(bs->left == bs->count, "records left");
+
+  /* all records with the same key, case insensitively, in added order */
+  fail_unless(t3224_take(bs, "Example.COM") == 0x45, "example.com records");
+  fail_unless(!t3224_take(bs, "example.com"), "taken twice");
+  fail_unless(t3224_take(bs, "example.co") == 0x10, "example.co record");
+  fail_unless(!t3224_take(bs, "example.c"), "prefix match");
+  fail_unless(!t3224_take(bs, "nope.example"), "missing key");
+  fail_unless(bs->left == 4, "records left after take");
+
+  /* a record can be peeked at and dropped */
+  for(i = 0; i < bs->count; i++) {
+    if(Curl_binstore_get(bs, i, &rec) && (rec.keylen == 7))
+      Curl_binstore_drop(bs, i);
+  }
+  fail_unless(bs->left == 3, "records left after drop");
+  fail_unless(!t3224_take(bs, "curl.se"), "dropped record taken");
+
+  /* the rest come in key order */
+  found = 0;
+  while(Curl_binstore_next(bs, &rec))
+    found = found * 10 + (unsigned int)rec.f[1].num;
+  fail_unless(found == 537, "records from next");
+  fail_unless(!bs->left, "records left at the end");
+  Curl_binstore_free(bs);
+  bs = NULL;
+
+  /* a text file is not a store */
+  curl_msnprintf(bad, sizeof(bad), "%s.text", arg);
+  f = fopen(bad, "wb");
+  abort_unless(f, "writing text file");
+  fputs("# Netscape HTTP Cookie File\n", f);
+  fclose(f);
+  fail_unless(!Curl_binstore_is(bad), "text detected as a store");
+  fail_unless(!Curl_binstore_open(bad, CURL_BINSTORE_HSTS, T3224_FMT, &bs),
+              "opening text file");
+  fail_unless(!bs, "store for a text file");
+
+  /* a broken record is skipped and a truncated index is an error */
+  f = fopen(arg, "rb");
+  abort_unless(f, "reading the store");
+  len = fread(buf, 1, sizeof(buf), f);
+  fclose(f);
+  abort_unless(len > 60, "store too short");
+  /* the first record offset points past the end */
+  memset(&buf[20], 0xff, 4);
+
+  curl_msnprintf(bad, sizeof(bad), "%s.bad", arg);
+  f = fopen(bad, "wb");
+  abort_unless(f, "writing broken store");
+  fwrite(buf, 1, len, f);
+  fclose(f);
+  abort_unless(!Curl_binstore_open(bad, CURL_BINSTORE_HSTS, T3224_FMT, &bs),
+               "opening broken store");
+  abort_unless(bs, "no broken store opened");
+  found = 0;
+  while(Curl_binstore_next(bs, &rec))
+    found++;
+  fail_unless(found == CURL_ARRAYSIZE(keys) - 1, "broken record not skipped");
+  Curl_binstore_free(bs);
+  bs = NULL;
+
+  f = fopen(bad, "wb");
+  abort_unless(f, "writing truncated store");
+  fwrite(buf, 1, 30, f);
+  fclose(f);
+  fail_unless(Curl_binstore_open(bad, CURL_BINSTORE_HSTS, T3224_FMT,
+                                 &bs) == CURLE_READ_ERROR, "truncated store");
+  fail_unless(!bs, "store for a truncated file");
+
+  UNITTEST_END(Curl_binstore_free(bs))
+}
+#endif
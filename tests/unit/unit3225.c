@@ -0,0 +1,128 @@
+/***************************************************************************
+ *                                  _   _ ____  _
+ *  Project                     ___| | | |  _ \| |
+ *                             / __| | | | |_) | |
+ *                            | (__| |_| |  _ <| |___
+ *                             \___|\___/|_| \_\_____|
+ *
+ * Copyright (C) Daniel Stenberg, <daniel@haxx.se>, et al.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution. The terms
+ * are also available at https://curl.se/docs/copyright.html.
+ *
+ * You may opt to use, copy, modify, merge, publish, distribute and/or sell
+ * copies of the Software, and permit persons to whom the Software is
+ * furnished to do so, under the terms of the COPYING file.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ * SPDX-License-Identifier: curl
+ *
+ ***************************************************************************/
+#include "unitcheck.h"
+
+#include "urldata.h"
+#include "flowctl.h"
+#include "memdebug.h"
+
+static struct curltime t3225_at(struct curltime start, timediff_t us)
+{
+  start.tv_sec += (time_t)(us / 1000000);
+  start.tv_usec += (int)(us % 1000000);
+  if(start.tv_usec >= 1000000) {
+    start.tv_sec++;
+    start.tv_usec -= 1000000;
+  }
+  return start;
+}
+
+static CURLcode test_unit3225(const char *arg)
+{
+  UNITTEST_BEGIN_SIMPLE
+
+  struct flowctl fc;
+  struct flowctl_stats stats;
+  struct curltime t0 = {1000, 0};
+
+  /* the window starts within its maximum */
+  Curl_flowctl_init(&fc, 8000, 4000);
+  fail_unless(fc.window == 4000, "window beyond window_max");
+
+  /* probed round trips */
+  Curl_flowctl_init(&fc, 1000, 4000);
+  fail_unless(Curl_flowctl_recvd(&fc, 100), "no probe at the start");
+  Curl_flowctl_probe_start(&fc, t0);
+  fail_unless(!Curl_flowctl_recvd(&fc, 666), "probe while probing");
+
+  /* 666 bytes are less than 2/3 of the window, it stays */
+  fail_unless(!Curl_flowctl_probe_done(&fc, t3225_at(t0, 10000)),
+              "window grew below 2/3");
+  fail_unless(fc.window == 1000, "window changed below 2/3");
+  fail_unless(fc.rtt_us == 10000, "wrong first rtt");
+
+  /* no probe until another window of data has been received */
+  fail_unless(!Curl_flowctl_recvd(&fc, 400), "probe after 400 bytes");
+  fail_unless(!Curl_flowctl_recvd(&fc, 500), "probe after 900 bytes");
+  fail_unless(Curl_flowctl_recvd(&fc, 100), "no probe after a window");
+
+  /* 667 bytes reach 2/3 of the window, it grows to twice the sample */
+  Curl_flowctl_probe_start(&fc, t3225_at(t0, 20000));
+  fail_unless(!Curl_flowctl_recvd(&fc, 667), "probe while probing");
+  fail_unless(Curl_flowctl_probe_done(&fc, t3225_at(t0, 40000)),
+              "window did not grow at 2/3");
+  fail_unless(fc.window == 1334, "window not twice the sample");
+  /* smoothed: (10000 * 7 + 20000) / 8 */
+  fail_unless(fc.rtt_us == 11250, "wrong smoothed rtt");
+
+  /* growing stops at window_max */
+  fail_unless(Curl_flowctl_recvd(&fc, 1), "no probe after growing");
+  Curl_flowctl_probe_start(&fc, t3225_at(t0, 50000));
+  fail_unless(!Curl_flowctl_recvd(&fc, 3000), "probe while probing");
+  fail_unless(Curl_flowctl_probe_done(&fc, t3225_at(t0, 60000)),
+              "window did not grow to the max");
+  fail_unless(fc.window == 4000, "window not capped at window_max");
+
+  /* no more probes at the maximum */
+  fail_unless(!Curl_flowctl_recvd(&fc, 100000), "probe at window_max");
+  fail_unless(!Curl_flowctl_probe_done(&fc, t3225_at(t0, 70000)),
+              "probe done without a probe");
+
+  Curl_flowctl_get_stats(&fc, &stats);
+  fail_unless(stats.window == 4000, "wrong window in stats");
+  fail_unless(stats.rtt_us == fc.rtt_us, "wrong rtt in stats");
+
+  /* round trips measured by the stack */
+  Curl_flowctl_init(&fc, 1000, 8000);
+  fail_unless(!Curl_flowctl_recvd_rtt(&fc, 100, 0, t0),
+              "grew without an rtt");
+  fail_unless(!fc.probing, "sampling without an rtt");
+
+  /* the sample starts, its data counts from the next call */
+  fail_unless(!Curl_flowctl_recvd_rtt(&fc, 100, 5000, t0),
+              "grew at the sample start");
+  fail_unless(fc.probing, "no sample started");
+  fail_unless(!Curl_flowctl_recvd_rtt(&fc, 800, 5000, t3225_at(t0, 1000)),
+              "grew before a round trip");
+  fail_unless(Curl_flowctl_recvd_rtt(&fc, 200, 5000, t3225_at(t0, 5000)),
+              "did not grow after a round trip");
+  fail_unless(fc.window == 2000, "window not twice the sample");
+  fail_unless(fc.rtt_us == 5000, "rtt not taken from the stack");
+
+  /* a small sample skips a window of data before the next */
+  fail_unless(!Curl_flowctl_recvd_rtt(&fc, 100, 5000, t3225_at(t0, 6000)),
+              "grew at the sample start");
+  fail_unless(!Curl_flowctl_recvd_rtt(&fc, 500, 5000, t3225_at(t0, 11000)),
+              "grew below 2/3");
+  fail_unless(fc.window == 2000, "window changed below 2/3");
+  fail_unless(!fc.probing, "sampling after a round trip");
+  fail_unless(!Curl_flowctl_recvd_rtt(&fc, 1500, 5000, t3225_at(t0, 12000)),
+              "grew while skipping");
+  fail_unless(!fc.probing, "sampling before a window of data");
+  fail_unless(!Curl_flowctl_recvd_rtt(&fc, 500, 5000, t3225_at(t0, 13000)),
+              "grew at the sample start");
+  fail_unless(fc.probing, "no sample after a window of data");
+
+  UNITTEST_END_SIMPLE
+}